@@ -86,6 +86,38 @@ When B<--recurse> is in effect, B<sunifdef> builds a graph of all unique input f
 
 Process only input files that have one of the file extensions I<ext1>,I<ext2>... A file extension may be any terminal segment of a filename that follows a '.'.
 
+=item B<-X>I<glob>, B<--exclude> I<glob>
+
+Exclude input files and directories that match the glob pattern I<glob>. An excluded directory is not searched at all, so e.g. B<--exclude .git --exclude build> keeps B<--recurse> out of those directories. May be repeated. In I<glob>, B<*> matches any characters except '/', B<**> matches any characters, B<?> matches any one character except '/' and B<[>...B<]> matches a character class. A pattern without a '/' is matched against leafnames; an absolute pattern against whole pathnames; any other pattern against the trailing components of pathnames, e.g. B<src/generated>. A directory named on the command line is searched even if it matches.
+
+=item B<-i>I<glob>, B<--include> I<glob>
+
+Process only input files that match the glob pattern I<glob>, or that satisfy a B<--filter> option. May be repeated. Patterns are as for B<--exclude>.
+
+=item B<-e>, B<--eager>
+
+With B<--recurse>, start processing input files as soon as they are found, while directories are still being searched, instead of first building the whole tree of input files. Files are then processed in the order in which they are found, directory by directory for each argument in turn, and a directory is reported as entered only while the files directly within it are processed. The summary at exit counts the files found. Needs B<--recurse>.
+
+=item B<-S>I<file>, B<--snapshot> I<file>
+
+With B<--recurse>, keep a snapshot of the directories searched in I<file>. The snapshot records the identity, modification time and entries of each directory. On a later run with the same I<file>, a directory that has not been modified since it was listed is not read again, and its entries are taken from the snapshot. A directory that was modified in the same second in which it was listed is always read again. Symbolic links are always resolved afresh. The snapshot is replaced when the search is finished. If I<file> does not exist or is damaged, every directory is read.
+
+=item B<-w>, B<--watch>
+
+With B<--recurse>, do not exit when the input files have been processed but watch the directories searched, and process each eligible file again when it is changed, and each eligible file in a directory that is created. Changes that arrive together are processed together once they have stopped for a moment. A file that is replaced with its output is not processed again until it is changed once more. The watch ends when B<sunifdef> is interrupted or terminated. Implies B<--keepgoing>. Cannot be combined with B<--backup> or B<--daemon>. Available only on Linux.
+
+=item B<-t>[I<format>[,I<file>]], B<--stats>[=I<format>[,I<file>]]
+
+At exit, report the wall-clock and CPU time spent in each phase of processing: searching the input file tree (and everything else outside the processing of files), opening files, reading, lexing, evaluating expressions, writing output and replacing or backing up input files. Also report the files processed, the bytes and lines read, the bytes written, the directives of each kind, the symbol lookups, the expressions evaluated, the operands skipped by short-circuit evaluation, and the cuts and parentheses deleted from directives. I<format> is B<text>, the default, or B<json>, which writes the report as a JSON object on one line. The report is appended to I<file> if given, otherwise written to stderr. Also report the allocations made after the options are parsed, with their count and bytes by the part of the program that makes them: B<lines> (line buffers and lexing), B<symbols>, B<file_tree>, B<diagnostics>, B<evaluator> and B<other>. The report also gives the allocations made while processing input lines, both in total and per line, and the peak bytes of heap in use. The heap is sampled at the end of each input file, and only where the C library can report it (glibc 2.33 or later); elsewhere the peak is given as 0. The peak resident set size of the process is given too, as B<peak_rss>. Timing each phase costs a little time on every line.
+
+=item B<-E>I<file>, B<--trace> I<file>
+
+Write a timeline of the run to I<file> in the Chrome trace-event JSON format, which can be viewed in B<chrome://tracing> or Perfetto. Each directory and each input file is a span. The span of a file has the times of its stages as arguments: opening, reading, lexing and evaluating, writing, and committing the output by replacing the input file. A run of a stage that lasts for 50 microseconds or more is also a span of its own. The trace ends with the 10 slowest input files and a histogram of the time taken per file, in powers of 2 microseconds. Unless B<--stats> is also given, only one input line in 16 is timed, and the times of reading, lexing and evaluating, and writing a file are estimated from those lines.
+
+=item B<-O>[I<file>], B<--profile>[=I<file>]
+
+At exit, report how often each symbol is looked up in B<#if>, B<#ifdef> and B<#ifndef> directives, and whether it is B<defined> or B<undefined> by B<-D> or B<-U> or is B<unknown>. Also report how often each distinct B<#if> or B<#elif> expression is evaluated, and how often it is true, false or insoluble and has an operand short-circuited. Expressions that differ only in comments and spacing are counted as one. Both lists are ranked by count. Unknown symbols and expressions that are never true or false do not change the output, so the report shows which B<-D> and B<-U> options are worth giving. The report is appended to I<file> if given, otherwise written to stderr.
+
 =item B<-B>I<suffix>, B<--backup> I<suffix>
 
 Backup each input file before replacing it, the backup file having the same name as the input file with I<suffix> appended to it.
@@ -128,7 +160,7 @@ Ouput the lines that ought to be dropped and vice versa.
 
 =item B<-d>, B<--debug>
 
-Write debugging information to stderr.
+Trace the steps of the parser and the evaluator, and write the trace to stderr at exit. Only the most recent steps of each thread are kept. Tracing is available only if B<sunifdef> is built with C<SUNIFDEF_TRACE> defined, e.g. by C<./configure CPPFLAGS=-DSUNIFDEF_TRACE>. Otherwise this option is ignored with a warning.
 
 =item B<-k>[B<d>|B<b>|B<c>], B<--discard> [B<drop> | B<blank> | B<comment>]
 
@@ -152,6 +184,38 @@ Apart from CPP directives, input is to be treated as Plain Old Data. C/C++ comme
 
 Output #line directives in place of discarded lines to preserve the line numbers of retained lines.
 
+=item B<-j>I<N>, B<--jobs> I<N>
+
+Use up to I<N> threads to search directories with B<--recurse> and to lex each large input file before it is processed. I<N> = 0 means one thread per processor. The output is the same whatever the value of I<N>. Default 1.
+
+=item B<-M>I<FILE>, B<--manifest> I<FILE>
+
+With B<--replace>, keep a manifest of the input files processed in I<FILE>. For each file that is processed without warnings or errors, the manifest records the size, modification time and content hash of the file as it is left by the run, together with a fingerprint of the options. On a later run with the same options, an input file that still matches its entry is skipped: it is not opened, parsed or replaced. A file whose modification time has changed but whose content has not is also skipped, after it is read to check its hash. The manifest is replaced atomically at the end of the run. Needs B<--replace>.
+
+=item B<-C>I<DIR>, B<--cache> I<DIR>
+
+Keep the output of input files in the cache directory I<DIR>, which is created if need be and may be shared by any number of runs, concurrent or not, on any number of checkouts. An input file whose contents have been processed before with the same options is not parsed: its output is taken from the cache. Only files that are processed without warnings or errors are entered in the cache. The summary reports how many of the files reached were found in the cache. Does not mix with B<--symbols>, B<--diff> or B<--incremental>.
+
+=item B<-z>I<SIZE>, B<--cache-size> I<SIZE>
+
+Limit the cache directory of B<--cache> to about I<SIZE> bytes. I<SIZE> may have a suffix B<k>, B<m> or B<g>. When a run leaves the cache over the limit, the entries least recently used are removed. Default 256m.
+
+=item B<-L>I<SOCKET>, B<--daemon> I<SOCKET>
+
+Take no input files, but serve clients on the Unix domain socket I<SOCKET>, processing the input files that they send with the other options. The options and symbols are parsed once, before a pool of B<--jobs> worker processes (by default one per processor) is forked to serve the clients, so that the cost of a large set of B<--define> and B<--undefine> options is not paid for each file. A worker that is killed is replaced. The daemon runs until it receives B<SIGTERM> or B<SIGINT>, when it removes the socket. Does not mix with B<--replace>, B<--recurse>, B<--symbols>, B<--diff>, B<--incremental>, B<--manifest> or B<--cache>.
+
+=item B<-T>I<SOCKET>, B<--client> I<SOCKET>
+
+Have the daemon serving on I<SOCKET> process the input files, instead of parsing them. The output, diagnostics and exit status are those the daemon's options would give, and options such as B<--replace>, B<--backup>, B<--recurse>, B<--filter> and B<--keepgoing> apply as usual, so that B<sunifdef --client> I<SOCKET> can stand in for B<sunifdef> with the daemon's options. Does not mix with B<--define>, B<--undefine>, B<--symbols>, B<--diff>, B<--incremental>, B<--manifest> or B<--cache>.
+
+=item B<-I>I<FILE>, B<--incremental> I<FILE>
+
+Keep checkpoints of the parse, with the output, in I<FILE>. When I<FILE> was written by an earlier run with the same options, only the part of the input file that has changed since then is reprocessed: the parse resumes from the last checkpoint before the first change and the earlier output is reused from the first checkpoint after the change at which the parse state is the same. Diagnostics are given only for the lines reprocessed. Does not mix with B<--replace> or B<--symbols>, and needs an input file.
+
+=item B<-u>, B<--diff>
+
+Instead of the output file, write to the standard output a unified diff of the changes that would be made to each input file, with three lines of context. Input files that would not change produce no output. The diff can be applied with B<patch -p0>. Any number of input files may be given, and B<--recurse> may be used to diff a whole tree: the diffs of all the files are written in turn and no input file is replaced. Does not mix with B<--replace>, B<--symbols> or B<--incremental>.
+
 =back
 
 =head1 EXAMPLES
@@ -45,6 +45,14 @@
 #include "symbol_table.h"
 #include "filesys.h"
 #include "dataset.h"
+#include "thread.h"
+#include "hash.h"
+#include "cache.h"
+#include "exception.h"
+#include "profile.h"
+#include "stats.h"
+#include "timeline.h"
+#include "trace.h"
 #include <stdio.h>
 #include <string.h>
 #include <stdarg.h>
@@ -85,6 +93,8 @@ IMPLEMENT(args,USER_INITABLE)
 DEFINE_USER_INIT(args)(STATE_T(args) * args_st)
 {
 	args_st->argfile_argv = ptr_vector_new();
+	args_st->args_public_state.fingerprint = HASH_INIT;
+	args_st->args_public_state.cache_limit = CACHE_DEFAULT_LIMIT;
 }
 
 /*! \fn void args_finis(args_state_t * args_st)
@@ -104,11 +114,11 @@ DEFINE_USER_FINIS(args)(STATE_T(args) * args_st)
 #define PROGRESS_GAGGED() \
 ((GET_PUBLIC(args,diagnostic_filter) & MSGCLASS_PROGRESS) != 0)
 
-static int optind;
+static STATE_LOCAL int optind;
 	/*!< Index of option parsed by getopt_long() */
-static int optopt;
+static STATE_LOCAL int optopt;
 	/*!< Unrecogised short option parsed by getopt_long() */
-static char *optarg;
+static STATE_LOCAL char *optarg;
 	/*!< Argument to an option parsed by getopt_long() */
 
 /*! Info structure for a commandline option for getopt_long() */
@@ -163,7 +173,23 @@ enum {
 	OPT_VERSION = 'v',		/*!< The \c --version option */
 	OPT_RECURSE = 'R', 		/*!< The \c --recurse option */
 	OPT_FILTER = 'F', 		/*!< The \c --filter option */
-	OPT_KEEPGOING = 'K'		/*!< The \c --keepgoing option */
+	OPT_KEEPGOING = 'K',	/*!< The \c --keepgoing option */
+	OPT_JOBS = 'j',			/*!< The \c --jobs option */
+	OPT_INCREMENTAL = 'I',	/*!< The \c --incremental option */
+	OPT_DIFF = 'u',			/*!< The \c --diff option */
+	OPT_EXCLUDE = 'X',		/*!< The \c --exclude option */
+	OPT_INCLUDE = 'i',		/*!< The \c --include option */
+	OPT_EAGER = 'e',		/*!< The \c --eager option */
+	OPT_SNAPSHOT = 'S',		/*!< The \c --snapshot option */
+	OPT_MANIFEST = 'M',		/*!< The \c --manifest option */
+	OPT_CACHE = 'C',		/*!< The \c --cache option */
+	OPT_CACHE_SIZE = 'z',	/*!< The \c --cache-size option */
+	OPT_DAEMON = 'L',		/*!< The \c --daemon option */
+	OPT_CLIENT = 'T',		/*!< The \c --client option */
+	OPT_WATCH = 'w',		/*!< The \c --watch option */
+	OPT_STATS = 't',		/*!< The \c --stats option */
+	OPT_TRACE = 'E',		/*!< The \c --trace option */
+	OPT_PROFILE = 'O'		/*!< The \c --profile option */
 };
 
 
@@ -189,6 +215,22 @@ static struct option long_options [] = {
 	{ "recurse", no_argument, NULL, OPT_RECURSE },
 	{ "filter", required_argument, NULL, OPT_FILTER },
 	{ "keepgoing", no_argument, NULL, OPT_KEEPGOING },
+	{ "jobs", required_argument, NULL, OPT_JOBS },
+	{ "incremental", required_argument, NULL, OPT_INCREMENTAL },
+	{ "diff", no_argument, NULL, OPT_DIFF },
+	{ "exclude", required_argument, NULL, OPT_EXCLUDE },
+	{ "include", required_argument, NULL, OPT_INCLUDE },
+	{ "eager", no_argument, NULL, OPT_EAGER },
+	{ "snapshot", required_argument, NULL, OPT_SNAPSHOT },
+	{ "manifest", required_argument, NULL, OPT_MANIFEST },
+	{ "cache", required_argument, NULL, OPT_CACHE },
+	{ "cache-size", required_argument, NULL, OPT_CACHE_SIZE },
+	{ "daemon", required_argument, NULL, OPT_DAEMON },
+	{ "client", required_argument, NULL, OPT_CLIENT },
+	{ "watch", no_argument, NULL, OPT_WATCH },
+	{ "stats", optional_argument, NULL, OPT_STATS },
+	{ "trace", required_argument, NULL, OPT_TRACE },
+	{ "profile", optional_argument, NULL, OPT_PROFILE },
 	{ 0, 0, 0, 0 }
 };
 
@@ -235,20 +277,10 @@ getopt_long(int argc, char * argv[], const char *optstr,
 				optarg = NULL;
 				return *opt;
 			}
-			else if (where[2] != ':') { /* Optional argument */
-				if (opt[1] != 0) {	/* arg abuts opt */
-					optarg = opt + 1;
-					return *opt;
-				}
-				else if (optind >= argc || *argv[optind] == '-') {
-					/* No arg */
-					optarg = NULL;
-					return *opt;
-				}
-				else {	/* Arg is next argv */
-					optarg = argv[optind++];
-					return *opt;
-				}
+			else if (where[2] == ':') { /* Optional argument */
+				/* Only an arg that abuts opt */
+				optarg = opt[1] != 0 ? opt + 1 : NULL;
+				return *opt;
 			}
 			else {	/* Required argument */
 				if (opt[1] != 0) {	/* arg abuts opt */
@@ -268,6 +300,7 @@ getopt_long(int argc, char * argv[], const char *optstr,
 		}
 		else { /* Long option */
 			int i, match = -1;
+			bool ambiguous = false;
 			size_t optlen;
 			/* Test for `opt=arg' and get length of opt */
 			char *eq = strchr(++opt,'=');
@@ -278,16 +311,24 @@ getopt_long(int argc, char * argv[], const char *optstr,
 			else {
 				optlen = strlen(opt);
 			}
-			/* Test for exactly one match of the option */
+			/* Test for exactly one match of the option, or for the
+				option in full, as "cache" is also a prefix of "cache-size" */
 			for (i = 0; longopts[i].name != NULL; ++i) {
 				if (!strncmp(opt,longopts[i].name,optlen)) {
-					if (match != -1) {
-						match = -1;
+					if (longopts[i].name[optlen] == '\0') {
+						match = i;
+						ambiguous = false;
 						break;
 					}
+					if (match != -1) {
+						ambiguous = true;
+					}
 					match = i;
 				}
 			}
+			if (ambiguous) {
+				match = -1;
+			}
 			if (longind != NULL) {
 				*longind = match;
 			}
@@ -312,14 +353,7 @@ getopt_long(int argc, char * argv[], const char *optstr,
 					optarg = argv[optind++];
 					break;
 				case optional_argument:
-					if (optarg) {	/* Arg after `=' */
-						break;
-					}
-					if (optarg || optind >= argc || *argv[optind] == '-') {
-						/* No argument */
-						break;
-					}
-					optarg = argv[optind++];
+					/* Only an arg after `=' */
 					break;
 				default:
 					assert(false);
@@ -384,6 +418,34 @@ usage(FILE * fp)
 		"--filter EXT1[,EXT2...]\n"
 		"\t\tProcess only input files that have one of the file extensions "
 		"EXT1,EXT2...\n"
+		"-XGLOB, --exclude GLOB\n"
+		"\t\tExclude files and directories that match GLOB. Excluded "
+		"directories are not searched.\n"
+		"-iGLOB, --include GLOB\n"
+		"\t\tProcess only input files that match GLOB or satisfy --filter.\n"
+		"-e, --eager\n"
+		"\t\tWith -R, process input files as soon as they are found "
+		"while directories are still being searched.\n"
+		"-SFILE, --snapshot FILE\n"
+		"\t\tWith -R, keep the listings of the directories searched in FILE "
+		"and on later runs do not read again directories that have not "
+		"changed.\n"
+		"-w, --watch\n"
+		"\t\tWith -R, after processing the input files keep watching the "
+		"directories searched for them and reprocess files as they change.\n"
+		"-t[FORMAT[,FILE]], --stats[=FORMAT[,FILE]]\n"
+		"\t\tAt exit, report the time spent in each phase of processing and "
+		"counts of the work done, in FORMAT text (default) or json, to FILE "
+		"or else to stderr.\n"
+		"-EFILE, --trace FILE\n"
+		"\t\tWrite a timeline of the run to FILE in Chrome trace-event JSON, "
+		"with a span for each directory, input file and stage of processing "
+		"a file, and the slowest files and a histogram of the time per "
+		"file.\n"
+		"-O[FILE], --profile[=FILE]\n"
+		"\t\tAt exit, report the lookups of each symbol and the evaluations "
+		"of each #if expression, with their outcomes, ranked by count, to "
+		"FILE or else to stderr.\n"
 		"-BSUFFIX, --backup SUFFIX\n"
 		"\t\tBackup each input file by appending SUFFIX to the name.\n"
 		"\t\tApplies only with -r.\n"
@@ -427,6 +489,34 @@ usage(FILE * fp)
 		"-K, --keepgoing\n"
 		"\t\tIf a parse error is encountered in an input file, continue "
 		"processing subsequent input files\n"
+		"-jN, --jobs N\n"
+		"\t\tUse up to N threads to search directories and to lex each "
+		"large input file. N = 0 means one thread per processor.\n"
+		"-MFILE, --manifest FILE\n"
+		"\t\tWith -r, enter the files processed in FILE and on later runs "
+		"skip files that are unchanged since they were processed with the "
+		"same options.\n"
+		"-CDIR, --cache DIR\n"
+		"\t\tKeep the output of input files in the cache directory DIR, "
+		"which may be shared by many runs, and take the output of any input "
+		"file that has the same contents and options from the cache.\n"
+		"-zSIZE, --cache-size SIZE\n"
+		"\t\tLimit the cache directory to SIZE bytes, with an optional "
+		"suffix k, m or g. The default is 256m.\n"
+		"-LSOCKET, --daemon SOCKET\n"
+		"\t\tTake no input files. Serve clients on the Unix domain socket "
+		"SOCKET with a pool of --jobs workers, processing the files they "
+		"send with the other options.\n"
+		"-TSOCKET, --client SOCKET\n"
+		"\t\tHave the daemon serving on SOCKET process the input files, "
+		"with its options in place of --define, --undefine and the other "
+		"options that bear on the output.\n"
+		"-IFILE, --incremental FILE\n"
+		"\t\tKeep checkpoints and output in FILE and on later runs "
+		"reprocess only the parts of the input file that have changed\n"
+		"-u, --diff\n"
+		"\t\tOutput a unified diff of the changes to each input file "
+		"instead of the output file. Input files are not replaced.\n"
 		"-P, --pod\n"
 		"\t\tApart from #-directives, input is Plain Old Data.\n"
 		"-l, --line\n"
@@ -469,7 +559,9 @@ usage_error(int reason, const char *format,...)
 {
 	if (format) {
 		va_list argp;
-		atexit(usage_error_summary);
+		if (!GET_PUBLIC(exception,hosted)) {
+			atexit(usage_error_summary);
+		}
 		va_start(argp,format);
 		vbail(reason,format,argp);
 		va_end(argp);
@@ -486,6 +578,9 @@ usage_error(int reason, const char *format,...)
 static void
 usage_help(void)
 {
+	if (GET_PUBLIC(exception,hosted)) {
+		usage_error(GRIPE_USAGE_ERROR,"--help is not available to a host");
+	}
 	usage(stdout);
 	exit(MSGCLASS_NONE);
 }
@@ -501,6 +596,9 @@ usage_help(void)
 static void
 version(void)
 {
+	if (GET_PUBLIC(exception,hosted)) {
+		usage_error(GRIPE_USAGE_ERROR,"--version is not available to a host");
+	}
 	printf("%s, version %s for %s (built %s, %s)\n",
 		GET_PUBLIC(args,prog_name),VERSION,OS_TYPE,__DATE__,__TIME__);
 	exit(MSGCLASS_NONE);
@@ -799,6 +897,151 @@ parse_symbols_policy(const char *optarg)
 	}
 }
 
+/*!	Parse the maximum number of threads to be used from the argument
+ 	to the \c --jobs option.
+ */
+static void
+parse_jobs(const char *optarg)
+{
+	char *end;
+	long jobs = strtol(optarg,&end,10);
+	if (*end != '\0' || end == optarg || jobs < 0 || jobs > MAXJOBS) {
+		usage_error(GRIPE_USAGE_ERROR,
+			"Invalid argument for --jobs: \"%s\"",optarg);
+	}
+	SET_PUBLIC(args,jobs) = jobs ? (int)jobs : thread_cpus();
+}
+
+/*!	Parse the format and file of the report from the argument, if any,
+	to the \c --stats option.
+ */
+static void
+parse_stats(char *optarg)
+{
+	char *comma;
+	size_t len;
+	SET_PUBLIC(args,stats_format) = STATS_TEXT;
+	SET_PUBLIC(args,stats_file) = NULL;
+	if (!optarg) {
+		return;
+	}
+	comma = strchr(optarg,',');
+	len = comma ? (size_t)(comma - optarg) : strlen(optarg);
+	if (len == 4 && !strncmp(optarg,"json",len)) {
+		SET_PUBLIC(args,stats_format) = STATS_JSON;
+	}
+	else if (len != 4 || strncmp(optarg,"text",len)) {
+		usage_error(GRIPE_USAGE_ERROR,
+			"Invalid argument for --stats: \"%s\"",optarg);
+	}
+	if (comma) {
+		if (!comma[1]) {
+			usage_error(GRIPE_USAGE_ERROR,
+				"Invalid argument for --stats: \"%s\"",optarg);
+		}
+		SET_PUBLIC(args,stats_file) = comma + 1;
+	}
+}
+
+/*!	Check the options for consistency with \c --watch, which keeps
+	replacing input files as they change.
+*/
+static void
+watch_sanity_checks(void)
+{
+	if (!GET_PUBLIC(args,watch)) {
+		return;
+	}
+	if (!GET_PUBLIC(args,recurse)) {
+		usage_error(GRIPE_INVALID_ARGS,
+			"--watch needs --recurse");
+	}
+	if (GET_PUBLIC(args,backup_suffix) != NULL) {
+		usage_error(GRIPE_INVALID_ARGS,
+			"--watch does not mix with --backup");
+	}
+	if (GET_PUBLIC(args,daemon_socket) != NULL) {
+		usage_error(GRIPE_INVALID_ARGS,
+			"--watch does not mix with --daemon");
+	}
+	/* An error in one file is not to end the watch */
+	SET_PUBLIC(args,keepgoing) = true;
+}
+
+/*!	Check the options for consistency with \c --client, which takes the
+	options that bear on the output from the daemon.
+
+	\param symbols	The number of symbols defined or undefined.
+*/
+static void
+client_sanity_checks(size_t symbols)
+{
+	if (symbols > 0) {
+		usage_error(GRIPE_INVALID_ARGS,
+			"--client does not mix with --define,--undefine");
+	}
+	if (GET_PUBLIC(args,symbols_policy) != SYMBOLS_NO) {
+		usage_error(GRIPE_INVALID_ARGS,
+			"--client does not mix with --symbols");
+	}
+	if (GET_PUBLIC(args,daemon_socket) != NULL) {
+		usage_error(GRIPE_INVALID_ARGS,
+			"--client does not mix with --daemon");
+	}
+	if (GET_PUBLIC(args,diff) || GET_PUBLIC(args,state_file) != NULL ||
+		GET_PUBLIC(args,manifest_file) != NULL ||
+		GET_PUBLIC(args,cache_dir) != NULL) {
+		usage_error(GRIPE_INVALID_ARGS,
+			"--client does not mix with --diff, --incremental, "
+			"--manifest or --cache");
+	}
+	if (GET_PUBLIC(args,backup_suffix) != NULL &&
+		!GET_PUBLIC(args,replace)) {
+		usage_error(GRIPE_INVALID_ARGS,
+			"--backup needs --replace");
+	}
+	if (GET_PUBLIC(args,eager) && !GET_PUBLIC(args,recurse)) {
+		usage_error(GRIPE_INVALID_ARGS,
+			"--eager needs --recurse");
+	}
+	watch_sanity_checks();
+}
+
+/*!	Parse the size limit of the output cache from the argument
+ 	to the \c --cache-size option.
+ */
+static void
+parse_cache_size(const char *optarg)
+{
+	char *end;
+	unsigned long size = strtoul(optarg,&end,10);
+	unsigned shift = 0;
+	switch(*end) {
+	case 'k':
+	case 'K':
+		shift = 10;
+		++end;
+		break;
+	case 'm':
+	case 'M':
+		shift = 20;
+		++end;
+		break;
+	case 'g':
+	case 'G':
+		shift = 30;
+		++end;
+		break;
+	default:;
+	}
+	if (*end != '\0' || end == optarg || *optarg == '-' || size == 0 ||
+		size > (~0UL >> shift)) {
+		usage_error(GRIPE_USAGE_ERROR,
+			"Invalid argument for --cache-size: \"%s\"",optarg);
+	}
+	SET_PUBLIC(args,cache_limit) = size << shift;
+}
+
 /*!
 	Check the consistency of the commandline options
 	and rectify innocuous mistakes.
@@ -812,6 +1055,10 @@ sanity_checks(void)
 	char *backup_suffix = GET_PUBLIC(args,backup_suffix);
 	size_t symbols = ptr_vector_count(GET_PUBLIC(symbol_table,sym_tab));
 
+	if (GET_PUBLIC(args,client_socket) != NULL) {
+		client_sanity_checks(symbols);
+		return;
+	}
 	if (list_symbols_only && symbols > 0) {
 		usage_error(GRIPE_INVALID_ARGS,
 			"--symbols does not mix with --define,--undefine");
@@ -840,6 +1087,71 @@ sanity_checks(void)
 		usage_error(GRIPE_INVALID_ARGS,
 			"--backup needs --replace");
 	}
+	if (GET_PUBLIC(args,state_file) != NULL) {
+		if (replace) {
+			usage_error(GRIPE_INVALID_ARGS,
+				"--incremental does not mix with --replace");
+		}
+		if (list_symbols_only) {
+			usage_error(GRIPE_INVALID_ARGS,
+				"--incremental does not mix with --symbols");
+		}
+	}
+	if (GET_PUBLIC(args,diff)) {
+		if (recurse) {
+			/* --recurse implied --replace, but nothing is rewritten */
+			replace = SET_PUBLIC(args,replace) = false;
+		}
+		if (replace) {
+			usage_error(GRIPE_INVALID_ARGS,
+				"--diff does not mix with --replace");
+		}
+		if (list_symbols_only) {
+			usage_error(GRIPE_INVALID_ARGS,
+				"--diff does not mix with --symbols");
+		}
+		if (GET_PUBLIC(args,state_file) != NULL) {
+			usage_error(GRIPE_INVALID_ARGS,
+				"--diff does not mix with --incremental");
+		}
+	}
+	if (GET_PUBLIC(args,manifest_file) != NULL && !replace) {
+		usage_error(GRIPE_INVALID_ARGS,
+			"--manifest needs --replace");
+	}
+	if (GET_PUBLIC(args,cache_dir) != NULL) {
+		if (list_symbols_only) {
+			usage_error(GRIPE_INVALID_ARGS,
+				"--cache does not mix with --symbols");
+		}
+		if (GET_PUBLIC(args,diff)) {
+			usage_error(GRIPE_INVALID_ARGS,
+				"--cache does not mix with --diff");
+		}
+		if (GET_PUBLIC(args,state_file) != NULL) {
+			usage_error(GRIPE_INVALID_ARGS,
+				"--cache does not mix with --incremental");
+		}
+	}
+	if (GET_PUBLIC(args,eager) && !recurse) {
+		usage_error(GRIPE_INVALID_ARGS,
+			"--eager needs --recurse");
+	}
+	watch_sanity_checks();
+	if (GET_PUBLIC(args,daemon_socket) != NULL) {
+		if (list_symbols_only) {
+			usage_error(GRIPE_INVALID_ARGS,
+				"--daemon does not mix with --symbols");
+		}
+		if (replace || GET_PUBLIC(args,diff) ||
+			GET_PUBLIC(args,state_file) != NULL ||
+			GET_PUBLIC(args,manifest_file) != NULL ||
+			GET_PUBLIC(args,cache_dir) != NULL) {
+			usage_error(GRIPE_INVALID_ARGS,
+				"--daemon does not mix with --replace, --recurse, --diff, "
+				"--incremental, --manifest or --cache");
+		}
+	}
 }
 
 /*!
@@ -897,13 +1209,24 @@ parse_executable(char **argv)
 void
 parse_args(int argc, char *argv[])
 {
-	static const char * const opts = "x:g:p:f:D:U:B:F:n:k:s:PRrcdlhvVK";
-	static bool parsing_file;
+	static const char * const opts = "x:g:p:f:D:U:B:F:n:k:s:j:I:X:i:S:M:C:z:L:T:t::E:O::PRrcdlhuvVKew";
+	static STATE_LOCAL bool parsing_file;
 	int args = argc;
 	int opt, save_ind, long_index;
 
 	for (optind = 0;
 		(opt = getopt_long(argc,argv,opts,long_options,&long_index)) != -1; ) {
+		if (opt != OPT_FILE && opt != OPT_JOBS && opt != OPT_INCREMENTAL &&
+			opt != OPT_EAGER && opt != OPT_SNAPSHOT && opt != OPT_MANIFEST &&
+			opt != OPT_CACHE && opt != OPT_CACHE_SIZE && opt != OPT_DAEMON &&
+			opt != OPT_CLIENT && opt != OPT_WATCH && opt != OPT_STATS &&
+			opt != OPT_TRACE && opt != OPT_PROFILE) {
+			/* Fingerprint the options that bear on the output */
+			hash_t fingerprint = hash_bytes(GET_PUBLIC(args,fingerprint),
+										&opt,sizeof(opt));
+			SET_PUBLIC(args,fingerprint) =
+				hash_str(fingerprint,optarg ? optarg : "");
+		}
 		switch (opt) {
 		case OPT_FILE:	/* Read further args from file */
 			save_ind = optind;
@@ -996,7 +1319,7 @@ parse_args(int argc, char *argv[])
 			SET_PUBLIC(args,replace) = true;
 			break;
 		case OPT_DEBUG:
-			debugging(true);
+			trace_start();
 			break;
 		case OPT_BACKUP:
 			SET_PUBLIC(args,backup_suffix) = optarg;
@@ -1063,6 +1386,61 @@ parse_args(int argc, char *argv[])
 								put files after errors */
 			SET_PUBLIC(args,keepgoing) = true;
 			break;
+		case OPT_JOBS: /* Threads for lexing large files */
+			parse_jobs(optarg);
+			break;
+		case OPT_INCREMENTAL: /* Reprocess only changed input */
+			SET_PUBLIC(args,state_file) = optarg;
+			break;
+		case OPT_DIFF: /* Output a diff of the changes */
+			SET_PUBLIC(args,diff) = true;
+			break;
+		case OPT_EXCLUDE: /* Exclude files and directories */
+			if (!dataset_exclude(optarg)) {
+				usage_error(GRIPE_USAGE_ERROR,
+					"Invalid argument for --exclude: \"%s\"",optarg);
+			}
+			break;
+		case OPT_INCLUDE: /* Include only matching files */
+			if (!dataset_include(optarg)) {
+				usage_error(GRIPE_USAGE_ERROR,
+					"Invalid argument for --include: \"%s\"",optarg);
+			}
+			break;
+		case OPT_EAGER: /* Process files while searching for more */
+			SET_PUBLIC(args,eager) = true;
+			break;
+		case OPT_SNAPSHOT: /* Reuse unchanged directory listings */
+			dataset_snapshot(optarg);
+			break;
+		case OPT_MANIFEST: /* Skip files already processed */
+			SET_PUBLIC(args,manifest_file) = optarg;
+			break;
+		case OPT_CACHE: /* Share output between runs */
+			SET_PUBLIC(args,cache_dir) = optarg;
+			break;
+		case OPT_CACHE_SIZE: /* Limit the output cache */
+			parse_cache_size(optarg);
+			break;
+		case OPT_DAEMON: /* Serve clients on a socket */
+			SET_PUBLIC(args,daemon_socket) = optarg;
+			break;
+		case OPT_CLIENT: /* Have a daemon process the input */
+			SET_PUBLIC(args,client_socket) = optarg;
+			break;
+		case OPT_WATCH: /* Reprocess files as they change */
+			SET_PUBLIC(args,watch) = true;
+			break;
+		case OPT_STATS: /* Report timings and counters at exit */
+			parse_stats(optarg);
+			break;
+		case OPT_TRACE: /* Write a timeline of the run */
+			SET_PUBLIC(args,trace_file) = optarg;
+			break;
+		case OPT_PROFILE: /* Count symbols and expressions */
+			SET_PUBLIC(args,profile) = true;
+			SET_PUBLIC(args,profile_file) = optarg;
+			break;
 		default:
 			usage_error(GRIPE_USAGE_ERROR,
 				"Invalid option: \"%s\"",argv[optind - 1]);
@@ -1070,6 +1448,8 @@ parse_args(int argc, char *argv[])
 	}
 	if (!parsing_file) {
 		SET_PUBLIC(args,got_opts) = true;
+		SET_PUBLIC(args,fingerprint) =
+			hash_str(GET_PUBLIC(args,fingerprint),VERSION);
 		finalise_diagnostics();
 		if (!PROGRESS_GAGGED()) {
 			heap_str argstr = concatenate(args,argv,' ');
@@ -1077,6 +1457,16 @@ parse_args(int argc, char *argv[])
 			free(argstr);
 		}
 		sanity_checks();
+		if (GET_PUBLIC(args,trace_file)) {
+			timeline_start();
+		}
+		if (GET_PUBLIC(args,profile)) {
+			profile_start();
+		}
+		if (GET_PUBLIC(args,stats_format) != STATS_NO ||
+			GET_PUBLIC(args,trace_file)) {
+			stats_start();
+		}
 		if (argc) {
 			report(PROGRESS_BUILDING_TREE,NULL,"Building input tree");
 		}
@@ -1099,8 +1489,7 @@ finish_args(void)
 	bool replace = GET_PUBLIC(args,replace);
 	bool input_is_stdin = false;
 
-	if (file_tree_is_empty(GET_PUBLIC(dataset,file_tree)) &&
-		GET_STATE(args,arg_dirs_ignored) == 0) {
+	if (dataset_is_empty() && GET_STATE(args,arg_dirs_ignored) == 0) {
 		/* No input files on command line */
 		if (!GET_PUBLIC(args,replace)) {
 			/* Without --replace, stdin is the input file */
@@ -1114,18 +1503,24 @@ finish_args(void)
 			}
 		}
 	}
-	if (file_tree_is_empty(GET_PUBLIC(dataset,file_tree)) && !input_is_stdin) {
+	if (dataset_is_empty() && !input_is_stdin) {
 		bail(GRIPE_NOTHING_TO_DO,
 			"Nothing to do. No input files.");
 	}
-	if (!list_symbols_only && !input_is_stdin &&
-		file_tree_count(GET_PUBLIC(dataset,file_tree),FT_COUNT_FILES,NULL) > 1 &&
-		!replace) {
+	if (input_is_stdin && GET_PUBLIC(args,state_file) != NULL) {
+		bail(GRIPE_INVALID_ARGS,
+		"--incremental needs an input file");
+	}
+	if (!list_symbols_only && !input_is_stdin && dataset_count() > 1 &&
+		!replace && !GET_PUBLIC(args,diff)) {
 		bail(GRIPE_ONE_FILE_ONLY,
 		"Need --replace to process multiple files");
 	}
-	report(PROGRESS_FILE_TALLY,NULL,"%d files to process",
-		file_tree_count(GET_PUBLIC(dataset,file_tree),FT_COUNT_FILES,NULL));
+	if (!GET_PUBLIC(args,eager)) {
+		/* Otherwise the files have not been found yet */
+		report(PROGRESS_FILE_TALLY,NULL,"%d files to process",
+			dataset_count());
+	}
 #ifdef DEBUG_FILE_TREE
 	file_tree_dump(GET_PUBLIC(dataset,file_tree));
 	exit(0);
@@ -41,6 +41,7 @@
 #include "opts.h"
 #include "file_tree.h"
 #include "ptr_vector.h"
+#include "hash.h"
 
 
 /*!\ingroup args_module args_module_interface
@@ -54,6 +55,11 @@
  */
 #define MAXMASKS 		64
 
+/*! The maximum number of threads that may be specified with
+	the \c --jobs option.
+ */
+#define MAXJOBS			256
+
 /*! Enumeration of policies for discarding lines */
 typedef enum {
 	DISCARD_DROP,	/*!< Drop discarded lines */
@@ -69,6 +75,13 @@ typedef enum {
 	SYMBOLS_LOCATE = 4	/*!< List symbol file and line location */
 } symbols_policy_t;
 
+/*! Enumeration of formats of the \c --stats report */
+typedef enum {
+	STATS_NO,	/*!< No report */
+	STATS_TEXT,	/*!< Report in text */
+	STATS_JSON	/*!< Report as a JSON object */
+} stats_format_t;
+
 
 /*! \fn void parse_executable(char **argv);
  * Parse the full and short names of the executable.
@@ -136,6 +149,44 @@ PUBLIC_STATE_DEF(args) {
 		/*!< Recurse into directories? */
 	bool	keepgoing;
 		/*!< Continue to process input files after errors */
+	int		jobs;
+		/*!< Maximum number of threads to search directories or to lex
+			an input file */
+	char	*state_file;
+		/*!< File in which checkpoints are kept for \c --incremental */
+	bool	diff;
+		/*!< Do we output a unified diff of the changes? */
+	bool	eager;
+		/*!< Do we process input files as soon as they are found? */
+	char	*manifest_file;
+		/*!< File in which processed files are entered for
+			\c --manifest */
+	char	*cache_dir;
+		/*!< Directory of the output cache for \c --cache */
+	unsigned long cache_limit;
+		/*!< Size limit of the output cache in bytes */
+	char	*daemon_socket;
+		/*!< Socket on which to serve clients for \c --daemon */
+	char	*client_socket;
+		/*!< Socket of the daemon that processes the input for
+			\c --client */
+	bool	watch;
+		/*!< Do we reprocess input files as they change? */
+	stats_format_t stats_format;
+		/*!< Format of the \c --stats report, if any */
+	char	*stats_file;
+		/*!< NULL, or the file to which the \c --stats report is
+			appended */
+	char	*trace_file;
+		/*!< NULL, or the file to which a timeline of the run is written
+			for \c --trace */
+	bool	profile;
+		/*!< Do we count symbols and expressions for \c --profile? */
+	char	*profile_file;
+		/*!< NULL, or the file to which the \c --profile report is
+			appended */
+	hash_t	fingerprint;
+		/*!< Hash of the options that bear on the output */
 	int		diagnostic_filter;
 		/*!< Bitmask of diagnostic filters */
 } PUBLIC_STATE_T(args);
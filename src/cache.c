@@ -0,0 +1,465 @@
+/***************************************************************************
+ *   Copyright (C) 2004, 2006 Symbian Software Ltd.                        *
+ *   All rights reserved.                                                  *
+ *   Copyright (C) 2007, 2008 Mike Kinghan, imk@strudl.org                 *
+ *   All rights reserved.                                                  *
+ *                                                                         *
+ *   Contributed originally by Mike Kinghan, imk@strudl.org                *
+ *                                                                         *
+ *   Redistribution and use in source and binary forms, with or without    *
+ *   modification, are permitted provided that the following conditions    *
+ *   are met:                                                              *
+ *                                                                         *
+ *   Redistributions of source code must retain the above copyright        *
+ *   notice, this list of conditions and the following disclaimer.         *
+ *                                                                         *
+ *   Redistributions in binary form must reproduce the above copyright     *
+ *   notice, this list of conditions and the following disclaimer in the   *
+ *   documentation and/or other materials provided with the distribution.  *
+ *                                                                         *
+ *   Neither the name of Symbian Software Ltd. nor the names of its        *
+ *   contributors may be used to endorse or promote products derived from  *
+ *   this software without specific prior written permission.              *
+ *                                                                         *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS   *
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT     *
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS    *
+ *   FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE        *
+ *   COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,   *
+ *   INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,  *
+ *   BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS *
+ *   OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED    *
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,*
+ *   OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF *
+ *   THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH  *
+ *   DAMAGE.                                                               *
+ *                                                                         *
+ ***************************************************************************/
+#include "cache.h"
+#include "args.h"
+#include "io.h"
+#include "filesys.h"
+#include "line_despatch.h"
+#include "memory.h"
+#include "platform.h"
+#include "report.h"
+#include "hash.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*!\ingroup cache_module, cache_interface, cache_internals
+ *\file cache.c
+ * This file implements the Cache module.
+ *
+ *	An entry is a file in one of 256 subdirectories of the cache
+ *	directory. It holds the fingerprint of the options, the size and
+ *	two hashes of the input, the exit flags raised and the counts of lines
+ *	dropped, changed and inserted, followed by the output. The entry is
+ *	named by the two hashes, and all of the key is checked when it is
+ *	read, so that a collision of the names cannot supply wrong output.
+ *
+ *	Only files that raised no diagnostic are entered, so that a hit never
+ *	hides a diagnostic. An entry is written under a temporary name and
+ *	renamed into place, so that concurrent runs can share the cache.
+ *	The modification time of an entry is refreshed on each hit, and
+ *	the entries least recently modified are evicted first.
+ */
+
+/*! \addtogroup cache_internals */
+/*@{*/
+
+/*! The first line of a cache entry */
+#define CACHE_MAGIC	"sunifdef-cache 1"
+
+/*! The name of the file in the cache directory that holds the
+	estimated size of the cache */
+#define CACHE_SIZE_FILE	"size"
+
+/*! The percentage of the size limit to which the cache is trimmed
+	when it exceeds the limit */
+#define CACHE_TRIM_PERCENT	80
+
+/*! Mask of all exit flags */
+#define ALL_EXIT_FLAGS		(~0)
+
+/*! Structure of a cache entry found when trimming the cache */
+typedef struct cache_file {
+	heap_str	name;	/*!< The name of the entry */
+	long		mtime;	/*!< Its modification time */
+	long		size;	/*!< Its size */
+} cache_file_t;
+
+/*@}*/
+
+/*! \addtogroup cache_internals_state_utils */
+/*@{*/
+
+/*! The state of the Cache module */
+STATE_DEF(cache) {
+	FILE *	output;	/*!< The output stream while output is staged */
+	heap_str entry;	/*!< The name of the entry of the current file */
+	hash_t	hash;	/*!< Hash of the current file */
+	hash_t	hash2;	/*!< Second hash of the current file, seeded with
+						the fingerprint of the options */
+	long	in_size;	/*!< The size of the current file */
+	int		flags;	/*!< Exit flags raised before the current file */
+	int		lines_dropped;	/*!< Lines dropped before the current file */
+	int		lines_changed;	/*!< Lines changed before the current file */
+	int		lines_inserted;	/*!< Lines inserted before the current file */
+	bool	active;	/*!< Is the output of the current file staged? */
+	unsigned	hits;	/*!< Files whose output came from the cache */
+	unsigned	misses;	/*!< Files looked up and not found */
+	unsigned	stored;	/*!< Entries added to the cache */
+	unsigned long added;	/*!< Bytes added to the cache */
+} STATE_T(cache);
+
+NO_PUBLIC_STATE(cache);
+
+IMPLEMENT(cache,ZERO_INITABLE);
+/*@}*/
+
+/*! \addtogroup cache_internals */
+/*@{*/
+
+/*! Copy a span of a stream to another.
+	\return	True iff the whole span is copied.
+ */
+static bool
+copy_span(FILE *from, long len, FILE *to)
+{
+	char buf[BUFSIZ];
+	while (len > 0) {
+		size_t want = len < (long)sizeof(buf) ? (size_t)len : sizeof(buf);
+		if (fread(buf,1,want,from) != want || fwrite(buf,1,want,to) != want) {
+			return false;
+		}
+		len -= (long)want;
+	}
+	return true;
+}
+
+/*! Compose the name of a file in the cache directory.
+	\param	subdir	NULL, or the name of a subdirectory.
+	\param	leaf	NULL, or the leafname of the file.
+	\return	The composed name.
+ */
+static heap_str
+cache_path(char const *subdir, char const *leaf)
+{
+	char const *dir = GET_PUBLIC(args,cache_dir);
+	heap_str path = allocate(strlen(dir) + (subdir ? strlen(subdir) : 0) +
+		(leaf ? strlen(leaf) : 0) + 3);
+	char *end = path + strlen(dir);
+	strcpy(path,dir);
+	if (subdir) {
+		*end++ = PATH_DELIM;
+		strcpy(end,subdir);
+		end += strlen(subdir);
+	}
+	if (leaf) {
+		*end++ = PATH_DELIM;
+		strcpy(end,leaf);
+	}
+	return path;
+}
+
+/*! Hash the current source file and compose the name of its entry.
+	\return	True iff the file is read.
+ */
+static bool
+make_key(void)
+{
+	char buf[BUFSIZ];
+	char subdir[8];
+	char leaf[2 * sizeof(hash_t) * 2 + 2];
+	size_t got;
+	FILE *in = fopen(GET_PUBLIC(io,filename),"rb");
+	if (in == NULL) {
+		return false;
+	}
+	SET_STATE(cache,hash) = HASH_INIT;
+	SET_STATE(cache,hash2) = GET_PUBLIC(args,fingerprint);
+	SET_STATE(cache,in_size) = 0;
+	while ((got = fread(buf,1,sizeof(buf),in)) != 0) {
+		SET_STATE(cache,hash) = hash_bytes(GET_STATE(cache,hash),buf,got);
+		SET_STATE(cache,hash2) = hash_bytes(GET_STATE(cache,hash2),buf,got);
+		SET_STATE(cache,in_size) += (long)got;
+	}
+	got = ferror(in);
+	fclose(in);
+	if (got) {
+		return false;
+	}
+	sprintf(subdir,"%02lx",GET_STATE(cache,hash) & 0xff);
+	sprintf(leaf,"%lx-%lx",GET_STATE(cache,hash),GET_STATE(cache,hash2));
+	SET_STATE(cache,entry) = cache_path(subdir,leaf);
+	return true;
+}
+
+/*! Supply the output of the current source file from its entry.
+	\return	True iff the entry exists and matches the file.
+ */
+static bool
+fetch(void)
+{
+	char magic[sizeof(CACHE_MAGIC)];
+	hash_t fingerprint, hash, hash2;
+	long in_size, out_size, out_at;
+	int flags, lines_dropped, lines_changed, lines_inserted;
+	bool hit = false;
+	FILE *in = fopen(GET_STATE(cache,entry),"rb");
+	if (in == NULL) {
+		return false;
+	}
+	if (fgets(magic,sizeof(magic),in) && !strcmp(magic,CACHE_MAGIC) &&
+		fscanf(in," %lx %lx %lx %ld %d %d %d %d %ld",&fingerprint,&hash,
+			&hash2,&in_size,&flags,&lines_dropped,&lines_changed,
+			&lines_inserted,&out_size) == 9 && fgetc(in) == '\n' &&
+		fingerprint == GET_PUBLIC(args,fingerprint) &&
+		hash == GET_STATE(cache,hash) && hash2 == GET_STATE(cache,hash2) &&
+		in_size == GET_STATE(cache,in_size)) {
+		/* Check the entry is whole before any output is written */
+		out_at = ftell(in);
+		if (!fseek(in,0,SEEK_END) && ftell(in) == out_at + out_size &&
+			!fseek(in,out_at,SEEK_SET)) {
+			if (!copy_span(in,out_size,GET_PUBLIC(io,output))) {
+				bail(GRIPE_CANT_WRITE_FILE,"Write error on output");
+			}
+			set_exit_flags(flags,true);
+			SET_PUBLIC(line_despatch,lines_dropped) += lines_dropped;
+			SET_PUBLIC(line_despatch,lines_changed) += lines_changed;
+			SET_PUBLIC(line_despatch,lines_inserted) += lines_inserted;
+			hit = true;
+		}
+	}
+	fclose(in);
+	return hit;
+}
+
+/*! Enter the staged output of the current source file in the cache.
+	\param	flags	The exit flags raised by the file.
+ */
+static void
+store(int flags)
+{
+	FILE *staged = GET_PUBLIC(io,output);
+	long out_size = ftell(staged);
+	char const *entry = GET_STATE(cache,entry);
+	size_t len = strlen(entry);
+	heap_str tempname = allocate(len + sizeof("_XXXXXX"));
+	heap_str dir = allocate(len + 1);
+	FILE *out;
+	bool good;
+	strcpy(dir,entry);
+	*strrchr(dir,PATH_DELIM) = '\0';
+	strcpy(tempname,entry);
+	strcpy(tempname + len,"_XXXXXX");
+	/* Failure to enter a file in the cache is not an error */
+	if (!fs_make_dir(GET_PUBLIC(args,cache_dir)) || !fs_make_dir(dir) ||
+		!fs_tempname(tempname) || (out = fopen(tempname,"wb")) == NULL) {
+		free(dir);
+		free(tempname);
+		return;
+	}
+	fprintf(out,"%s\n%lx %lx %lx %ld %d %d %d %d %ld\n",CACHE_MAGIC,
+		GET_PUBLIC(args,fingerprint),GET_STATE(cache,hash),
+		GET_STATE(cache,hash2),GET_STATE(cache,in_size),flags,
+		GET_PUBLIC(line_despatch,lines_dropped) - GET_STATE(cache,lines_dropped),
+		GET_PUBLIC(line_despatch,lines_changed) - GET_STATE(cache,lines_changed),
+		GET_PUBLIC(line_despatch,lines_inserted) -
+			GET_STATE(cache,lines_inserted),
+		out_size);
+	good = !fseek(staged,0,SEEK_SET) && copy_span(staged,out_size,out);
+	good = !fclose(out) && good;
+	if (good && !rename(tempname,entry)) {
+		++SET_STATE(cache,stored);
+		SET_STATE(cache,added) += (unsigned long)out_size;
+	}
+	else {
+		remove(tempname);
+	}
+	free(dir);
+	free(tempname);
+}
+
+/*! Write the staged output to the output stream and reinstate
+	the exit flags raised before the current file.
+ */
+static void
+deliver(void)
+{
+	FILE *staged = GET_PUBLIC(io,output);
+	long out_size = ftell(staged);
+	if (fseek(staged,0,SEEK_SET) ||
+		!copy_span(staged,out_size,GET_STATE(cache,output))) {
+		bail(GRIPE_CANT_WRITE_FILE,"Write error on output");
+	}
+	fclose(staged);
+	SET_PUBLIC(io,output) = GET_STATE(cache,output);
+	set_exit_flags(GET_STATE(cache,flags),true);
+}
+
+/*! Compare two cache entries by modification time, for \c qsort() */
+static int
+older(void const *lhs, void const *rhs)
+{
+	long lhs_mtime = ((cache_file_t const *)lhs)->mtime;
+	long rhs_mtime = ((cache_file_t const *)rhs)->mtime;
+	return lhs_mtime < rhs_mtime ? -1 : lhs_mtime > rhs_mtime;
+}
+
+/*! Evict the least recently used entries from the cache until it is
+	within \c CACHE_TRIM_PERCENT of its size limit.
+	\return	The size of the cache remaining.
+ */
+static unsigned long
+trim(void)
+{
+	unsigned long limit = GET_PUBLIC(args,cache_limit);
+	unsigned long total = 0;
+	cache_file_t *files = NULL;
+	size_t count = 0, size = 0, i;
+	unsigned sub;
+	for (sub = 0; sub < 256; ++sub) {
+		char subdir[8];
+		heap_str dirname;
+		fs_dir_t dir;
+		char const *fullname;
+		sprintf(subdir,"%02x",sub);
+		dirname = cache_path(subdir,NULL);
+		dir = fs_open_dir(dirname,NULL);
+		free(dirname);
+		if (!dir) {
+			continue;
+		}
+		while (fs_read_dir(dir,&fullname) != NULL) {
+			fs_stamp_t stamp;
+			size_t len;
+			if (!fs_stamp(fullname,&stamp)) {
+				continue;
+			}
+			if (count == size) {
+				size = size ? size * 2 : 256;
+				files = reallocate(files,size * sizeof(cache_file_t));
+			}
+			len = strlen(fullname);
+			files[count].name = allocate(len + 1);
+			memcpy(files[count].name,fullname,len + 1);
+			files[count].mtime = stamp.mtime;
+			files[count].size = stamp.size;
+			total += (unsigned long)stamp.size;
+			++count;
+		}
+		fs_close_dir(dir);
+	}
+	if (count) {
+		qsort(files,count,sizeof(cache_file_t),older);
+	}
+	for (i = 0; i < count; ++i) {
+		if (total > limit / 100 * CACHE_TRIM_PERCENT &&
+			!remove(files[i].name)) {
+			total -= (unsigned long)files[i].size;
+		}
+		free(files[i].name);
+	}
+	free(files);
+	return total;
+}
+
+/*@}*/
+
+/* API ***************************************************************/
+
+bool
+cache_open(void)
+{
+	if (GET_PUBLIC(args,cache_dir) == NULL ||
+		!strcmp(GET_PUBLIC(io,filename),STDIN_NAME) || !make_key()) {
+		return false;
+	}
+	if (fetch()) {
+		fs_touch(GET_STATE(cache,entry));
+		free(SET_STATE(cache,entry));
+		SET_STATE(cache,entry) = NULL;
+		++SET_STATE(cache,hits);
+		return true;
+	}
+	++SET_STATE(cache,misses);
+	SET_STATE(cache,output) = GET_PUBLIC(io,output);
+	SET_PUBLIC(io,output) = tmpfile();
+	if (GET_PUBLIC(io,output) == NULL) {
+		bail(GRIPE_NO_TEMPFILE,"Cannot create temporary file");
+	}
+	SET_STATE(cache,flags) = get_exit_flags(ALL_EXIT_FLAGS);
+	set_exit_flags(ALL_EXIT_FLAGS,false);
+	SET_STATE(cache,lines_dropped) = GET_PUBLIC(line_despatch,lines_dropped);
+	SET_STATE(cache,lines_changed) = GET_PUBLIC(line_despatch,lines_changed);
+	SET_STATE(cache,lines_inserted) = GET_PUBLIC(line_despatch,lines_inserted);
+	SET_STATE(cache,active) = true;
+	return false;
+}
+
+void
+cache_close(bool error)
+{
+	int raised;
+	if (!GET_STATE(cache,active)) {
+		return;
+	}
+	SET_STATE(cache,active) = false;
+	raised = get_exit_flags(ALL_EXIT_FLAGS);
+	if (!error && !(raised & MSGEVENT_MASK)) {
+		store(raised);
+	}
+	deliver();
+	free(SET_STATE(cache,entry));
+	SET_STATE(cache,entry) = NULL;
+}
+
+void
+cache_finish(void)
+{
+	heap_str size_file;
+	unsigned long size = 0;
+	FILE *file;
+	if (GET_PUBLIC(args,cache_dir) == NULL || !GET_STATE(cache,stored)) {
+		return;
+	}
+	size_file = cache_path(NULL,CACHE_SIZE_FILE);
+	file = fopen(size_file,"r");
+	if (file) {
+		if (fscanf(file,"%lu",&size) != 1) {
+			size = 0;
+		}
+		fclose(file);
+	}
+	size += GET_STATE(cache,added);
+	if (size > GET_PUBLIC(args,cache_limit)) {
+		size = trim();
+	}
+	/* The size is an estimate, as concurrent runs may race to update it.
+		It is corrected whenever the cache is trimmed */
+	file = fopen(size_file,"w");
+	if (file) {
+		fprintf(file,"%lu\n",size);
+		fclose(file);
+	}
+	free(size_file);
+}
+
+void
+cache_report(void)
+{
+	unsigned hits = GET_STATE(cache,hits);
+	unsigned looked = hits + GET_STATE(cache,misses);
+	if (GET_PUBLIC(args,cache_dir) == NULL || !looked) {
+		return;
+	}
+	report(PROGRESS_SUMMARY_CACHE,NULL,
+		"%u out of %u files were found in the output cache (%u%%); "
+		"%u files were added",
+		hits,looked,hits * 100 / looked,GET_STATE(cache,stored));
+}
+
+/* EOF */
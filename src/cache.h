@@ -0,0 +1,109 @@
+#ifndef CACHE_H
+#define CACHE_H
+/***************************************************************************
+ *   Copyright (C) 2004, 2006 Symbian Software Ltd.                        *
+ *   All rights reserved.                                                  *
+ *   Copyright (C) 2007, 2008 Mike Kinghan, imk@strudl.org                 *
+ *   All rights reserved.                                                  *
+ *                                                                         *
+ *   Contributed originally by Mike Kinghan, imk@strudl.org                *
+ *                                                                         *
+ *   Redistribution and use in source and binary forms, with or without    *
+ *   modification, are permitted provided that the following conditions    *
+ *   are met:                                                              *
+ *                                                                         *
+ *   Redistributions of source code must retain the above copyright        *
+ *   notice, this list of conditions and the following disclaimer.         *
+ *                                                                         *
+ *   Redistributions in binary form must reproduce the above copyright     *
+ *   notice, this list of conditions and the following disclaimer in the   *
+ *   documentation and/or other materials provided with the distribution.  *
+ *                                                                         *
+ *   Neither the name of Symbian Software Ltd. nor the names of its        *
+ *   contributors may be used to endorse or promote products derived from  *
+ *   this software without specific prior written permission.              *
+ *                                                                         *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS   *
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT     *
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS    *
+ *   FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE        *
+ *   COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,   *
+ *   INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,  *
+ *   BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS *
+ *   OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED    *
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,*
+ *   OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF *
+ *   THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH  *
+ *   DAMAGE.                                                               *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "opts.h"
+#include "bool.h"
+
+/*!\ingroup cache_module, cache_interface
+ *\file cache.h
+ * This file provides the Cache module interface.
+ *
+ *	When the \c --cache option is in force the Cache module keeps the
+ *	output of input files in a directory, keyed by the content of the
+ *	input and the fingerprint of the options, which covers the symbols
+ *	defined and undefined. An input file with the same content as one
+ *	processed before under the same options, by any run and from any
+ *	path, is not parsed: its output is copied from the cache.
+ *
+ *	The cache is kept within a size limit by evicting the least recently
+ *	used entries, and the hits and misses of the run are reported in the
+ *	exit summary.
+ */
+
+/*! \addtogroup cache_interface */
+/*@{*/
+
+/*! The default limit on the size of the cache, in bytes */
+#define CACHE_DEFAULT_LIMIT	(256UL << 20)
+
+/*! Look up the current source file in the cache, if the \c --cache
+	option is in force.
+
+	\return	\em true iff the output has been supplied from the cache
+	and no input is to be parsed.
+
+	Call after the source file is opened. On a miss, the output is
+	staged so that it can be entered in the cache when the file is closed.
+*/
+extern bool
+cache_open(void);
+
+/*! Finish processing the current source file, if the \c --cache option
+	is in force. Called by close_io().
+
+	\param	error	Did processing end in an error?
+
+	The staged output is delivered and, unless \em error or any
+	diagnostic was raised for the file, it is entered in the cache.
+*/
+extern void
+cache_close(bool error);
+
+/*! Account for the entries added to the cache in this run, and evict
+	the least recently used entries if the cache exceeds its size limit.
+*/
+extern void
+cache_finish(void);
+
+/*! Report the hits and misses of the cache in this run, if the
+	\c --cache option is in force.
+*/
+extern void
+cache_report(void);
+
+/*@}*/
+
+/*! \addtogroup cache_interface_state_utils */
+/*@{*/
+IMPORT_INITOR(cache);
+IMPORT_FINITOR(cache);
+/*@}*/
+
+#endif /* EOF */
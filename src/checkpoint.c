@@ -0,0 +1,701 @@
+/***************************************************************************
+ *   Copyright (C) 2004, 2006 Symbian Software Ltd.                        *
+ *   All rights reserved.                                                  *
+ *   Copyright (C) 2007, 2008 Mike Kinghan, imk@strudl.org                 *
+ *   All rights reserved.                                                  *
+ *                                                                         *
+ *   Contributed originally by Mike Kinghan, imk@strudl.org                *
+ *                                                                         *
+ *   Redistribution and use in source and binary forms, with or without    *
+ *   modification, are permitted provided that the following conditions    *
+ *   are met:                                                              *
+ *                                                                         *
+ *   Redistributions of source code must retain the above copyright        *
+ *   notice, this list of conditions and the following disclaimer.         *
+ *                                                                         *
+ *   Redistributions in binary form must reproduce the above copyright     *
+ *   notice, this list of conditions and the following disclaimer in the   *
+ *   documentation and/or other materials provided with the distribution.  *
+ *                                                                         *
+ *   Neither the name of Symbian Software Ltd. nor the names of its        *
+ *   contributors may be used to endorse or promote products derived from  *
+ *   this software without specific prior written permission.              *
+ *                                                                         *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS   *
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT     *
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS    *
+ *   FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE        *
+ *   COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,   *
+ *   INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,  *
+ *   BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS *
+ *   OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED    *
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,*
+ *   OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF *
+ *   THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH  *
+ *   DAMAGE.                                                               *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "checkpoint.h"
+#include "args.h"
+#include "io.h"
+#include "chew.h"
+#include "categorical.h"
+#include "if_control.h"
+#include "line_despatch.h"
+#include "memory.h"
+#include "report.h"
+#include "hash.h"
+#include <stdio.h>
+#include <string.h>
+
+/*!\ingroup checkpoint_module, checkpoint_interface, checkpoint_internals
+ *\file checkpoint.c
+ * This file implements the Checkpoint module.
+ *
+ *	A checkpoint is taken only at the start of a logical line where the
+ *	parse carries nothing over from earlier lines except the if-control
+ *	stack, the count of a run of dropped lines and the running totals:
+ *	i.e. outside any comment or quotation and with no contradiction
+ *	pending. The parse from a checkpoint onward is then determined by
+ *	the input from that offset onward and the state recorded.
+ *
+ *	The exit flags raised in each segment of input between checkpoints
+ *	are recorded with the checkpoint that ends it, so that the exit status
+ *	of a run that reuses saved output is the same as if the whole input
+ *	had been parsed.
+ */
+
+/*! \addtogroup checkpoint_internals */
+/*@{*/
+
+/*! The minimum number of lines between checkpoints */
+#define CHECKPOINT_LINES	128
+
+/*! The first line of a state file */
+#define CHECKPOINT_MAGIC	"sunifdef-incremental 1"
+
+/*! Mask of all exit flags */
+#define ALL_EXIT_FLAGS		(~0)
+
+/*! Structure representing a checkpoint */
+typedef struct checkpoint {
+	/*! The input offset of the next line */
+	long		in_off;
+	/*! The number of the last line read */
+	int			line_num;
+	/*! The output offset */
+	long		out_off;
+	/*! Hash of the input from the previous checkpoint */
+	hash_t		seg_hash;
+	/*! Exit flags raised since the previous checkpoint */
+	int			seg_flags;
+	/*! Count of lines dropped so far */
+	int			lines_dropped;
+	/*! Count of lines changed so far */
+	int			lines_changed;
+	/*! Count of diagnostic lines inserted so far */
+	int			lines_inserted;
+	/*! Count of contiguous lines just dropped */
+	size_t		drop_run;
+	/*! Depth of if-nesting */
+	size_t		depth;
+	/*! The if-control states */
+	if_state_t	ifstate[MAXDEPTH];
+	/*! The if-control start lines */
+	size_t		if_start_lines[MAXDEPTH];
+} checkpoint_t;
+
+/*! Structure representing the checkpoints of a run */
+typedef struct checkpoint_file {
+	/*! Array of checkpoints. The first is at the start of input */
+	checkpoint_t *cps;
+	/*! The number of checkpoints */
+	size_t		count;
+	/*! The capacity of \c cps */
+	size_t		cap;
+	/*! The size of the input */
+	long		in_size;
+	/*! Hash of the input after the last checkpoint */
+	hash_t		tail_hash;
+	/*! Exit flags raised after the last checkpoint */
+	int			tail_flags;
+	/*! Final count of lines dropped */
+	int			lines_dropped;
+	/*! Final count of lines changed */
+	int			lines_changed;
+	/*! Final count of diagnostic lines inserted */
+	int			lines_inserted;
+	/*! The state file, open to read the saved output */
+	FILE *		stream;
+	/*! Offset of the saved output in the state file */
+	long		out_at;
+	/*! Size of the saved output */
+	long		out_size;
+} checkpoint_file_t;
+
+/*@}*/
+
+/*! \addtogroup checkpoint_internals_state_utils */
+/*@{*/
+
+/*! The state of the Checkpoint module */
+STATE_DEF(checkpoint) {
+	checkpoint_file_t now;	/*!< Checkpoints of this run */
+	checkpoint_file_t then;	/*!< Checkpoints read from the state file */
+	FILE *	output;	/*!< The output stream while output is staged */
+	FILE *	hash_in;	/*!< Stream on which input is read for hashing */
+	long	hashed_to;	/*!< Offset to which \c hash_in has been read */
+	long	delta;	/*!< The input size less the size saved */
+	size_t	next_then;	/*!< Next saved checkpoint at which to resync */
+	int		flags;	/*!< Exit flags raised before the last checkpoint */
+	bool	active;	/*!< Is \c --incremental in force for this file? */
+	bool	complete;	/*!< Has all the output been supplied? */
+} STATE_T(checkpoint);
+
+NO_PUBLIC_STATE(checkpoint);
+
+IMPLEMENT(checkpoint,ZERO_INITABLE);
+/*@}*/
+
+/*! \addtogroup checkpoint_internals */
+/*@{*/
+
+/*! Return the fingerprint of the options and the input filename, which
+	are cited in diagnostic inserts.
+ */
+static hash_t
+fingerprint(void)
+{
+	return hash_str(GET_PUBLIC(args,fingerprint),GET_PUBLIC(io,filename));
+}
+
+/*! Append a checkpoint to a run and return its address */
+static checkpoint_t *
+new_checkpoint(checkpoint_file_t *cpf)
+{
+	if (cpf->count == cpf->cap) {
+		cpf->cap = cpf->cap ? cpf->cap * 2 : 64;
+		cpf->cps = reallocate(cpf->cps,cpf->cap * sizeof(checkpoint_t));
+	}
+	return &cpf->cps[cpf->count++];
+}
+
+/*! Release the resources of a run */
+static void
+discard(checkpoint_file_t *cpf)
+{
+	release((void **)&cpf->cps);
+	if (cpf->stream) {
+		fclose(cpf->stream);
+	}
+	memset(cpf,0,sizeof(*cpf));
+}
+
+/*! Copy a span of one stream to another.
+	\param	from	The stream to copy from.
+	\param	offset	The offset in \em from of the span.
+	\param	len		The length of the span.
+	\param	to		The stream to copy to.
+ */
+static void
+copy_out(FILE *from, long offset, long len, FILE *to)
+{
+	char buf[BUFSIZ];
+	if (fseek(from,offset,SEEK_SET)) {
+		bail(GRIPE_CANT_READ_INPUT,"Cannot seek in saved output");
+	}
+	while (len > 0) {
+		size_t want = len < (long)sizeof(buf) ? (size_t)len : sizeof(buf);
+		if (fread(buf,1,want,from) != want) {
+			bail(GRIPE_CANT_READ_INPUT,"Read error on saved output");
+		}
+		if (fwrite(buf,1,want,to) != want) {
+			bail(GRIPE_CANT_WRITE_FILE,"Write error on output");
+		}
+		len -= (long)want;
+	}
+}
+
+/*! Hash a span of the current source file.
+	\param	from	The offset of the start of the span.
+	\param	to		The offset of the end of the span, or -1 for
+					end of file.
+	\param	hash	Receives the hash of the span.
+	\return	\em true iff the whole span is read.
+ */
+static bool
+hash_span(long from, long to, hash_t *hash)
+{
+	char buf[BUFSIZ];
+	FILE *in = GET_STATE(checkpoint,hash_in);
+	long pos = from;
+	hash_t h = HASH_INIT;
+	if (GET_STATE(checkpoint,hashed_to) != from &&
+		fseek(in,from,SEEK_SET)) {
+		bail(GRIPE_CANT_READ_INPUT,"Cannot seek in file %s",
+			GET_PUBLIC(io,filename));
+	}
+	while (to < 0 || pos < to) {
+		size_t want = sizeof(buf);
+		size_t got;
+		if (to >= 0 && (long)want > to - pos) {
+			want = (size_t)(to - pos);
+		}
+		got = fread(buf,1,want,in);
+		if (ferror(in)) {
+			bail(GRIPE_CANT_READ_INPUT,"Read error on file %s",
+				GET_PUBLIC(io,filename));
+		}
+		h = hash_bytes(h,buf,got);
+		pos += (long)got;
+		if (got < want) {
+			break;
+		}
+	}
+	SET_STATE(checkpoint,hashed_to) = pos;
+	*hash = h;
+	return to < 0 || pos == to;
+}
+
+/*! Is the parse at a point where a checkpoint can be taken? */
+static bool
+quiescent(void)
+{
+	return GET_PUBLIC(chew,comment_state) == NO_COMMENT &&
+		GET_PUBLIC(chew,line_state) == LS_NEUTER &&
+		!in_quotation() &&
+		GET_PUBLIC(categorical,last_contradictory_undef) < 0;
+}
+
+/*! Record the parse state in a checkpoint.
+	\param	cp		The checkpoint to fill in.
+	\param	in_off	The input offset of the next line.
+
+	The exit flags raised since the previous checkpoint are moved from
+	the exit status to the checkpoint.
+ */
+static void
+snapshot(checkpoint_t *cp, long in_off)
+{
+	cp->in_off = in_off;
+	cp->line_num = GET_PUBLIC(io,line_num);
+	cp->out_off = ftell(GET_PUBLIC(io,output));
+	cp->seg_flags = get_exit_flags(ALL_EXIT_FLAGS);
+	set_exit_flags(ALL_EXIT_FLAGS,false);
+	SET_STATE(checkpoint,flags) |= cp->seg_flags;
+	cp->lines_dropped = GET_PUBLIC(line_despatch,lines_dropped);
+	cp->lines_changed = GET_PUBLIC(line_despatch,lines_changed);
+	cp->lines_inserted = GET_PUBLIC(line_despatch,lines_inserted);
+	cp->drop_run = drop_run();
+	cp->depth = if_control_save(cp->ifstate,cp->if_start_lines);
+}
+
+/*! Append a checkpoint at an input offset to this run */
+static void
+record(long in_off)
+{
+	checkpoint_file_t *now = &SET_STATE(checkpoint,now);
+	long from = now->cps[now->count - 1].in_off;
+	checkpoint_t *cp = new_checkpoint(now);
+	(void)hash_span(from,in_off,&cp->seg_hash);
+	snapshot(cp,in_off);
+}
+
+/*! Reinstate the parse state recorded in a checkpoint */
+static void
+restore(checkpoint_t const *cp)
+{
+	seek_input(cp->in_off,cp->line_num);
+	if_control_restore(cp->depth,cp->ifstate,cp->if_start_lines);
+	set_drop_run(cp->drop_run);
+	SET_PUBLIC(line_despatch,lines_dropped) = cp->lines_dropped;
+	SET_PUBLIC(line_despatch,lines_changed) = cp->lines_changed;
+	SET_PUBLIC(line_despatch,lines_inserted) = cp->lines_inserted;
+}
+
+/*! Is the parse state the same as recorded in a saved checkpoint,
+	for the purpose of the output from here on?
+ */
+static bool
+same_state(checkpoint_t const *cp)
+{
+	checkpoint_file_t const *then = &SET_STATE(checkpoint,then);
+	if_state_t ifstate[MAXDEPTH];
+	size_t start_lines[MAXDEPTH];
+	size_t depth = if_control_save(ifstate,start_lines);
+	if (depth != cp->depth || (drop_run() != 0) != (cp->drop_run != 0)) {
+		return false;
+	}
+	if (GET_PUBLIC(io,line_num) != cp->line_num &&
+		(GET_PUBLIC(args,line_directives) ||
+		then->lines_inserted != cp->lines_inserted)) {
+		/* Saved #line directives or diagnostic inserts would cite
+			the wrong line numbers */
+		return false;
+	}
+	return !memcmp(ifstate,cp->ifstate,(depth + 1) * sizeof(if_state_t));
+}
+
+/*! Read the state file saved by an earlier run.
+	\return \em true iff the state file exists, is well formed and
+	was saved with the same options.
+ */
+static bool
+load_state(void)
+{
+	checkpoint_file_t *then = &SET_STATE(checkpoint,then);
+	char magic[sizeof(CHECKPOINT_MAGIC)];
+	unsigned long saved_fingerprint, count, i;
+	FILE *in = then->stream = fopen(GET_PUBLIC(args,state_file),"rb");
+	if (in == NULL) {
+		return false;
+	}
+	if (!fgets(magic,sizeof(magic),in) || strcmp(magic,CHECKPOINT_MAGIC) ||
+		fscanf(in," fingerprint %lx",&saved_fingerprint) != 1 ||
+		saved_fingerprint != fingerprint() ||
+		fscanf(in," input %ld %lx %d",
+			&then->in_size,&then->tail_hash,&then->tail_flags) != 3 ||
+		fscanf(in," lines %d %d %d",&then->lines_dropped,
+			&then->lines_changed,&then->lines_inserted) != 3 ||
+		fscanf(in," checkpoints %lu",&count) != 1 || count == 0) {
+		return false;
+	}
+	for (i = 0; i < count; ++i) {
+		checkpoint_t *cp = new_checkpoint(then);
+		unsigned long run, depth, level;
+		if (fscanf(in," %ld %d %ld %lx %d %d %d %d %lu %lu",
+				&cp->in_off,&cp->line_num,&cp->out_off,&cp->seg_hash,
+				&cp->seg_flags,&cp->lines_dropped,&cp->lines_changed,
+				&cp->lines_inserted,&run,&depth) != 10 || depth >= MAXDEPTH) {
+			return false;
+		}
+		if (i ? cp->in_off <= cp[-1].in_off || cp->out_off < cp[-1].out_off :
+				cp->in_off != 0) {
+			return false;
+		}
+		cp->drop_run = run;
+		cp->depth = depth;
+		for (level = 0; level <= depth; ++level) {
+			int state;
+			unsigned long start_line;
+			if (fscanf(in," %d %lu",&state,&start_line) != 2 ||
+				state < 0 || state >= IS_COUNT) {
+				return false;
+			}
+			cp->ifstate[level] = state;
+			cp->if_start_lines[level] = start_line;
+		}
+	}
+	if (fscanf(in," output %ld",&then->out_size) != 1 || fgetc(in) != '\n' ||
+		then->out_size < then->cps[count - 1].out_off) {
+		return false;
+	}
+	then->out_at = ftell(in);
+	return true;
+}
+
+/*! Save the checkpoints and output of this run in the state file */
+static void
+save_state(void)
+{
+	checkpoint_file_t const *now = &SET_STATE(checkpoint,now);
+	FILE *staged = GET_PUBLIC(io,output);
+	long out_size = ftell(staged);
+	FILE *out = open_file(GET_PUBLIC(args,state_file),"wb");
+	size_t i, level;
+	fprintf(out,"%s\nfingerprint %lx\ninput %ld %lx %d\nlines %d %d %d\n"
+		"checkpoints %lu\n",
+		CHECKPOINT_MAGIC,fingerprint(),
+		now->in_size,now->tail_hash,now->tail_flags,
+		now->lines_dropped,now->lines_changed,now->lines_inserted,
+		(unsigned long)now->count);
+	for (i = 0; i < now->count; ++i) {
+		checkpoint_t const *cp = &now->cps[i];
+		fprintf(out,"%ld %d %ld %lx %d %d %d %d %lu %lu",
+			cp->in_off,cp->line_num,cp->out_off,cp->seg_hash,
+			cp->seg_flags,cp->lines_dropped,cp->lines_changed,
+			cp->lines_inserted,(unsigned long)cp->drop_run,(unsigned long)cp->depth);
+		for (level = 0; level <= cp->depth; ++level) {
+			fprintf(out," %d %lu",(int)cp->ifstate[level],
+				(unsigned long)cp->if_start_lines[level]);
+		}
+		fputc('\n',out);
+	}
+	fprintf(out,"output %ld\n",out_size);
+	copy_out(staged,0,out_size,out);
+	if (fclose(out)) {
+		bail(GRIPE_CANT_WRITE_FILE,"Write error on file %s",
+			GET_PUBLIC(args,state_file));
+	}
+}
+
+/*! Say how much of the saved input is unchanged.
+	\return	The index of the last saved checkpoint before the first
+	changed byte of input, or the number of saved checkpoints if the
+	input is unchanged.
+ */
+static size_t
+unchanged_prefix(void)
+{
+	checkpoint_file_t const *then = &SET_STATE(checkpoint,then);
+	size_t i;
+	hash_t hash;
+	for (i = 1; i < then->count; ++i) {
+		if (!hash_span(then->cps[i - 1].in_off,then->cps[i].in_off,&hash) ||
+			hash != then->cps[i].seg_hash) {
+			return i - 1;
+		}
+	}
+	if (hash_span(then->cps[i - 1].in_off,-1,&hash) &&
+		hash == then->tail_hash &&
+		GET_STATE(checkpoint,hashed_to) == then->in_size) {
+		return then->count;
+	}
+	return then->count - 1;
+}
+
+/*! Say whether the input from a saved checkpoint onward is unchanged,
+	allowing for the change in the size of input.
+	\param	j	The index of the saved checkpoint.
+
+	If not, the next saved checkpoint at which the parse may resync is
+	the one that ends the first changed segment of input.
+ */
+static bool
+unchanged_suffix(size_t j)
+{
+	checkpoint_file_t const *then = &SET_STATE(checkpoint,then);
+	long delta = GET_STATE(checkpoint,delta);
+	size_t k;
+	hash_t hash;
+	for (k = j + 1; k < then->count; ++k) {
+		if (!hash_span(then->cps[k - 1].in_off + delta,
+				then->cps[k].in_off + delta,&hash) ||
+			hash != then->cps[k].seg_hash) {
+			SET_STATE(checkpoint,next_then) = k;
+			return false;
+		}
+	}
+	if (hash_span(then->cps[k - 1].in_off + delta,-1,&hash) &&
+		hash == then->tail_hash &&
+		GET_STATE(checkpoint,hashed_to) == then->in_size + delta) {
+		return true;
+	}
+	SET_STATE(checkpoint,next_then) = then->count;
+	return false;
+}
+
+/*! Is the parse in step with a saved checkpoint?
+	\param	in_off	The input offset of the next line.
+	\return	The index of the saved checkpoint, or the number of
+	saved checkpoints if none.
+ */
+static size_t
+in_step(long in_off)
+{
+	checkpoint_file_t const *then = &SET_STATE(checkpoint,then);
+	long delta = GET_STATE(checkpoint,delta);
+	size_t j = GET_STATE(checkpoint,next_then);
+	for (	;j < then->count && then->cps[j].in_off + delta < in_off; ++j) {}
+	SET_STATE(checkpoint,next_then) = j;
+	if (j < then->count && then->cps[j].in_off + delta == in_off &&
+		same_state(&then->cps[j])) {
+		return j;
+	}
+	return then->count;
+}
+
+/*! Complete the output with the saved output from a saved checkpoint
+	with which the parse is in step at the last checkpoint of this run.
+	\param	j	The index of the saved checkpoint.
+
+	The saved checkpoints after \em j are appended to this run, shifted
+	by the differences in offsets and line numbers. The start line of an
+	\c #if that was already open at checkpoint \em j is taken from this
+	run.
+ */
+static void
+splice(size_t j)
+{
+	checkpoint_file_t *now = &SET_STATE(checkpoint,now);
+	checkpoint_file_t const *then = &SET_STATE(checkpoint,then);
+	checkpoint_t const *at = &then->cps[j];
+	checkpoint_t here = now->cps[now->count - 1];
+	long in_delta = GET_STATE(checkpoint,delta);
+	long out_delta = here.out_off - at->out_off;
+	int line_delta = here.line_num - at->line_num;
+	size_t k, level;
+
+	report(PROGRESS_SPLICING,NULL,
+		"Reusing saved output of \"%s\" after line %d",
+		GET_PUBLIC(io,filename),here.line_num);
+	copy_out(then->stream,then->out_at + at->out_off,
+		then->out_size - at->out_off,GET_PUBLIC(io,output));
+	for (k = j + 1; k < then->count; ++k) {
+		checkpoint_t *cp = new_checkpoint(now);
+		*cp = then->cps[k];
+		cp->in_off += in_delta;
+		cp->line_num += line_delta;
+		cp->out_off += out_delta;
+		cp->lines_dropped += here.lines_dropped - at->lines_dropped;
+		cp->lines_changed += here.lines_changed - at->lines_changed;
+		cp->lines_inserted += here.lines_inserted - at->lines_inserted;
+		for (level = 0; level <= cp->depth; ++level) {
+			if (level <= at->depth &&
+				cp->if_start_lines[level] == at->if_start_lines[level]) {
+				cp->if_start_lines[level] = here.if_start_lines[level];
+			}
+			else {
+				cp->if_start_lines[level] += line_delta;
+			}
+		}
+		SET_STATE(checkpoint,flags) |= cp->seg_flags;
+	}
+	now->tail_hash = then->tail_hash;
+	now->tail_flags = then->tail_flags;
+	now->in_size = then->in_size + in_delta;
+	SET_STATE(checkpoint,flags) |= then->tail_flags;
+	SET_PUBLIC(line_despatch,lines_dropped) +=
+		then->lines_dropped - at->lines_dropped;
+	SET_PUBLIC(line_despatch,lines_changed) +=
+		then->lines_changed - at->lines_changed;
+	SET_PUBLIC(line_despatch,lines_inserted) +=
+		then->lines_inserted - at->lines_inserted;
+	SET_STATE(checkpoint,complete) = true;
+}
+
+/*! Write the staged output to the output stream and reinstate
+	the exit flags raised before the last checkpoint.
+ */
+static void
+deliver(void)
+{
+	FILE *staged = GET_PUBLIC(io,output);
+	copy_out(staged,0,ftell(staged),GET_STATE(checkpoint,output));
+	fclose(staged);
+	SET_PUBLIC(io,output) = GET_STATE(checkpoint,output);
+	set_exit_flags(GET_STATE(checkpoint,flags),true);
+}
+
+/*@}*/
+
+/* API ***************************************************************/
+
+void
+checkpoint_open(void)
+{
+	checkpoint_file_t *then = &SET_STATE(checkpoint,then);
+	size_t resume, i;
+
+	if (GET_PUBLIC(args,state_file) == NULL) {
+		return;
+	}
+	SET_STATE(checkpoint,output) = GET_PUBLIC(io,output);
+	SET_PUBLIC(io,output) = tmpfile();
+	if (GET_PUBLIC(io,output) == NULL) {
+		bail(GRIPE_NO_TEMPFILE,"Cannot create temporary file");
+	}
+	SET_STATE(checkpoint,active) = true;
+	SET_STATE(checkpoint,complete) = false;
+	SET_STATE(checkpoint,hash_in) = open_file(GET_PUBLIC(io,filename),"r");
+	SET_STATE(checkpoint,hashed_to) = 0;
+	SET_STATE(checkpoint,flags) = 0;
+	snapshot(new_checkpoint(&SET_STATE(checkpoint,now)),0);
+	SET_STATE(checkpoint,now).cps[0].seg_hash = HASH_INIT;
+	if (!load_state()) {
+		discard(then);
+		return;
+	}
+	resume = unchanged_prefix();
+	if (resume == then->count) {
+		SET_STATE(checkpoint,delta) = 0;
+		splice(0);
+		return;
+	}
+	if (resume > 0) {
+		checkpoint_t const *at = &then->cps[resume];
+		report(PROGRESS_RESUMING,NULL,"Resuming \"%s\" after line %d",
+			GET_PUBLIC(io,filename),at->line_num);
+		restore(at);
+		copy_out(then->stream,then->out_at,at->out_off,GET_PUBLIC(io,output));
+		for (i = 1; i <= resume; ++i) {
+			*new_checkpoint(&SET_STATE(checkpoint,now)) = then->cps[i];
+			SET_STATE(checkpoint,flags) |= then->cps[i].seg_flags;
+		}
+	}
+	if (fseek(GET_STATE(checkpoint,hash_in),0,SEEK_END)) {
+		bail(GRIPE_CANT_READ_INPUT,"Cannot seek in file %s",
+			GET_PUBLIC(io,filename));
+	}
+	SET_STATE(checkpoint,hashed_to) = ftell(GET_STATE(checkpoint,hash_in));
+	SET_STATE(checkpoint,delta) = GET_STATE(checkpoint,hashed_to) -
+									then->in_size;
+	SET_STATE(checkpoint,next_then) = resume + 1;
+}
+
+bool
+checkpoint_line(void)
+{
+	checkpoint_file_t const *now = &SET_STATE(checkpoint,now);
+	bool due;
+	long in_off;
+	size_t j;
+
+	if (!GET_STATE(checkpoint,active)) {
+		return false;
+	}
+	if (GET_STATE(checkpoint,complete)) {
+		return true;
+	}
+	if (!quiescent()) {
+		return false;
+	}
+	due = GET_PUBLIC(io,line_num) - now->cps[now->count - 1].line_num >=
+			CHECKPOINT_LINES;
+	if (!due &&
+		GET_STATE(checkpoint,next_then) >= GET_STATE(checkpoint,then).count) {
+		return false;
+	}
+	in_off = input_offset();
+	j = in_step(in_off);
+	if (j < GET_STATE(checkpoint,then).count) {
+		record(in_off);
+		if (unchanged_suffix(j)) {
+			splice(j);
+			return true;
+		}
+	}
+	else if (due) {
+		record(in_off);
+	}
+	return false;
+}
+
+void
+checkpoint_close(bool error)
+{
+	checkpoint_file_t *now = &SET_STATE(checkpoint,now);
+	if (!GET_STATE(checkpoint,active)) {
+		return;
+	}
+	SET_STATE(checkpoint,active) = false;
+	discard(&SET_STATE(checkpoint,then));
+	if (!GET_STATE(checkpoint,complete)) {
+		(void)hash_span(now->cps[now->count - 1].in_off,-1,&now->tail_hash);
+		now->in_size = GET_STATE(checkpoint,hashed_to);
+		now->tail_flags = get_exit_flags(ALL_EXIT_FLAGS);
+	}
+	now->lines_dropped = GET_PUBLIC(line_despatch,lines_dropped);
+	now->lines_changed = GET_PUBLIC(line_despatch,lines_changed);
+	now->lines_inserted = GET_PUBLIC(line_despatch,lines_inserted);
+	if (!error) {
+		save_state();
+	}
+	deliver();
+	discard(now);
+	fclose(GET_STATE(checkpoint,hash_in));
+	SET_STATE(checkpoint,hash_in) = NULL;
+}
+
+/* EOF */
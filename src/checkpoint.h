@@ -0,0 +1,106 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+/***************************************************************************
+ *   Copyright (C) 2004, 2006 Symbian Software Ltd.                        *
+ *   All rights reserved.                                                  *
+ *   Copyright (C) 2007, 2008 Mike Kinghan, imk@strudl.org                 *
+ *   All rights reserved.                                                  *
+ *                                                                         *
+ *   Contributed originally by Mike Kinghan, imk@strudl.org                *
+ *                                                                         *
+ *   Redistribution and use in source and binary forms, with or without    *
+ *   modification, are permitted provided that the following conditions    *
+ *   are met:                                                              *
+ *                                                                         *
+ *   Redistributions of source code must retain the above copyright        *
+ *   notice, this list of conditions and the following disclaimer.         *
+ *                                                                         *
+ *   Redistributions in binary form must reproduce the above copyright     *
+ *   notice, this list of conditions and the following disclaimer in the   *
+ *   documentation and/or other materials provided with the distribution.  *
+ *                                                                         *
+ *   Neither the name of Symbian Software Ltd. nor the names of its        *
+ *   contributors may be used to endorse or promote products derived from  *
+ *   this software without specific prior written permission.              *
+ *                                                                         *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS   *
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT     *
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS    *
+ *   FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE        *
+ *   COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,   *
+ *   INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,  *
+ *   BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS *
+ *   OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED    *
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,*
+ *   OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF *
+ *   THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH  *
+ *   DAMAGE.                                                               *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "opts.h"
+#include "bool.h"
+
+/*!\ingroup checkpoint_module, checkpoint_interface
+ *\file checkpoint.h
+ * This file provides the Checkpoint module interface.
+ *
+ *	When the \c --incremental option is in force the Checkpoint module
+ *	records the state of the parse at intervals, together with
+ *	the input offset, the output offset and a hash of the input
+ *	consumed since the previous checkpoint. These checkpoints and the
+ *	output are saved in the state file named by the option.
+ *
+ *	On a later run with the same options, the parse of the input file
+ *	resumes from the last checkpoint before the first changed byte,
+ *	reusing the saved output up to that checkpoint. Thereafter, when the
+ *	parse reaches the shifted offset of a saved checkpoint in the state
+ *	recorded there, and all the input beyond is unchanged, the rest of
+ *	the saved output is spliced into the new output and the parse stops.
+ */
+
+/*! \addtogroup checkpoint_interface */
+/*@{*/
+
+/*! Prepare to process the current source file incrementally, if the
+	\c --incremental option is in force.
+
+	Call after the source file is opened and the parse state reset. If
+	the state file holds checkpoints of the same input file under the
+	same options, then the parse state is restored from the last
+	checkpoint before any change and the saved output up to that
+	checkpoint is written.
+*/
+extern void
+checkpoint_open(void);
+
+/*! Record a checkpoint at the start of a logical line if one is due, and
+	splice the saved output if the parse is back in step with it.
+
+	\return \em true iff the rest of the output has been supplied and no
+	more input is to be parsed.
+*/
+extern bool
+checkpoint_line(void);
+
+/*! Finish processing the current source file incrementally. Called
+	by close_io().
+
+	\param	error	Did processing end in an error?
+
+	The output is delivered and, unless \em error, the checkpoints and
+	output are saved in the state file.
+*/
+extern void
+checkpoint_close(bool error);
+
+/*@}*/
+
+/*! \addtogroup checkpoint_interface_state_utils */
+/*@{*/
+IMPORT_INITOR(checkpoint);
+IMPORT_FINITOR(checkpoint);
+/*@}*/
+
+#endif /* EOF */
@@ -63,13 +63,45 @@ STATE_DEF(chew) {
 	bool		escape;	/*!< Last char read was escape? */
 	bool		in_double_quote; /*!< Are we reading within double quotes? */
 	bool		in_single_quote; /*!< Are we reading within single quotes? */
+	char *		(*lexer)(char *);
+		/*!< Pointer to the lexer for the current source file. Will
+			address chew_on_lf() if the file has only Unix line-ends,
+			otherwise chew_on_general() */
 } STATE_T(chew);
 
 /*@}*/
 
+/*! \addtogroup chew_internals */
+/*@{*/
+
+/*! Lexer for source files with any line-end convention.
+	\param	cp	The current text pointer
+	\return A pointer to the next input character that is not to be chewed.
+ */
+static char *
+chew_on_general(char *cp);
+
+/*! Lexer specialised for source files with only Unix line-ends.
+	\param	cp	The current text pointer
+	\return A pointer to the next input character that is not to be chewed.
+
+	This function does the same work as chew_on_general() but does not
+	test for Windows line-ends. If the I/O module reports that a
+	Windows line-end has been read the function hands over to
+	chew_on_general() for the rest of the file.
+ */
+static char *
+chew_on_lf(char *cp);
+
+/*@}*/
+
 /*! \addtogroup chew_internals_state_utils */
 /*@{*/
-IMPLEMENT(chew,ZERO_INITABLE)
+IMPLEMENT(chew,STATIC_INITABLE);
+
+USE_STATIC_INITIALISER(chew) = {
+	{ NO_COMMENT, LS_NEUTER, 0, 0 }, false, false, false, chew_on_general
+};
 /*@}*/
 
 /*! \ingroup chew_internals */
@@ -113,6 +145,213 @@ chew_continuation(char *cp)
 }
 
 
+/*! The body of the lexers.
+	\param	cp		The current text pointer, which is advanced
+	\param	crlf	Are Windows line-ends to be recognised? If false, only
+					Unix line-ends are, and lexing is handed over to
+					chew_on_general() as soon as the I/O module reports
+					that a Windows line-end has been read.
+
+	This is a macro rather than a function so that each lexer expands it
+	with a constant \c crlf and the Unix lexer does not test for \c '\\r'.
+ */
+#define CHEW_LINES(cp,crlf) \
+	while (*cp != '\0') { \
+		if (cp[0] == '\\') {	/* Toggle escape state */ \
+			SET_STATE(chew,escape) = !GET_STATE(chew,escape); \
+			++cp; \
+			continue; \
+		} \
+		if (cp[0] == '"') { \
+			if (!GET_STATE(chew,escape) && !GET_STATE(chew,in_single_quote)) { \
+				/* 	Can enter a double-quote state if we are not escaped and \
+					not already in a single quote */ \
+				if ((SET_STATE(chew,in_double_quote) = \
+						!GET_STATE(chew,in_double_quote)) == true) { \
+					SET_PUBLIC(chew,last_quote_start_line) = \
+						GET_PUBLIC(io,line_num); \
+				} \
+			} \
+			++cp; \
+		} \
+		else if (cp[0] == '\'') { \
+				/* 	Can enter a single-quote state if we are not escaped and \
+					not already in a double quote */ \
+			if (!GET_STATE(chew,escape) && !GET_STATE(chew,in_double_quote)) { \
+				if ((SET_STATE(chew,in_single_quote) = \
+					!GET_STATE(chew,in_single_quote)) == true) { \
+					SET_PUBLIC(chew,last_quote_start_line) = \
+						GET_PUBLIC(io,line_num); \
+				} \
+			} \
+			++cp; \
+		} \
+		else if (crlf ? EOL(cp) : cp[0] == '\n') { /* Newline */ \
+			if (GET_STATE(chew,escape)) { \
+				/* Extend line buffer following line-continuation */ \
+				cp = read_more(cp); \
+				/* don't reset to LS_NEUTER after a line continuation */ \
+			} \
+			else {	/* Plain newline */ \
+				SET_PUBLIC(chew,line_state) = LS_NEUTER; \
+				if (GET_PUBLIC(chew,comment_state) == CXX_COMMENT || \
+					 GET_PUBLIC(chew,comment_state) == PSEUDO_COMMENT) { \
+					/* Newline terminates C++ comment */ \
+					SET_PUBLIC(chew,comment_state) = NO_COMMENT; \
+					SET_STATE(chew,in_double_quote) = \
+						SET_STATE(chew,in_single_quote) = false; \
+				} \
+				else if (GET_PUBLIC(chew,comment_state) == C_COMMENT) { \
+					SET_STATE(chew,in_double_quote) = \
+						SET_STATE(chew,in_single_quote) = false; \
+					++SET_PUBLIC(io,extension_lines); \
+					cp = read_more(cp); \
+				} \
+				else if (GET_STATE(chew,in_double_quote) || \
+					GET_STATE(chew,in_single_quote)) { \
+					/* Dangling quotation is not in comment. Error */ \
+					parse_error(GRIPE_NEWLINE_IN_QUOTE, \
+						"Newline within quotation"); \
+				} \
+			} \
+			if (crlf && *cp == '\r') { \
+				/* Detected Windows line-end in Unix environment */ \
+				++cp; \
+			} \
+			++cp; \
+			if (!crlf && !GET_PUBLIC(io,lf_only)) { \
+				/* The line just read has a Windows line-end */ \
+				SET_STATE(chew,escape) = false; \
+				SET_STATE(chew,lexer) = chew_on_general; \
+				return chew_on_general(cp); \
+			} \
+		} \
+		else if (cp[0] == ' ' || cp[0] == '\t') { /* Some whitespace */ \
+			++cp; \
+		} \
+		/* Could be at the start or end of a comment */ \
+		else if (GET_PUBLIC(chew,comment_state) == NO_COMMENT || \
+			GET_PUBLIC(chew,comment_state) == PSEUDO_COMMENT) { \
+			/* Not in C or C++ comment */ \
+			/* Check for start of comment */ \
+			if (!GET_STATE(chew,in_double_quote) && \
+				!GET_STATE(chew,in_single_quote)) { \
+				/* Don't let comments start within quotation */ \
+				if (!strncmp(cp, "/\\\n",3)) { \
+					SET_PUBLIC(chew,comment_state) = STARTING_COMMENT; \
+					SET_PUBLIC(chew,last_comment_start_line) = \
+						GET_PUBLIC(io,line_num); \
+					cp += 3; \
+				} \
+				if (crlf && !strncmp(cp, "/\\\r\n",4)) { \
+					SET_PUBLIC(chew,comment_state) = STARTING_COMMENT; \
+					SET_PUBLIC(chew,last_comment_start_line) = \
+						GET_PUBLIC(io,line_num); \
+					cp += 4; \
+				} \
+				else if (cp[0] == '/' && cp[1] == '*') { \
+					SET_PUBLIC(chew,comment_state) = C_COMMENT; \
+					SET_PUBLIC(chew,last_comment_start_line) = \
+						GET_PUBLIC(io,line_num); \
+					cp += 2; \
+				} \
+				else if (cp[0] == '/' && cp[1] == cp[0]) { \
+					SET_PUBLIC(chew,comment_state) = CXX_COMMENT; \
+					SET_PUBLIC(chew,last_comment_start_line) = \
+						GET_PUBLIC(io,line_num); \
+					cp += 2; \
+				} \
+				else if (GET_PUBLIC(chew,comment_state) == PSEUDO_COMMENT) { \
+					/* Inside #error text. Truck on */ \
+					++cp; \
+				} \
+				else { /* No comment starting. We're done */ \
+					SET_STATE(chew,escape) = false; \
+					break; \
+				} \
+			} \
+			else {	/* We're inside quotation. Truck on */ \
+				++cp; \
+			} \
+		} \
+		/* We are in a comment state. Check for end of comment */ \
+		/* No need to test for end of C++ comment 'cos newline case \
+			covers it */ \
+		else if (GET_PUBLIC(chew,comment_state) == C_COMMENT) { \
+			if (!strncmp(cp, "*\\\n",3)) { \
+				SET_PUBLIC(chew,comment_state) = FINISHING_COMMENT; \
+				cp += 3; \
+			} \
+			if (crlf && !strncmp(cp, "*\\\r\n",4)) { \
+				SET_PUBLIC(chew,comment_state) = FINISHING_COMMENT; \
+				cp += 4; \
+			} \
+			else if (cp[0] == '*' && cp[1] == '/') { \
+				SET_PUBLIC(chew,comment_state) = NO_COMMENT; \
+				SET_STATE(chew,in_double_quote) = \
+					SET_STATE(chew,in_single_quote) = false; \
+				cp += 2; \
+			} \
+			else { \
+				++cp; \
+			} \
+		} \
+		else if (GET_PUBLIC(chew,comment_state) == STARTING_COMMENT) { \
+			if (*cp == '*') { \
+				SET_PUBLIC(chew,comment_state) = C_COMMENT; \
+				++cp; \
+			} \
+			else if (*cp == '/') { \
+				SET_PUBLIC(chew,comment_state) = CXX_COMMENT; \
+				++cp; \
+			} \
+			else { \
+				SET_PUBLIC(chew,comment_state) = NO_COMMENT; \
+				SET_PUBLIC(chew,line_state) = LS_CODE; \
+			} \
+		} \
+		else if (GET_PUBLIC(chew,comment_state) == FINISHING_COMMENT) { \
+			if (*cp == '/') { \
+				SET_PUBLIC(chew,comment_state) = NO_COMMENT; \
+				++cp; \
+			} \
+			else { \
+				SET_PUBLIC(chew,comment_state) = C_COMMENT; \
+			} \
+		} \
+		else { \
+			++cp; \
+		} \
+		SET_STATE(chew,escape) = false; \
+	}
+
+static char *
+chew_on_general(char *cp)
+{
+	if (GET_PUBLIC(args,plaintext)) {
+		for (; isspace((unsigned char)*cp); ++cp) {
+			if (EOL(cp)) {
+				SET_PUBLIC(chew,line_state) = LS_NEUTER;
+			}
+		}
+		return (cp);
+	}
+	CHEW_LINES(cp,true);
+	return cp;
+}
+
+static char *
+chew_on_lf(char *cp)
+{
+	if (!GET_PUBLIC(io,lf_only)) {
+		/* A Windows line-end has been read since the last call */
+		SET_STATE(chew,lexer) = chew_on_general;
+		return chew_on_general(cp);
+	}
+	CHEW_LINES(cp,false);
+	return cp;
+}
+
 /* API ***************************************************************/
 
 bool
@@ -141,177 +380,7 @@ chew_str(char *cp)
 char *
 chew_on(char *cp)
 {
-	if (GET_PUBLIC(args,plaintext)) {
-		for (; isspace((unsigned char)*cp); ++cp) {
-			if (EOL(cp)) {
-				SET_PUBLIC(chew,line_state) = LS_NEUTER;
-			}
-		}
-		return (cp);
-	}
-	while (*cp != '\0') {
-		if (cp[0] == '\\') {	/* Toggle escape state */
-			SET_STATE(chew,escape) = !GET_STATE(chew,escape);
-			++cp;
-			continue;
-		}
-		if (cp[0] == '"') {
-			if (!GET_STATE(chew,escape) && !GET_STATE(chew,in_single_quote)) {
-				/* 	Can enter a double-quote state if we are not escaped and
-					not already in a single quote */
-				if ((SET_STATE(chew,in_double_quote) =
-						!GET_STATE(chew,in_double_quote)) == true) {
-					SET_PUBLIC(chew,last_quote_start_line) =
-						GET_PUBLIC(io,line_num);
-				}
-			}
-			++cp;
-		}
-		else if (cp[0] == '\'') {
-				/* 	Can enter a single-quote state if we are not escaped and
-					not already in a double quote */
-			if (!GET_STATE(chew,escape) && !GET_STATE(chew,in_double_quote)) {
-				if ((SET_STATE(chew,in_single_quote) =
-					!GET_STATE(chew,in_single_quote)) == true) {
-					SET_PUBLIC(chew,last_quote_start_line) =
-						GET_PUBLIC(io,line_num);
-				}
-			}
-			++cp;
-		}
-		else if (EOL(cp)) { /* Newline */
-			if (GET_STATE(chew,escape)) {
-				/* Extend line buffer following line-continuation */
-				cp = read_more(cp);
-				/* don't reset to LS_NEUTER after a line continuation */
-			}
-			else {	/* Plain newline */
-				SET_PUBLIC(chew,line_state) = LS_NEUTER;
-				if (GET_PUBLIC(chew,comment_state) == CXX_COMMENT ||
-					 GET_PUBLIC(chew,comment_state) == PSEUDO_COMMENT) {
-					/* Newline terminates C++ comment */
-					SET_PUBLIC(chew,comment_state) = NO_COMMENT;
-					SET_STATE(chew,in_double_quote) =
-						SET_STATE(chew,in_single_quote) = false;
-				}
-				else if (GET_PUBLIC(chew,comment_state) == C_COMMENT) {
-					SET_STATE(chew,in_double_quote) =
-						SET_STATE(chew,in_single_quote) = false;
-					++SET_PUBLIC(io,extension_lines);
-					cp = read_more(cp);
-				}
-				else if (GET_STATE(chew,in_double_quote) ||
-					GET_STATE(chew,in_single_quote)) {
-					/* Dangling quotation is not in comment. Error */
-					parse_error(GRIPE_NEWLINE_IN_QUOTE,
-						"Newline within quotation");
-				}
-			}
-			if (*cp == '\r') {
-				/* Detected Windows line-end in Unix environment */
-				++cp;
-			}
-			++cp;
-		}
-		else if (cp[0] == ' ' || cp[0] == '\t') { /* Some whitespace */
-			++cp;
-		}
-		/* Could be at the start or end of a comment */
-		else if (GET_PUBLIC(chew,comment_state) == NO_COMMENT ||
-			GET_PUBLIC(chew,comment_state) == PSEUDO_COMMENT) {
-			/* Not in C or C++ comment */
-			/* Check for start of comment */
-			if (!GET_STATE(chew,in_double_quote) &&
-				!GET_STATE(chew,in_single_quote)) {
-				/* Don't let comments start within quotation */
-				if (!strncmp(cp, "/\\\n",3)) {
-					SET_PUBLIC(chew,comment_state) = STARTING_COMMENT;
-					SET_PUBLIC(chew,last_comment_start_line) =
-						GET_PUBLIC(io,line_num);
-					cp += 3;
-				}
-				if (!strncmp(cp, "/\\\r\n",4)) {
-					SET_PUBLIC(chew,comment_state) = STARTING_COMMENT;
-					SET_PUBLIC(chew,last_comment_start_line) =
-						GET_PUBLIC(io,line_num);
-					cp += 4;
-				}
-				else if (cp[0] == '/' && cp[1] == '*') {
-					SET_PUBLIC(chew,comment_state) = C_COMMENT;
-					SET_PUBLIC(chew,last_comment_start_line) =
-						GET_PUBLIC(io,line_num);
-					cp += 2;
-				}
-				else if (cp[0] == '/' && cp[1] == cp[0]) {
-					SET_PUBLIC(chew,comment_state) = CXX_COMMENT;
-					SET_PUBLIC(chew,last_comment_start_line) =
-						GET_PUBLIC(io,line_num);
-					cp += 2;
-				}
-				else if (GET_PUBLIC(chew,comment_state) == PSEUDO_COMMENT) {
-					/* Inside #error text. Truck on */
-					++cp;
-				}
-				else { /* No comment starting. We're done */
-					SET_STATE(chew,escape) = false;
-					break;
-				}
-			}
-			else {	/* We're inside quotation. Truck on */
-				++cp;
-			}
-		}
-		/* We are in a comment state. Check for end of comment */
-		/* No need to test for end of C++ comment 'cos newline case
-			covers it */
-		else if (GET_PUBLIC(chew,comment_state) == C_COMMENT) {
-			if (!strncmp(cp, "*\\\n",3)) {
-				SET_PUBLIC(chew,comment_state) = FINISHING_COMMENT;
-				cp += 3;
-			}
-			if (!strncmp(cp, "*\\\r\n",4)) {
-				SET_PUBLIC(chew,comment_state) = FINISHING_COMMENT;
-				cp += 4;
-			}
-			else if (cp[0] == '*' && cp[1] == '/') {
-				SET_PUBLIC(chew,comment_state) = NO_COMMENT;
-				SET_STATE(chew,in_double_quote) =
-					SET_STATE(chew,in_single_quote) = false;
-				cp += 2;
-			}
-			else {
-				++cp;
-			}
-		}
-		else if (GET_PUBLIC(chew,comment_state) == STARTING_COMMENT) {
-			if (*cp == '*') {
-				SET_PUBLIC(chew,comment_state) = C_COMMENT;
-				++cp;
-			}
-			else if (*cp == '/') {
-				SET_PUBLIC(chew,comment_state) = CXX_COMMENT;
-				++cp;
-			}
-			else {
-				SET_PUBLIC(chew,comment_state) = NO_COMMENT;
-				SET_PUBLIC(chew,line_state) = LS_CODE;
-			}
-		}
-		else if (GET_PUBLIC(chew,comment_state) == FINISHING_COMMENT) {
-			if (*cp == '/') {
-				SET_PUBLIC(chew,comment_state) = NO_COMMENT;
-				++cp;
-			}
-			else {
-				SET_PUBLIC(chew,comment_state) = C_COMMENT;
-			}
-		}
-		else {
-			++cp;
-		}
-		SET_STATE(chew,escape) = false;
-	}
-	return cp;
+	return GET_STATE(chew,lexer)(cp);
 }
 
 void
@@ -321,6 +390,9 @@ chew_toplevel(void)
 	SET_PUBLIC(chew,comment_state) = NO_COMMENT;
 	SET_STATE(chew,in_double_quote) = false;
 	SET_STATE(chew,in_double_quote) = false;
+	SET_STATE(chew,lexer) =
+		GET_PUBLIC(io,lf_only) && !GET_PUBLIC(args,plaintext) ?
+			chew_on_lf : chew_on_general;
 }
 
 /* EOF */
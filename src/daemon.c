@@ -0,0 +1,631 @@
+/***************************************************************************
+ *   Copyright (C) 2004, 2006 Symbian Software Ltd.                        *
+ *   All rights reserved.                                                  *
+ *   Copyright (C) 2007, 2008 Mike Kinghan, imk@strudl.org                 *
+ *   All rights reserved.                                                  *
+ *                                                                         *
+ *   Contributed originally by Mike Kinghan, imk@strudl.org                *
+ *                                                                         *
+ *   Redistribution and use in source and binary forms, with or without    *
+ *   modification, are permitted provided that the following conditions    *
+ *   are met:                                                              *
+ *                                                                         *
+ *   Redistributions of source code must retain the above copyright        *
+ *   notice, this list of conditions and the following disclaimer.         *
+ *                                                                         *
+ *   Redistributions in binary form must reproduce the above copyright     *
+ *   notice, this list of conditions and the following disclaimer in the   *
+ *   documentation and/or other materials provided with the distribution.  *
+ *                                                                         *
+ *   Neither the name of Symbian Software Ltd. nor the names of its        *
+ *   contributors may be used to endorse or promote products derived from  *
+ *   this software without specific prior written permission.              *
+ *                                                                         *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS   *
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT     *
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS    *
+ *   FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE        *
+ *   COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,   *
+ *   INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,  *
+ *   BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS *
+ *   OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED    *
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,*
+ *   OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF *
+ *   THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH  *
+ *   DAMAGE.                                                               *
+ *                                                                         *
+ ***************************************************************************/
+#include "daemon.h"
+#include "args.h"
+#include "dataset.h"
+#include "exception.h"
+#include "filesys.h"
+#include "io.h"
+#include "line_despatch.h"
+#include "memory.h"
+#include "platform.h"
+#include "process.h"
+#include "report.h"
+#include "thread.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef UNIX
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <time.h>
+#endif
+
+/*!\ingroup daemon_module, daemon_interface, daemon_internals
+ *\file daemon.c
+ * This file implements the Daemon module.
+ *
+ *	A client keeps one connection to the daemon for the run and sends a
+ *	request for each input file: a \c request_t followed by the name of
+ *	the file, for diagnostics, and a body that is either the absolute
+ *	name of the file, which the daemon reads, or the contents of the
+ *	standard input. The daemon answers each request with a \c reply_t
+ *	followed by the output and the diagnostics. The client and the daemon
+ *	are the same program on the same host, so the headers are sent as
+ *	they are in memory.
+ *
+ *	The daemon parses its options and symbols before forking its workers,
+ *	so that every worker starts warm. The workers accept connections on
+ *	the same socket, and each serves one client at a time. A worker
+ *	processes each file afresh as the \c libsunifdef library does, with
+ *	errors and abends caught, so that a bad file or a bad request only
+ *	fails its request. A worker that exits is replaced.
+ */
+
+/*! \addtogroup daemon_internals */
+/*@{*/
+
+/*! Mask of all exit flags */
+#define ALL_EXIT_FLAGS		(~0)
+
+/*! The longest name of an input file that a daemon accepts */
+#define MAX_NAME_LEN		4096
+
+/*! The longest contents of an input that a daemon accepts */
+#define MAX_DATA_LEN		((size_t)1 << 28)
+
+/*! The least number of seconds for which a worker is to run before
+	it is replaced without a pause */
+#define MIN_WORKER_LIFE		1
+
+/*! Kinds of request sent by a client */
+typedef enum {
+	REQUEST_PATH = 'F',	/*!< The body is the absolute name of the file */
+	REQUEST_DATA = 'D'	/*!< The body is the contents of the input */
+} request_kind_t;
+
+/*! Header of a request sent by a client */
+typedef struct request {
+	int		kind;		/*!< The \c request_kind_t of the request */
+	size_t	name_len;	/*!< The length of the name that follows */
+	size_t	body_len;	/*!< The length of the body that follows the name */
+} request_t;
+
+/*! Header of a reply sent by a daemon */
+typedef struct reply {
+	int		error;
+		/*!< 0, or the reason code of the error that abandoned the input */
+	int		flags;		/*!< The exit flags raised by the input */
+	int		lines_dropped;	/*!< The number of lines dropped */
+	int		lines_changed;	/*!< The number of lines changed */
+	int		lines_inserted;	/*!< The number of lines inserted */
+	size_t	output_len;	/*!< The length of the output that follows */
+	size_t	diagnostics_len;
+		/*!< The length of the diagnostics that follow the output */
+} reply_t;
+
+/*@}*/
+
+/*! \addtogroup daemon_internals_state_utils */
+/*@{*/
+
+/*! The state of the Daemon module */
+STATE_DEF(daemon) {
+	int		socket;		/*!< The connection of a client to the daemon */
+	bool	connected;	/*!< Is \c socket connected? */
+} STATE_T(daemon);
+
+NO_PUBLIC_STATE(daemon);
+
+IMPLEMENT(daemon,ZERO_INITABLE);
+/*@}*/
+
+#ifdef UNIX
+
+/*! \addtogroup daemon_internals */
+/*@{*/
+
+/*! Set when the daemon is to stop serving */
+static volatile sig_atomic_t stopping;
+
+/*! Signal handler that stops the daemon */
+static void
+stop(int signum)
+{
+	(void)signum;
+	stopping = 1;
+}
+
+/*! Write a whole buffer to a socket.
+	\return	True iff the buffer is written.
+*/
+static bool
+send_all(int fd, void const *buf, size_t len)
+{
+	char const *at = buf;
+	while (len) {
+		ssize_t sent = write(fd,at,len);
+		if (sent < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			return false;
+		}
+		at += sent;
+		len -= (size_t)sent;
+	}
+	return true;
+}
+
+/*! Read a whole buffer from a socket.
+	\return	True iff the buffer is read, false at end of stream or
+	on error.
+*/
+static bool
+recv_all(int fd, void *buf, size_t len)
+{
+	char *at = buf;
+	while (len) {
+		ssize_t got = read(fd,at,len);
+		if (got <= 0) {
+			if (got < 0 && errno == EINTR) {
+				continue;
+			}
+			return false;
+		}
+		at += got;
+		len -= (size_t)got;
+	}
+	return true;
+}
+
+/*! Read a block of a given length from a socket.
+	\return	NULL, or the block on the heap with a terminal nul.
+*/
+static heap_str
+recv_block(int fd, size_t len)
+{
+	heap_str block = allocate(len + 1);
+	if (!recv_all(fd,block,len)) {
+		free(block);
+		return NULL;
+	}
+	block[len] = '\0';
+	return block;
+}
+
+/*! Compose the address of the socket named \c path.
+	\return	The length of the address.
+*/
+static socklen_t
+socket_address(char const *path, struct sockaddr_un *addr)
+{
+	memset(addr,0,sizeof(*addr));
+	if (strlen(path) >= sizeof(addr->sun_path)) {
+		bail(GRIPE_FILENAME_TOO_LONG,"Socket name too long: \"%s\"",path);
+	}
+	addr->sun_family = AF_UNIX;
+	strcpy(addr->sun_path,path);
+	return (socklen_t)sizeof(*addr);
+}
+
+/*! Check the header of a request and receive the name and body
+	that follow it.
+
+	\param	client	The connection to the client.
+	\param	request	The header of the request.
+	\param	name	Receives NULL, or the name on the heap.
+	\param	body	Receives NULL, or the body on the heap.
+	\return	0, or the reason code of the error that fails the request,
+	which is reported.
+
+	The lengths in the header are bounded, and a bail while the name
+	and body are received is caught, so that a bad request cannot end
+	the worker. If the client is lost then 0 is returned and \c body
+	is NULL.
+*/
+static int
+recv_request(int client, request_t const *request,
+	heap_str *name, heap_str *body)
+{
+	volatile int error;
+	size_t max_body_len =
+		request->kind == REQUEST_PATH ? MAX_NAME_LEN : MAX_DATA_LEN;
+	if ((request->kind != REQUEST_PATH && request->kind != REQUEST_DATA) ||
+		request->name_len > MAX_NAME_LEN ||
+		request->body_len > max_body_len) {
+		report(GRIPE_CANT_USE_SOCKET,NULL,"Invalid request from a client");
+		return GRIPE_CANT_USE_SOCKET;
+	}
+	SET_PUBLIC(exception,enabled) = true;
+	error = catch();
+	if (!error) {
+		*name = recv_block(client,request->name_len);
+		if (*name) {
+			*body = recv_block(client,request->body_len);
+		}
+	}
+	SET_PUBLIC(exception,enabled) = false;
+	return error;
+}
+
+/*! Serve one request on a connection.
+	\return	True iff the request is served and the connection may
+	carry another.
+*/
+static bool
+serve_request(int client)
+{
+	request_t request;
+	reply_t reply;
+	heap_str name = NULL, body = NULL;
+	char *output = NULL, *diagnostics = NULL;
+	size_t output_len = 0, diagnostics_len = 0;
+	FILE *in, *out, *diag;
+	bool good;
+	if (!recv_all(client,&request,sizeof(request))) {
+		return false;
+	}
+	out = open_memstream(&output,&output_len);
+	diag = out ? open_memstream(&diagnostics,&diagnostics_len) : NULL;
+	if (diag == NULL) {
+		if (out) {
+			fclose(out);
+			free(output);
+		}
+		return false;
+	}
+	memset(&reply,0,sizeof(reply));
+	set_exit_flags(ALL_EXIT_FLAGS,false);
+	divert_diagnostics(diag);
+	reply.error = recv_request(client,&request,&name,&body);
+	divert_diagnostics(NULL);
+	if (!reply.error && !body) {
+		/* The client is gone */
+		fclose(diag);
+		fclose(out);
+		free(diagnostics);
+		free(output);
+		free(name);
+		return false;
+	}
+	if (reply.error) {
+		/* The rest of the request cannot be read. Fail it */
+		in = NULL;
+	}
+	else if (request.kind == REQUEST_PATH) {
+		in = fopen(body,"r");
+	}
+	else {
+		in = request.body_len ?
+			fmemopen(body,request.body_len,"r") : tmpfile();
+	}
+	if (in) {
+		reply.error = process_stream(name,in,out,diag);
+		fclose(in);
+	}
+	else if (!reply.error) {
+		divert_diagnostics(diag);
+		report(GRIPE_CANT_OPEN_INPUT,NULL,"Can't open %s for reading",name);
+		divert_diagnostics(NULL);
+		reply.error = GRIPE_CANT_OPEN_INPUT;
+	}
+	reply.flags = get_exit_flags(ALL_EXIT_FLAGS);
+	reply.lines_dropped = GET_PUBLIC(line_despatch,lines_dropped);
+	reply.lines_changed = GET_PUBLIC(line_despatch,lines_changed);
+	reply.lines_inserted = GET_PUBLIC(line_despatch,lines_inserted);
+	fclose(out);
+	fclose(diag);
+	reply.output_len = output_len;
+	reply.diagnostics_len = diagnostics_len;
+	good = send_all(client,&reply,sizeof(reply)) &&
+		send_all(client,output,reply.output_len) &&
+		send_all(client,diagnostics,reply.diagnostics_len);
+	free(diagnostics);
+	free(output);
+	free(body);
+	free(name);
+	return good && body != NULL;
+}
+
+/*! Run a worker, serving the clients that connect to the socket */
+static void
+work(int listener)
+{
+	SET_PUBLIC(exception,hosted) = true;
+	for (	;;) {
+		int client = accept(listener,NULL,NULL);
+		if (client < 0) {
+			if (errno == EINTR || errno == ECONNABORTED) {
+				continue;
+			}
+			bail(GRIPE_CANT_USE_SOCKET,"Can't accept a client: %s",
+				strerror(errno));
+		}
+		while (serve_request(client)) {}
+		close(client);
+	}
+}
+
+/*! Fork a worker.
+	\return	The process id of the worker.
+*/
+static pid_t
+spawn(int listener)
+{
+	pid_t pid = fork();
+	if (pid < 0) {
+		bail(GRIPE_CANT_START_THREAD,"Can't fork a worker: %s",
+			strerror(errno));
+	}
+	if (pid == 0) {
+		signal(SIGTERM,SIG_DFL);
+		signal(SIGINT,SIG_DFL);
+		work(listener);
+	}
+	return pid;
+}
+
+/*! Connect to the daemon named by the \c --client option */
+static void
+connect_daemon(void)
+{
+	char const *path = GET_PUBLIC(args,client_socket);
+	struct sockaddr_un addr;
+	socklen_t addr_len = socket_address(path,&addr);
+	int fd = socket(AF_UNIX,SOCK_STREAM,0);
+	if (fd < 0 || connect(fd,(struct sockaddr *)&addr,addr_len)) {
+		bail(GRIPE_CANT_USE_SOCKET,"Can't connect to a daemon on %s: %s",
+			path,strerror(errno));
+	}
+	/* Let a lost daemon fail a write rather than kill the client */
+	signal(SIGPIPE,SIG_IGN);
+	SET_STATE(daemon,socket) = fd;
+	SET_STATE(daemon,connected) = true;
+}
+
+/*! Bail when the connection to the daemon fails */
+static void
+lost_daemon(void)
+{
+	daemon_disconnect();
+	bail(GRIPE_CANT_USE_SOCKET,"Lost the daemon on %s",
+		GET_PUBLIC(args,client_socket));
+}
+
+/*! Read the whole of an input stream.
+	\return	The contents, on the heap.
+*/
+static heap_str
+slurp(FILE *in, size_t *len)
+{
+	size_t size = BUFSIZ;
+	size_t got = 0;
+	size_t read;
+	heap_str buf = allocate(size);
+	while ((read = fread(buf + got,1,size - got,in)) > 0) {
+		got += read;
+		if (got == size) {
+			buf = reallocate(buf,size *= 2);
+		}
+	}
+	if (ferror(in)) {
+		free(buf);
+		bail(GRIPE_CANT_READ_INPUT,"Read error on file %s",
+			GET_PUBLIC(io,filename));
+	}
+	*len = got;
+	return buf;
+}
+
+/*@}*/
+
+/* API ***************************************************************/
+
+void
+daemon_serve(void)
+{
+	char const *path = GET_PUBLIC(args,daemon_socket);
+	int workers = GET_PUBLIC(args,jobs) ? GET_PUBLIC(args,jobs) : thread_cpus();
+	struct sockaddr_un addr;
+	socklen_t addr_len = socket_address(path,&addr);
+	struct sigaction action;
+	struct stat st;
+	pid_t *pids;
+	time_t *started;
+	int listener, i;
+	if (!dataset_is_empty()) {
+		bail(GRIPE_INVALID_ARGS,"--daemon takes no input files");
+	}
+	listener = socket(AF_UNIX,SOCK_STREAM,0);
+	if (listener < 0) {
+		bail(GRIPE_CANT_USE_SOCKET,"Can't create a socket: %s",
+			strerror(errno));
+	}
+	if (lstat(path,&st) == 0 && S_ISSOCK(st.st_mode)) {
+		/* Replace the socket of a daemon that is gone, but not a live one */
+		if (!connect(listener,(struct sockaddr *)&addr,addr_len)) {
+			bail(GRIPE_CANT_USE_SOCKET,"A daemon is already serving on %s",
+				path);
+		}
+		close(listener);
+		unlink(path);
+		listener = socket(AF_UNIX,SOCK_STREAM,0);
+	}
+	if (listener < 0 || bind(listener,(struct sockaddr *)&addr,addr_len) ||
+		listen(listener,SOMAXCONN)) {
+		bail(GRIPE_CANT_USE_SOCKET,"Can't serve on %s: %s",
+			path,strerror(errno));
+	}
+	memset(&action,0,sizeof(action));
+	action.sa_handler = stop;
+	sigemptyset(&action.sa_mask);
+	/* No SA_RESTART, so that a signal interrupts wait() */
+	sigaction(SIGTERM,&action,NULL);
+	sigaction(SIGINT,&action,NULL);
+	signal(SIGPIPE,SIG_IGN);
+	pids = callocate(workers,sizeof(pid_t));
+	started = callocate(workers,sizeof(time_t));
+	for (i = 0; i < workers; ++i) {
+		pids[i] = spawn(listener);
+		started[i] = time(NULL);
+	}
+	report(PROGRESS_SERVING,NULL,"Serving on %s with %d workers",
+		path,workers);
+	while (!stopping) {
+		pid_t pid = wait(NULL);
+		if (pid < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			break;	/* No workers left */
+		}
+		/* Replace the worker, pausing if it failed at once lest its
+			replacement fail likewise in a tight loop */
+		for (i = 0; i < workers; ++i) {
+			if (pids[i] == pid) {
+				pids[i] = 0;
+				if (!stopping &&
+					time(NULL) - started[i] < MIN_WORKER_LIFE) {
+					sleep(MIN_WORKER_LIFE);
+				}
+				if (!stopping) {
+					pids[i] = spawn(listener);
+					started[i] = time(NULL);
+				}
+			}
+		}
+	}
+	for (i = 0; i < workers; ++i) {
+		if (pids[i]) {
+			kill(pids[i],SIGTERM);
+		}
+	}
+	while (wait(NULL) > 0 || errno == EINTR) {}
+	close(listener);
+	unlink(path);
+	free(started);
+	free(pids);
+	exit(exitcode());
+}
+
+bool
+daemon_forward(void)
+{
+	char const *name = GET_PUBLIC(io,filename);
+	request_t request;
+	reply_t reply;
+	heap_str body, output, diagnostics;
+	int fd;
+	if (GET_PUBLIC(args,client_socket) == NULL) {
+		return false;
+	}
+	if (!GET_STATE(daemon,connected)) {
+		connect_daemon();
+	}
+	fd = GET_STATE(daemon,socket);
+	memset(&request,0,sizeof(request));
+	if (!strcmp(name,STDIN_NAME)) {
+		request.kind = REQUEST_DATA;
+		body = slurp(stdin,&request.body_len);
+	}
+	else {
+		request.kind = REQUEST_PATH;
+		body = fs_real_path(name,&request.body_len);
+		if (body == NULL) {
+			bail(GRIPE_CANT_OPEN_INPUT,"Can't open %s for reading",name);
+		}
+	}
+	request.name_len = strlen(name);
+	if (!send_all(fd,&request,sizeof(request)) ||
+		!send_all(fd,name,request.name_len) ||
+		!send_all(fd,body,request.body_len) ||
+		!recv_all(fd,&reply,sizeof(reply))) {
+		free(body);
+		lost_daemon();
+	}
+	free(body);
+	output = recv_block(fd,reply.output_len);
+	diagnostics = output ? recv_block(fd,reply.diagnostics_len) : NULL;
+	if (diagnostics == NULL) {
+		free(output);
+		lost_daemon();
+	}
+	fwrite(diagnostics,1,reply.diagnostics_len,stderr);
+	free(diagnostics);
+	set_exit_flags(reply.flags,true);
+	/* The output of an abandoned input is written as far as it went,
+		as it would be if the input were parsed here */
+	if (fwrite(output,1,reply.output_len,GET_PUBLIC(io,output)) !=
+		reply.output_len) {
+		free(output);
+		bail(GRIPE_CANT_WRITE_FILE,"Write error on output");
+	}
+	free(output);
+	if (reply.error) {
+		bail(reply.error,NULL);
+	}
+	SET_PUBLIC(line_despatch,lines_dropped) += reply.lines_dropped;
+	SET_PUBLIC(line_despatch,lines_changed) += reply.lines_changed;
+	SET_PUBLIC(line_despatch,lines_inserted) += reply.lines_inserted;
+	return true;
+}
+
+void
+daemon_disconnect(void)
+{
+	if (GET_STATE(daemon,connected)) {
+		close(GET_STATE(daemon,socket));
+		SET_STATE(daemon,connected) = false;
+	}
+}
+
+#else /* !UNIX */
+
+/* API ***************************************************************/
+
+void
+daemon_serve(void)
+{
+	bail(GRIPE_INVALID_ARGS,"--daemon is not supported on this platform");
+}
+
+bool
+daemon_forward(void)
+{
+	if (GET_PUBLIC(args,client_socket) != NULL) {
+		bail(GRIPE_INVALID_ARGS,"--client is not supported on this platform");
+	}
+	return false;
+}
+
+void
+daemon_disconnect(void)
+{
+}
+
+#endif /* UNIX */
+
+/* EOF */
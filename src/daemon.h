@@ -0,0 +1,96 @@
+#ifndef DAEMON_H
+#define DAEMON_H
+/***************************************************************************
+ *   Copyright (C) 2004, 2006 Symbian Software Ltd.                        *
+ *   All rights reserved.                                                  *
+ *   Copyright (C) 2007, 2008 Mike Kinghan, imk@strudl.org                 *
+ *   All rights reserved.                                                  *
+ *                                                                         *
+ *   Contributed originally by Mike Kinghan, imk@strudl.org                *
+ *                                                                         *
+ *   Redistribution and use in source and binary forms, with or without    *
+ *   modification, are permitted provided that the following conditions    *
+ *   are met:                                                              *
+ *                                                                         *
+ *   Redistributions of source code must retain the above copyright        *
+ *   notice, this list of conditions and the following disclaimer.         *
+ *                                                                         *
+ *   Redistributions in binary form must reproduce the above copyright     *
+ *   notice, this list of conditions and the following disclaimer in the   *
+ *   documentation and/or other materials provided with the distribution.  *
+ *                                                                         *
+ *   Neither the name of Symbian Software Ltd. nor the names of its        *
+ *   contributors may be used to endorse or promote products derived from  *
+ *   this software without specific prior written permission.              *
+ *                                                                         *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS   *
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT     *
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS    *
+ *   FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE        *
+ *   COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,   *
+ *   INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,  *
+ *   BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS *
+ *   OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED    *
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,*
+ *   OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF *
+ *   THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH  *
+ *   DAMAGE.                                                               *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#include "opts.h"
+#include "bool.h"
+
+/*!\ingroup daemon_module, daemon_interface
+ *\file daemon.h
+ * This file provides the Daemon module interface.
+ *
+ *	With the \c --daemon option the program parses its options once and
+ *	then serves clients on a Unix domain socket, so that the cost of
+ *	parsing a large set of symbols is not paid for every file. With the
+ *	\c --client option the program forwards each input file to a daemon
+ *	and writes the output that it returns, in place of parsing the file.
+ */
+
+/*! \addtogroup daemon_interface */
+/*@{*/
+
+/*! Serve clients on the socket named by the \c --daemon option until
+	the program is terminated, then exit.
+
+	The socket is served by a pool of \c --jobs worker processes, or one
+	per processor, each forked with the options and symbols parsed. A
+	worker that dies is replaced. On \c SIGTERM or \c SIGINT the workers
+	are stopped and the socket is removed.
+*/
+extern void
+daemon_serve(void);
+
+/*! Have the daemon process the current source file, if the \c --client
+	option is in force.
+
+	\return	\em true iff the output of the file has been written to the
+	output stream and no input is to be parsed.
+
+	Call after the source file is opened. The diagnostics of the daemon
+	are written to \c stderr and its exit flags and line counts are
+	accounted to this run. If the daemon abandoned the file with an error,
+	the function bails with the same reason.
+*/
+extern bool
+daemon_forward(void);
+
+/*! Disconnect from the daemon, if connected. */
+extern void
+daemon_disconnect(void);
+
+/*@}*/
+
+/*! \addtogroup daemon_interface_state_utils */
+/*@{*/
+IMPORT_INITOR(daemon);
+IMPORT_FINITOR(daemon);
+/*@}*/
+
+#endif /* EOF */
@@ -36,7 +36,14 @@
  *                                                                         *
  ***************************************************************************/
 
+#define MEMORY_TAG	MEMORY_FILE_TREE
 #include "dataset.h"
+#include "args.h"
+#include "name_rules.h"
+#include "snapshot.h"
+#include "filesys.h"
+#include "ptr_vector.h"
+#include "thread.h"
 #include "platform.h"
 #include "report.h"
 
@@ -45,16 +52,73 @@
  * This file implements the Dataset module
  */
 
+/*! \addtogroup dataset_internals */
+/*@{*/
+
+/*! The capacity of the queue of files and directories found by an eager
+	search for input files
+*/
+#define FOUND_QUEUE_SIZE	256
+
+/*! Structure of a file, directory or symbolic link found by an eager
+	search for input files
+*/
+typedef struct found {
+	file_tree_traverse_state_t context;
+		/*!< How it was found, as passed to the
+			\c file_tree_callback_t of the search */
+	heap_str name;	/*!< Its full name */
+	unsigned files;	/*!< For \c FT_LEAVING_DIR, the number of files
+						added from the directory */
+} found_t;
+
+/*@}*/
+
 /*! \addtogroup dataset_internals_state_utils */
 /*@{*/
 /*! The global state of the Dataset module */
 STATE_DEF(dataset) {
 	/*! The public state of the Dataset module */
 	INCLUDE_PUBLIC(dataset);
-	heap_str filter_types;
-		/*!< List of filter file types. Stored as
-			continguous nul-punctuated strings with a
-			terminatied by a double nul*/
+	name_rules_h filter_types;
+		/*!< The file extensions given by the \c --filter option,
+			or NULL */
+	name_rules_h includes;
+		/*!< The patterns given by \c --include options */
+	name_rules_h excludes;
+		/*!< The patterns given by \c --exclude options */
+	ptr_vector_h paths;
+		/*!< With \c --eager, the paths to be searched */
+	thread_t searcher;
+		/*!< With \c --eager, the thread that searches \c paths while
+			the input files are processed, or NULL */
+	thread_lock_t lock;
+		/*!< Lock on the queue of files found */
+	thread_cond_t cond;
+		/*!< Signalled when the queue of files found changes */
+	found_t found[FOUND_QUEUE_SIZE];
+		/*!< The queue of files found and waiting to be processed */
+	size_t found_head;
+		/*!< The index of the oldest entry in \c found */
+	size_t found_count;
+		/*!< The number of entries in \c found */
+	unsigned found_files;
+		/*!< The number of files found so far */
+	bool searched;
+		/*!< Is the search finished? */
+	bool halted;
+		/*!< Is the search to be abandoned? */
+	int search_error;
+		/*!< The reason code of an error that ended the search, or 0 */
+	char search_msg[THREAD_TRAP_MSG_SIZE];
+		/*!< The diagnostic of the error that ended the search */
+	snapshot_h snapshot;
+		/*!< The directory snapshot given by the \c --snapshot
+			option, or NULL */
+	char const *snapshot_file;
+		/*!< The file in which \c snapshot is kept */
+	file_tree_callback_t update_callback;
+		/*!< The callback of the \c dataset_update() in progress */
 } STATE_T(dataset);
 
 
@@ -63,54 +127,89 @@ IMPLEMENT(dataset,USER_INITABLE);
 DEFINE_USER_INIT(dataset)(STATE_T(dataset) * dataset_st)
 {
 	dataset_st->dataset_public_state.file_tree = file_tree_new();
+	dataset_st->includes = name_rules_new();
+	dataset_st->excludes = name_rules_new();
+	dataset_st->paths = ptr_vector_new();
 }
 
 DEFINE_USER_FINIS(dataset)(STATE_T(dataset) * dataset_st)
 {
 	file_tree_dispose(&(SET_PUBLIC(dataset,file_tree)));
-	free(SET_STATE(dataset,filter_types));
+	name_rules_dispose(&SET_STATE(dataset,filter_types));
+	name_rules_dispose(&SET_STATE(dataset,includes));
+	name_rules_dispose(&SET_STATE(dataset,excludes));
+	snapshot_dispose(&SET_STATE(dataset,snapshot));
+	if (GET_STATE(dataset,paths)) {
+		heap_str * start = (heap_str *)ptr_vector_start(GET_STATE(dataset,paths));
+		heap_str * end = (heap_str *)ptr_vector_end(GET_STATE(dataset,paths));
+		for (	;start != end; ++start) {
+			free(*start);
+		}
+		ptr_vector_dispose(&SET_STATE(dataset,paths));
+	}
+	if (GET_PUBLIC(dataset,searched_dirs)) {
+		heap_str * start =
+			(heap_str *)ptr_vector_start(GET_PUBLIC(dataset,searched_dirs));
+		heap_str * end =
+			(heap_str *)ptr_vector_end(GET_PUBLIC(dataset,searched_dirs));
+		for (	;start != end; ++start) {
+			free(*start);
+		}
+		ptr_vector_dispose(&SET_PUBLIC(dataset,searched_dirs));
+	}
 }
 /*@}*/
 
 /*! \addtogroup dataset_internals */
 /*@{*/
 
-/*! Say whether a file is eligible for processing
-	by matching one of the file extensions given by
-	the \c --filter option.
+/*! Say whether a file is eligible for processing, or a directory
+	for searching.
+
+	A file or directory that matches an \c --exclude option is
+	ineligible. Otherwise a directory is eligible, and a file is eligible
+	if no \c --filter or \c --include options are given or if it has
+	one of the file extensions given by \c --filter or matches an
+	\c --include pattern.
 */
 static bool
-filter_filename(const char *filename)
-{
-	char const * filter_filetypes = GET_STATE(dataset,filter_types);
-	char const *leafname = strrchr(filename,PATH_DELIM);
-	if (!leafname) {
-		leafname = filename;
-	}
-	if (filter_filetypes) {
-		char const *extension = filter_filetypes;
-		size_t ext_len = 0;
-		for (	;*extension; extension += ext_len + 1) {
-			char *posn = strrchr(leafname,'.');
-			ext_len = strlen(extension);
-			if (posn && posn[1]) {
-				if (!strcmp(++posn,extension)) {
-					return true;
-				}
-			}
-		}
+filter_filename(const char *fullname, const char *leafname, bool is_dir)
+{
+	name_rules_h filter_types = GET_STATE(dataset,filter_types);
+	name_rules_h includes = GET_STATE(dataset,includes);
+	if (name_rules_match(GET_STATE(dataset,excludes),fullname,leafname)) {
+		return false;
 	}
-	return false;
+	if (is_dir || (!filter_types && name_rules_empty(includes))) {
+		return true;
+	}
+	return (filter_types && name_rules_match(filter_types,fullname,leafname))
+		|| name_rules_match(includes,fullname,leafname);
 }
 
+/*! Report a file, directory or symbolic link found in the search
+	for input files.
+
+	\param		name	The name of the file, directory or link.
+	\param		context	How it was found, as passed to the
+						\c file_tree_callback_t of the search.
+	\param		files	For \c FT_LEAVING_DIR, the number of files added
+						from the directory.
+*/
 static void
-build_proc(	file_tree_h tree,
-			char const *name,
-			file_tree_traverse_state_t context)
+report_found(char const *name, file_tree_traverse_state_t context, unsigned files)
 {
 	switch(context) {
 	case FT_ENTERING_DIR:
 		report(PROGRESS_SEARCHING_DIR,NULL,"Searching dir \"%s\"",name);
+		if (GET_PUBLIC(args,watch)) {
+			heap_str copy = allocate(strlen(name) + 1);
+			strcpy(copy,name);
+			if (!GET_PUBLIC(dataset,searched_dirs)) {
+				SET_PUBLIC(dataset,searched_dirs) = ptr_vector_new();
+			}
+			ptr_vector_append(GET_PUBLIC(dataset,searched_dirs),copy);
+		}
 		break;
 	case FT_AT_FILE:
 		report(PROGRESS_ADDED_FILE,NULL,"Added file \"%s\"",name);
@@ -118,15 +217,229 @@ build_proc(	file_tree_h tree,
 	case FT_LEAVING_DIR:
 		report(	PROGRESS_ADDED_DIR,
 					NULL,
-					"Added %d files from dir \"%s\"",
-					file_tree_count(tree,FT_COUNT_FILES,NULL),
+					"Added %u files from dir \"%s\"",
+					files,
 					name);
 		break;
+	case FT_AT_SYMLINK:
+		report(GRIPE_SYMLINK,NULL,"Resolved symbolic link \"%s\"",name);
+		break;
 	default:
 		assert(false);	
 	}
 }
 
+/*! The \c file_tree_callback_t with which input files are added to the
+	file tree.
+*/
+static void
+build_proc(	file_tree_h tree,
+			char const *name,
+			file_tree_traverse_state_t context)
+{
+	report_found(name,context,context == FT_LEAVING_DIR ?
+		(unsigned)file_tree_count(tree,FT_COUNT_FILES,NULL) : 0);
+}
+
+/*! The \c file_tree_callback_t with which paths are added to the file
+	tree by \c dataset_update(). It reports what is found and passes
+	the directories entered and the files added to the callback of
+	the update.
+*/
+static void
+update_proc(	file_tree_h tree,
+				char const *name,
+				file_tree_traverse_state_t context)
+{
+	build_proc(tree,name,context);
+	if (context == FT_ENTERING_DIR || context == FT_AT_FILE) {
+		GET_STATE(dataset,update_callback)(tree,name,context);
+	}
+}
+
+/*! The \c file_tree_callback_t with which input files are added to the
+	file tree by an eager search. It queues what is found, to be
+	reported and processed on the main thread, waiting while the queue
+	is full.
+
+	If the search is halted it waits for ever.
+*/
+static void
+feed_proc(	file_tree_h tree,
+			char const *name,
+			file_tree_traverse_state_t context)
+{
+	found_t *found;
+	thread_lock_t lock = GET_STATE(dataset,lock);
+	/* Allocate before locking, as a bail would leave the lock held */
+	heap_str copy = allocate(strlen(name) + 1);
+	strcpy(copy,name);
+	thread_lock(lock);
+	while (GET_STATE(dataset,found_count) == FOUND_QUEUE_SIZE ||
+			GET_STATE(dataset,halted)) {
+		thread_cond_wait(GET_STATE(dataset,cond),lock);
+	}
+	found = SET_STATE(dataset,found) +
+		(GET_STATE(dataset,found_head) + GET_STATE(dataset,found_count)) %
+			FOUND_QUEUE_SIZE;
+	++SET_STATE(dataset,found_count);
+	found->context = context;
+	found->name = copy;
+	found->files = context == FT_LEAVING_DIR ?
+		(unsigned)file_tree_count(tree,FT_COUNT_FILES,NULL) : 0;
+	SET_STATE(dataset,found_files) += context == FT_AT_FILE;
+	thread_cond_broadcast(GET_STATE(dataset,cond));
+	thread_unlock(lock);
+}
+
+/*! Thread function of an eager search for input files.
+	It adds the paths to be searched to the file tree.
+
+	A bail in the search must not unwind the stack of the main thread,
+	so it is trapped and ends the search, and the error is raised by
+	\c process_found() on the main thread.
+*/
+static void
+search(void *arg)
+{
+	heap_str * start = (heap_str *)ptr_vector_start(GET_STATE(dataset,paths));
+	heap_str * end = (heap_str *)ptr_vector_end(GET_STATE(dataset,paths));
+	thread_trap_t trap;
+	int error = 0;
+	(void)arg;
+	thread_set_trap(&trap);
+	if (!setjmp(trap.context)) {
+		for (	;start != end; ++start) {
+			file_tree_add(GET_PUBLIC(dataset,file_tree),*start,feed_proc,
+				GET_PUBLIC(args,jobs));
+		}
+	}
+	else {
+		error = trap.reason;
+	}
+	thread_set_trap(NULL);
+	thread_lock(GET_STATE(dataset,lock));
+	if (error) {
+		SET_STATE(dataset,search_error) = error;
+		strcpy(SET_STATE(dataset,search_msg),trap.msg);
+	}
+	SET_STATE(dataset,searched) = true;
+	thread_cond_broadcast(GET_STATE(dataset,cond));
+	thread_unlock(GET_STATE(dataset,lock));
+}
+
+/*! Take the oldest entry from the queue of files found by an eager
+	search, waiting until there is one or the search is finished.
+
+	\param		found	Receives the entry.
+	\return True if an entry is taken, false if the search is
+				finished and there are no more, or the search failed.
+*/
+static bool
+take_found(found_t *found)
+{
+	bool got;
+	thread_lock_t lock = GET_STATE(dataset,lock);
+	thread_lock(lock);
+	while (!GET_STATE(dataset,found_count) && !GET_STATE(dataset,searched)) {
+		thread_cond_wait(GET_STATE(dataset,cond),lock);
+	}
+	got = GET_STATE(dataset,found_count) != 0 &&
+		!GET_STATE(dataset,search_error);
+	if (got) {
+		*found = GET_STATE(dataset,found)[GET_STATE(dataset,found_head)];
+		SET_STATE(dataset,found_head) =
+			(GET_STATE(dataset,found_head) + 1) % FOUND_QUEUE_SIZE;
+		--SET_STATE(dataset,found_count);
+		thread_cond_broadcast(GET_STATE(dataset,cond));
+	}
+	thread_unlock(lock);
+	return got;
+}
+
+/*! Process input files on the main thread as they are found by an eager
+	search on another thread.
+
+	\param		callback	The \c file_tree_callback_t to be called for
+						each file found and for each directory entered
+						and left.
+
+	A directory is entered just before the first file found in it, so
+	directories that contain only directories are not entered, and the
+	directory node is not passed to \c callback.
+
+	If the search fails, no more files are processed and its error is
+	raised when the search thread has finished.
+*/
+static void
+process_found(file_tree_callback_t callback)
+{
+	typedef struct {
+		heap_str name;	/* The name of the directory */
+		bool entered;	/* Has \c callback entered it? */
+	} open_dir_t;
+	open_dir_t *dirs = NULL;
+	size_t depth = 0;
+	size_t size = 0;
+	found_t found;
+	SET_STATE(dataset,lock) = thread_lock_new();
+	SET_STATE(dataset,cond) = thread_cond_new();
+	SET_STATE(dataset,searcher) = thread_start(search,NULL);
+	while (take_found(&found)) {
+		report_found(found.name,found.context,found.files);
+		switch(found.context) {
+		case FT_ENTERING_DIR:
+			if (depth == size) {
+				size = size ? size * 2 : 16;
+				dirs = reallocate(dirs,size * sizeof(open_dir_t));
+			}
+			dirs[depth].name = found.name;
+			dirs[depth++].entered = false;
+			continue;
+		case FT_AT_FILE:
+			if (depth && !dirs[depth - 1].entered) {
+				callback(NULL,dirs[depth - 1].name,FT_ENTERING_DIR);
+				dirs[depth - 1].entered = true;
+			}
+			callback(NULL,found.name,FT_AT_FILE);
+			break;
+		case FT_LEAVING_DIR:
+			assert(depth);
+			if (dirs[--depth].entered) {
+				callback(NULL,found.name,FT_LEAVING_DIR);
+			}
+			free(dirs[depth].name);
+			break;
+		default:
+			break;
+		}
+		free(found.name);
+	}
+	free(dirs);
+	thread_join(GET_STATE(dataset,searcher));
+	SET_STATE(dataset,searcher) = NULL;
+	if (GET_STATE(dataset,search_error)) {
+		if (GET_STATE(dataset,search_msg)[0]) {
+			bail(GET_STATE(dataset,search_error),"%s",
+				GET_STATE(dataset,search_msg));
+		}
+		bail(GET_STATE(dataset,search_error),
+			"Error while searching directories");
+	}
+}
+
+/*! Save the directory snapshot, if any, when the input dataset has
+	been searched
+*/
+static void
+save_snapshot(void)
+{
+	if (GET_STATE(dataset,snapshot)) {
+		snapshot_save(GET_STATE(dataset,snapshot),
+			GET_STATE(dataset,snapshot_file));
+	}
+}
+
 /*@}*/
 
 /* API */
@@ -134,22 +447,130 @@ build_proc(	file_tree_h tree,
 void
 dataset_filter_filetypes(const char *optarg)
 {
-	size_t len = strlen(optarg);
-	heap_str list = SET_STATE(dataset,filter_types) = allocate(len + 2);
+	heap_str list = allocate(strlen(optarg) + 1);
+	char *ext;
 	strcpy(list,optarg);
-	list[len + 1] = '\0';
-	while(--len) {
-		if (list[len] == ',') {
-			list[len] = '\0';
-		}
+	name_rules_dispose(&SET_STATE(dataset,filter_types));
+	SET_STATE(dataset,filter_types) = name_rules_new();
+	for (ext = strtok(list,","); ext; ext = strtok(NULL,",")) {
+		name_rules_add_extension(GET_STATE(dataset,filter_types),ext);
 	}
+	free(list);
+	file_tree_set_filter(GET_PUBLIC(dataset,file_tree),filter_filename);
+}
+
+bool
+dataset_exclude(const char *glob)
+{
+	file_tree_set_filter(GET_PUBLIC(dataset,file_tree),filter_filename);
+	return name_rules_add_glob(GET_STATE(dataset,excludes),glob);
+}
+
+bool
+dataset_include(const char *glob)
+{
 	file_tree_set_filter(GET_PUBLIC(dataset,file_tree),filter_filename);
+	return name_rules_add_glob(GET_STATE(dataset,includes),glob);
+}
+
+void
+dataset_snapshot(char const *filename)
+{
+	snapshot_dispose(&SET_STATE(dataset,snapshot));
+	SET_STATE(dataset,snapshot) = snapshot_load(filename);
+	SET_STATE(dataset,snapshot_file) = filename;
+	file_tree_set_snapshot(GET_PUBLIC(dataset,file_tree),
+		GET_STATE(dataset,snapshot));
 }
 
 void
 dataset_add(char const *path)
 {
-	file_tree_add(GET_PUBLIC(dataset,file_tree),path,build_proc);
+	if (GET_PUBLIC(args,eager)) {
+		heap_str copy = allocate(strlen(path) + 1);
+		strcpy(copy,path);
+		ptr_vector_append(GET_STATE(dataset,paths),copy);
+	}
+	else {
+		file_tree_add(GET_PUBLIC(dataset,file_tree),path,build_proc,
+			GET_PUBLIC(args,jobs));
+	}
+}
+
+void
+dataset_update(char const *path, file_tree_callback_t callback)
+{
+	fs_obj_type_t obj_type = fs_obj_type(path);
+	char const *leafname = strrchr(path,PATH_DELIM);
+	leafname = leafname ? leafname + 1 : path;
+	if (FS_IS_DIR(obj_type)) {
+		if (filter_filename(path,leafname,true)) {
+			SET_STATE(dataset,update_callback) = callback;
+			file_tree_add(GET_PUBLIC(dataset,file_tree),path,update_proc,
+				GET_PUBLIC(args,jobs));
+			SET_STATE(dataset,update_callback) = NULL;
+		}
+	}
+	else if (FS_IS_FILE(obj_type) && filter_filename(path,leafname,false)) {
+		file_tree_add(GET_PUBLIC(dataset,file_tree),path,build_proc,
+			GET_PUBLIC(args,jobs));
+		callback(NULL,path,FT_AT_FILE);
+	}
+}
+
+bool
+dataset_is_empty(void)
+{
+	if (GET_PUBLIC(args,eager)) {
+		return ptr_vector_count(GET_STATE(dataset,paths)) == 0;
+	}
+	return file_tree_is_empty(GET_PUBLIC(dataset,file_tree));
+}
+
+size_t
+dataset_count(void)
+{
+	size_t count;
+	if (!GET_PUBLIC(args,eager)) {
+		return file_tree_count(GET_PUBLIC(dataset,file_tree),FT_COUNT_FILES,NULL);
+	}
+	if (!GET_STATE(dataset,searcher)) {
+		return GET_STATE(dataset,found_files);
+	}
+	thread_lock(GET_STATE(dataset,lock));
+	count = GET_STATE(dataset,found_files);
+	thread_unlock(GET_STATE(dataset,lock));
+	return count;
+}
+
+void
+dataset_traverse(file_tree_callback_t callback)
+{
+	file_tree_h tree = GET_PUBLIC(dataset,file_tree);
+	if (!GET_PUBLIC(args,eager)) {
+		save_snapshot();
+		file_tree_traverse(tree,callback);
+		return;
+	}
+	callback(tree,NULL,FT_ENTERING_TREE);
+	process_found(callback);
+	save_snapshot();
+	thread_lock_dispose(&SET_STATE(dataset,lock));
+	thread_cond_dispose(&SET_STATE(dataset,cond));
+	if (!GET_STATE(dataset,found_files)) {
+		bail(GRIPE_NOTHING_TO_DO,"Nothing to do. No input files.");
+	}
+	callback(tree,NULL,FT_LEAVING_TREE);
+}
+
+void
+dataset_halt(void)
+{
+	if (GET_STATE(dataset,searcher)) {
+		thread_lock(GET_STATE(dataset,lock));
+		SET_STATE(dataset,halted) = true;
+		thread_unlock(GET_STATE(dataset,lock));
+	}
 }
 
 
@@ -39,6 +39,7 @@
  ***************************************************************************/
 #include "opts.h"
 #include "file_tree.h"
+#include "ptr_vector.h"
 
 /*!\ingroup dataset_module dataset_interface
  *\file dataset.h
@@ -57,22 +58,116 @@
 void
 dataset_filter_filetypes(const char *list);
 
+/*! Add a glob pattern given by the \c --exclude option. Files and
+	directories that match any such pattern are excluded from the
+	input dataset, and excluded directories are not searched.
+
+	\param	glob	The glob pattern.
+	\return True if \c glob is well-formed, else false.
+ */
+bool
+dataset_exclude(const char *glob);
+
+/*! Add a glob pattern given by the \c --include option. If any such
+	pattern is given then files are included in the input dataset only
+	if they match one of them or satisfy a \c --filter option.
+
+	\param	glob	The glob pattern.
+	\return True if \c glob is well-formed, else false.
+ */
+bool
+dataset_include(const char *glob);
+
+/*! Load the directory snapshot given by the \c --snapshot option.
+
+	\param	filename	The file in which the snapshot is kept. If it
+						does not exist, the snapshot is empty.
+
+	Directories searched for input files are then listed from the
+	snapshot if they have not been modified since it was made, and the
+	snapshot of the directories searched is saved in \c filename when
+	the search is finished.
+ */
+void
+dataset_snapshot(char const *filename);
+
 /*!
 	Add files to the input dataset.
 
 	\param		path		Name of file or directory to
 							be included in the input dataset.
 
-	If \e path is a file that satisfies any \c --filter option
-	it is added to the input dataset.
+	If \e path is a file that satisfies any \c --filter and
+	\c --include options it is added to the input dataset.
 
 	If \e path is a directory then files recursively beneath it
-	that satisfy any \c --filter option are added to the input
-	dataset.
+	that satisfy any \c --filter and \c --include options, and
+	are not excluded by an \c --exclude option, are added to the
+	input dataset.
 */
 void
 dataset_add(char const *path);
 
+/*!
+	Add a path that has appeared or changed to the input file tree,
+	after the input dataset has been traversed.
+
+	\param		path		Name of the file or directory.
+	\param		callback	The \c file_tree_callback_t to be called with
+							\c FT_AT_FILE for each eligible file at
+							\c path and with \c FT_ENTERING_DIR for each
+							directory searched. It is passed NULL for the
+							tree at a file.
+
+	If \e path is a file that satisfies any \c --filter and \c --include
+	options it is added to the input file tree, if it is not already
+	there, and \c callback is called for it. If \e path is a directory
+	that is not excluded then it is searched as by \c dataset_add(), and
+	\c callback is called for each directory searched and each file added.
+	A \e path that no longer exists is ignored.
+*/
+void
+dataset_update(char const *path, file_tree_callback_t callback);
+
+/*! Say whether any paths have been added to the input dataset.
+
+	With \c --eager, the paths added have not yet been searched, so
+	the dataset is not empty if any paths have been added.
+*/
+bool
+dataset_is_empty(void);
+
+/*! Count the files in the input dataset.
+
+	With \c --eager, this is the number of files found so far.
+*/
+size_t
+dataset_count(void);
+
+/*! Iterate a function over the input dataset.
+
+	\param		callback	The \c file_tree_callback_t to be called as
+						for \c file_tree_traverse().
+
+	Without \c --eager, the input file tree is traversed.
+
+	With \c --eager, the paths added to the dataset are searched by
+	another thread, which passes the files found through a bounded
+	queue to the calling thread, and \c callback is called for each
+	file as soon as it is found. It is called to enter a directory just
+	before the first file in that directory, and is passed NULL for the
+	tree at directories and files. The function bails if no files
+	are found.
+*/
+void
+dataset_traverse(file_tree_callback_t callback);
+
+/*! Halt any eager search for input files that is in progress, so that
+	the input dataset does not change while the program exits.
+*/
+void
+dataset_halt(void);
+
 /*@}*/
 
 /*!\addtogroup dataset_interface_state_utils */
@@ -87,6 +182,9 @@ PUBLIC_STATE_DEF(dataset) {
 			abandoned due to parse errors */
 	unsigned int errorfiles;
 		/*!< Number of files abandoned due to parse errors */
+	ptr_vector_h searched_dirs;
+		/*!< With \c --watch, the names on the heap of the directories
+			searched that the Watch module has yet to take, or NULL */
 } PUBLIC_STATE_T(dataset);
 
 IMPORT(dataset);
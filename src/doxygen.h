@@ -457,6 +457,11 @@
  *	This module implements the Sunifdef program
  */
 
+ /*! \defgroup microbench_module The Microbenchmark module
+ *	This module implements the microbenchmark program, which times
+ *	the kernels of Sunifdef in isolation
+ */
+
  /*! \defgroup exception_module The Exception module
 	This module provides a very rudimentary exception
 	handling facility using \c setjmp() and \c longjmp().
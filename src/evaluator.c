@@ -41,6 +41,7 @@
  *                                                                         *
  ***************************************************************************/
 
+#define MEMORY_TAG	MEMORY_EVALUATOR
 #include "evaluator.h"
 #include "io.h"
 #include "report.h"
@@ -52,6 +53,10 @@
 #include "symbol_table.h"
 #include "report.h"
 #include "line_despatch.h"
+#include "lex_map.h"
+#include "profile.h"
+#include "stats.h"
+#include "trace.h"
 #include <stddef.h>
 #include <ctype.h>
 #include <math.h>
@@ -448,6 +453,204 @@ op_mod(eval_result_t *lhs, eval_result_t *rhs)
 }
 
 
+/*! Enumeration of the kinds of token in an expression */
+typedef enum {
+	/*! The end of the text */
+	TOK_END,
+	/*! Any single character that does not begin one of the other kinds.
+		Operators and parentheses are tokens of this kind */
+	TOK_PUNCT,
+	/*! A numeral */
+	TOK_NUMBER,
+	/*! The keyword \c defined */
+	TOK_DEFINED,
+	/*! An identifier */
+	TOK_IDENT
+} token_kind_t;
+
+/*! Structure representing a token of an expression.
+
+	An operator of two characters is two \c TOK_PUNCT tokens. It is
+	recognised from the character of the first and the character that
+	immediately follows it in the text, just as the evaluator has always
+	recognised operators.
+*/
+typedef struct token {
+	/*! The kind of token */
+	token_kind_t kind;
+	/*! For \c TOK_PUNCT, the character */
+	char ch;
+	/*! For \c TOK_PUNCT, the character immediately following in the text */
+	char next;
+	/*! For \c TOK_NUMBER, is the numeral too big for us? */
+	bool overflow;
+	/*! For \c TOK_NUMBER, the value of the numeral */
+	int value;
+	/*! Offset of the start of the token in the text */
+	size_t start;
+	/*! Offset just past the end of the token in the text. For a
+		\c TOK_IDENT that has not yet been scanned this equals \c start */
+	size_t end;
+} token_t;
+
+/*! Structure representing the tokenised text of an expression.
+
+	Tokens are lexed on demand, exactly once each, as the evaluator
+	advances through them and are never lexed beyond the point that
+	evaluation reaches. Text after the end of an expression is
+	thus left to be chewed as the caller sees fit.
+
+	Positions are kept as offsets because the line buffer may be
+	reallocated as continuation lines are read.
+*/
+typedef struct token_stream {
+	/*! The text being tokenised, or \c NULL for the line buffer */
+	char *text;
+	/*! Offset in the text at which the expression begins */
+	size_t origin;
+	/*! Array of tokens lexed so far */
+	token_t *toks;
+	/*! The number of tokens lexed so far */
+	size_t count;
+	/*! The number of tokens for which \c toks has room */
+	size_t size;
+	/*! Index of the current token */
+	size_t cur;
+} token_stream_t;
+
+/*! Test whether a token is a given punctuation character */
+#define IS_PUNCT(tok,c)	((tok)->kind == TOK_PUNCT && (tok)->ch == (c))
+
+/*! Get the address of the start of a token */
+#define TOKEN_POS(ts,tok)	(stream_text(ts) + (tok)->start)
+
+/*! Get the current address of the text of a token stream */
+static char *
+stream_text(token_stream_t const *ts)
+{
+	return ts->text ? ts->text : GET_PUBLIC(io,line_start);
+}
+
+/*! Get the offset just past the end of a token, scanning it first
+	if it is an identifier not yet scanned.
+
+	Scanning an identifier discards any line-continuations within it.
+ */
+static size_t
+token_end(token_stream_t *ts, token_t *tok)
+{
+	if (tok->kind == TOK_IDENT && tok->end == tok->start) {
+		char *end = chew_sym(TOKEN_POS(ts,tok));
+		tok->end = end - stream_text(ts);
+	}
+	return tok->end;
+}
+
+static double
+scan_numeral(char const *num, char const **numend);
+
+/*! Lex the next token of a token stream and append it to the stream */
+static void
+lex_token(token_stream_t *ts)
+{
+	token_t *tok;
+	char *cp;
+	size_t off = ts->count ?
+		token_end(ts,ts->toks + ts->count - 1) : ts->origin;
+	if (ts->count == ts->size) {
+		ts->size = ts->size ? ts->size * 2 : 32;
+		ts->toks = reallocate(ts->toks,ts->size * sizeof(token_t));
+	}
+	cp = chew_on(stream_text(ts) + off);
+	tok = ts->toks + ts->count++;
+	tok->start = tok->end = cp - stream_text(ts);
+	if (*cp == '\0') {
+		tok->kind = TOK_END;
+	}
+	else if (isdigit((unsigned char)*cp)) {
+		char const *ep;
+		double val = scan_numeral(cp,&ep);
+		tok->kind = TOK_NUMBER;
+		tok->overflow = val == HUGE_VAL;
+		tok->value = tok->overflow ? 0 : (int)val;
+		tok->end += ep - cp;
+	}
+	else if (strncmp(cp, "defined", 7) == 0 && !symchar(cp[7])) {
+		tok->kind = TOK_DEFINED;
+		tok->end += 7;
+	}
+	else if (symchar(*cp)) {
+		/* Scanned when needed */
+		tok->kind = TOK_IDENT;
+	}
+	else {
+		tok->kind = TOK_PUNCT;
+		tok->ch = cp[0];
+		tok->next = cp[1];
+		++tok->end;
+	}
+}
+
+/*! Get the current token of a token stream, lexing it if need be.
+	The pointer returned is good only until the next token is lexed. */
+static token_t *
+peek_token(token_stream_t *ts)
+{
+	if (ts->cur == ts->count) {
+		lex_token(ts);
+	}
+	return ts->toks + ts->cur;
+}
+
+/*! Advance a token stream to the next token, unless at the end */
+static void
+next_token(token_stream_t *ts)
+{
+	if (peek_token(ts)->kind != TOK_END) {
+		++ts->cur;
+	}
+}
+
+/*! Get the offset at which an expression starting with the current
+	token begins, i.e. just past the previous token */
+static size_t
+expr_start(token_stream_t *ts)
+{
+	return ts->cur ? token_end(ts,ts->toks + ts->cur - 1) : ts->origin;
+}
+
+/*! Look up the identifier at a token in the symbol table.
+	\return The value returned by \c find_sym()
+
+	The token is scanned if it was not already. If it is not
+	an identifier we bail out as \c find_sym() does.
+ */
+static int
+resolve_ident(token_stream_t *ts, token_t *tok)
+{
+	char *end;
+	int symind = find_sym(TOKEN_POS(ts,tok),&end);
+	tok->end = end - stream_text(ts);
+	return symind;
+}
+
+/*! Logically delete the text between two offsets in a token stream.
+
+	If the stream is not the line buffer it is the definiens of a
+	symbol. There is nothing to edit then, but cutting it still counts
+	as simplifying the line.
+*/
+static void
+cut_span(token_stream_t const *ts, size_t start, size_t end)
+{
+	if (ts->text) {
+		SET_PUBLIC(line_edit,simplification_state) |= OPS_CUT;
+	}
+	else {
+		cut_text(start,end);
+	}
+}
+
 struct ops;
 
 /*! Type of evaluation functions.
@@ -456,14 +659,15 @@ struct ops;
 						table which lists the	operators at the
 						current level of precedence.
 
-	\param		On entry, a pointer to a \c char* that points to the
-				expression to be evaluated. On return, receives
-				the address terminating the evaluated expression.
+	\param		ts		The token stream of the expression, positioned
+				at the start of the expression to be evaluated. On
+				return, positioned at the token terminating the
+				evaluated expression.
 
 	\return An \em eval_result_t representing the result of
 				evaluation.
  */
-typedef eval_result_t (evaluator_t)(const struct ops *,char **);
+typedef eval_result_t (evaluator_t)(const struct ops *,token_stream_t *);
 
 /*! The evaluator for binary expressions */
 static evaluator_t eval_table;
@@ -562,24 +766,24 @@ static const struct ops eval_ops[] = {
 	},
 };
 
-/*! Test whether a given operator occurs at a given line-buffer position.
- *	\param txt	A line buffer position
+/*! Test whether a given operator occurs at a given token.
+ *	\param tok	A token
  *	\param op		Pointer to an operator token
- *	\return		\em true iff the operator token \c op occurs at position \c txt
+ *	\return		\em true iff the operator token \c op occurs at \c tok
  */
 static bool
-op_cmp(char const * txt, char const *op)
+op_cmp(token_t const * tok, char const *op)
 {
 	assert(op[1] == '\0' || op[2] =='\0');
-	if (txt[0] != op[0]) {
+	if (tok->kind != TOK_PUNCT || tok->ch != op[0]) {
 		return false;
 	}
 	if (op[1]) {
-		if (txt[1] != op[1]) {
+		if (tok->next != op[1]) {
 			return false;
 		}
 	}
-	else if (txt[1] == op[0]) {
+	else if (tok->next == op[0]) {
 		return false;
 	}
 	return true;
@@ -594,20 +798,20 @@ op_cmp(char const * txt, char const *op)
 
  \param	ops		Pointer to the \em struct ops to be used for
 					the evaluation.
- \param cpp		On entry, a pointer to the start of the text
-					to be evaluated. Receives the address reached
+ \param ts		The token stream, positioned at the start of the
+					text to be evaluated. Receives the position reached
 					by evaluation.
  \return	An \em eval_result_t representing
 			the result of evaluation.
  */
 static eval_result_t
-eval_unary(const struct ops *ops, char **cpp);
+eval_unary(const struct ops *ops, token_stream_t *ts);
 
 /*!	Skip right-hand operand of \c && in an \c #if
  *  directive when we can short-circuit the evaluation.
  *
- *	\param cp	Line-buffer position at which the operand
- *				begins.
+ *	\param ts	The token stream, positioned at the start
+ *				of the operand.
  *
  *	When an \c && can be short-circuited, the evaluator
  *	can skip from the start of the righthand operand until:
@@ -615,17 +819,20 @@ eval_unary(const struct ops *ops, char **cpp);
  *	- an unbalanced ')', which must close the scope of the \c &&, or
  *	- a \c || operator, which has higher precedence.
  *
- *	\return The address just past the skipped operand.
+ *	On return the stream is positioned just past the skipped operand.
  */
-static char *
-short_circuit_and(char *cp)
+static void
+short_circuit_and(token_stream_t *ts)
 {
 	int balance = 0;
-	for (	;*(cp = chew_on(cp)); ++cp) {
-		if (*cp == '(') {
+	token_t *tok;
+	STATS_COUNT(STATS_SHORT_CIRCUITS);
+	PROFILE_SHORT_CIRCUIT();
+	for (	;(tok = peek_token(ts))->kind != TOK_END; next_token(ts)) {
+		if (IS_PUNCT(tok,'(')) {
 			++balance;
 		}
-		else if (*cp == ')') {
+		else if (IS_PUNCT(tok,')')) {
 			--balance;
 		}
 		if (balance < 0) {
@@ -635,19 +842,18 @@ short_circuit_and(char *cp)
 			/* Check for another binary truth functor on same
 			 * level to respect precedence.
 			 */
-			if (cp[0] == cp[1] && cp[0] == '|') {
+			if (IS_PUNCT(tok,'|') && tok->next == '|') {
 				break;
 			}
 		}
 	}
-	return cp;
 }
 
 /*!	Skip the right-hand operand of \c || in an \c #if
  *  directive when we can short-circuit the evaluation.
  *
- *	\param cp	Line-buffer position at which the operand
- *				begins.
+ *	\param ts	The token stream, positioned at the start
+ *				of the operand.
  *
  *	When an \c || can be short-circuited, the evaluator can
  *	skip from the start of the righthand operand until the end
@@ -655,24 +861,26 @@ short_circuit_and(char *cp)
  *	the scope of the \c ||. None of our operators has higher
  *	precedence.
  *
- *	\return The address just past the skipped operand.
+ *	On return the stream is positioned just past the skipped operand.
  */
-static char *
-short_circuit_or(char *cp)
+static void
+short_circuit_or(token_stream_t *ts)
 {
 	int balance = 0;
-	for (	;*(cp = chew_on(cp)); ++cp) {
-		if (*cp == '(') {
+	token_t *tok;
+	STATS_COUNT(STATS_SHORT_CIRCUITS);
+	PROFILE_SHORT_CIRCUIT();
+	for (	;(tok = peek_token(ts))->kind != TOK_END; next_token(ts)) {
+		if (IS_PUNCT(tok,'(')) {
 			++balance;
 		}
-		else if (*cp == ')') {
+		else if (IS_PUNCT(tok,')')) {
 			--balance;
 		}
 		if (balance < 0) {
 			break;
 		}
 	}
-	return cp;
 }
 
 /*! Evaluate the expression of a \c #if or \c #elif directive.
@@ -725,7 +933,7 @@ eval_define(char **cpp)
 	int retval;
 	int cursym;
 	bool functionoid = false;
-	debug(DBG_13,line_len(*cpp),*cpp);
+	TRACE_TEXT(TRACE_EVAL_DEFINE,0,*cpp,line_len(*cpp));
 	cp = chew_on(cp);
 	cursym = find_sym(cp,&cp);
 	do {
@@ -795,7 +1003,7 @@ eval_define(char **cpp)
 		/* Pseudo-comment parsing */
 		for (	;*(cp = chew_on(cp)) != '\0'; ++cp){} /* Skip to newline */
 	}
-	debug(DBG_14,line_len(*cpp),*cpp,retval);
+	TRACE_TEXT(TRACE_EVAL_DEFINE_TYPE,retval,*cpp,line_len(*cpp));
 	*cpp = cp;
 	return retval;
 }
@@ -821,7 +1029,7 @@ eval_undef(char **cpp)
 	char *cp = *cpp;
 	int retval;
 	int cursym;
-	debug(DBG_15,line_len(*cpp),*cpp);
+	TRACE_TEXT(TRACE_EVAL_UNDEF,0,*cpp,line_len(*cpp));
 	cp = chew_on(cp);
 	cursym = find_sym(cp,&cp);
 	do {
@@ -849,7 +1057,7 @@ eval_undef(char **cpp)
 			retval = LT_CONTRADICTORY_UNDEF;
 		}
 	} while(false);
-	debug(DBG_16,line_len(*cpp),*cpp,retval);
+	TRACE_TEXT(TRACE_EVAL_UNDEF_TYPE,retval,*cpp,line_len(*cpp));
 	*cpp = cp = chew_on(cp);
 	return retval;
 }
@@ -871,13 +1079,13 @@ eval_undef(char **cpp)
 					the evaluation.
  \param result	Pointer to an \em eval_result_t that receives
 					the result of evaluation.
- \param cpp		On entry, a pointer to the start of the text
-					to be evaluated. Receives the address reached
+ \param ts		The token stream, positioned at the start of the
+					text to be evaluated. Receives the position reached
 					by evaluation.
 
  */
 static eval_result_t
-eval_table(const struct ops *ops,char **cpp);
+eval_table(const struct ops *ops,token_stream_t *ts);
 
 /*@}*/
 
@@ -893,6 +1101,8 @@ STATE_DEF(evaluator) {
 	/*! Are we parsing the definiens VAL of an option -DSYM=VAL,
 		rather than input source? */
 	bool parsing_sym_def;
+	/*! The tokens of the current \c #if or \c #elif condition */
+	token_stream_t	tokens;
 } STATE_T(evaluator);
 /*@}*/
 
@@ -967,7 +1177,7 @@ list_symbol(	symbols_policy_t policy,
 	
 */
 static double
-eval_numeral(char const *num, char const **numend)
+scan_numeral(char const *num, char const **numend)
 {
 	int sign = 1;
 	int base = 10;
@@ -1088,15 +1298,38 @@ eval_numeral(char const *num, char const **numend)
 	}
 	*numend = num;
 	if (overflow) {
-		report(GRIPE_INT_OVERFLOW,NULL,
-			"Integer constant \"%.*s\" is too big for sunifdef "
-			"(max %d): expression will not be resolved",
-			num - start,start,INT_MAX);
 		return HUGE_VAL;
 	}
 	return sign * val;
 }
 
+/*! Complain of an integer constant that is too big.
+	\param	num	The start of the numeral, less any sign.
+	\param	len	The length of the numeral.
+*/
+static void
+report_overflow(char const *num, size_t len)
+{
+	report(GRIPE_INT_OVERFLOW,NULL,
+		"Integer constant \"%.*s\" is too big for sunifdef "
+		"(max %d): expression will not be resolved",
+		(int)len,num,INT_MAX);
+}
+
+/*! Evaluate a string as a numeral as per \c scan_numeral(), complaining
+	if the numeral is too big.
+*/
+static double
+eval_numeral(char const *num, char const **numend)
+{
+	double val = scan_numeral(num,numend);
+	if (val == HUGE_VAL) {
+		char const *start = num + (*num == '-' || *num == '+');
+		report_overflow(start,*numend - start);
+	}
+	return val;
+}
+
 /*!		Evaluate a symbol.
 
 	\param symbol	Pointer to an eval_result_t that
@@ -1143,13 +1376,15 @@ eval_symbol(eval_result_t *symbol)
 				size_t len = strlen(symdef);
 				if (len) {
 					/* Possible expression */
+					token_stream_t def_tokens = { NULL, 0, NULL, 0, 0, 0 };
 					char * symdup = allocate(len + 1);
-					char * heapblk = symdup;
 					strcpy(symdup,symdef);
+					def_tokens.text = symdup;
 					SET_STATE(evaluator,parsing_sym_def) = true;
-					result = eval_table(eval_ops,&symdup);
+					result = eval_table(eval_ops,&def_tokens);
 					SET_STATE(evaluator,parsing_sym_def) = false;
-					free(heapblk);
+					free(def_tokens.toks);
+					free(symdup);
 					if (UNRESOLVED(result)) {
 						SET_FLAGS(*symbol,EVAL_INSOLUBLE);
 					}
@@ -1166,75 +1401,76 @@ eval_symbol(eval_result_t *symbol)
 }
 
 static eval_result_t
-eval_unary(const struct ops *ops, char **cpp)
+eval_unary(const struct ops *ops, token_stream_t *ts)
 {
-	char const *ep;
 	int symind;
-	char *sym_name;
+	size_t sym_off;
+	size_t sym_len;
 	eval_result_t * symbol;
 	eval_result_t result = {0,0,0};
-	char *cp = chew_on(*cpp);
+	token_t *tok = peek_token(ts);
 	do {
 
-		if (*cp == '!') {
-			debug(DBG_1,ops - eval_ops);
-			++cp;
-			result = eval_unary(ops,&cp);
+		if (IS_PUNCT(tok,'!')) {
+			TRACE(TRACE_EVAL_NOT,ops - eval_ops,0,0);
+			next_token(ts);
+			result = eval_unary(ops,ts);
 			if (UNRESOLVED(result)) {
 				break;
 			}
 			result.value = !result.value;
 			FLIP_FLAGS(result,EVAL_RESOLVED);
 		}
-		else if (*cp == '~') {
+		else if (IS_PUNCT(tok,'~')) {
 			eval_result_t neg_result;
-			debug(DBG_22,ops - eval_ops);
-			++cp;
-			neg_result = eval_unary(ops,&cp);
+			TRACE(TRACE_EVAL_COMPL,ops - eval_ops,0,0);
+			next_token(ts);
+			neg_result = eval_unary(ops,ts);
 			if (UNRESOLVED(neg_result)) {
 				break;
 			}
 			set_value(&result,~neg_result.value);
 		}
-		else if (*cp == '(') {
-			char *start = cp;
-			++cp;
-			debug(DBG_2,ops - eval_ops);
-			result = eval_table(eval_ops,&cp);
-			cp = chew_on(cp);
-			if (*cp != ')') {
+		else if (IS_PUNCT(tok,'(')) {
+			size_t lparen = tok->start;
+			next_token(ts);
+			TRACE(TRACE_EVAL_PAREN,ops - eval_ops,0,0);
+			result = eval_table(eval_ops,ts);
+			tok = peek_token(ts);
+			if (!IS_PUNCT(tok,')')) {
 				/* Missing ')' */
 				bail(GRIPE_UNBALANCED_PAREN,
 					"Missing \")\" in \"%.*s\"",
 					line_len(GET_PUBLIC(io,line_start)),
 					GET_PUBLIC(io,line_start));
 			}
-			else if (DEL_PAREN(result)) {
-				delete_paren(start,cp);
+			else if (DEL_PAREN(result) && !ts->text) {
+				delete_paren(lparen,tok->start);
 			}
-			++cp;
+			next_token(ts);
 		}
-		else if (*cp == '+') {
-			debug(DBG_20,ops - eval_ops);
-			++cp;
-			result = eval_unary(ops,&cp);
+		else if (IS_PUNCT(tok,'+')) {
+			TRACE(TRACE_EVAL_PLUS,ops - eval_ops,0,0);
+			next_token(ts);
+			result = eval_unary(ops,ts);
 			break;
 		}
-		else if (*cp == '-') {
-			debug(DBG_21,ops - eval_ops);
-			++cp;
-			result = eval_unary(ops,&cp);
+		else if (IS_PUNCT(tok,'-')) {
+			TRACE(TRACE_EVAL_MINUS,ops - eval_ops,0,0);
+			next_token(ts);
+			result = eval_unary(ops,ts);
 			if (UNRESOLVED(result)) {
 				break;
 			}
 			result.value = -result.value;
 		}
-		else if (isdigit((unsigned char)*cp)) {
-			double val;
-			debug(DBG_3,ops - eval_ops);
-			val = eval_numeral(cp,&ep);
-			if (val != HUGE_VAL) {
-				result.value = (int)val;
+		else if (tok->kind == TOK_NUMBER) {
+			TRACE(TRACE_EVAL_NUMBER,ops - eval_ops,0,0);
+			if (tok->overflow) {
+				report_overflow(TOKEN_POS(ts,tok),tok->end - tok->start);
+			}
+			else {
+				result.value = tok->value;
 				if (!GET_STATE(evaluator,parsing_sym_def)) {
 					SET_CONST(result);
 					if (!GET_PUBLIC(args,del_consts)) {
@@ -1248,25 +1484,27 @@ eval_unary(const struct ops *ops, char **cpp)
 					SET_FLAGS(result,result.value ? EVAL_TRUE : EVAL_FALSE);
 				}
 			}
-			cp = (char *)ep;
+			next_token(ts);
 		}
-		else if (strncmp(cp, "defined", 7) == 0 && !symchar(cp[7])) {
+		else if (tok->kind == TOK_DEFINED) {
 			symbols_policy_t symbols_policy;
 			bool paren;
-			ptrdiff_t sym_len;
-			cp = chew_on(cp + 7);
-			debug(DBG_4, ops - eval_ops);
-			paren = *cp == '(';
+			next_token(ts);
+			TRACE(TRACE_EVAL_DEFINED,ops - eval_ops,0,0);
+			tok = peek_token(ts);
+			paren = IS_PUNCT(tok,'(');
 			if (paren) {
-				++cp;
+				next_token(ts);
+				tok = peek_token(ts);
 			}
-			sym_name = chew_on(cp);
-			symind = find_sym(sym_name,&cp);
-			sym_len = cp - sym_name;
-			cp = chew_on(cp);
+			symind = resolve_ident(ts,tok);
+			sym_off = tok->start;
+			sym_len = tok->end - tok->start;
+			next_token(ts);
+			tok = peek_token(ts);
 			if (paren) {
-				if (*cp == ')') {
-					++cp;
+				if (IS_PUNCT(tok,')')) {
+					next_token(ts);
 				}
 				else {
 					/* Missing ')' */
@@ -1276,10 +1514,12 @@ eval_unary(const struct ops *ops, char **cpp)
 						GET_PUBLIC(io,line_start));
 				}
 			}
+			PROFILE_SYMBOL(stream_text(ts) + sym_off,sym_len,symind);
  			symbols_policy =  GET_PUBLIC(args,symbols_policy);
 			if (symbols_policy) {
 				/* --symbols in force */
-				list_symbol(symbols_policy,sym_name,sym_len,symind);
+				list_symbol(symbols_policy,stream_text(ts) + sym_off,
+					sym_len,symind);
 				break;
 			}
 			if (symind < 0) {
@@ -1289,15 +1529,19 @@ eval_unary(const struct ops *ops, char **cpp)
 			symbol = SYMBOL(symind);
 			set_value(&result,symbol->sym_def != NULL);
 		}
-		else if (symchar(*cp)) {
+		else if (tok->kind == TOK_IDENT) {
 			symbols_policy_t symbols_policy;
-			sym_name = cp;
-			debug(DBG_5,ops - eval_ops);
-			symind = find_sym(cp,&cp);
+			TRACE(TRACE_EVAL_SYMBOL,ops - eval_ops,0,0);
+			symind = resolve_ident(ts,tok);
+			sym_off = tok->start;
+			sym_len = tok->end - tok->start;
+			next_token(ts);
+			PROFILE_SYMBOL(stream_text(ts) + sym_off,sym_len,symind);
  			symbols_policy =  GET_PUBLIC(args,symbols_policy);
 			if (symbols_policy) {
 				/* --symbols in force */
-				list_symbol(symbols_policy,sym_name,cp - sym_name,symind);
+				list_symbol(symbols_policy,stream_text(ts) + sym_off,
+					sym_len,symind);
 				break;
 			}
 			if (symind < 0) {
@@ -1323,13 +1567,12 @@ eval_unary(const struct ops *ops, char **cpp)
 			result = *symbol;
 
 		} else {
-			debug(DBG_6,ops - eval_ops);
+			TRACE(TRACE_EVAL_BAD,ops - eval_ops,0,0);
 			break;
 		}
 	} while(false);
-	*cpp = cp;
 	if (RESOLVED(result)) {
-		debug(DBG_7,ops - eval_ops,result.value);
+		TRACE(TRACE_EVAL_UNARY_VALUE,ops - eval_ops,result.value,0);
 	}
 	else {
 		SET_KEEP(result);
@@ -1341,93 +1584,111 @@ static int
 eval_if(char **cpp)
 {
 	eval_result_t result;
-	debug(DBG_11, *cpp);
-	result = eval_table(eval_ops,cpp);
-	debug(DBG_12,result.value);
+	token_stream_t *ts = &SET_STATE(evaluator,tokens);
+	char const *expr = *cpp;
+	unsigned long shorts = GET_PUBLIC(profile,short_circuits);
+	int linetype = LT_IF;
+	stats_phase_t phase = STATS_PHASE(STATS_EVAL);
+	TRACE_TEXT(TRACE_EVAL_IF,0,*cpp,line_len(*cpp));
+	STATS_COUNT(STATS_EVALS);
+	ts->text = NULL;
+	ts->origin = read_offset(*cpp);
+	ts->count = ts->cur = 0;
+	result = eval_table(eval_ops,ts);
+	*cpp = TOKEN_POS(ts,peek_token(ts));
+	TRACE(TRACE_EVAL_IF_VALUE,result.value,0,0);
+	STATS_PHASE(phase);
 
 	if (KEEP_CONST(result)) {
-		return LT_IF;
+		linetype = LT_IF;
 	}
-	if (IS_TRUE(result)) {
-		return LT_TRUE;
+	else if (IS_TRUE(result)) {
+		linetype = LT_TRUE;
 	}
-	if (IS_FALSE(result)) {
-		return LT_FALSE;;
+	else if (IS_FALSE(result)) {
+		linetype = LT_FALSE;
 	}
-	return LT_IF;
+	PROFILE_EXPRESSION(expr,*cpp - expr,
+		linetype == LT_TRUE ? PROFILE_TRUE :
+			linetype == LT_FALSE ? PROFILE_FALSE : PROFILE_INSOLUBLE,
+		shorts);
+	return linetype;
 }
 
 static eval_result_t
-eval_table(const struct ops *ops, char **cpp)
+eval_table(const struct ops *ops, token_stream_t *ts)
 {
-	char *start_cut = (debug(DBG_8, ops - eval_ops),*cpp);
+	size_t start_cut = (TRACE(TRACE_EVAL_TABLE,ops - eval_ops,0,0),
+		expr_start(ts));
 	/* Evaluate the lhs... */
-	eval_result_t lhs_result = ops->inner(ops+1,cpp);
+	eval_result_t lhs_result = ops->inner(ops+1,ts);
 	/* Assume lhs is all we've got... */
 	eval_result_t result = lhs_result;
+	token_t *tok;
 	/* Assume we will delete parentheses... */
-	char * cp = *cpp;
 	SET_DEL_PAREN(result);
-	for (; *(cp = chew_on(cp)) && *cp != ')'; ) {
+	for (; (tok = peek_token(ts))->kind != TOK_END && !IS_PUNCT(tok,')'); ) {
 		eval_result_t rhs_result = {0,0,0};
-		char *start_lhs_cut = start_cut;
-		char *end_lhs_cut = cp;
+		size_t start_lhs_cut = start_cut;
+		size_t end_lhs_cut = tok->start;
 		const struct operation *op;
+		size_t op_len;
 
 		/* Now look for binary op at current precedence... */
-		for (op = ops->op; op->str != NULL && !op_cmp(cp,op->str); op++){}
+		for (op = ops->op; op->str != NULL && !op_cmp(tok,op->str); op++){}
 		if (op->str == NULL) { /* No binary op, no rhs */
 			break;
 		}
-		cp += strlen(op->str);
+		for (op_len = strlen(op->str); op_len; --op_len) {
+			next_token(ts);
+		}
 			/* Got bin op - we will not delete parentheses... */
 		CLEAR_FLAGS(result,EVAL_DEL_PAREN);
 		if (RESOLVED(lhs_result) && !KEEP_CONST(lhs_result)) {
 			/* ...Possibly can short-circuit */
 			if (IS_TRUE(lhs_result) && op->fn == op_or) {
 				/*	Can shortcircuit on TRUE || <RHS>... */
-				cp = short_circuit_or(cp);
+				short_circuit_or(ts);
 				/* result == lhs_result. OK */
 				break;
 			}
 			else if (IS_FALSE(lhs_result) && op->fn == op_and) {
 				/*	Can shortcircuit on FALSE && <RHS>... */
-				cp = short_circuit_and(cp);
+				short_circuit_and(ts);
 				/* result == lhs_result. OK */
 				break;
 			}
 			else if ((IS_TRUE(lhs_result) && op->fn == op_and) ||
 						(IS_FALSE(lhs_result) && op->fn == op_or)) {
 				/* Can delete TRUE &&, or FALSE ||... */
-				cut_text(start_lhs_cut,cp);
+				cut_span(ts,start_lhs_cut,expr_start(ts));
 				/* Cutting lhs can make superflous parentheses */
 				SET_DEL_PAREN(result);
 			}
 		}
 		start_cut = end_lhs_cut;
-		end_lhs_cut = cp;
-		debug(DBG_9, ops - eval_ops, op->str);
+		end_lhs_cut = expr_start(ts);
+		TRACE_TEXT(TRACE_EVAL_OP,ops - eval_ops,op->str,(size_t)-1);
 		/* Evaluate rhs... */
-		rhs_result = ops->inner(ops,&cp);
+		rhs_result = ops->inner(ops,ts);
 		result = op->fn(&lhs_result,&rhs_result);
 		if (op->fn == op_or || op->fn == op_and) {
 			if (!KEEP(lhs_result) && KEEP(rhs_result)) {
-				cut_text(start_lhs_cut,end_lhs_cut);
+				cut_span(ts,start_lhs_cut,end_lhs_cut);
 				SET_FLAGS(result,EVAL_DEL_PAREN | EVAL_KEEP);
 			}
 			else if (!KEEP(rhs_result) && KEEP(lhs_result)) {
-				cut_text(start_cut,cp);
+				cut_span(ts,start_cut,peek_token(ts)->start);
 				SET_FLAGS(result,EVAL_DEL_PAREN | EVAL_KEEP);
 			}
 		}
 	}
 	if (RESOLVED(result)) {
-		debug(DBG_10, ops - eval_ops, result.value);
+		TRACE(TRACE_EVAL_TABLE_VALUE,ops - eval_ops,result.value,0);
 	}
 	else {
 		SET_KEEP(result);
 	}
-	*cpp = cp;
 	return result;
 }
 
@@ -1452,9 +1713,18 @@ eval_line(void)
 		return LT_EOF;
 	}
 
-	SET_PUBLIC(line_edit,simplification_state) = UNSIMPLIFIED;
+	clear_edits();
 		/* Assume no simplification possible */
 	retval = LT_PLAIN;
+	if (lex_map_inert_line(GET_PUBLIC(io,line_num)) &&
+		GET_PUBLIC(chew,comment_state) == NO_COMMENT &&
+		GET_PUBLIC(chew,line_state) == LS_NEUTER && !in_quotation()) {
+		/* Already lexed as a plain line of code. No need to chew it */
+		flush_contradiction();
+		TRACE(TRACE_PARSER_STATE,GET_PUBLIC(chew,comment_state),
+			GET_PUBLIC(chew,line_state),0);
+		return retval;
+	}
 	wascomment = GET_PUBLIC(chew,comment_state);
 	cp = chew_on(GET_PUBLIC(io,line_start));
 	if (GET_PUBLIC(chew,line_state) == LS_NEUTER) {
@@ -1492,10 +1762,12 @@ eval_line(void)
 			if (strncmp(kwpos,"def",kwlen) == 0 ) {
 				/* Got #ifdef or #ifndef */
 				char *name;
+				STATS_COUNT(ifdef ? STATS_DIR_IFDEF : STATS_DIR_IFNDEF);
 				cp = chew_on(cp);
 				name = cp;
 				cursym = find_sym(cp,&cp);
 				retval = LT_IF;
+				PROFILE_SYMBOL(name,cp - name,cursym);
 				if (symbols_policy) {
 					list_symbol(symbols_policy,name,cp - name,cursym);
 				}
@@ -1511,6 +1783,7 @@ eval_line(void)
 				}
 			}
 			else { /* Just #if */
+				STATS_COUNT(STATS_DIR_IF);
 				SET_STATE(evaluator,ifpos) = cp;
 				retval = eval_if(&cp);
 			}
@@ -1520,15 +1793,19 @@ eval_line(void)
 			char const *kwpos = GET_PUBLIC(line_edit,keyword) + 1;
 			--kwlen;
 			if (strncmp(kwpos,"lif",kwlen) == 0) { /* #elif */
+				STATS_COUNT(STATS_DIR_ELIF);
 				retval = eval_if(&cp) - LT_IF + LT_ELIF;
 			}
 			else if (strncmp(kwpos,"lse",kwlen) == 0) { /* #else */
+				STATS_COUNT(STATS_DIR_ELSE);
 				retval = LT_ELSE;
 			}
 			else if (strncmp(kwpos,"ndif",kwlen) == 0) { /* #endif */
+				STATS_COUNT(STATS_DIR_ENDIF);
 				retval = LT_ENDIF;
 			}
 			else if (strncmp(kwpos,"rror",kwlen) == 0) { /* #error */
+				STATS_COUNT(STATS_DIR_ERROR);
 				SET_PUBLIC(chew,comment_state) = PSEUDO_COMMENT;
 				if (!symbols_policy && !dropping_line()) {
 					SET_PUBLIC(chew,last_comment_start_line) =
@@ -1548,16 +1825,19 @@ eval_line(void)
 			}
 		}
 		else if (strncmp(GET_PUBLIC(line_edit,keyword),"define",kwlen) == 0) {
+			STATS_COUNT(STATS_DIR_DEFINE);
 			if (!symbols_policy && !dropping_line()) {
 				retval = eval_define(&cp);
 			}
 		}
 		else if (strncmp(GET_PUBLIC(line_edit,keyword),"undef",kwlen) == 0 ) {
+			STATS_COUNT(STATS_DIR_UNDEF);
 			if (!symbols_policy && !dropping_line()) {
 				retval = eval_undef(&cp);
 			}
 		}
 		else {
+			STATS_COUNT(STATS_DIR_OTHER);
 			SET_PUBLIC(chew,line_state) = LS_CODE;
 			retval = LT_PLAIN;
 		}
@@ -1597,7 +1877,8 @@ eval_line(void)
 			cp = chew_on(cp + 1);
 		}
 	}
-	debug(DBG_17);
+	TRACE(TRACE_PARSER_STATE,GET_PUBLIC(chew,comment_state),
+		GET_PUBLIC(chew,line_state),0);
 	return (retval);
 }
 
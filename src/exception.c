@@ -46,8 +46,13 @@
  * This file implements the Exception module.
  */
 
-jmp_buf exception_context;
+/*! \addtogroup exception_module */
+/*@{*/
 
-bool exceptions_enabled = 0;
+/*! The global state of the Exception module */
+NO_PRIVATE_STATE(exception);
+
+IMPLEMENT(exception,ZERO_INITABLE);
+/*@}*/
 
 /* EOF */
@@ -49,25 +49,29 @@
 /*!	\addtogroup exception_module */
 /*@{*/
 
-/*! The execution context to which exceptions return.
-*/
-extern jmp_buf exception_context;
+/*! The public state of the Exception module */
+PUBLIC_STATE_DEF(exception) {
+	jmp_buf	context;	/*!< The execution context to which exceptions return */
+	bool	enabled;	/*!< Status of exception handling, enabled/disabled */
+	bool	hosted;
+		/*!< Is sunifdef hosted by another program, so that abends are
+			thrown as exceptions instead of terminating the program? */
+} PUBLIC_STATE_T(exception);
 
-/*! Status of exception handling, enabled/disabled */
-extern bool exceptions_enabled;
+IMPORT(exception);
 
 /*! Catch an exception.
 	The macro returns 0 if no exception was
 	thrown, else the integer exception.
 */
-#define catch()		setjmp(exception_context)
+#define catch()		setjmp(SET_PUBLIC(exception,context))
 
 /*! Throw an exception.
 	The function causes control to pass to the site
 	of the last call to \c catch(), which will then
 	return the value \c exception
 */
-#define throw(x)	longjmp(exception_context,(x))
+#define throw(x)	longjmp(SET_PUBLIC(exception,context),(x))
 
 /*@}*/
 
@@ -36,11 +36,13 @@
  *                                                                         *
  ***************************************************************************/
 
+#define MEMORY_TAG	MEMORY_FILE_TREE
 #include "file_tree.h"
 #include "filesys.h"
-#include "ptr_vector.h"
 #include "platform.h"
 #include "report.h"
+#include "thread.h"
+#include "hash.h"
 #include <ctype.h>
 #include <stdio.h>
 
@@ -52,24 +54,34 @@
 /*! \addtogroup file_tree_internals */
 /*@{*/
 
+/*! Type of the index of a node in the store of a file tree */
+typedef unsigned node_ix_t;
+
+/*! The index of the root node in the store of a file tree */
+#define ROOT_IX	((node_ix_t)0)
+
 /*! Value of the \c parent field in \c struct \c file_tree
 	indicating the the true value has yet to be set.
 */
-#define PARENT_PENDING	((void *)-1)
+#define PARENT_PENDING	((node_ix_t)-1)
+/*! Value of the \c first field in \c struct \c file_tree
+	indicating that the node represents a file.
+*/
+#define NO_CHILDREN	((unsigned)-1)
 /*!
 	Test whether a file tree is not yet linked to its
 	parent.
 */
 #define IS_UNLINKED(ftree)	((ftree)->parent == PARENT_PENDING)
 /*!
-	A file tree is a root node if it has no parent
+	A file tree is a root node if it is the first node in its store
 */
-#define IS_ROOT(ftree)	((ftree)->parent == NULL)
+#define IS_ROOT(ftree)	((ftree)->self == ROOT_IX)
 /*!
-	A file tree represents a file if it has no list of
-	children (not even an empty list).
+	A file tree represents a file if it has no range of
+	children (not even an empty range).
 */
-#define IS_FILE(ftree)	((ftree)->children == NULL)
+#define IS_FILE(ftree)	((ftree)->first == NO_CHILDREN)
 /*!
 	A file tree represents a directory if it does not
 	represent a file.
@@ -108,86 +120,301 @@
 */
 #define COUNT_CHILDREN(flags) (((flags) & FT_COUNT_CHILDREN) == FT_COUNT_CHILDREN)
 
+/*!
+	The number of children at which the children of a directory node
+	are indexed by name.
+*/
+#define CHILD_INDEX_MIN	16
+
+/*! log2 of the number of nodes in each block of nodes of a file tree */
+#define NODE_BLOCK_SHIFT	10
+
+/*! The number of nodes in each block of nodes of a file tree */
+#define NODE_BLOCK_SIZE	(1 << NODE_BLOCK_SHIFT)
+
+/*! log2 of the number of bytes in each block of leafnames of a file tree.
+	A leafname is addressed by an offset whose low \c NAME_BLOCK_SHIFT bits
+	are its position in its block and whose high bits are the number of
+	the block.
+*/
+#define NAME_BLOCK_SHIFT	16
+
+/*! The number of bytes in each block of leafnames of a file tree */
+#define NAME_BLOCK_SIZE	(1 << NAME_BLOCK_SHIFT)
+
+/*! The initial number of slots in each hash table of a file tree */
+#define HASH_TABLE_MIN	64
+
 /*! Structure representing a file or directory in
 	relation to its parent directory (if any) and
-	contained files (if any)
+	contained files (if any).
+
+	Nodes are allocated in blocks from the store of their file tree and
+	never move, so a handle to a node is good for the life of the tree.
+	Nodes refer to one another by their indices in the store.
 */
 struct file_tree {
-	union {
-		heap_str leafname;	/*!< In non-root node, leafname of file
-								or directory */
-		file_filter_t filter;	/*!< In root-node, pointer to the
-								filter function of the tree. */
-	} var;
-	struct file_tree * parent;	 /*!< NULL for root node. For
-								non-root node, node representing
-								parent directory */
-	ptr_vector_h children;	/*!< Immediate children of directory node,
-								or NULL */
+	struct file_store *store;	/*!< The store of the tree */
+	node_ix_t self;		/*!< The index of this node in the store */
+	node_ix_t parent;	/*!< The index of the node representing the
+							parent directory, or \c PARENT_PENDING for
+							the root node or a node not yet linked */
+	unsigned name;		/*!< The offset of the leafname in the store */
+	unsigned first;		/*!< In a directory node, the position of the
+							indices of its children in the child table
+							of the store; else \c NO_CHILDREN */
+	unsigned count;		/*!< The number of children */
 	unsigned files; /*!< Total number of files (excluding directories)
 						within this tree */
 };
 
+/*! Structure of the storage of all the nodes of a file tree.
+*/
+typedef struct file_store {
+	file_filter_t filter;	/*!< The filter function of the tree */
+	struct file_tree **nodes;	/*!< The blocks of nodes. The first
+									node is the root */
+	size_t node_blocks;		/*!< The number of blocks of nodes */
+	node_ix_t node_count;	/*!< The number of nodes allocated */
+	char **names;			/*!< The blocks of leafnames. Each leafname
+								is stored once however many nodes have it.
+								The first is the empty name of the root */
+	size_t name_blocks;		/*!< The number of blocks of leafnames */
+	size_t name_used;		/*!< Bytes used in the last block of
+								leafnames */
+	unsigned *interned;		/*!< Hash table of the offsets of the
+								leafnames, with open addressing. 0 marks
+								an empty slot */
+	size_t interned_size;	/*!< Slots in \c interned, a power of 2 */
+	size_t interned_count;	/*!< Leafnames in \c interned */
+	node_ix_t *kids;		/*!< The child table: for each directory node,
+								the indices of its children in order */
+	size_t kids_len;		/*!< Entries used in \c kids */
+	size_t kids_size;		/*!< Capacity of \c kids */
+	node_ix_t *index;		/*!< Hash table, with open addressing, of the
+								children of every directory node that has
+								at least \c CHILD_INDEX_MIN children, by
+								parent and leafname. 0 marks an empty
+								slot */
+	size_t index_size;		/*!< Slots in \c index, a power of 2 */
+	size_t index_count;		/*!< Children in \c index */
+	snapshot_h snapshot;	/*!< NULL, or the snapshot in which
+								directory listings are found and
+								recorded */
+} file_store_t;
+
+/*! The node with a given index in the store of a file tree */
+#define NODE(store,ix) \
+	((store)->nodes[(ix) >> NODE_BLOCK_SHIFT] + ((ix) & (NODE_BLOCK_SIZE - 1)))
+
+/*! The leafname with a given offset in the store of a file tree */
+#define NAME_AT(store,offset) \
+	((store)->names[(offset) >> NAME_BLOCK_SHIFT] + \
+		((offset) & (NAME_BLOCK_SIZE - 1)))
+
+/*! The leafname of a node of a file tree */
+#define LEAFNAME(ftree)	NAME_AT((ftree)->store,(ftree)->name)
+
+/*! The filter function of the file tree to which a node belongs */
+#define FILTER(ftree)	((ftree)->store->filter)
+
 /*!
 	The default filter function for a file tree to which
 	no filter is attached. It accepts all files.
 */
 static bool
-null_filter(char const *leafname)
+null_filter(char const *fullname, char const *leafname, bool is_dir)
 {
+	(void)fullname;
+	(void)leafname;
+	(void)is_dir;
 	return true;
 }
 
 /*!
 	The default callback function for a file tree traversals
-	where none is specified. It does nothing.
+	where none is specified. It does nothing but report symbolic
+	links resolved.
 */
 static void
 null_callback(	file_tree_h tree,
 				char const *name,
 				file_tree_traverse_state_t context)
 {
+	if (context == FT_AT_SYMLINK) {
+		report(GRIPE_SYMLINK,NULL,"Resolved symbolic link \"%s\"",name);
+	}
+}
+
+/*!
+	Intern a leafname in the store of a file tree.
+
+	\param		store		The store.
+	\param		leafname	The leafname, not necessarily nul-terminated.
+	\param		len			The length of \c leafname.
+	\return	The offset of the leafname in the store.
+*/
+static unsigned
+intern_name(file_store_t *store, char const *leafname, size_t len)
+{
+	size_t mask;
+	size_t slot;
+	unsigned offset;
+	char *name;
+	assert(len < NAME_BLOCK_SIZE);
+	if ((store->interned_count + 1) * 2 > store->interned_size) {
+		unsigned *old = store->interned;
+		size_t old_size = store->interned_size;
+		size_t i;
+		store->interned_size =
+			old_size ? old_size * 2 : HASH_TABLE_MIN;
+		store->interned = callocate(store->interned_size,sizeof(unsigned));
+		mask = store->interned_size - 1;
+		for (i = 0; i < old_size; ++i) {
+			if (old[i]) {
+				name = NAME_AT(store,old[i]);
+				slot = hash_bytes(HASH_INIT,name,strlen(name)) & mask;
+				while (store->interned[slot]) {
+					slot = (slot + 1) & mask;
+				}
+				store->interned[slot] = old[i];
+			}
+		}
+		free(old);
+	}
+	mask = store->interned_size - 1;
+	slot = hash_bytes(HASH_INIT,leafname,len) & mask;
+	for (	;(offset = store->interned[slot]) != 0; slot = (slot + 1) & mask) {
+		name = NAME_AT(store,offset);
+		if (!strncmp(name,leafname,len) && name[len] == '\0') {
+			return offset;
+		}
+	}
+	if (store->name_used + len + 1 > NAME_BLOCK_SIZE) {
+		store->names = reallocate(store->names,
+			(store->name_blocks + 1) * sizeof(char *));
+		store->names[store->name_blocks++] = allocate(NAME_BLOCK_SIZE);
+		store->name_used = 0;
+	}
+	offset = (unsigned)(((store->name_blocks - 1) << NAME_BLOCK_SHIFT) |
+		store->name_used);
+	name = NAME_AT(store,offset);
+	memcpy(name,leafname,len);
+	name[len] = '\0';
+	store->name_used += len + 1;
+	store->interned[slot] = offset;
+	++store->interned_count;
+	return offset;
+}
+
+/*!
+	Construct an empty store for a file tree, with its root node.
+
+	\return	The root node.
+*/
+static file_tree_h
+new_store(void)
+{
+	file_store_t *store = callocate(1,sizeof(file_store_t));
+	file_tree_h root;
+	store->filter = null_filter;
+	store->names = allocate(sizeof(char *));
+	store->names[store->name_blocks++] = allocate(NAME_BLOCK_SIZE);
+	store->names[0][0] = '\0';
+	store->name_used = 1;
+	store->nodes = allocate(sizeof(struct file_tree *));
+	store->nodes[store->node_blocks++] =
+		allocate(NODE_BLOCK_SIZE * sizeof(struct file_tree));
+	root = NODE(store,ROOT_IX);
+	memset(root,0,sizeof(struct file_tree));
+	root->store = store;
+	root->parent = PARENT_PENDING;
+	store->node_count = 1;
+	return root;
+}
+
+/*!
+	Dispose of the store of a file tree and all its nodes.
+*/
+static void
+dispose_store(file_store_t *store)
+{
+	size_t i;
+	for (i = 0; i < store->node_blocks; ++i) {
+		free(store->nodes[i]);
+	}
+	for (i = 0; i < store->name_blocks; ++i) {
+		free(store->names[i]);
+	}
+	free(store->nodes);
+	free(store->names);
+	free(store->interned);
+	free(store->kids);
+	free(store->index);
+	free(store);
 }
 
 /*!
 	Construct a new file tree node.
 
+	\param		store		The store of the file tree.
 	\param		leafname	Pointer to the name of the new node.
 	\param		len			The length of the name at \c leafname.
 				If 0, \c strlen(leafname) is used.
 
-	\return	The new node.
+	\return	The new node, which represents a file until it is
+				made a directory with \c make_dir().
 */
 static file_tree_h
-new_node(char const *leafname, size_t len)
+new_node(file_store_t *store, char const *leafname, size_t len)
 {
-	file_tree_h tree = callocate(1,sizeof(struct file_tree));
+	node_ix_t ix = store->node_count++;
+	file_tree_h tree;
 	if (!len) {
 		len = strlen(leafname);
 	}
+	if (!(ix & (NODE_BLOCK_SIZE - 1))) {
+		store->nodes = reallocate(store->nodes,
+			(store->node_blocks + 1) * sizeof(struct file_tree *));
+		store->nodes[store->node_blocks++] =
+			allocate(NODE_BLOCK_SIZE * sizeof(struct file_tree));
+	}
+	tree = NODE(store,ix);
+	tree->store = store;
+	tree->self = ix;
 	tree->parent = PARENT_PENDING;
-	tree->var.leafname = allocate(len + 1);
-	strncpy(tree->var.leafname,leafname,len);
+	tree->name = intern_name(store,leafname,len);
+	tree->first = NO_CHILDREN;
+	tree->count = 0;
+	tree->files = 0;
 	return tree;
 }
 
+/*!
+	Make a file tree node represent a directory, with no children.
+*/
+static void
+make_dir(file_tree_h tree)
+{
+	tree->first = 0;
+	tree->count = 0;
+}
 
 /*!
 	Construct a new file tree node to represent a file.
 
+	\param		store		The store of the file tree.
+	\param		fullname	The absolute name of the file.
 	\param		leafname	The name of the new node.
-	\param		filter		Pointer to a function that
-				shall be	applied to \c leafname to accept or
-				reject it for constructing a node.
-	\return	iIf \c leafname satisfies \c filter then
-				a new node is returned; else NULL.
+	\return	iIf \c fullname satisfies the filter of the file tree
+				then a new node is returned; else NULL.
 */
 static file_tree_h
-new_file_node(char const *leafname, file_filter_t filter)
+new_file_node(file_store_t *store, char const *fullname, char const *leafname)
 {
 	file_tree_h tree = NULL;
-	if (filter(leafname)) {
-		tree = new_node(leafname,0);
+	if (store->filter(fullname,leafname,false)) {
+		tree = new_node(store,leafname,0);
 		tree->files = 1;
 	}
 	return tree;
@@ -204,8 +431,156 @@ new_file_node(char const *leafname, file_filter_t filter)
 static file_tree_h
 get_parent(file_tree_h child)
 {
-	return IS_UNLINKED(child) || IS_ROOT(child) ? NULL : child->parent;
+	return IS_UNLINKED(child) ? NULL : NODE(child->store,child->parent);
+}
+
+/*!
+	Return a child of a directory node.
+
+	\param		parent	The directory node.
+	\param		which	The position of the child, less than
+						\c parent->count.
+*/
+static file_tree_h
+get_child(file_tree_h parent, size_t which)
+{
+	file_store_t *store = parent->store;
+	return NODE(store,store->kids[parent->first + which]);
+}
+
+/*!
+	Hash a leafname, with the index of its parent, for the index of
+	children in a file tree.
+
+	\param		parent	The index of the parent node.
+	\param		name	The leafname.
+	\param		len		The length of \c name.
+*/
+static size_t
+index_hash(node_ix_t parent, char const *name, size_t len)
+{
+	return (size_t)hash_bytes(hash_bytes(HASH_INIT,&parent,sizeof(parent)),
+		name,len);
+}
+
+/*!
+	Add a linked child to the index of children of a file tree, making
+	room for it if need be.
+*/
+static void
+index_insert(file_store_t *store, file_tree_h child)
+{
+	size_t mask;
+	size_t slot;
+	char const *name;
+	if ((store->index_count + 1) * 2 > store->index_size) {
+		node_ix_t *old = store->index;
+		size_t old_size = store->index_size;
+		size_t i;
+		store->index_size = old_size ? old_size * 2 : HASH_TABLE_MIN;
+		store->index = callocate(store->index_size,sizeof(node_ix_t));
+		store->index_count = 0;
+		for (i = 0; i < old_size; ++i) {
+			if (old[i]) {
+				index_insert(store,NODE(store,old[i]));
+			}
+		}
+		free(old);
+	}
+	mask = store->index_size - 1;
+	name = LEAFNAME(child);
+	slot = index_hash(child->parent,name,strlen(name)) & mask;
+	while (store->index[slot]) {
+		slot = (slot + 1) & mask;
+	}
+	store->index[slot] = child->self;
+	++store->index_count;
+}
+
+/*!
+	Bring the index of children in a file tree up to date after
+	children have been appended to a directory node.
+
+	\param		parent	The directory node.
+	\param		added	The number of children appended.
+
+	A directory with fewer than \c CHILD_INDEX_MIN children is not
+	indexed. When a directory reaches that number, all its children
+	are indexed.
+*/
+static void
+index_children(file_tree_h parent, size_t added)
+{
+	size_t i = parent->count - added;
+	if (parent->count < CHILD_INDEX_MIN) {
+		return;
+	}
+	if (i < CHILD_INDEX_MIN) {
+		i = 0;
+	}
+	for (	;i < parent->count; ++i) {
+		index_insert(parent->store,get_child(parent,i));
+	}
+}
+
+/*!
+	Link child nodes to their parent node in a file tree.
+
+	\param		parent		The parent node.
+	\param		children	The child nodes.
+	\param		count		The number of child nodes.
+
+	The children are added to the children of \e parent in order,
+	\e parent is assigned as the parent of each child, and the index of
+	the children of \e parent is updated once for them all.
+
+	The indices of the children of a directory are kept contiguous in
+	the child table of the store. If they are not at the end of the
+	table they are moved there before more are appended.
+*/
+static void
+link_children(file_tree_h parent, file_tree_h *children, size_t count)
+{
+	file_store_t *store = parent->store;
+	unsigned new_files = 0;
+	size_t i;
+	file_tree_h child = parent;
+	if (!count) {
+		return;
+	}
+	assert(IS_DIR(parent));
+	if (store->kids_len + parent->count + count > store->kids_size) {
+		store->kids_size = store->kids_size ? store->kids_size * 2 : 256;
+		while (store->kids_len + parent->count + count > store->kids_size) {
+			store->kids_size *= 2;
+		}
+		store->kids = reallocate(store->kids,
+			store->kids_size * sizeof(node_ix_t));
+	}
+	if (!parent->count) {
+		parent->first = (unsigned)store->kids_len;
+	}
+	else if (parent->first + parent->count != store->kids_len) {
+		memcpy(store->kids + store->kids_len,store->kids + parent->first,
+			parent->count * sizeof(node_ix_t));
+		parent->first = (unsigned)store->kids_len;
+		store->kids_len += parent->count;
+	}
+	for (i = 0; i < count; ++i) {
+		assert(!IS_ROOT(children[i]));
+		children[i]->parent = parent->self;
+		store->kids[store->kids_len++] = children[i]->self;
+		new_files += children[i]->files;
+	}
+	parent->count += (unsigned)count;
+	index_children(parent,count);
+	if (new_files) {
+		for	(	;parent; child = parent,parent = get_parent(child)) {
+			parent->files += new_files;
+		}
+	}
 }
+
 /*!
 	Link a child node to its parent node in a file tree.
 
@@ -219,90 +594,659 @@ get_parent(file_tree_h child)
 static void
 link(file_tree_h parent, file_tree_h child)
 {
-	unsigned new_files;
-	assert(!IS_ROOT(child));
-	if (!parent->children) {
-		parent->children = ptr_vector_new();
+	link_children(parent,&child,1);
+}
+
+/*!
+	Find the child of a directory node that has a given leafname.
+
+	\param		node	The directory node.
+	\param		name	The leafname, not necessarily nul-terminated.
+	\param		len		The length of \c name.
+	\return	The child named \c name, or NULL if there is none.
+*/
+static file_tree_h
+find_child(file_tree_h node, char const *name, size_t len)
+{
+	file_store_t *store = node->store;
+	if (IS_FILE(node)) {
+		return NULL;
 	}
-	child->parent = parent;
-	ptr_vector_append(parent->children,child);
-	new_files = child->files;
-	if (new_files) {
-		for	(	;parent; child = parent,parent = get_parent(child)) {
-			parent->files += new_files;
+	if (node->count >= CHILD_INDEX_MIN) {
+		size_t mask = store->index_size - 1;
+		size_t slot = index_hash(node->self,name,len) & mask;
+		node_ix_t ix;
+		for (	;(ix = store->index[slot]) != 0; slot = (slot + 1) & mask) {
+			file_tree_h child = NODE(store,ix);
+			char const *leafname = LEAFNAME(child);
+			if (child->parent == node->self &&
+				!strncmp(leafname,name,len) && leafname[len] == '\0') {
+				return child;
+			}
+		}
+	}
+	else {
+		size_t i;
+		for (i = 0; i < node->count; ++i) {
+			file_tree_h child = get_child(node,i);
+			char const *leafname = LEAFNAME(child);
+			if (!strncmp(leafname,name,len) && leafname[len] == '\0') {
+				return child;
+			}
+		}
+	}
+	return NULL;
+}
+
+/*! The maximum number of directories waiting in the work queue of a walk
+	that are held open
+*/
+#define WALK_MAX_OPEN_DIRS	64
+
+/*! Structure of an entry in a directory listing made by the
+	directory walker.
+*/
+typedef struct scan_entry {
+	heap_str fullname;		/*!< The absolute name of the entry */
+	char const *leafname;	/*!< The leafname of the entry, within
+								\c fullname */
+	fs_obj_type_t obj_type;	/*!< The type of the entry */
+	struct dir_scan *subdir;	/*!< If the entry is a directory that
+									is to be searched, its listing;
+									else NULL */
+} scan_entry_t;
+
+/*! Structure of the listing of a directory made by the
+	directory walker.
+*/
+typedef struct dir_scan {
+	struct dir_scan *parent;	/*!< The listing of the parent directory,
+									or NULL */
+	char const *path;		/*!< The name by which the directory is
+								opened */
+	heap_str dirname;		/*!< The real name of the directory, or NULL
+								if the directory cannot be opened */
+	scan_entry_t *entries;	/*!< The entries of the directory in the
+								order they were read */
+	size_t count;			/*!< The number of entries */
+	size_t size;			/*!< The capacity of \c entries */
+	struct dir_scan *next;	/*!< The next listing in the work queue */
+	bool queued;			/*!< Has the listing been put in the work
+								queue? */
+	bool done;				/*!< Has the listing been made? */
+	int error;				/*!< The reason code of a bail while the
+								listing was made by a walker thread,
+								or 0 */
+	char *error_msg;		/*!< NULL, or the diagnostic of \c error */
+	fs_dir_t dir;			/*!< NULL, or the handle of the directory,
+								opened relative to its parent when the
+								parent was listed */
+} dir_scan_t;
+
+/*! Structure of a directory walk: the work queue of directories to be
+	listed, shared by the walker threads, and the parameters with which
+	the listings are merged into a file tree.
+*/
+typedef struct walk {
+	file_tree_h root;		/*!< The root of the file tree */
+	file_tree_callback_t callback;	/*!< Callback for each node merged */
+	int jobs;				/*!< The maximum number of walker threads */
+	thread_t *threads;		/*!< NULL, or the walker threads started */
+	bool closing;			/*!< Are the walker threads to finish? */
+	bool abandoned;			/*!< Are the walker threads to finish
+								without emptying the work queue? */
+	thread_lock_t lock;		/*!< Lock on the work queue */
+	thread_cond_t cond;		/*!< Signalled when the work queue changes
+								or a listing is made */
+	dir_scan_t *head;		/*!< First directory waiting to be listed */
+	dir_scan_t *tail;		/*!< Last directory waiting to be listed */
+	int open_dirs;			/*!< Directories waiting to be listed that
+								are held open */
+} walk_t;
+
+/*!
+	Construct a new, empty directory listing.
+
+	\param		parent	The listing of the parent directory, or NULL.
+	\param		path	The name by which the directory is to be opened.
+	\return	The new listing.
+*/
+static dir_scan_t *
+scan_new(dir_scan_t *parent, char const *path)
+{
+	dir_scan_t *scan = callocate(1,sizeof(dir_scan_t));
+	scan->parent = parent;
+	scan->path = path;
+	return scan;
+}
+
+/*! Dispose of a directory listing. The listings of its subdirectories
+	must have been disposed.
+*/
+static void
+scan_dispose(dir_scan_t *scan)
+{
+	size_t i;
+	for (i = 0; i < scan->count; ++i) {
+		assert(!scan->entries[i].subdir);
+		free(scan->entries[i].fullname);
+	}
+	free(scan->entries);
+	free(scan->dirname);
+	free(scan->error_msg);
+	free(scan);
+}
+
+/*!
+	Say whether another directory may be held open in the work queue of
+	a walk, and if so count it.
+*/
+static bool
+walk_hold_dir(walk_t *walk)
+{
+	bool hold;
+	if (walk->lock) {
+		thread_lock(walk->lock);
+	}
+	hold = walk->open_dirs < WALK_MAX_OPEN_DIRS;
+	walk->open_dirs += hold;
+	if (walk->lock) {
+		thread_unlock(walk->lock);
+	}
+	return hold;
+}
+
+/*!
+	Uncount a directory held open in the work queue of a walk.
+*/
+static void
+walk_hold_dir_done(walk_t *walk)
+{
+	if (walk->lock) {
+		thread_lock(walk->lock);
+	}
+	--walk->open_dirs;
+	if (walk->lock) {
+		thread_unlock(walk->lock);
+	}
+}
+
+/*!
+	Add an entry to the listing of a directory.
+
+	\param		walk		The walk that lists the directory.
+	\param		scan		The listing of the directory.
+	\param		dir			The handle of the directory.
+	\param		dirname_len	The length of \c scan->dirname.
+	\param		leafname	The leafname of the entry.
+	\param		leaf_len	The length of \c leafname.
+	\param		obj_type	The type of the entry.
+	\param		cached		Is the entry taken from a snapshot of the
+							directory, rather than read from it?
+
+	The type of a symbolic link taken from a snapshot is got afresh,
+	as its target may have changed without the directory changing.
+*/
+static void
+scan_add_entry(	walk_t *walk,
+				dir_scan_t *scan,
+				fs_dir_t dir,
+				size_t dirname_len,
+				char const *leafname,
+				size_t leaf_len,
+				fs_obj_type_t obj_type,
+				bool cached)
+{
+	scan_entry_t *entry;
+	if (scan->count == scan->size) {
+		scan->size = scan->size ? scan->size * 2 : 16;
+		scan->entries =
+			reallocate(scan->entries,scan->size * sizeof(scan_entry_t));
+	}
+	entry = scan->entries + scan->count++;
+	entry->fullname = allocate(dirname_len + leaf_len + 2);
+	memcpy(entry->fullname,scan->dirname,dirname_len);
+	entry->fullname[dirname_len] = PATH_DELIM;
+	memcpy(entry->fullname + dirname_len + 1,leafname,leaf_len + 1);
+	entry->leafname = entry->fullname + dirname_len + 1;
+	entry->obj_type = cached && FS_IS_SLINK(obj_type) ?
+		fs_obj_type(entry->fullname) : obj_type;
+	entry->subdir = NULL;
+	if (FS_IS_DIR(entry->obj_type) &&
+		!FILTER(walk->root)(entry->fullname,entry->leafname,true)) {
+		/* Pruned. Forget it */
+		free(entry->fullname);
+		--scan->count;
+		return;
+	}
+	if (!FS_IS_SLINK(entry->obj_type) && FS_IS_DIR(entry->obj_type)) {
+		entry->subdir = scan_new(scan,entry->fullname);
+		if (walk_hold_dir(walk)) {
+			entry->subdir->dir = fs_open_dir(entry->fullname,dir);
+			if (!entry->subdir->dir) {
+				walk_hold_dir_done(walk);
+			}
 		}
 	}
 }
 
+/*!
+	List a directory.
+
+	\param		walk	The walk that lists the directory.
+	\param		scan	The listing of the directory, to be filled in.
+	\param		dir		The handle of the directory, or NULL if it
+						cannot be opened. It is closed on return.
+
+	A listing is made of every entry of the directory, with its type,
+	except for directories, or links to directories, that are rejected
+	by the filter of the file tree. An empty listing is made for each
+	subdirectory that is not a symbolic link, but the subdirectory
+	itself is not read. It is opened relative to the directory if the
+	walk may hold another directory open. If the directory cannot be
+	opened then \c scan->dirname is left NULL.
+
+	If a snapshot is attached to the file tree, the entries are taken
+	from the snapshot if it holds a current listing of the directory.
+	Otherwise the directory is read and all its entries are recorded in
+	the snapshot, before any are rejected by the filter.
+
+	The function is called concurrently by the walker threads and must
+	touch nothing but \c scan, the count of open directories and the
+	snapshot, apart from calling the filter.
+*/
+static void
+scan_dir(walk_t *walk, dir_scan_t *scan, fs_dir_t dir)
+{
+	snapshot_h snap = walk->root->store->snapshot;
+	snapshot_listing_h listing = NULL;
+	char const *leafname;
+	char const *cur_entry;
+	char const *dirname;
+	size_t dirname_len;
+	fs_stamp_t stamp;
+	if (!dir) {
+		return;
+	}
+	dirname = fs_cur_dir_entry(dir,&cur_entry);
+	dirname_len = cur_entry - dirname;
+	scan->dirname = allocate(dirname_len + 1);
+	memcpy(scan->dirname,dirname,dirname_len + 1);
+	if (snap && fs_dir_stamp(dir,&stamp)) {
+		listing = snapshot_find(snap,scan->dirname,&stamp);
+		if (listing) {
+			size_t count = snapshot_listing_count(listing);
+			size_t i;
+			for (i = 0; i < count; ++i) {
+				fs_obj_type_t obj_type;
+				size_t leaf_len;
+				leafname = snapshot_listing_entry(listing,i,&leaf_len,&obj_type);
+				scan_add_entry(walk,scan,dir,dirname_len,leafname,leaf_len,
+					obj_type,true);
+			}
+			fs_close_dir(dir);
+			return;
+		}
+		listing = snapshot_listing_new(scan->dirname,&stamp);
+	}
+	while((leafname = fs_read_dir(dir,NULL)) != NULL) {
+		size_t leaf_len = strlen(leafname);
+		fs_obj_type_t obj_type = fs_cur_entry_type(dir);
+		if (listing) {
+			snapshot_listing_add(listing,leafname,leaf_len,obj_type);
+		}
+		scan_add_entry(walk,scan,dir,dirname_len,leafname,leaf_len,
+			obj_type,false);
+	}
+	if (listing) {
+		snapshot_record(snap,&listing);
+	}
+	fs_close_dir(dir);
+}
+
+/*!
+	Make a directory listing.
+
+	\param		walk	The walk that lists the directory.
+	\param		scan	The listing to be made.
+
+	The directory is read from the handle held open for it, if any,
+	else opened by name.
+*/
+static void
+scan_make(walk_t *walk, dir_scan_t *scan)
+{
+	fs_dir_t dir = scan->dir;
+	if (dir) {
+		scan->dir = NULL;
+		walk_hold_dir_done(walk);
+	}
+	else {
+		dir = fs_open_real_dir(scan->path);
+	}
+	scan_dir(walk,scan,dir);
+}
+
+/*!
+	Add a directory listing to the work queue of a walk.
+
+	\param		walk	The walk.
+	\param		scan	The listing to be made.
+
+	The caller must hold the lock of the work queue.
+*/
+static void
+walk_push(walk_t *walk, dir_scan_t *scan)
+{
+	scan->next = NULL;
+	scan->queued = true;
+	if (walk->tail) {
+		walk->tail->next = scan;
+	}
+	else {
+		walk->head = scan;
+	}
+	walk->tail = scan;
+}
+
+/*!
+	Make a directory listing on a walker thread.
+
+	\param		walk	The walk that lists the directory.
+	\param		scan	The listing to be made.
+	\param		trap	The trap for errors on the walker thread.
+
+	A bail while the listing is made must not unwind the stack of
+	another thread, so it is trapped and recorded in the listing, to be
+	raised by the thread that merges the listing.
+*/
+static void
+walker_scan(walk_t *walk, dir_scan_t *scan, thread_trap_t *trap)
+{
+	if (!setjmp(trap->context)) {
+		scan_make(walk,scan);
+		return;
+	}
+	scan->error = trap->reason;
+	if (trap->msg[0]) {
+		/* Not allocate(), which may bail */
+		scan->error_msg = malloc(strlen(trap->msg) + 1);
+		if (scan->error_msg) {
+			strcpy(scan->error_msg,trap->msg);
+		}
+	}
+}
+
+/*!
+	Thread function of a directory walker.
+
+	\param		arg	 The \c walk_t of the walk.
+
+	The walker takes listings from the work queue and makes them, adding
+	the listings of subdirectories found to the queue, until the walk
+	is closing and the queue is empty, or the walk is abandoned. The
+	subdirectories of a listing that failed are not queued.
+*/
+static void
+walker(void *arg)
+{
+	walk_t *walk = arg;
+	thread_trap_t trap;
+	thread_set_trap(&trap);
+	thread_lock(walk->lock);
+	for (	;;) {
+		dir_scan_t *scan;
+		size_t i;
+		while (!walk->head && !walk->closing) {
+			thread_cond_wait(walk->cond,walk->lock);
+		}
+		if (!walk->head || walk->abandoned) {
+			break;
+		}
+		scan = walk->head;
+		walk->head = scan->next;
+		if (!walk->head) {
+			walk->tail = NULL;
+		}
+		thread_unlock(walk->lock);
+		walker_scan(walk,scan,&trap);
+		thread_lock(walk->lock);
+		for (i = 0; i < scan->count && !scan->error; ++i) {
+			if (scan->entries[i].subdir) {
+				walk_push(walk,scan->entries[i].subdir);
+			}
+		}
+		/* The listing now belongs to the merging thread */
+		scan->done = true;
+		thread_cond_broadcast(walk->cond);
+	}
+	thread_unlock(walk->lock);
+	thread_set_trap(NULL);
+}
+
+/*!
+	Schedule a directory listing to be made by a walk.
+
+	\param		walk	The walk.
+	\param		scan	The listing to be made.
+
+	If the walk may have more than one thread then the listing is queued
+	for the walker threads, which are started if need be. Otherwise it
+	will be made when it is awaited.
+*/
+static void
+walk_queue(walk_t *walk, dir_scan_t *scan)
+{
+	if (walk->jobs <= 1) {
+		return;
+	}
+	if (!walk->threads) {
+		int i;
+		walk->lock = thread_lock_new();
+		walk->cond = thread_cond_new();
+		walk->threads = callocate(walk->jobs,sizeof(thread_t));
+		for (i = 0; i < walk->jobs; ++i) {
+			walk->threads[i] = thread_start(walker,walk);
+		}
+	}
+	thread_lock(walk->lock);
+	walk_push(walk,scan);
+	thread_cond_broadcast(walk->cond);
+	thread_unlock(walk->lock);
+}
+
+/*!
+	Wait until a directory listing scheduled by \c walk_queue() has been
+	made, making it on the calling thread if no walker threads will.
+*/
+static void
+walk_await(walk_t *walk, dir_scan_t *scan)
+{
+	if (walk->threads) {
+		thread_lock(walk->lock);
+		while (!scan->done) {
+			thread_cond_wait(walk->cond,walk->lock);
+		}
+		thread_unlock(walk->lock);
+	}
+	else if (!scan->done) {
+		scan_make(walk,scan);
+		scan->done = true;
+	}
+}
+
+/*!
+	Stop the walker threads of a walk, if any, when the work queue is
+	empty.
+*/
+static void
+walk_finish(walk_t *walk)
+{
+	int i;
+	if (!walk->threads) {
+		return;
+	}
+	thread_lock(walk->lock);
+	walk->closing = true;
+	thread_cond_broadcast(walk->cond);
+	thread_unlock(walk->lock);
+	for (i = 0; i < walk->jobs; ++i) {
+		thread_join(walk->threads[i]);
+	}
+	free(walk->threads);
+	walk->threads = NULL;
+	thread_lock_dispose(&walk->lock);
+	thread_cond_dispose(&walk->cond);
+}
+
+/*!
+	Raise the error, if any, that a walker thread recorded in a directory
+	listing.
+
+	\param		walk	The walk.
+	\param		scan	A listing that has been awaited.
+
+	The walker threads are stopped before the error is raised, as the
+	walk will not be finished. The listings left in the work queue are
+	not disposed of.
+*/
+static void
+walk_raise(walk_t *walk, dir_scan_t *scan)
+{
+	if (!scan->error) {
+		return;
+	}
+	thread_lock(walk->lock);
+	walk->abandoned = true;
+	thread_unlock(walk->lock);
+	walk_finish(walk);
+	if (scan->error_msg) {
+		bail(scan->error,"%s",scan->error_msg);
+	}
+	bail(scan->error,"Error while searching directories");
+}
+
+/*!
+	Dispose of a directory listing that is not to be merged, and of the
+	listings of its subdirectories, once the walker threads are done
+	with them. A listing that was never queued is not awaited, as no
+	walker thread will make it.
+*/
+static void
+scan_discard(walk_t *walk, dir_scan_t *scan)
+{
+	size_t i;
+	if (scan->queued) {
+		walk_await(walk,scan);
+	}
+	for (i = 0; i < scan->count; ++i) {
+		if (scan->entries[i].subdir) {
+			scan_discard(walk,scan->entries[i].subdir);
+			scan->entries[i].subdir = NULL;
+		}
+	}
+	if (scan->dir) {
+		fs_close_dir(scan->dir);
+		walk_hold_dir_done(walk);
+	}
+	scan_dispose(scan);
+}
+
 /* Forward declaration */
 static void
-file_tree_add_symlink(	file_tree_h root,
-						fs_dir_t parent,
-						char const *symlink,
-						file_tree_callback_t callback);
+file_tree_add_symlink(	walk_t *walk,
+						dir_scan_t const *scan,
+						char const *symlink);
 
+/* Forward declaration */
+static file_tree_h
+merge_dir(	walk_t *walk,
+			char const *leafname,
+			dir_scan_t *scan);
 
 /*!
-	Construct a new file tree node to represent a directory
+	Construct a new file tree node to represent a listed directory entry
+	that is not a symbolic link.
+
+	\param		walk	The walk that listed the entry.
+	\param		entry	The entry.
+	\return		A new node representing the entry, if the entry is
+				a file that satisfies the filter of the file tree or
+				a directory that recursively contains any such files;
+				else NULL.
+
+	A directory that cannot be opened is taken to be a file. The listing
+	of a directory is disposed of once it is merged.
+*/
+static file_tree_h
+merge_entry(walk_t *walk, scan_entry_t *entry)
+{
+	file_tree_h child = NULL;
+	bool is_dir = false;
+	if (entry->subdir) {
+		walk_await(walk,entry->subdir);
+		walk_raise(walk,entry->subdir);
+		if (entry->subdir->dirname) {
+			child = merge_dir(walk,entry->leafname,entry->subdir);
+			is_dir = true;
+		}
+		scan_dispose(entry->subdir);
+		entry->subdir = NULL;
+	}
+	if (!is_dir) {
+		child = new_file_node(walk->root->store,entry->fullname,
+			entry->leafname);
+		if (child) {
+			walk->callback(child,entry->fullname,FT_AT_FILE);
+		}
+	}
+	return child;
+}
+
+/*!
+	Construct a new file tree node to represent a listed directory
 
-	\param		root	The root node of the file tree in which
-						the new node will potentially be added.
+	\param		walk		The walk that listed the directory.
 	\param		leafname	The name of the new node.
-	\param		dir			Handle to the directory of which
-				\c leafname is the leafname.
-	\param		filter		A pointer to a function that
-				shall be	applied to the names of files
-				(not directories) under \c dir	to accept or reject
-				them for inclusion	under the new node.
-	\param		callback	NULL, or a \c file_tree_callback_t to be
-				called at entry	and exit for each directory node
-				constructed and for each file added.
-	\return	If any files are found recursively under \c dir
-				that satisfy \c filter then a new node is returned
-				representing the directory together with all such
-				files and the subdirectories that contain them.
+	\param		scan		The listing of the directory.
+	\return	If any files are found recursively under the directory
+				that satisfy the filter of the file tree then a new node
+				is returned representing the directory together with all
+				such files and the subdirectories that contain them.
+
+	The walk's callback is called at entry and exit for each directory
+	node constructed and for each file added, in the order in which the
+	entries were read from each directory. Each subdirectory is merged
+	as soon as it has been listed, while the walker threads go on
+	listing others.
 */
-
 static file_tree_h
-new_dir_node(	file_tree_h root,
-				char const *leafname,
-				fs_dir_t dir,
-				file_filter_t filter,
-				file_tree_callback_t callback)
+merge_dir(	walk_t *walk,
+			char const *leafname,
+			dir_scan_t *scan)
 {
-	file_tree_h tree = new_node(leafname,0);
-	char const *cur_entry;
-	char const *fullname = fs_cur_dir_entry(dir,&cur_entry);
-	assert(cur_entry[0] == '\0');
-	callback(tree,fullname,FT_ENTERING_DIR);
-	tree->children = ptr_vector_new();
-	while((leafname = fs_read_dir(dir,&fullname)) != NULL) {
-		fs_obj_type_t obj_type = fs_obj_type(fullname);
-		if (FS_IS_SLINK(obj_type)) {
-			file_tree_add_symlink(tree,dir,fullname,callback);
+	file_tree_h tree = new_node(walk->root->store,leafname,0);
+	file_tree_h *children = allocate((scan->count + 1) * sizeof(file_tree_h));
+	size_t count = 0;
+	size_t i;
+	walk->callback(tree,scan->dirname,FT_ENTERING_DIR);
+	make_dir(tree);
+	for (i = 0; i < scan->count; ++i) {
+		scan_entry_t *entry = scan->entries + i;
+		if (FS_IS_SLINK(entry->obj_type)) {
+			file_tree_add_symlink(walk,scan,entry->fullname);
 		}
 		else {
-			file_tree_h child = NULL;
-			fs_dir_t subdir = fs_open_dir(fullname,dir);
-			if (subdir) {
-				child = new_dir_node(root,leafname,subdir,filter,callback);
-				fs_close_dir(subdir);
-			}
-			else {
-				child = new_file_node(leafname,filter);
-				if (child) {
-					callback(child,fullname,FT_AT_FILE);
-				}
-			}
+			file_tree_h child = merge_entry(walk,entry);
 			if (child) {
 				assert(child->files);
-				link(tree,child);
+				children[count++] = child;
 			}
 		}
 	}
-	fullname = fs_cur_dir_entry(dir,&cur_entry);
-	assert(cur_entry[0] == '\0');
-	callback(tree,fullname,FT_LEAVING_DIR);
+	link_children(tree,children,count);
+	free(children);
+	walk->callback(tree,scan->dirname,FT_LEAVING_DIR);
 	if (!tree->files) {
 		file_tree_dispose(&tree);
 	}
@@ -313,30 +1257,17 @@ new_dir_node(	file_tree_h root,
 static file_tree_h
 get_root(file_tree_h tree)
 {
-	if (IS_ROOT(tree)) {
-		return tree;
-	}
-	return get_root(tree->parent);
+	return NODE(tree->store,ROOT_IX);
 }
 
 
+/*!
+	Find the child of a directory node that has a given leafname.
+*/
 static file_tree_h
 seek_child(file_tree_h node, char const *childname)
 {
-	file_tree_h child = NULL;
-	if (node->children) {
-		file_tree_h *start =
-			(file_tree_h *)ptr_vector_start(node->children);
-		file_tree_h *end =
-			(file_tree_h *)ptr_vector_end(node->children);
-		for (	;start != end; ++start) {
-			if (!strcmp(childname,(*start)->var.leafname)) {
-				child = *start;
-				break;
-			}
-		}
-	}
-	return child;
+	return find_child(node,childname,strlen(childname));
 }
 
 
@@ -372,8 +1303,8 @@ seek(file_tree_h tree, char const **path)
 		if (fs_windows_path(path_type) && fs_absolute_path(path_type)) {
 			path_type = 0;
 		}
-		if (tree->var.leafname[elmlen] =='\0' &&
-				!strncmp(tree->var.leafname,posn,elmlen)) {
+		char const *leafname = LEAFNAME(tree);
+		if (leafname[elmlen] =='\0' && !strncmp(leafname,posn,elmlen)) {
 			*path = posn += elmlen;
 		}
 		else {
@@ -384,14 +1315,12 @@ seek(file_tree_h tree, char const **path)
 		if (!fs_windows_path(path_type) || !fs_absolute_path(path_type)) {
 			*path = posn = end + 1;
 		}
-		if (tree->children) {
-			file_tree_h child = NULL;
-			file_tree_h *start =
-				(file_tree_h *)ptr_vector_start(tree->children);
-			file_tree_h *end =
-				(file_tree_h *)ptr_vector_end(tree->children);
-			for (	;start != end && posn == *path; ++start) {
-				child = seek(*start,&posn);
+		if (IS_DIR(tree)) {
+			char const *elmend = strchr(posn,PATH_DELIM);
+			file_tree_h child = find_child(tree,posn,
+				elmend ? (size_t)(elmend - posn) : strlen(posn));
+			if (child) {
+				child = seek(child,&posn);
 			}
 			if (posn != *path) {
 				*path = posn;
@@ -419,8 +1348,8 @@ deepen(file_tree_h tree, char const **path)
 {
 	char const *end = strchr(*path,PATH_DELIM);
 	if (end) {
-		file_tree_h child = new_node(*path,end - *path);
-		child->children = ptr_vector_new();
+		file_tree_h child = new_node(tree->store,*path,end - *path);
+		make_dir(child);
 		link(tree,child);
 		*path = end + 1;
 		tree = deepen(child,path);
@@ -451,15 +1380,15 @@ traverse(	file_tree_h tree,
 			char *path_start,
 			char *path_end)
 {
-	strcpy(path_end,tree->var.leafname);
+	char const *leafname = LEAFNAME(tree);
+	size_t leaflen = strlen(leafname);
+	memcpy(path_end,leafname,leaflen + 1);
 	if (IS_DIR(tree)) {
-		size_t leaflen = strlen(path_end);
-		file_tree_h * start = (file_tree_h *)ptr_vector_start(tree->children);
-		file_tree_h * end = (file_tree_h *)ptr_vector_end(tree->children);
+		size_t i;
 		callback(tree,path_start,FT_ENTERING_DIR);
 		path_end[leaflen++] = PATH_DELIM;
-		for (	;start != end; ++start) {
-			traverse(*start,callback,path_start,path_end + leaflen);
+		for (i = 0; i < tree->count; ++i) {
+			traverse(get_child(tree,i),callback,path_start,path_end + leaflen);
 		}
 		path_end[--leaflen] = '\0';
 		callback(tree,path_start,FT_LEAVING_DIR);
@@ -475,91 +1404,101 @@ traverse(	file_tree_h tree,
 	The function is the same as \e file_tree_add() with the
 	restriction that the path parameter must be an absolute
 	real path (not a symbolic link).
+
+	\param		walk	The walk with which the path is to be
+						searched and added.
+	\param		path	The path.
+
+	If \c path is a directory then it is listed on the calling thread,
+	and then the subdirectories that are not already in the file tree
+	are searched by the walker threads. The listings are merged into
+	the file tree on the calling thread, in the order in which directory
+	entries were read, as soon as each is made.
 */
 static void
-file_tree_add_canon(	file_tree_h root,
-						char const *path,
-						file_tree_callback_t callback)
+file_tree_add_canon(walk_t *walk, char const *path)
 {
 	char const * fullpath = path;
 	heap_str parent_path = fs_split_filename(path,NULL);
-	fs_dir_t parent_dir = parent_path ? fs_open_dir(parent_path,NULL) : NULL;
-	fs_dir_t dir = fs_open_dir(path,parent_dir);
-	file_filter_t filter;
+	dir_scan_t parent_scan;
+	dir_scan_t *scan;
 	file_tree_h lowest;
-	if (parent_path) {
-		free(parent_path);
-	}
-	root = get_root(root);
-	filter = root->var.filter;
-	if (!callback) {
-		callback = null_callback;
-	}
-	lowest = seek(root,&path);
+	memset(&parent_scan,0,sizeof(parent_scan));
+	parent_scan.dirname = parent_path;
+	scan = scan_new(parent_path ? &parent_scan : NULL,path);
+	scan_dir(walk,scan,fs_open_dir(path,NULL));
+	scan->done = true;
+	lowest = seek(walk->root,&path);
 	if (*path) {
 		file_tree_h child;
 		lowest = deepen(lowest,&path);
-		if (!dir) {
-			child = new_file_node(path,filter);
+		if (!scan->dirname) {
+			child = new_file_node(walk->root->store,fullpath,path);
 			if (child) {
-				callback(child,fullpath,FT_AT_FILE);
+				walk->callback(child,fullpath,FT_AT_FILE);
 			}
 		}
 		else {
-			child = new_dir_node(root,path,dir,filter,callback);
+			size_t i;
+			for (i = 0; i < scan->count; ++i) {
+				if (scan->entries[i].subdir) {
+					walk_queue(walk,scan->entries[i].subdir);
+				}
+			}
+			child = merge_dir(walk,path,scan);
 		}
 		if (child) {
 			link(lowest,child);
 		}
 	}
-	else if (dir) {
-		char const * leafname;
-		char const *fullname;
-		while((leafname = fs_read_dir(dir,&fullname)) != NULL) {
-			fs_obj_type_t obj_type = fs_obj_type(fullname);
-			if (FS_IS_SLINK(obj_type)) {
-				file_tree_add_symlink(root,dir,fullname,callback);
+	else if (scan->dirname) {
+		file_tree_h *children;
+		size_t count = 0;
+		size_t i;
+		for (i = 0; i < scan->count; ++i) {
+			scan_entry_t *entry = scan->entries + i;
+			if (!entry->subdir) {
+				continue;
+			}
+			if (!seek_child(lowest,entry->leafname)) {
+				walk_queue(walk,entry->subdir);
 			}
 			else {
-				file_tree_h child = seek_child(lowest,leafname);
-				if (!child) {
-					fs_dir_t subdir = fs_open_dir(fullname,dir);
-					if (!subdir) {
-						child = new_file_node(leafname,filter);
-						if (child) {
-							callback(child,fullname,FT_AT_FILE);
-						}
-					}
-					else {
-						child =
-							new_dir_node(root,leafname,subdir,filter,callback);
-						fs_close_dir(subdir);
-					}
-					if (child) {
-						link(lowest,child);
-					}
+				/* Already in the tree. Don't search it */
+				scan_discard(walk,entry->subdir);
+				entry->subdir = NULL;
+			}
+		}
+		children = allocate((scan->count + 1) * sizeof(file_tree_h));
+		for (i = 0; i < scan->count; ++i) {
+			scan_entry_t *entry = scan->entries + i;
+			if (FS_IS_SLINK(entry->obj_type)) {
+				file_tree_add_symlink(walk,scan,entry->fullname);
+			}
+			else if (!seek_child(lowest,entry->leafname)) {
+				file_tree_h child = merge_entry(walk,entry);
+				if (child) {
+					children[count++] = child;
 				}
 			}
 		}
+		link_children(lowest,children,count);
+		free(children);
 	}
-	if (parent_dir) {
-		fs_close_dir(parent_dir);
-	}
-	if (dir) {
-		fs_close_dir(dir);
+	scan_discard(walk,scan);
+	if (parent_path) {
+		free(parent_path);
 	}
 }
 
 
 /*! Add a the contents of a symbolic link to a file tree.
 
-	\param		root	The file tree to which a symbolic link is
+	\param		walk	The walk with which the symbolic link is
 						to be added.
-	\param		dir		NULL, or the handle of the directory being
+	\param		scan	NULL, or the listing of the directory being
 						traversed when the symlink was found.
 	\param		symlink	The absolute name of the symlink.
-	\return	True if the symlink is found to be eligible for
-	addition to the file tree, else false.
 
 	When a symbolic link is found among the inputs, it can
 	represent a "jump" from one ostensible position in the
@@ -596,30 +1535,28 @@ file_tree_add_canon(	file_tree_h root,
 
 */
 static void
-file_tree_add_symlink(	file_tree_h root,
-						fs_dir_t dir,
-						char const *symlink,
-						file_tree_callback_t callback)
+file_tree_add_symlink(	walk_t *walk,
+						dir_scan_t const *scan,
+						char const *symlink)
 {
 	heap_str realpath;
 	realpath = fs_real_path(symlink,NULL);
-	report(GRIPE_SYMLINK,NULL,"Resolved symbolic link \"%s\"",symlink);
-	if (dir) {
+	walk->callback(walk->root,symlink,FT_AT_SYMLINK);
+	if (scan) {
 		size_t shared_len = 0;
-		char const *entry;
-		char const * dirname = fs_cur_dir_entry(dir,&entry);
+		char const * dirname = scan->dirname;
 		char const *shared_path  =
 			fs_path_comp(dirname,realpath,&shared_len);
 		while (!(shared_path == dirname && dirname[shared_len] == 0)) {
-			if ((dir = fs_get_parent(dir)) == NULL) {
+			if ((scan = scan->parent) == NULL) {
 				break;
 			}
-			dirname = fs_cur_dir_entry(dir,&entry);
+			dirname = scan->dirname;
 			shared_path  = fs_path_comp(dirname,realpath,&shared_len);
 		}
 	}
-	if (!dir) {
-		file_tree_add_canon(root,realpath,callback);
+	if (!scan) {
+		file_tree_add_canon(walk,realpath);
 	}
 	free(realpath);
 }
@@ -657,9 +1594,9 @@ file_tree_name(const file_tree_h file_tree)
 		full_name = callocate(1,1);
 	}
 	else {
-		heap_str path_name = file_tree_name(file_tree->parent);
+		heap_str path_name = file_tree_name(get_parent(file_tree));
 		full_name =
-			fs_compose_filename(path_name,file_tree->var.leafname);
+			fs_compose_filename(path_name,LEAFNAME(file_tree));
 		free(path_name);
 	}
 	return full_name;
@@ -668,8 +1605,8 @@ file_tree_name(const file_tree_h file_tree)
 file_tree_h
 file_tree_new(void)
 {
-	file_tree_h tree = callocate(1,sizeof(struct file_tree));
-	tree->var.filter = null_filter;
+	file_tree_h tree = new_store();
+	make_dir(tree);
 	return tree;
 }
 
@@ -679,27 +1616,26 @@ file_tree_set_filter(file_tree_h file_tree, file_filter_t filter)
 	if (!file_tree_is_empty(file_tree)) {
 		return false;
 	}
-	file_tree->var.filter = filter;
+	FILTER(file_tree) = filter;
 	return true;
 }
 
+void
+file_tree_set_snapshot(file_tree_h file_tree, snapshot_h snap)
+{
+	file_tree->store->snapshot = snap;
+}
+
 void
 file_tree_dispose(file_tree_h * file_tree)
 {
 	file_tree_h tree = *file_tree;
 	if (tree) {
-		if (tree->children) {
-			file_tree_h * start = (file_tree_h *)ptr_vector_start(tree->children);
-			file_tree_h * end = (file_tree_h *)ptr_vector_end(tree->children);
-			for (	;start != end; ++start) {
-				file_tree_dispose(start);
-			}
-			ptr_vector_dispose(&tree->children);
-		}
-		if (!IS_ROOT(tree) && tree->var.leafname) {
-			free(tree->var.leafname);
+		if (IS_ROOT(tree)) {
+			dispose_store(tree->store);
 		}
-		release((void **)file_tree);
+		/* Else the nodes are reclaimed with the store */
+		*file_tree = NULL;
 	}
 }
 
@@ -707,17 +1643,26 @@ file_tree_dispose(file_tree_h * file_tree)
 void
 file_tree_add(	file_tree_h root,
 				char const *path,
-				file_tree_callback_t callback)
+				file_tree_callback_t callback,
+				int jobs)
 {
 	fs_obj_type_t obj_type = fs_file_or_dir(path);
+	walk_t walk;
+	memset(&walk,0,sizeof(walk));
+	walk.root = get_root(root);
+	walk.callback = callback ? callback : null_callback;
+	walk.jobs = jobs;
+	fs_real_path_cache_open();
 	if (FS_IS_SLINK(obj_type)) {
-		file_tree_add_symlink(root,NULL,path,callback);
+		file_tree_add_symlink(&walk,NULL,path);
 	}
 	else {
 		heap_str fullpath = fs_real_path(path,NULL);
-		file_tree_add_canon(root,fullpath,callback);
+		file_tree_add_canon(&walk,fullpath);
 		free(fullpath);
 	}
+	walk_finish(&walk);
+	fs_real_path_cache_close();
 }
 
 void
@@ -725,15 +1670,13 @@ file_tree_traverse(	file_tree_h tree,
 					file_tree_callback_t callback)
 {
 	callback(tree,NULL,FT_ENTERING_TREE);
-	if (tree->children) {
-		file_tree_h * start;
-		file_tree_h * end;
+	if (tree->count) {
+		size_t i;
 		heap_str pathstack = callocate(1,PATH_MAX);
 		strcpy(pathstack,FS_ROOT_PREFIX);
-		start = (file_tree_h *)ptr_vector_start(tree->children);
-		end = (file_tree_h *)ptr_vector_end(tree->children);
-		for (	;start != end; ++start) {
-			traverse(*start,callback,pathstack,pathstack + strlen(pathstack));
+		for (i = 0; i < tree->count; ++i) {
+			traverse(get_child(tree,i),callback,pathstack,
+				pathstack + strlen(pathstack));
 		}
 		free(pathstack);
 	}
@@ -746,7 +1689,7 @@ file_tree_is_empty(file_tree_h file_tree)
 	if (!IS_ROOT(file_tree)) {
 		return false;
 	}
-	return !file_tree->children || ptr_vector_count(file_tree->children) == 0;
+	return file_tree->count == 0;
 }
 
 size_t
@@ -771,12 +1714,12 @@ file_tree_count(const file_tree_h tree, unsigned flags, file_tree_count_t *count
 			}
 		}
 		if (IS_DIR(tree)) {
-			file_tree_h * start = (file_tree_h *)ptr_vector_start(tree->children);
-			file_tree_h * end = (file_tree_h *)ptr_vector_end(tree->children);
-			for (	;start != end; ++ start) {
+			size_t i;
+			for (i = 0; i < tree->count; ++i) {
+				file_tree_h child = get_child(tree,i);
 				if (count_children) {
 					++count.children;
-					if (IS_DIR(*start)) {
+					if (IS_DIR(child)) {
 						count.dirs += count_dirs;
 					}
 					else {
@@ -784,7 +1727,7 @@ file_tree_count(const file_tree_h tree, unsigned flags, file_tree_count_t *count
 					}
 				}
 				else {
-					file_tree_count(*start,flags,&count);
+					file_tree_count(child,flags,&count);
 				}
 			}
 		}
@@ -801,13 +1744,13 @@ file_tree_child(file_tree_h file_tree, size_t which)
 {
 	file_tree_h child = NULL;
 	if (IS_DIR(file_tree)) {
-		size_t children = ptr_vector_count(file_tree->children);
+		size_t children = file_tree->count;
 		if (children) {
 			if (which == FT_LAST) {
 				which = children - 1;
 			}
 			if (which < children) {
-				child = *(file_tree_h *)ptr_vector_at(file_tree->children,which);
+				child = get_child(file_tree,which);
 			}
 		}
 	}
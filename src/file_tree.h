@@ -38,6 +38,7 @@
  *                                                                         *
  ***************************************************************************/
 #include "memory.h"
+#include "snapshot.h"
 
 /*!\ingroup file_tree_module file_tree_interface
  *\file file_tree.h
@@ -59,7 +60,9 @@ typedef enum {
 	FT_ENTERING_DIR	= -1,	/*!< Entering directory */
 	FT_AT_FILE = 0,		/*!< At a file */
 	FT_LEAVING_DIR	= 1,	/*!< Leaving directory */
-	FT_LEAVING_TREE = 2		/*! Leaving file tree */
+	FT_LEAVING_TREE = 2,	/*! Leaving file tree */
+	FT_AT_SYMLINK = 3		/*!< Resolving a symbolic link, while
+								adding to a file tree */
 } file_tree_traverse_state_t;
 
 /*! Bit flags that may be combined in flags passed to
@@ -95,6 +98,7 @@ typedef struct {
 	FT_AT_FILE => \e name is a file
 	FT_LEAVING_DIR => Entering directory \e name
 	FT_LEAVING_TREE => Finished traversal. \e name is NULL
+	FT_AT_SYMLINK => \e name is a symbolic link being resolved
 
  */
 
@@ -102,17 +106,26 @@ typedef void (*file_tree_callback_t)(	file_tree_h tree,
 										char const *name,
 										file_tree_traverse_state_t context);
 
-/*! Type of functions for filtering files by leafname.
+/*! Type of functions for filtering files and directories by name.
 	A file tree contains a function pointer of this type that
-	is used to decide the eligibility of files (not directories)
-	for insertion in the file tree. If no such function is
-	assigned to a file tree then the default filter accepts
-	all files.
-
-	\param		leafname	The leafname of the file.
-	\return	True iff the leafname satisfies the filter.	
+	is used to decide the eligibility of files for insertion in the
+	file tree, and of directories to be searched. If no such function
+	is assigned to a file tree then the default filter accepts
+	everything.
+
+	\param		fullname	The absolute name of the file or directory.
+	\param		leafname	The leafname of the file or directory,
+							within \c fullname.
+	\param		is_dir		Is \c fullname a directory? A directory that
+							is rejected is not opened.
+	\return	True iff the name satisfies the filter.
+
+	Directories are filtered by the walker threads, so the function
+	may be called concurrently.
 */
-typedef bool (*file_filter_t)(char const *leafname);
+typedef bool (*file_filter_t)(	char const *fullname,
+								char const *leafname,
+								bool is_dir);
 
 
 /*! Compose the full name of a file tree, i.e.
@@ -132,8 +145,8 @@ extern file_tree_h
 file_tree_new(void);
 
 /*! Try to attach a filter function to a file tree, to be used
-	to be used to decide the eligibility of files (not directories)
-	for insertion in the file tree.
+	to be used to decide the eligibility of files for insertion in the
+	file tree and of directories to be searched.
 
 	\param		file_tree		The file tree to which the filter
 				will be attached.
@@ -147,6 +160,19 @@ file_tree_new(void);
 extern bool
 file_tree_set_filter(file_tree_h file_tree, file_filter_t filter);
 
+/*! Attach a directory snapshot to a file tree.
+
+	\param		file_tree		The file tree.
+	\param		snap			The snapshot, or NULL. It is not owned by
+							the file tree.
+
+	When a snapshot is attached, \c file_tree_add() takes the listing
+	of a directory from the snapshot if it is current, instead of reading
+	the directory, and records in the snapshot the listing of each
+	directory that it reads.
+*/
+extern void
+file_tree_set_snapshot(file_tree_h file_tree, snapshot_h snap);
 
 /*! Add the filtered contents of a path to a file tree.
 
@@ -156,7 +182,11 @@ file_tree_set_filter(file_tree_h file_tree, file_filter_t filter);
 
 	\param		callback	NULL, or \c file_tree_callback_t to be
 						called on entry and exit for each directory
-						added and for each file added.
+						added, for each file added and for each
+						symbolic link resolved. If NULL, symbolic links
+						are reported as they are resolved.
+	\param		jobs	The maximum number of threads with which to
+						search directories.
 
 	Files in \c path are added to the tree that satisfy the
 	assigned or default filter function of the tree. The
@@ -177,11 +207,18 @@ file_tree_set_filter(file_tree_h file_tree, file_filter_t filter);
 	node will only be added to any parent when the subtree rooted
 	at the new node has been wholly constructed in the same
 	grudging manner and found to contain any wanted files.
+
+	Directories are searched by up to \c jobs threads, but the file
+	tree is built, and \c callback is called, on the calling thread in
+	the same order whatever the number of threads. Each directory is
+	merged into the tree as soon as it has been listed, so \c callback
+	is called for the first files found while the search goes on.
 */
 extern void
 file_tree_add(	file_tree_h parent,
 				char const *path,
-				file_tree_callback_t callback);
+				file_tree_callback_t callback,
+				int jobs);
 
 
 /*! Dispose of a file tree, releasing its resources.
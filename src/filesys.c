@@ -36,6 +36,7 @@
  *                                                                         *
  ***************************************************************************/
 
+#define MEMORY_TAG	MEMORY_FILE_TREE
 #include "filesys.h"
 #include "platform.h"
 #include "report.h"
@@ -53,6 +53,18 @@
 typedef void * fs_dir_t;
 
 
+/*! Structure of the identity, size and modification time of a file or
+	directory, by which it can be known to be unchanged.
+*/
+typedef struct fs_stamp {
+	unsigned long device;	/*!< The device of the object, or 0 */
+	unsigned long inode;	/*!< The inode of the object, or 0 */
+	long size;		/*!< The size of the object in bytes */
+	long mtime;		/*!< The modification time, in seconds */
+	long mtime_ns;	/*!< The nanoseconds of the modification time,
+						where the platform reports them, else 0 */
+} fs_stamp_t;
+
 /*! Enumerated type of filesystem objects */
 typedef enum {
 	FS_OBJ_NONE,	/*!< No such object */
@@ -140,7 +152,9 @@ fs_file_or_dir(char const *name);
 	opened.
 	\param		parent. The handle of the open directory of
 				\em dirname is a subdirectory, or NULL if none.
-				
+				If not NULL, \em dirname must name the current
+				entry of \em parent, which is then opened relative
+				to \em parent where the platform allows.
 
 	\return	A handle to \em dirname, or NULL if an error
 	occurs, which will be indicated	by \c errno.
@@ -148,6 +162,18 @@ fs_file_or_dir(char const *name);
 extern fs_dir_t
 fs_open_dir(char const *dirname, fs_dir_t const parent);
 
+/*! Open an abstract directory handle for a directory whose name
+	is known to be an absolute real pathname, without resolving the
+	name again.
+
+	\param		realname	The absolute real pathname of the directory.
+
+	\return	A handle to \em realname, or NULL if an error
+	occurs, which will be indicated	by \c errno.
+*/
+extern fs_dir_t
+fs_open_real_dir(char const *realname);
+
 /*! Close an abstract directory handle, releasing
 	its resources.
 */
@@ -175,6 +201,58 @@ extern char const *
 fs_read_dir(fs_dir_t dir, char const ** fullname);
 
 
+/*! Get the type of the current entry of a directory handle,
+	as \em fs_obj_type() would for its full name.
+
+	\param		dir		The open directory handle, on which
+				\em fs_read_dir() has returned an entry.
+
+	Where the platform reports the types of directory entries as they
+	are read, no further filesystem call is made except for a
+	symbolic link.
+*/
+extern fs_obj_type_t
+fs_cur_entry_type(fs_dir_t dir);
+
+/*! Get the identity, size and modification time of a file or
+	directory.
+
+	\param		name	The name of the file or directory. A symbolic
+						link is followed.
+	\param		stamp	Receives the identity, size and modification
+						time.
+	\return	True on success, else false.
+*/
+extern bool
+fs_stamp(char const *name, fs_stamp_t *stamp);
+
+/*! Get the identity, size and modification time of an open directory.
+
+	\param		dir		The open directory handle.
+	\param		stamp	Receives the identity, size and modification
+						time.
+	\return	True on success, else false.
+*/
+extern bool
+fs_dir_stamp(fs_dir_t dir, fs_stamp_t *stamp);
+
+/*! Set the modification time of a file to the current time.
+
+	\param		name	The name of the file.
+	\return	True on success, else false.
+*/
+extern bool
+fs_touch(char const *name);
+
+/*! Create a directory, if it does not exist.
+
+	\param		name	The name of the directory. Its parent must
+						exist.
+	\return	True if the directory exists on return, else false.
+*/
+extern bool
+fs_make_dir(char const *name);
+
 /*! Return the handle of the open parent directory of
 	a directory, if any, else NULL.
 */
@@ -213,6 +291,21 @@ fs_compose_filename(char const *path, char const *leafname);
 extern heap_str
 fs_split_filename(char const *path, char **leafname);
 
+/*! Start caching the real paths of absolute pathnames for
+	\e fs_real_path(), forgetting any cached before.
+
+	The cache is meant to last for one walk of the filesystem,
+	during which symbolic links are assumed not to change. It
+	must be opened and closed while no other thread is calling
+	\e fs_real_path().
+*/
+extern void
+fs_real_path_cache_open(void);
+
+/*! Stop caching real paths and forget those cached. */
+extern void
+fs_real_path_cache_close(void);
+
 /*! Return the absolute real pathname of a
 	file or directory name (which may be the name of
 	a symbolic link).
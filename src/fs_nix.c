@@ -41,6 +41,7 @@
  *
  * This file implements the filesystem module for Unix.
  */
+#define MEMORY_TAG	MEMORY_FILE_TREE
 #include "platform.h"
 
 #ifdef UNIX
@@ -48,13 +49,22 @@
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <utime.h>
 #include "filesys.h"
+#include "hash.h"
 #include "report.h"
+#include "thread.h"
 
 
 /*! \addtogroup filesystem_unix_internals */
 /*@{*/
 
+/*! The number of entries in the cache of real paths. A power of 2. */
+#define REAL_PATH_CACHE_SIZE	256
+
 /*! Structure implementing \e fs_dir_t for Unix */
 typedef struct fs_dir_nix {
 	/*! Handle of parent directory if any, else NULL. */
@@ -63,30 +73,187 @@ typedef struct fs_dir_nix {
 	heap_str dirname;
 	/*! The end of the directory name */
 	char *dirname_end;
+	/*! The size of the heap block at \c dirname */
+	size_t dirname_size;
 	/*! The directory handle */
 	DIR * dir;
 	/*! Latest retrieved directory entry */
-	struct dirent entry;
+	struct dirent *entry;
 } fs_dir_nix_t;
 
+/*! Structure of an entry in the cache of real paths */
+typedef struct real_path_entry {
+	/*! An absolute pathname, or NULL if the entry is unused */
+	heap_str name;
+	/*! The real pathname of \c name */
+	heap_str real;
+	/*! The length of \c real */
+	size_t len;
+} real_path_entry_t;
+
+/*! Cache of the real paths of absolute pathnames, indexed by the hashes
+	of the pathnames. An entry is replaced by any later pathname with the
+	same index. The cache is used only while it is open, between
+	\c fs_real_path_cache_open() and \c fs_real_path_cache_close(), so
+	that a symbolic link retargeted between walks is resolved afresh.
+*/
+static real_path_entry_t real_path_cache[REAL_PATH_CACHE_SIZE];
+
+/*! Lock on \c real_path_cache, which the directory walker threads share,
+	or NULL if the cache is closed. Nothing that may bail is called
+	while it is held.
+*/
+static thread_lock_t real_path_lock;
+
+/*! Make a directory handle from an open file descriptor.
+
+	\param		fd		The open file descriptor of a directory.
+	\param		parent	The handle of the parent directory, or NULL.
+	\param		realname	The real name of the directory, on the heap.
+						It is adopted by the handle.
+	\param		namelen	The length of \c realname.
+
+	\return	The handle, or NULL if \c fd cannot be read as a directory,
+	in which case \c fd is closed and \c realname is freed.
+*/
+static fs_dir_t
+make_dir(int fd, fs_dir_nix_t *parent, heap_str realname, size_t namelen)
+{
+	fs_dir_nix_t * dir;
+	DIR * dir_handle = fd == -1 ? NULL : fdopendir(fd);
+	if (!dir_handle) {
+		if (fd != -1) {
+			close(fd);
+		}
+		free(realname);
+		return NULL;
+	}
+	dir = allocate(sizeof(fs_dir_nix_t));
+	dir->parent = parent;
+	dir->dir = dir_handle;
+	dir->dirname = realname;
+	dir->dirname_end = dir->dirname + namelen;
+	dir->dirname_size = namelen + 1;
+	dir->entry = NULL;
+	return dir;
+}
+
+/*! Get the type of a filesystem object from its stat information */
+static fs_obj_type_t
+stat_type(struct stat const *obj_info)
+{
+	if (S_ISREG(obj_info->st_mode)) {
+		return FS_OBJ_FILE;
+	}
+	if (S_ISDIR(obj_info->st_mode)) {
+		return FS_OBJ_DIR;
+	}
+	return FS_OBJ_NONE;
+}
+
+/*! Get the stamp of a filesystem object from its stat information */
+static void
+stat_stamp(struct stat const *obj_info, fs_stamp_t *stamp)
+{
+	stamp->device = (unsigned long)obj_info->st_dev;
+	stamp->inode = (unsigned long)obj_info->st_ino;
+	stamp->size = (long)obj_info->st_size;
+	stamp->mtime = (long)obj_info->st_mtime;
+#if defined(__APPLE__)
+	stamp->mtime_ns = (long)obj_info->st_mtimespec.tv_nsec;
+#elif defined(st_mtime)
+	/* st_mtime is a macro for st_mtim.tv_sec */
+	stamp->mtime_ns = (long)obj_info->st_mtim.tv_nsec;
+#else
+	stamp->mtime_ns = 0;
+#endif
+}
+
+/*! Forget all the entries in the cache of real paths */
+static void
+real_path_cache_clear(void)
+{
+	size_t i;
+	for (i = 0; i < REAL_PATH_CACHE_SIZE; ++i) {
+		free(real_path_cache[i].name);
+		free(real_path_cache[i].real);
+		real_path_cache[i].name = real_path_cache[i].real = NULL;
+	}
+}
+
 /*@}*/
 
 
+void
+fs_real_path_cache_open(void)
+{
+	if (!real_path_lock) {
+		real_path_lock = thread_lock_new();
+	}
+	real_path_cache_clear();
+}
+
+void
+fs_real_path_cache_close(void)
+{
+	if (real_path_lock) {
+		real_path_cache_clear();
+		thread_lock_dispose(&real_path_lock);
+	}
+}
+
 heap_str
 fs_real_path(char const *relname, size_t *namelen)
 {
 	char buf[PATH_MAX];
-	if (realpath(relname,buf)) {
-		char *full_path;
-		size_t len = strlen(buf);
-		if (namelen) {
-			*namelen = len;
+	real_path_entry_t *cached = NULL;
+	char *full_path;
+	size_t len;
+	bool hit = false;
+	if (relname[0] == PATH_DELIM && real_path_lock) {
+		/* An absolute name resolves the same wherever we are */
+		cached = real_path_cache +
+			(hash_str(HASH_INIT,relname) & (REAL_PATH_CACHE_SIZE - 1));
+		thread_lock(real_path_lock);
+		if (cached->name && !strcmp(cached->name,relname)) {
+			len = cached->len;
+			memcpy(buf,cached->real,len + 1);
+			hit = true;
 		}
-		full_path = allocate(len + 1);
-		strcpy(full_path,buf);
-		return full_path;
+		thread_unlock(real_path_lock);
+	}
+	if (hit) {
+		cached = NULL;
+	}
+	else if (!realpath(relname,buf)) {
+		return NULL;
+	}
+	else {
+		len = strlen(buf);
 	}
-	return NULL;
+	if (namelen) {
+		*namelen = len;
+	}
+	full_path = allocate(len + 1);
+	memcpy(full_path,buf,len + 1);
+	if (cached) {
+		size_t name_len = strlen(relname);
+		heap_str name = allocate(name_len + 1);
+		heap_str real = allocate(len + 1);
+		heap_str old_name, old_real;
+		memcpy(name,relname,name_len + 1);
+		memcpy(real,buf,len + 1);
+		thread_lock(real_path_lock);
+		old_name = cached->name;
+		old_real = cached->real;
+		cached->name = name;
+		cached->real = real;
+		cached->len = len;
+		thread_unlock(real_path_lock);
+		free(old_name);
+		free(old_real);
+	}
+	return full_path;
 }
 
 fs_obj_type_t
@@ -98,15 +265,10 @@ fs_obj_type(char const *name)
 	if (!res) {
 		if (S_ISLNK(obj_info.st_mode)) {
 			type |= FS_OBJ_SLINK;
+			res = stat(name,&obj_info);
 		}
-		res = stat(name,&obj_info);
 		if (!res) {
-			if (S_ISREG(obj_info.st_mode)) {
-				type |= FS_OBJ_FILE;
-			}
-			else if (S_ISDIR(obj_info.st_mode)) {
-				type |= FS_OBJ_DIR;
-			}
+			type |= stat_type(&obj_info);
 		}
 	}
 	return type;
@@ -115,22 +277,50 @@ fs_obj_type(char const *name)
 fs_dir_t
 fs_open_dir(char const *dirname, fs_dir_t const parent)
 {
-	fs_dir_nix_t * dir = NULL;
-	DIR * dir_handle = opendir(dirname);
-	if (dir_handle ) {
-		size_t namelen;
-		heap_str fullname = fs_real_path(dirname,&namelen);
-		if (fullname) {
-			dir = allocate(sizeof(fs_dir_nix_t));
-			dir->parent = (fs_dir_nix_t *)parent;
-			dir->dir = dir_handle;
-			dir->dirname = fullname;
-			dir->dirname_end = dir->dirname + namelen;
+	fs_dir_nix_t * nix_parent = parent;
+	heap_str fullname;
+	size_t namelen;
+	int fd;
+	if (nix_parent) {
+		/* Open the entry relative to the parent. As it is not a symbolic
+			link, its real name is the parent's with its leafname */
+		char const *leafname = strrchr(dirname,PATH_DELIM);
+		size_t parent_len = nix_parent->dirname_end - nix_parent->dirname;
+		size_t leaf_len;
+		leafname = leafname ? leafname + 1 : dirname;
+		fd = openat(dirfd(nix_parent->dir),leafname,
+			O_RDONLY | O_DIRECTORY | O_NOFOLLOW);
+		if (fd != -1) {
+			leaf_len = strlen(leafname);
+			namelen = parent_len + 1 + leaf_len;
+			fullname = allocate(namelen + 1);
+			memcpy(fullname,nix_parent->dirname,parent_len);
+			fullname[parent_len] = PATH_DELIM;
+			memcpy(fullname + parent_len + 1,leafname,leaf_len + 1);
+			return make_dir(fd,nix_parent,fullname,namelen);
 		}
 	}
-	return dir;
+	fd = open(dirname,O_RDONLY | O_DIRECTORY);
+	if (fd == -1) {
+		return NULL;
+	}
+	fullname = fs_real_path(dirname,&namelen);
+	if (!fullname) {
+		close(fd);
+		return NULL;
+	}
+	return make_dir(fd,nix_parent,fullname,namelen);
 }
 
+fs_dir_t
+fs_open_real_dir(char const *realname)
+{
+	size_t namelen = strlen(realname);
+	heap_str fullname = allocate(namelen + 1);
+	memcpy(fullname,realname,namelen + 1);
+	return make_dir(open(realname,O_RDONLY | O_DIRECTORY),NULL,
+		fullname,namelen);
+}
 
 void
 fs_close_dir(fs_dir_t dir)
@@ -150,23 +340,34 @@ fs_read_dir(fs_dir_t dir, char const **fullname)
 	char *filename = NULL;
 	fs_dir_nix_t * nix_dir = dir;
 	struct dirent * entry;
-	int res = readdir_r(nix_dir->dir,&nix_dir->entry,&entry);
-	if (res) {
-		bail(GRIPE_CANT_READ_DIR,"Read error on directory \"%s\"",
-			nix_dir->dirname);
+	for (	;;) {
+		errno = 0;
+		entry = readdir(nix_dir->dir);
+		if (!entry) {
+			if (errno) {
+				bail(GRIPE_CANT_READ_DIR,"Read error on directory \"%s\"",
+					nix_dir->dirname);
+			}
+			break;
+		}
+		filename = entry->d_name;
+		if (!(filename[0] == '.' &&
+			((filename[1] == '.' && filename[2] == '\0') ||
+				filename[1] == '\0'))) {
+			break;
+		}
 	}
+	nix_dir->entry = entry;
 	if (entry) {
-		filename = nix_dir->entry.d_name;
-		if (filename[0] == '.' &&
-			((filename[1] == '.' && filename[2] == '\0') || filename[1] == '\0')) {
-			return fs_read_dir(dir,fullname);
-		}
 		if (fullname) {
 			size_t len = nix_dir->dirname_end - nix_dir->dirname;
-			size_t available = strlen(nix_dir->dirname_end) ;
-			size_t needed = strlen(filename) + 1;
-			if (available < needed) {
-				nix_dir->dirname = reallocate(nix_dir->dirname,len + needed + 1);
+			size_t needed = len + strlen(filename) + 2;
+			if (needed > nix_dir->dirname_size) {
+				while (needed > nix_dir->dirname_size) {
+					nix_dir->dirname_size *= 2;
+				}
+				nix_dir->dirname =
+					reallocate(nix_dir->dirname,nix_dir->dirname_size);
 				nix_dir->dirname_end = nix_dir->dirname + len;
 			}
 			*nix_dir->dirname_end = PATH_DELIM;
@@ -177,10 +378,53 @@ fs_read_dir(fs_dir_t dir, char const **fullname)
 	}
 	else {
 		*nix_dir->dirname_end = '\0';
+		filename = NULL;
 	}
 	return filename;
 }
 
+fs_obj_type_t
+fs_cur_entry_type(fs_dir_t dir)
+{
+	fs_dir_nix_t * nix_dir = dir;
+	fs_obj_type_t type = FS_OBJ_NONE;
+	struct stat obj_info;
+	char const *name;
+	int fd;
+	assert(nix_dir->entry);
+	name = nix_dir->entry->d_name;
+	fd = dirfd(nix_dir->dir);
+#ifdef DT_UNKNOWN
+	switch(nix_dir->entry->d_type) {
+	case DT_REG:
+		return FS_OBJ_FILE;
+	case DT_DIR:
+		return FS_OBJ_DIR;
+	case DT_LNK:
+		type = FS_OBJ_SLINK;
+		if (!fstatat(fd,name,&obj_info,0)) {
+			type |= stat_type(&obj_info);
+		}
+		return type;
+	case DT_UNKNOWN:
+		break;
+	default:
+		return FS_OBJ_NONE;
+	}
+#endif
+	if (!fstatat(fd,name,&obj_info,AT_SYMLINK_NOFOLLOW)) {
+		int res = 0;
+		if (S_ISLNK(obj_info.st_mode)) {
+			type |= FS_OBJ_SLINK;
+			res = fstatat(fd,name,&obj_info,0);
+		}
+		if (!res) {
+			type |= stat_type(&obj_info);
+		}
+	}
+	return type;
+}
+
 char const *
 fs_cur_dir_entry(fs_dir_t dir, char const **entry)
 {
@@ -192,6 +436,42 @@ fs_cur_dir_entry(fs_dir_t dir, char const **entry)
 	return nix_dir->dirname;
 }
 
+bool
+fs_stamp(char const *name, fs_stamp_t *stamp)
+{
+	struct stat obj_info;
+	if (stat(name,&obj_info)) {
+		return false;
+	}
+	stat_stamp(&obj_info,stamp);
+	return true;
+}
+
+bool
+fs_dir_stamp(fs_dir_t dir, fs_stamp_t *stamp)
+{
+	fs_dir_nix_t * nix_dir = dir;
+	struct stat dir_info;
+	assert(dir);
+	if (fstat(dirfd(nix_dir->dir),&dir_info)) {
+		return false;
+	}
+	stat_stamp(&dir_info,stamp);
+	return true;
+}
+
+bool
+fs_touch(char const *name)
+{
+	return utime(name,NULL) == 0;
+}
+
+bool
+fs_make_dir(char const *name)
+{
+	return mkdir(name,0777) == 0 || errno == EEXIST;
+}
+
 fs_dir_t
 fs_get_parent(fs_dir_t dir)
 {
@@ -41,6 +41,7 @@
  *
  * This file implements the filesystem module for windows.
  */
+#define MEMORY_TAG	MEMORY_FILE_TREE
 #include "platform.h"
 
 #ifdef WINDOWS
@@ -50,6 +51,9 @@
 #include "report.h"
 #include <ctype.h>
 #include <stdlib.h>
+#include <sys/utime.h>
+#include <direct.h>
+#include <errno.h>
 #include <windows.h>
 
 /*! \addtogroup filesystem_windows_internals */
@@ -72,6 +76,17 @@ typedef struct fs_dir_win {
 
 /*@}*/
 
+void
+fs_real_path_cache_open(void)
+{
+	/* Real paths are not cached on Windows */
+}
+
+void
+fs_real_path_cache_close(void)
+{
+}
+
 heap_str
 fs_real_path(char const *relname, size_t *namelen)
 {
@@ -131,6 +146,12 @@ fs_open_dir(char const *dirname, fs_dir_t const parent)
 	return dir;
 }
 
+fs_dir_t
+fs_open_real_dir(char const *realname)
+{
+	return fs_open_dir(realname,NULL);
+}
+
 void
 fs_close_dir(fs_dir_t dir)
 {
@@ -186,6 +207,14 @@ fs_read_dir(fs_dir_t dir, char const ** fullname)
 	return filename;
 }
 
+fs_obj_type_t
+fs_cur_entry_type(fs_dir_t dir)
+{
+	fs_dir_win_t * win_dir = dir;
+	assert(dir);
+	return fs_obj_type(win_dir->dirname);
+}
+
 char const *
 fs_cur_dir_entry(fs_dir_t dir, char const **entry)
 {
@@ -197,6 +226,52 @@ fs_cur_dir_entry(fs_dir_t dir, char const **entry)
 	return win_dir->dirname;
 }
 
+bool
+fs_stamp(char const *name, fs_stamp_t *stamp)
+{
+	WIN32_FILE_ATTRIBUTE_DATA obj_info;
+	ULARGE_INTEGER ticks;
+	if (!GetFileAttributesEx(name,GetFileExInfoStandard,&obj_info)) {
+		return false;
+	}
+	ticks.LowPart = obj_info.ftLastWriteTime.dwLowDateTime;
+	ticks.HighPart = obj_info.ftLastWriteTime.dwHighDateTime;
+	/* FILETIME counts 100ns ticks since 1601 */
+	stamp->device = 0;
+	stamp->inode = 0;
+	stamp->size = (long)obj_info.nFileSizeLow;
+	stamp->mtime = (long)(ticks.QuadPart / 10000000 - 11644473600);
+	stamp->mtime_ns = (long)(ticks.QuadPart % 10000000) * 100;
+	return true;
+}
+
+bool
+fs_dir_stamp(fs_dir_t dir, fs_stamp_t *stamp)
+{
+	fs_dir_win_t * win_dir = dir;
+	char save;
+	bool res;
+	assert(dir);
+	/* The directory name is followed by the current entry */
+	save = *win_dir->dirname_end;
+	*win_dir->dirname_end = '\0';
+	res = fs_stamp(win_dir->dirname,stamp);
+	*win_dir->dirname_end = save;
+	return res;
+}
+
+bool
+fs_touch(char const *name)
+{
+	return _utime(name,NULL) == 0;
+}
+
+bool
+fs_make_dir(char const *name)
+{
+	return _mkdir(name) == 0 || errno == EEXIST;
+}
+
 fs_dir_t
 fs_get_parent(fs_dir_t dir)
 {
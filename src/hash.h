@@ -0,0 +1,81 @@
+#ifndef HASH_H
+#define HASH_H
+
+/***************************************************************************
+ *   Copyright (C) 2004, 2006 Symbian Software Ltd.                        *
+ *   All rights reserved.                                                  *
+ *   Copyright (C) 2007, 2008 Mike Kinghan, imk@strudl.org                 *
+ *   All rights reserved.                                                  *
+ *                                                                         *
+ *   Contributed originally by Mike Kinghan, imk@strudl.org                *
+ *                                                                         *
+ *   Redistribution and use in source and binary forms, with or without    *
+ *   modification, are permitted provided that the following conditions    *
+ *   are met:                                                              *
+ *                                                                         *
+ *   Redistributions of source code must retain the above copyright        *
+ *   notice, this list of conditions and the following disclaimer.         *
+ *                                                                         *
+ *   Redistributions in binary form must reproduce the above copyright     *
+ *   notice, this list of conditions and the following disclaimer in the   *
+ *   documentation and/or other materials provided with the distribution.  *
+ *                                                                         *
+ *   Neither the name of Symbian Software Ltd. nor the names of its        *
+ *   contributors may be used to endorse or promote products derived from  *
+ *   this software without specific prior written permission.              *
+ *                                                                         *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS   *
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT     *
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS    *
+ *   FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE        *
+ *   COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,   *
+ *   INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,  *
+ *   BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS *
+ *   OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED    *
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,*
+ *   OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF *
+ *   THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH  *
+ *   DAMAGE.                                                               *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "opts.h"
+#include <stddef.h>
+
+/*!\ingroup hash_module, hash_interface
+ *\file hash.h
+ * This file provides the Hash module interface.
+ *
+ *	The Hash module computes 32-bit FNV-1a hashes, used to tell
+ *	whether stored results still answer to the current input.
+ */
+
+/*! \addtogroup hash_interface */
+/*@{*/
+
+/*! Type of a hash value */
+typedef unsigned long hash_t;
+
+/*! The value with which a hash is seeded */
+#define HASH_INIT	2166136261UL
+
+/*! Fold a block of bytes into a hash.
+	\param	hash	The hash so far.
+	\param	data	The bytes to fold in.
+	\param	len		The number of bytes.
+	\return	The updated hash.
+ */
+extern hash_t
+hash_bytes(hash_t hash, void const *data, size_t len);
+
+/*! Fold a nul-terminated string, including the terminator, into a hash.
+	\param	hash	The hash so far.
+	\param	str		The string to fold in.
+	\return	The updated hash.
+ */
+extern hash_t
+hash_str(hash_t hash, char const *str);
+
+/*@}*/
+
+#endif /* EOF */
@@ -51,6 +51,8 @@
 #include "args.h"
 #include "io.h"
 #include <stddef.h>
+#include <string.h>
+#include <assert.h>
 
 
 /*!	\ingroup if_control_module, if_control_interface, if_control_internals
@@ -62,11 +64,6 @@
 /*! \addtogroup if_control_internals */
 /*@{*/
 
-/*! Maximum depth of #if nesting, c.f.
- *	Minimum translation limits from ISO/IEC 9899:1999 5.2.4.1
- */
-#define	MAXDEPTH        64
-
 /* Helpers *****************************************************************/
 
 /*! Type of if-state transition functions.*/
@@ -397,5 +394,29 @@ if_control_toplevel(void)
 	SET_STATE(if_control,depth) = 0;
 }
 
+size_t
+if_control_save(if_state_t states[], size_t start_lines[])
+{
+	size_t depth = if_depth();
+	memcpy(states,GET_STATE(if_control,ifstate),
+		(depth + 1) * sizeof(if_state_t));
+	memcpy(start_lines,GET_STATE(if_control,if_start_lines),
+		(depth + 1) * sizeof(size_t));
+	return depth;
+}
+
+void
+if_control_restore(	size_t depth,
+					if_state_t const states[],
+					size_t const start_lines[])
+{
+	assert(depth < MAXDEPTH);
+	SET_STATE(if_control,depth) = depth;
+	memcpy(GET_STATE(if_control,ifstate),states,
+		(depth + 1) * sizeof(if_state_t));
+	memcpy(GET_STATE(if_control,if_start_lines),start_lines,
+		(depth + 1) * sizeof(size_t));
+}
+
 
 /* EOF */
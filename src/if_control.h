@@ -56,6 +56,11 @@
 /*!	\addtogroup if_control_interface */
 /*@{*/
 
+/*! Maximum depth of #if nesting, c.f.
+ *	Minimum translation limits from ISO/IEC 9899:1999 5.2.4.1
+ */
+#define	MAXDEPTH        64
+
 /*! Enumeration of the if-control states */
 typedef enum {
 	IS_OUTSIDE,	
@@ -110,7 +115,7 @@ was_unconditional_line(void);
 extern bool
 is_unconditional_line(void);
 
-/*! For debug(), return the starting line number of the
+/*! For diagnostics, return the starting line number of the
  *	current #if-sequence.
  */ 
 extern size_t
@@ -128,6 +133,27 @@ if_state(void);
 void
 if_control_toplevel(void);
 
+/*! Copy the if-control stack to caller's storage.
+ *	\param	states		Receives the if-states of the stack, bottom first.
+ *	\param	start_lines	Receives the start lines of the <tt>#if</tt>s
+ *						on the stack.
+ *	\return	The current depth of if-nesting. <tt>depth + 1</tt> elements
+ *			are written to each array, which must have \c MAXDEPTH
+ *			elements.
+ */
+extern size_t
+if_control_save(if_state_t states[], size_t start_lines[]);
+
+/*! Reinstate an if-control stack copied by if_control_save()
+ *	\param	depth		The depth of if-nesting to reinstate.
+ *	\param	states		The if-states to reinstate.
+ *	\param	start_lines	The <tt>#if</tt> start lines to reinstate.
+ */
+extern void
+if_control_restore(	size_t depth,
+					if_state_t const states[],
+					size_t const start_lines[]);
+
  
 /*@}*/
 
@@ -36,12 +36,19 @@
  *                                                                         *
  ***************************************************************************/
 
+#define MEMORY_TAG	MEMORY_LINES
 #include "report.h"
 #include "filesys.h"
 #include "io.h"
 #include "args.h"
 #include "platform.h"
 #include "dataset.h"
+#include "lex_map.h"
+#include "checkpoint.h"
+#include "manifest.h"
+#include "cache.h"
+#include "line_despatch.h"
+#include "stats.h"
 #include <ctype.h>
 
 /*!\ingroup io_module, io_interface, io_internals
@@ -116,6 +123,16 @@ delete_infile(void)
 static void
 open_output(void);
 
+/*! Determine the line-end convention of the current input file from its
+ *	first block.
+ *
+ *	The public \c lf_only flag is set if the first block contains
+ *	no carriage return. The standard input is not sniffed, since it
+ *	cannot be rewound, and is assumed to have mixed line-ends.
+ */
+static void
+sniff_line_ends(void);
+
 /*@}*/
 
 /*! \ingroup io_internals_state_utils */
@@ -135,6 +152,10 @@ STATE_DEF(io) {
 		/*!< Current output filename on heap, if needed */
 	char * bak_name_buf; /*!< Backup filename on heap, if needed */
 	size_t saved_read_pos; /*!< Saved offset into line buffer */
+	FILE * given_input;
+		/*!< NULL, or the input stream supplied by \c io_use_streams() */
+	FILE * given_output;
+		/*!< NULL, or the output stream supplied by \c io_use_streams() */
 } STATE_T(io);
 /*@}*/
 
@@ -213,6 +234,7 @@ static bool
 readon(void)
 {
 	size_t read = 0;
+	stats_phase_t phase = STATS_PHASE(STATS_READ);
 	for (;;) {
 		char *bufp;
 		if (GET_STATE(io,linelen) + 1 >= GET_STATE(io,bufsz)) {
@@ -235,13 +257,23 @@ readon(void)
 		}
 		/* Update length of line */
 		SET_STATE(io,linelen) += read = strlen(bufp);
+		STATS_ADD(STATS_BYTES_IN,read);
+		if (GET_PUBLIC(args,diff)) {
+			diff_input(bufp,read);
+		}
 		bufp += read;
 		if (bufp[-1] == '\n') {
 			/* End of line. That's all */
 			SET_PUBLIC(io,line_end) = bufp;
+			if (GET_PUBLIC(io,lf_only) && GET_STATE(io,linelen) > 1 &&
+				bufp[-2] == '\r') {
+				/* Windows line-end after a Unix first block. Demote */
+				SET_PUBLIC(io,lf_only) = false;
+			}
 			break;
 		}
 	}
+	STATS_PHASE(phase);
 	return read != 0;
 }
 
@@ -256,6 +288,7 @@ extend_line(void)
 	bool eof = !readon();
 	if (!eof) {
 		++SET_PUBLIC(io,line_num);
+		STATS_COUNT(STATS_LINES);
 		return true;
 	}
 	if (GET_STATE(io,linelen) > 0) {
@@ -350,7 +383,10 @@ backup_infile(void)
 static void
 open_output(void)
 {
-	if (!GET_PUBLIC(args,replace)) {
+	if (GET_STATE(io,given_output)) {
+		SET_PUBLIC(io,output) = GET_STATE(io,given_output);
+	}
+	else if (!GET_PUBLIC(args,replace)) {
 		SET_PUBLIC(io,output) = stdout;
 	}
 	else {
@@ -360,6 +396,25 @@ open_output(void)
 	}
 }
 
+static void
+sniff_line_ends(void)
+{
+	char block[BUFSIZ];
+	FILE *input = GET_STATE(io,input);
+	size_t read;
+	SET_PUBLIC(io,lf_only) = false;
+	if (input == stdin) {
+		return;
+	}
+	read = fread(block,1,sizeof(block),input);
+	if (ferror(input)) {
+		bail(GRIPE_CANT_READ_INPUT,"Read error on file %s",
+			GET_PUBLIC(io,filename));
+	}
+	rewind(input);
+	SET_PUBLIC(io,lf_only) = memchr(block,'\r',read) == NULL;
+}
+
 /* API ***************************************************************/
 
 FILE * open_file(const char *file, const char *mode)
@@ -376,11 +431,22 @@ void
 close_io(int error)
 {
 	if (GET_STATE(io,input) != NULL) {
+		checkpoint_close(error);
+		cache_close(error);
+		if (GET_PUBLIC(args,diff)) {
+			diff_close(error);
+		}
 		++SET_PUBLIC(dataset,donefiles);
 		if (error) {
 			++SET_PUBLIC(dataset,errorfiles);
 		}
-		if (GET_STATE(io,input) != stdin) {
+		if (GET_STATE(io,input) == GET_STATE(io,given_input)) {
+			/* The streams belong to the caller */
+			SET_STATE(io,given_input) = SET_STATE(io,given_output) = NULL;
+			SET_STATE(io,input) = NULL;
+			SET_PUBLIC(io,output) = NULL;
+		}
+		else if (GET_STATE(io,input) != stdin) {
 	
 			fclose(GET_STATE(io,input));
 			SET_STATE(io,input) = NULL;
@@ -391,6 +457,7 @@ close_io(int error)
 				SET_PUBLIC(io,output) = NULL;
 			}
 			if (!error && GET_PUBLIC(args,replace)) {
+				stats_phase_t phase = STATS_PHASE(STATS_RENAME);
 				if (GET_PUBLIC(args,backup_suffix) != NULL) {
 					backup_infile();
 				}
@@ -398,18 +465,32 @@ close_io(int error)
 					delete_infile();
 				}
 				replace_infile();
+				STATS_PHASE(phase);
 			}
+			manifest_close(GET_PUBLIC(io,filename),error);
 		}
 		io_toplevel();
 	}
 }
 
 
+void
+io_use_streams(FILE *input, FILE *output)
+{
+	SET_STATE(io,given_input) = input;
+	SET_STATE(io,given_output) = output;
+}
+
 void
 open_io(char const *filename)
 {
+	stats_phase_t phase;
 	SET_PUBLIC(io,filename) = filename;
-	if (!strcmp(GET_PUBLIC(io,filename),STDIN_NAME)) {
+	if (GET_STATE(io,given_input)) {
+		SET_STATE(io,input) = GET_STATE(io,given_input);
+		SET_PUBLIC(io,line_num) = 0;
+	}
+	else if (!strcmp(GET_PUBLIC(io,filename),STDIN_NAME)) {
 		SET_STATE(io,input) = stdin;
 	}
 	else {
@@ -417,11 +498,18 @@ open_io(char const *filename)
 			open_file(GET_PUBLIC(io,filename),"r");
 		SET_PUBLIC(io,line_num) = 0;
 	}
+	sniff_line_ends();
+	phase = STATS_PHASE(STATS_LEX);
+	lex_map_build(GET_STATE(io,input));
+	STATS_PHASE(phase);
 	open_output();
 }
 
 bool get_line(void)
 {
+	if (GET_PUBLIC(args,diff)) {
+		diff_sync();
+	}
 	SET_STATE(io,linelen) = 0;
 	SET_PUBLIC(io,extension_lines) = 0;
 	return extend_line();
@@ -493,6 +581,27 @@ saved_read_pos(void)
 	return GET_PUBLIC(io,line_start) + GET_STATE(io,saved_read_pos);
 }
 
+long
+input_offset(void)
+{
+	long offset = ftell(GET_STATE(io,input));
+	if (offset < 0) {
+		bail(GRIPE_CANT_READ_INPUT,"Cannot tell position in file %s",
+			GET_PUBLIC(io,filename));
+	}
+	return offset;
+}
+
+void
+seek_input(long offset, int line_num)
+{
+	if (fseek(GET_STATE(io,input),offset,SEEK_SET)) {
+		bail(GRIPE_CANT_READ_INPUT,"Cannot seek in file %s",
+			GET_PUBLIC(io,filename));
+	}
+	SET_PUBLIC(io,line_num) = line_num;
+}
+
 void
 io_toplevel(void)
 {
@@ -77,6 +77,18 @@ FILE * open_file(const char *file, const char *mode);
 extern void
 open_io(char const *filename);
 
+/*! Supply the streams to be opened by the next call to \c open_io().
+
+	\param		input	A readable and seekable stream from which the
+				next input file is read.
+	\param		output	A stream to which its output is written.
+
+	The streams belong to the caller. \c close_io() does not close them
+	and never replaces an input file with output written to them.
+ */
+extern void
+io_use_streams(FILE *input, FILE *output);
+
 /*! Finalise the current pairing of source input and processed output,
  *	if any.
 
@@ -171,6 +183,20 @@ read_offset(char const *readpos);
 extern char *
 read_pos(size_t readoff);
 
+/*! Get the offset in the current source file at which the next
+ *	line will be read, as reported by \c ftell()
+ */
+extern long
+input_offset(void);
+
+/*! Reposition the current source file to read the next line from
+ *	a given offset.
+ *	\param offset	An offset returned by input_offset().
+ *	\param line_num	The line number of the last line before \em offset.
+ */
+extern void
+seek_input(long offset, int line_num);
+
 
 /*@}*/
 
@@ -186,6 +212,8 @@ PUBLIC_STATE_DEF(io) {
 	FILE * output;	/*!< The output stream */
 	int extension_lines; /*!< Number of linefeeds embedded in the current
 							extended line */
+	bool lf_only;	/*!< Have only Unix line-ends been read from the
+						current source file? */
 } PUBLIC_STATE_T(io);
 
 /*@}*/
@@ -0,0 +1,343 @@
+/***************************************************************************
+ *   Copyright (C) 2004, 2006 Symbian Software Ltd.                        *
+ *   All rights reserved.                                                  *
+ *   Copyright (C) 2007, 2008 Mike Kinghan, imk@strudl.org                 *
+ *   All rights reserved.                                                  *
+ *                                                                         *
+ *   Contributed originally by Mike Kinghan, imk@strudl.org                *
+ *                                                                         *
+ *   Redistribution and use in source and binary forms, with or without    *
+ *   modification, are permitted provided that the following conditions    *
+ *   are met:                                                              *
+ *                                                                         *
+ *   Redistributions of source code must retain the above copyright        *
+ *   notice, this list of conditions and the following disclaimer.         *
+ *                                                                         *
+ *   Redistributions in binary form must reproduce the above copyright     *
+ *   notice, this list of conditions and the following disclaimer in the   *
+ *   documentation and/or other materials provided with the distribution.  *
+ *                                                                         *
+ *   Neither the name of Symbian Software Ltd. nor the names of its        *
+ *   contributors may be used to endorse or promote products derived from  *
+ *   this software without specific prior written permission.              *
+ *                                                                         *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS   *
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT     *
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS    *
+ *   FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE        *
+ *   COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,   *
+ *   INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,  *
+ *   BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS *
+ *   OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED    *
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,*
+ *   OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF *
+ *   THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH  *
+ *   DAMAGE.                                                               *
+ *                                                                         *
+ ***************************************************************************/
+
+#define MEMORY_TAG	MEMORY_LINES
+#include "lex_map.h"
+#include "args.h"
+#include "io.h"
+#include "memory.h"
+#include "report.h"
+#include "thread.h"
+#include <string.h>
+
+/*!\ingroup lex_map_module, lex_map_interface, lex_map_internals
+ *\file lex_map.c
+ * This file implements the Lex Map module.
+ *
+ *	The chew module never begins a logical line within a comment or
+ *	quotation: a newline within a C comment or after a line-continuation
+ *	extends the current line instead. So whether a physical line is inert
+ *	depends only on its own text and not on the lexical state in which
+ *	the preceding text leaves off. Each chunk of a file can therefore be
+ *	classified without regard to any other, and the results of all chunks
+ *	are simply concatenated in order.
+ */
+
+/*! \addtogroup lex_map_internals */
+/*@{*/
+
+/*! The number of bytes of input classified per window */
+#define LEX_MAP_WINDOW	(1 << 23)
+
+/*! The smallest chunk of input that is worth a thread of its own */
+#define LEX_MAP_MIN_CHUNK	(1 << 14)
+
+/*! Structure representing a chunk of input to be classified
+	by one thread */
+typedef struct lex_chunk {
+	/*! The start of the chunk */
+	char const *start;
+	/*! One past the final newline of the chunk */
+	char const *end;
+	/*! Array of inert flags, one per line of the chunk. It is allocated
+		by the main thread with one flag per byte of the chunk, enough
+		for any number of lines. */
+	unsigned char *inert;
+	/*! The number of lines in the chunk */
+	size_t lines;
+} lex_chunk_t;
+
+/*! Say whether a line is inert.
+
+	\param	cp		The start of the line.
+	\param	eol		The address of the newline that ends the line.
+	\return	\em true iff the line is inert.
+
+	The line is deemed inert if the first character beyond leading
+	whitespace makes it a code line and, scanning as per chew_on(),
+	the line ends outside any quotation or C comment. A line that
+	contains a backslash or a nul is never deemed inert.
+ */
+static bool
+inert_line(char const *cp, char const *eol)
+{
+	enum {
+		IN_CODE,
+		IN_DOUBLE_QUOTE,
+		IN_SINGLE_QUOTE,
+		IN_C_COMMENT,
+		IN_CXX_COMMENT
+	} state = IN_CODE;
+	for (	;*cp == ' ' || *cp == '\t'; ++cp) {}
+	switch(*cp) {
+	case '#':
+	case '/':
+	case '\\':
+	case '"':
+	case '\'':
+	case '\r':
+	case '\n':
+	case '\0':
+		return false;
+	default:;
+	}
+	for (	;cp < eol; ++cp) {
+		if (*cp == '\\' || *cp == '\0') {
+			return false;
+		}
+		switch(state) {
+		case IN_CODE:
+			if (*cp == '"') {
+				state = IN_DOUBLE_QUOTE;
+			}
+			else if (*cp == '\'') {
+				state = IN_SINGLE_QUOTE;
+			}
+			else if (cp[0] == '/' && cp[1] == '*') {
+				state = IN_C_COMMENT;
+				++cp;
+			}
+			else if (cp[0] == '/' && cp[1] == '/') {
+				state = IN_CXX_COMMENT;
+				++cp;
+			}
+			break;
+		case IN_DOUBLE_QUOTE:
+			if (*cp == '"') {
+				state = IN_CODE;
+			}
+			break;
+		case IN_SINGLE_QUOTE:
+			if (*cp == '\'') {
+				state = IN_CODE;
+			}
+			break;
+		case IN_C_COMMENT:
+			if (cp[0] == '*' && cp[1] == '/') {
+				state = IN_CODE;
+				++cp;
+			}
+			break;
+		case IN_CXX_COMMENT:
+			break;
+		}
+	}
+	return state == IN_CODE || state == IN_CXX_COMMENT;
+}
+
+/*! Classify the lines of a chunk of input.
+	\param	chunk	Pointer to the \e lex_chunk_t to be classified.
+
+	This function is run by a worker thread. It must not touch the
+	state of any module, nor allocate, since a failed allocation would
+	bail out of the wrong thread.
+*/
+static void
+classify_chunk(void *chunk)
+{
+	lex_chunk_t *lc = chunk;
+	char const *cp;
+	for (cp = lc->start, lc->lines = 0; cp < lc->end; ++lc->lines) {
+		char const *eol = memchr(cp,'\n',lc->end - cp);
+		lc->inert[lc->lines] = inert_line(cp,eol);
+		cp = eol + 1;
+	}
+}
+
+/*! Get the address one past the last newline in a buffer, or NULL
+	if there is none.
+*/
+static char const *
+after_last_newline(char const *start, char const *end)
+{
+	while (end > start) {
+		if (*--end == '\n') {
+			return end + 1;
+		}
+	}
+	return NULL;
+}
+
+/*@}*/
+
+/*! \ingroup lex_map_internals_state_utils */
+/*@{*/
+
+/*! The global state of the Lex Map module */
+STATE_DEF(lex_map) {
+	unsigned char *inert;	/*!< Array of inert flags, one per line */
+	size_t lines;	/*!< Number of lines classified in the current file */
+	size_t cap;		/*!< Capacity of the array of flags */
+} STATE_T(lex_map);
+/*@}*/
+
+/*! \addtogroup lex_map_internals_state_utils */
+/*@{*/
+NO_PUBLIC_STATE(lex_map);
+
+IMPLEMENT(lex_map,ZERO_INITABLE);
+/*@}*/
+
+/*! \addtogroup lex_map_internals */
+/*@{*/
+
+/*! Classify the lines of a window of input in parallel and append
+	their flags to the module's array.
+
+	\param	start	The start of the window.
+	\param	end		One past the last newline in the window.
+	\param	jobs	The maximum number of threads to use.
+*/
+static void
+classify_window(char const *start, char const *end, int jobs)
+{
+	lex_chunk_t *chunks;
+	thread_t *threads;
+	size_t target;
+	int nchunks, i;
+	if ((size_t)jobs > (size_t)(end - start) / LEX_MAP_MIN_CHUNK) {
+		jobs = (int)((end - start) / LEX_MAP_MIN_CHUNK);
+	}
+	if (jobs < 1) {
+		jobs = 1;
+	}
+	target = (end - start) / jobs;
+	chunks = callocate(jobs,sizeof(lex_chunk_t));
+	threads = callocate(jobs,sizeof(thread_t));
+	for (nchunks = 0; start < end; ++nchunks) {
+		char const *chunk_end = end;
+		if (nchunks < jobs - 1 && (size_t)(end - start) > target) {
+			/* End the chunk at the first newline beyond the target size */
+			chunk_end = (char const *)memchr(start + target - 1,'\n',
+				(end - start) - (target - 1)) + 1;
+		}
+		chunks[nchunks].start = start;
+		chunks[nchunks].end = chunk_end;
+		chunks[nchunks].inert = allocate(chunk_end - start);
+		start = chunk_end;
+	}
+	for (i = 1; i < nchunks; ++i) {
+		threads[i] = thread_start(classify_chunk,chunks + i);
+	}
+	classify_chunk(chunks);
+	for (i = 1; i < nchunks; ++i) {
+		thread_join(threads[i]);
+	}
+	for (i = 0; i < nchunks; ++i) {
+		size_t lines = GET_STATE(lex_map,lines);
+		if (lines + chunks[i].lines > GET_STATE(lex_map,cap)) {
+			size_t cap = GET_STATE(lex_map,cap) * 2;
+			if (cap < lines + chunks[i].lines) {
+				cap = lines + chunks[i].lines;
+			}
+			SET_STATE(lex_map,inert) =
+				reallocate(GET_STATE(lex_map,inert),cap);
+			SET_STATE(lex_map,cap) = cap;
+		}
+		memcpy(GET_STATE(lex_map,inert) + lines,
+			chunks[i].inert,chunks[i].lines);
+		SET_STATE(lex_map,lines) += chunks[i].lines;
+		release((void **)&chunks[i].inert);
+	}
+	release((void **)&threads);
+	release((void **)&chunks);
+}
+
+/*@}*/
+
+/* API ***************************************************************/
+
+void
+lex_map_build(FILE *input)
+{
+	int jobs = GET_PUBLIC(args,jobs);
+	size_t winsz = LEX_MAP_WINDOW;
+	size_t carry = 0;
+	char *window;
+	long size;
+
+	SET_STATE(lex_map,lines) = 0;
+	if (jobs < 2 || input == stdin) {
+		return;
+	}
+	if (fseek(input,0,SEEK_END)) {
+		return;
+	}
+	size = ftell(input);
+	rewind(input);
+	if (size < 2 * LEX_MAP_MIN_CHUNK) {
+		return;
+	}
+	window = allocate(winsz);
+	for (	;;) {
+		size_t read = fread(window + carry,1,winsz - carry,input);
+		size_t avail = carry + read;
+		char const *mapped;
+		if (read == 0) {
+			/* Any carry is a last line without newline. Not inert */
+			break;
+		}
+		mapped = after_last_newline(window,window + avail);
+		if (mapped == NULL) {
+			/* No line ends in the window. Need a bigger window */
+			carry = avail;
+			if (carry == winsz) {
+				window = reallocate(window,winsz *= 2);
+			}
+			continue;
+		}
+		classify_window(window,mapped,jobs);
+		carry = window + avail - mapped;
+		memmove(window,mapped,carry);
+	}
+	if (ferror(input)) {
+		bail(GRIPE_CANT_READ_INPUT,"Read error on file %s",
+			GET_PUBLIC(io,filename));
+	}
+	release((void **)&window);
+	rewind(input);
+}
+
+bool
+lex_map_inert_line(int line_num)
+{
+	return line_num > 0 && (size_t)line_num <= GET_STATE(lex_map,lines) &&
+		GET_STATE(lex_map,inert)[line_num - 1];
+}
+
+/* EOF */
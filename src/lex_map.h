@@ -0,0 +1,89 @@
+#ifndef LEX_MAP_H
+#define LEX_MAP_H
+
+/***************************************************************************
+ *   Copyright (C) 2004, 2006 Symbian Software Ltd.                        *
+ *   All rights reserved.                                                  *
+ *   Copyright (C) 2007, 2008 Mike Kinghan, imk@strudl.org                 *
+ *   All rights reserved.                                                  *
+ *                                                                         *
+ *   Contributed originally by Mike Kinghan, imk@strudl.org                *
+ *                                                                         *
+ *   Redistribution and use in source and binary forms, with or without    *
+ *   modification, are permitted provided that the following conditions    *
+ *   are met:                                                              *
+ *                                                                         *
+ *   Redistributions of source code must retain the above copyright        *
+ *   notice, this list of conditions and the following disclaimer.         *
+ *                                                                         *
+ *   Redistributions in binary form must reproduce the above copyright     *
+ *   notice, this list of conditions and the following disclaimer in the   *
+ *   documentation and/or other materials provided with the distribution.  *
+ *                                                                         *
+ *   Neither the name of Symbian Software Ltd. nor the names of its        *
+ *   contributors may be used to endorse or promote products derived from  *
+ *   this software without specific prior written permission.              *
+ *                                                                         *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS   *
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT     *
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS    *
+ *   FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE        *
+ *   COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,   *
+ *   INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,  *
+ *   BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS *
+ *   OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED    *
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,*
+ *   OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF *
+ *   THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH  *
+ *   DAMAGE.                                                               *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "opts.h"
+#include <stdio.h>
+
+/*!\ingroup lex_map_module, lex_map_interface
+ *\file lex_map.h
+ * This file provides the Lex Map module interface.
+ *
+ *	The Lex Map module classifies the lines of a large input file
+ *	in advance of the sequential parse, spreading the work over
+ *	multiple threads. A line is classified \em inert if, when
+ *	it is read at the start of a logical line, it is certainly
+ *	a plain line of code that opens no comment or quotation that
+ *	runs past its end and contains no line-continuation. The
+ *	Evaluator need not chew an inert line.
+ */
+
+/*! \addtogroup lex_map_interface */
+/*@{*/
+
+/*! Classify the lines of an input file, when the \c --jobs
+	option is in force and the file is large enough to warrant it.
+
+	\param	input	The input stream, positioned at the start of file.
+
+	On return \em input is rewound. If the file is not classified
+	then no line will be reported inert.
+*/
+extern void
+lex_map_build(FILE *input);
+
+/*! Say whether a line of the current input file has been
+	classified inert.
+
+	\param	line_num	The 1-based number of a physical line.
+	\return \em true iff line \em line_num is inert.
+ */
+extern bool
+lex_map_inert_line(int line_num);
+
+/*@}*/
+
+/*! \addtogroup lex_map_interface_state_utils */
+/*@{*/
+IMPORT_INITOR(lex_map);
+IMPORT_FINITOR(lex_map);
+/*@}*/
+
+#endif /* EOF */
@@ -0,0 +1,424 @@
+/***************************************************************************
+ *   Copyright (C) 2004, 2006 Symbian Software Ltd.                        *
+ *   All rights reserved.                                                  *
+ *   Copyright (C) 2007, 2008 Mike Kinghan, imk@strudl.org                 *
+ *   All rights reserved.                                                  *
+ *                                                                         *
+ *   Contributed originally by Mike Kinghan, imk@strudl.org                *
+ *                                                                         *
+ *   Redistribution and use in source and binary forms, with or without    *
+ *   modification, are permitted provided that the following conditions    *
+ *   are met:                                                              *
+ *                                                                         *
+ *   Redistributions of source code must retain the above copyright        *
+ *   notice, this list of conditions and the following disclaimer.         *
+ *                                                                         *
+ *   Redistributions in binary form must reproduce the above copyright     *
+ *   notice, this list of conditions and the following disclaimer in the   *
+ *   documentation and/or other materials provided with the distribution.  *
+ *                                                                         *
+ *   Neither the name of Symbian Software Ltd. nor the names of its        *
+ *   contributors may be used to endorse or promote products derived from  *
+ *   this software without specific prior written permission.              *
+ *                                                                         *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS   *
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT     *
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS    *
+ *   FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE        *
+ *   COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,   *
+ *   INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,  *
+ *   BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS *
+ *   OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED    *
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,*
+ *   OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF *
+ *   THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH  *
+ *   DAMAGE.                                                               *
+ *                                                                         *
+ ***************************************************************************/
+#include "libsunifdef.h"
+#include "opts.h"
+#include "platform.h"
+#include "args.h"
+#include "cache.h"
+#include "categorical.h"
+#include "checkpoint.h"
+#include "chew.h"
+#include "daemon.h"
+#include "dataset.h"
+#include "evaluator.h"
+#include "exception.h"
+#include "if_control.h"
+#include "io.h"
+#include "lex_map.h"
+#include "line_despatch.h"
+#include "line_edit.h"
+#include "manifest.h"
+#include "memory.h"
+#include "process.h"
+#include "profile.h"
+#include "report.h"
+#include "stats.h"
+#include "symbol_table.h"
+#include "timeline.h"
+#include <stdio.h>
+#include <string.h>
+
+/*!\ingroup libsunifdef_module
+ *\file libsunifdef.c
+ * This file implements the \c libsunifdef library.
+ *
+ *	The library is built with \c SUNIFDEF_LIBRARY defined, so that every
+ *	module keeps its state on the heap, addressed by thread-local handles.
+ *	A context owns one instance of the state of every module, and each
+ *	call attaches the handles of the calling thread to the instances of
+ *	the context for the duration of the call. Errors and abends are thrown
+ *	to the context's own execution context instead of exiting.
+ */
+
+/*! \addtogroup libsunifdef_module */
+/*@{*/
+
+/*! The name given to an input buffer that has none */
+#define BUFFER_NAME	"[buffer]"
+
+IMPORT_ATTACHER(chew);
+IMPORT_ATTACHER(diagnostic);
+IMPORT_ATTACHER(evaluator);
+IMPORT_ATTACHER(if_control);
+IMPORT_ATTACHER(io);
+IMPORT_ATTACHER(dataset);
+IMPORT_ATTACHER(line_edit);
+IMPORT_ATTACHER(args);
+IMPORT_ATTACHER(symbol_table);
+IMPORT_ATTACHER(line_despatch);
+IMPORT_ATTACHER(categorical);
+IMPORT_ATTACHER(lex_map);
+IMPORT_ATTACHER(checkpoint);
+IMPORT_ATTACHER(manifest);
+IMPORT_ATTACHER(cache);
+IMPORT_ATTACHER(daemon);
+IMPORT_ATTACHER(stats);
+IMPORT_ATTACHER(timeline);
+IMPORT_ATTACHER(profile);
+IMPORT_ATTACHER(exception);
+
+/*! Structure of the generated functions of a module */
+typedef struct module {
+	void (*initor)(void);	/*!< The module's initialising function */
+	void (*finitor)(void);	/*!< The module's finalising function */
+	void * (*attacher)(void *);	/*!< The module's attaching function */
+} module_t;
+
+/*! Compose the \c module_t of a module */
+#define MODULE(module)	{ INITOR(module), FINITOR(module), ATTACHER(module) }
+
+/*! The modules with state, in order of initialisation */
+static module_t const modules[] = {
+	MODULE(chew),
+	MODULE(diagnostic),
+	MODULE(evaluator),
+	MODULE(if_control),
+	MODULE(io),
+	MODULE(dataset),
+	MODULE(line_edit),
+	MODULE(args),
+	MODULE(symbol_table),
+	MODULE(line_despatch),
+	MODULE(categorical),
+	MODULE(lex_map),
+	MODULE(checkpoint),
+	MODULE(manifest),
+	MODULE(cache),
+	MODULE(daemon),
+	MODULE(stats),
+	MODULE(timeline),
+	MODULE(profile),
+	MODULE(exception)
+};
+
+/*! The number of modules with state */
+#define MODULES		(sizeof(modules) / sizeof(modules[0]))
+
+/*! Structure of a context */
+struct sunifdef_context {
+	/*! The instance of the state of each module in \c modules, while the
+		context is not attached. While it is attached, the instances that
+		it displaced */
+	void *	states[MODULES];
+	/*! The commandline composed from the options, which the parsed
+		options address */
+	heap_str *	argv;
+	/*! The number of elements of \c argv */
+	int		argc;
+};
+
+/*! Structure of a stream to which output is collected */
+typedef struct sink {
+	FILE *	stream;	/*!< The stream */
+	char *	buf;	/*!< The buffer of a memory stream */
+	size_t	size;	/*!< The size of the contents of a memory stream */
+	bool	memory;	/*!< Is \c stream a memory stream? */
+} sink_t;
+
+/*! Attach the module states of a context to the calling thread, or
+	detach them, swapping them with the states attached.
+*/
+static void
+swap_states(sunifdef_h context)
+{
+	size_t i;
+	for (i = 0; i < MODULES; ++i) {
+		context->states[i] = modules[i].attacher(context->states[i]);
+	}
+}
+
+/*! Open a stream on an input buffer.
+	\return	The stream, or NULL on failure.
+*/
+static FILE *
+open_input(char const *input, size_t len)
+{
+	FILE *stream = NULL;
+#ifdef UNIX
+	if (len) {
+		stream = fmemopen((void *)input,len,"r");
+	}
+#endif
+	if (stream == NULL) {
+		stream = tmpfile();
+		if (stream && (fwrite(input,1,len,stream) != len ||
+			fseek(stream,0,SEEK_SET))) {
+			fclose(stream);
+			stream = NULL;
+		}
+	}
+	return stream;
+}
+
+/*! Open a sink.
+	\return	True iff the sink is opened.
+*/
+static bool
+open_sink(sink_t *sink)
+{
+	memset(sink,0,sizeof(*sink));
+#ifdef UNIX
+	sink->stream = open_memstream(&sink->buf,&sink->size);
+	sink->memory = sink->stream != NULL;
+#endif
+	if (sink->stream == NULL) {
+		sink->stream = tmpfile();
+	}
+	return sink->stream != NULL;
+}
+
+/*! Close a sink and take what was written to it.
+	\param	sink	The sink.
+	\param	keep	Is the contents wanted?
+	\param	len		Receives the length of the contents.
+	\return	NULL, or the contents, on the heap with a terminal nul.
+*/
+static char *
+close_sink(sink_t *sink, bool keep, size_t *len)
+{
+	char *contents = NULL;
+	*len = 0;
+	if (sink->stream == NULL) {
+		return NULL;
+	}
+	if (sink->memory) {
+		fclose(sink->stream);
+		contents = sink->buf;
+		*len = sink->size;
+	}
+	else if (keep) {
+		long size = ftell(sink->stream);
+		if (size > 0 && !fseek(sink->stream,0,SEEK_SET)) {
+			contents = malloc((size_t)size + 1);
+			if (contents) {
+				*len = fread(contents,1,(size_t)size,sink->stream);
+				contents[*len] = '\0';
+			}
+		}
+		fclose(sink->stream);
+	}
+	else {
+		fclose(sink->stream);
+	}
+	sink->stream = NULL;
+	if (contents && (!keep || *len == 0)) {
+		free(contents);
+		contents = NULL;
+		*len = 0;
+	}
+	return contents;
+}
+
+/*! Copy the options to a context, composing a commandline */
+static void
+copy_args(sunifdef_h context, int argc, char const * const argv[])
+{
+	int i;
+	context->argc = argc + 1;
+	context->argv = callocate(argc + 2,sizeof(heap_str));
+	context->argv[0] = allocate(sizeof("sunifdef"));
+	strcpy(context->argv[0],"sunifdef");
+	for (i = 0; i < argc; ++i) {
+		context->argv[i + 1] = allocate(strlen(argv[i]) + 1);
+		strcpy(context->argv[i + 1],argv[i]);
+	}
+}
+
+/*! Parse the options of a context to which it is attached, writing any
+	diagnostics to a sink.
+	\return	True iff the options are valid.
+*/
+static bool
+parse_options(sunifdef_h context, sink_t *diagnostics)
+{
+	volatile bool valid = false;
+	SET_PUBLIC(exception,hosted) = true;
+	SET_PUBLIC(exception,enabled) = true;
+	divert_diagnostics(diagnostics->stream);
+	if (!catch()) {
+		parse_executable(context->argv);
+		parse_args(context->argc,context->argv);
+		if (!dataset_is_empty() || GET_PUBLIC(args,replace) ||
+			GET_PUBLIC(args,diff) || GET_PUBLIC(args,state_file) ||
+			GET_PUBLIC(args,manifest_file) || GET_PUBLIC(args,cache_dir) ||
+			GET_PUBLIC(args,daemon_socket) ||
+			GET_PUBLIC(args,client_socket) ||
+			GET_PUBLIC(args,stats_format) != STATS_NO ||
+			GET_PUBLIC(args,trace_file) || GET_PUBLIC(args,profile)) {
+			bail(GRIPE_INVALID_ARGS,
+				"The library takes no input files and does not support "
+				"--replace, --recurse, --diff, --incremental, --manifest, "
+				"--cache, --daemon, --client, --stats, --trace or --profile");
+		}
+		valid = true;
+	}
+	divert_diagnostics(NULL);
+	SET_PUBLIC(exception,enabled) = false;
+	return valid;
+}
+
+/*! Finalise the module states of a context to which it is attached */
+static void
+finalise(void)
+{
+	size_t i = MODULES;
+	while (i--) {
+		modules[i].finitor();
+	}
+}
+
+/*@}*/
+
+/* API ***************************************************************/
+
+sunifdef_h
+sunifdef_new(int argc, char const * const argv[], sunifdef_result_t *result)
+{
+	sunifdef_h context = callocate(1,sizeof(struct sunifdef_context));
+	sink_t diagnostics;
+	size_t i;
+	bool valid;
+	copy_args(context,argc,argv);
+	/* Detach any states of the calling thread to initialise new ones */
+	swap_states(context);
+	for (i = 0; i < MODULES; ++i) {
+		modules[i].initor();
+	}
+	if (!open_sink(&diagnostics)) {
+		diagnostics.stream = NULL;
+	}
+	valid = parse_options(context,&diagnostics);
+	if (result) {
+		result->output = NULL;
+		result->output_len = 0;
+		result->status = exitcode();
+		result->diagnostics =
+			close_sink(&diagnostics,true,&result->diagnostics_len);
+	}
+	else {
+		close_sink(&diagnostics,false,&i);
+	}
+	if (!valid) {
+		finalise();
+	}
+	swap_states(context);
+	if (!valid) {
+		sunifdef_dispose(&context);
+	}
+	return context;
+}
+
+int
+sunifdef_process(	sunifdef_h context,
+					char const *name,
+					char const *input,
+					size_t len,
+					sunifdef_result_t *result)
+{
+	sink_t output, diagnostics;
+	FILE *in = open_input(input,len);
+	int error;
+	memset(result,0,sizeof(*result));
+	if (in == NULL || !open_sink(&output)) {
+		if (in) {
+			fclose(in);
+		}
+		result->status = SUNIFDEF_ABEND;
+		return result->status;
+	}
+	if (!open_sink(&diagnostics)) {
+		diagnostics.stream = NULL;
+	}
+	swap_states(context);
+	error = process_stream(name ? name : BUFFER_NAME,in,output.stream,
+		diagnostics.stream);
+	result->status = exitcode();
+	swap_states(context);
+	fclose(in);
+	result->output = close_sink(&output,!error,&result->output_len);
+	result->diagnostics =
+		close_sink(&diagnostics,true,&result->diagnostics_len);
+	return result->status;
+}
+
+void
+sunifdef_result_free(sunifdef_result_t *result)
+{
+	free(result->output);
+	free(result->diagnostics);
+	memset(result,0,sizeof(*result));
+}
+
+void
+sunifdef_dispose(sunifdef_h *context)
+{
+	sunifdef_h ctx = *context;
+	int i;
+	if (ctx == NULL) {
+		return;
+	}
+	if (ctx->states[0]) {
+		swap_states(ctx);
+		finalise();
+		swap_states(ctx);
+	}
+	for (i = 0; i < ctx->argc; ++i) {
+		free(ctx->argv[i]);
+	}
+	free(ctx->argv);
+	free(ctx);
+	*context = NULL;
+}
+
+char const *
+sunifdef_version(void)
+{
+	return VERSION;
+}
+
+/* EOF */
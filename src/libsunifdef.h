@@ -0,0 +1,146 @@
+#ifndef LIBSUNIFDEF_H
+#define LIBSUNIFDEF_H
+/***************************************************************************
+ *   Copyright (C) 2004, 2006 Symbian Software Ltd.                        *
+ *   All rights reserved.                                                  *
+ *   Copyright (C) 2007, 2008 Mike Kinghan, imk@strudl.org                 *
+ *   All rights reserved.                                                  *
+ *                                                                         *
+ *   Contributed originally by Mike Kinghan, imk@strudl.org                *
+ *                                                                         *
+ *   Redistribution and use in source and binary forms, with or without    *
+ *   modification, are permitted provided that the following conditions    *
+ *   are met:                                                              *
+ *                                                                         *
+ *   Redistributions of source code must retain the above copyright        *
+ *   notice, this list of conditions and the following disclaimer.         *
+ *                                                                         *
+ *   Redistributions in binary form must reproduce the above copyright     *
+ *   notice, this list of conditions and the following disclaimer in the   *
+ *   documentation and/or other materials provided with the distribution.  *
+ *                                                                         *
+ *   Neither the name of Symbian Software Ltd. nor the names of its        *
+ *   contributors may be used to endorse or promote products derived from  *
+ *   this software without specific prior written permission.              *
+ *                                                                         *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS   *
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT     *
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS    *
+ *   FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE        *
+ *   COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,   *
+ *   INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,  *
+ *   BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS *
+ *   OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED    *
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,*
+ *   OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF *
+ *   THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH  *
+ *   DAMAGE.                                                               *
+ *                                                                         *
+ ***************************************************************************/
+#include <stddef.h>
+
+/*!\ingroup libsunifdef_module
+ *\file libsunifdef.h
+ * This file provides the interface of the \c libsunifdef library.
+ *
+ *	The library lets a program process buffers as the \c sunifdef program
+ *	processes files, without a process per file. A context holds the
+ *	options, the symbol table and the rest of the state of a run. It is
+ *	set up once by \c sunifdef_new() and then processes any number of
+ *	buffers with \c sunifdef_process(), as \c sunifdef processes any
+ *	number of input files.
+ *
+ *	The library is reentrant. Distinct contexts may be used concurrently
+ *	by distinct threads. A context may be used by only one thread at a
+ *	time, but need not always be used by the same one.
+ */
+
+/*! \addtogroup libsunifdef_module */
+/*@{*/
+
+/*! Abstract type of a \c libsunifdef context */
+typedef struct sunifdef_context * sunifdef_h;
+
+/*! Bits of the status returned for a call, as for the exit status
+	of the \c sunifdef program */
+enum sunifdef_status {
+	SUNIFDEF_INFO = 0x01,	/*!< Remarks were given */
+	SUNIFDEF_WARNING = 0x02,	/*!< Warnings were given */
+	SUNIFDEF_ERROR = 0x04,	/*!< Errors were given. There is no output */
+	SUNIFDEF_ABEND = 0x08,	/*!< The call failed. There is no output */
+	SUNIFDEF_DROPPED_LINES = 0x10,	/*!< Input lines were dropped */
+	SUNIFDEF_CHANGED_LINES = 0x20,	/*!< Input lines were changed */
+	SUNIFDEF_ERRORED_LINES = 0x40,
+		/*!< Input lines were changed to \c #error directives */
+	SUNIFDEF_ERROR_OUTPUT = 0x80
+		/*!< Unconditional \c #error directives were output */
+};
+
+/*! Structure of the result of a call */
+typedef struct sunifdef_result {
+	char *	output;
+		/*!< NULL, or the output on the heap with a terminal nul */
+	size_t	output_len;	/*!< The length of the output */
+	char *	diagnostics;
+		/*!< NULL, or the diagnostics on the heap with a terminal nul */
+	size_t	diagnostics_len;	/*!< The length of the diagnostics */
+	int		status;
+		/*!< The status of the call, a combination of the bits in
+			\c enum \c sunifdef_status */
+} sunifdef_result_t;
+
+/*! Construct a context from options.
+
+	\param	argc	The number of options at \c argv.
+	\param	argv	The options, as they would follow the program name
+					on the \c sunifdef commandline. They are copied.
+	\param	result	NULL, or the address at which to store the result. Its
+					diagnostics are those given for the options.
+	\return	The new context, or NULL if the options are invalid.
+
+	A context takes no input files and does not support the options
+	that replace or name input files, such as \c --replace,
+	\c --recurse, \c --diff, \c --incremental, \c --manifest,
+	\c --cache, \c --daemon or \c --client.
+*/
+extern sunifdef_h
+sunifdef_new(int argc, char const * const argv[], sunifdef_result_t *result);
+
+/*! Process a buffer.
+
+	\param	context	The context.
+	\param	name	NULL, or the name of the input, for diagnostics.
+	\param	input	The input.
+	\param	len		The length of the input.
+	\param	result	The address at which to store the result.
+	\return	The status of the call, as in \c result.
+
+	The output and diagnostics are as the \c sunifdef program would give
+	for an input file with the options of the context. Each call starts
+	afresh: the status reflects only this buffer.
+*/
+extern int
+sunifdef_process(	sunifdef_h context,
+					char const *name,
+					char const *input,
+					size_t len,
+					sunifdef_result_t *result);
+
+/*! Release the storage of a result, which may then be reused. */
+extern void
+sunifdef_result_free(sunifdef_result_t *result);
+
+/*! Dispose of a context, releasing its resources.
+
+	\param	context	Address of the context, which is set NULL.
+*/
+extern void
+sunifdef_dispose(sunifdef_h *context);
+
+/*! Return the version of the library */
+extern char const *
+sunifdef_version(void);
+
+/*@}*/
+
+#endif /* EOF */
@@ -0,0 +1,162 @@
+/***************************************************************************
+ *   Copyright (C) 2004, 2006 Symbian Software Ltd.                        *
+ *   All rights reserved.                                                  *
+ *   Copyright (C) 2007, 2008 Mike Kinghan, imk@strudl.org                 *
+ *   All rights reserved.                                                  *
+ *                                                                         *
+ *   Contributed originally by Mike Kinghan, imk@strudl.org                *
+ *                                                                         *
+ *   Redistribution and use in source and binary forms, with or without    *
+ *   modification, are permitted provided that the following conditions    *
+ *   are met:                                                              *
+ *                                                                         *
+ *   Redistributions of source code must retain the above copyright        *
+ *   notice, this list of conditions and the following disclaimer.         *
+ *                                                                         *
+ *   Redistributions in binary form must reproduce the above copyright     *
+ *   notice, this list of conditions and the following disclaimer in the   *
+ *   documentation and/or other materials provided with the distribution.  *
+ *                                                                         *
+ *   Neither the name of Symbian Software Ltd. nor the names of its        *
+ *   contributors may be used to endorse or promote products derived from  *
+ *   this software without specific prior written permission.              *
+ *                                                                         *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS   *
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT     *
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS    *
+ *   FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE        *
+ *   COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,   *
+ *   INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,  *
+ *   BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS *
+ *   OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED    *
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,*
+ *   OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF *
+ *   THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH  *
+ *   DAMAGE.                                                               *
+ *                                                                         *
+ ***************************************************************************/
+#include "libsunifdef.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+
+/*! \ingroup libsunifdef_module
+ * \file libsunifdef_test.c
+ *	This file implements the test of the \c libsunifdef library that is
+ *	run by <tt>make check</tt>.
+ *
+ *	The test is a client of the library like any other. Two contexts with
+ *	contrary options each process many buffers at once on threads of
+ *	their own, and the output and status of every call are checked. As
+ *	the contexts share no state, neither may see the other's options.
+ */
+
+/*! \addtogroup libsunifdef_module */
+/*@{*/
+
+/*! The number of buffers processed by each context */
+#define BUFFERS		5000
+
+/*! Structure of the work of one thread */
+typedef struct job {
+	char const *option;	/*!< The option of the context */
+	char const *kept;	/*!< The variable that the option keeps */
+	int failures;	/*!< The number of calls that went wrong */
+} job_t;
+
+/*! Make the input buffer for a call and the output expected of it.
+	The buffers grow with the call number, so that each call sees
+	a new length.
+
+	\param	job		The work of the thread.
+	\param	call	The number of the call.
+	\param	input	Receives the input.
+	\param	output	Receives the output expected.
+	\return	The length of the input.
+*/
+static size_t
+make_buffers(job_t const *job, int call, char *input, char *output)
+{
+	int lines = call % 16 + 1;
+	int i;
+	char *in = input;
+	char *out = output;
+	for (i = 0; i < lines; ++i) {
+		in += sprintf(in,"#ifdef FOO\nint foo_%d_%d;\n#else\nint bar_%d_%d;\n"
+			"#endif\nint all_%d_%d;\n",call,i,call,i,call,i);
+		out += sprintf(out,"int %s_%d_%d;\nint all_%d_%d;\n",
+			job->kept,call,i,call,i);
+	}
+	return (size_t)(in - input);
+}
+
+/*! Thread function of a test thread. It makes a context with the
+	option of its \c job_t and has it process \c BUFFERS buffers.
+*/
+static void *
+run(void *arg)
+{
+	job_t *job = arg;
+	char const *argv[1];
+	sunifdef_h context;
+	int call;
+	argv[0] = job->option;
+	context = sunifdef_new(1,argv,NULL);
+	if (context == NULL) {
+		job->failures = BUFFERS;
+		return NULL;
+	}
+	for (call = 0; call < BUFFERS; ++call) {
+		char input[2048];
+		char output[1024];
+		sunifdef_result_t result;
+		size_t len = make_buffers(job,call,input,output);
+		int status = sunifdef_process(context,NULL,input,len,&result);
+		if (status != result.status ||
+			(status & (SUNIFDEF_ERROR | SUNIFDEF_ABEND)) ||
+			!(status & SUNIFDEF_DROPPED_LINES) ||
+			result.output == NULL || result.output_len != strlen(output) ||
+			strcmp(result.output,output)) {
+			if (!job->failures) {
+				fprintf(stderr,"libsunifdef_test: with %s, call %d gave "
+					"status 0x%x and output:\n%s",job->option,call,status,
+					result.output ? result.output : "(none)\n");
+			}
+			++job->failures;
+		}
+		sunifdef_result_free(&result);
+	}
+	sunifdef_dispose(&context);
+	return NULL;
+}
+
+int
+main(void)
+{
+	job_t jobs[2] = {
+		{ "-DFOO", "foo", 0 },
+		{ "-UFOO", "bar", 0 }
+	};
+	pthread_t threads[2];
+	int failures = 0;
+	int i;
+	for (i = 0; i < 2; ++i) {
+		if (pthread_create(threads + i,NULL,run,jobs + i)) {
+			fprintf(stderr,"libsunifdef_test: cannot start a thread\n");
+			return 1;
+		}
+	}
+	for (i = 0; i < 2; ++i) {
+		pthread_join(threads[i],NULL);
+		if (jobs[i].failures) {
+			fprintf(stderr,"libsunifdef_test: with %s, %d out of %d "
+				"calls failed\n",jobs[i].option,jobs[i].failures,BUFFERS);
+		}
+		failures += jobs[i].failures;
+	}
+	return failures != 0;
+}
+
+/*@}*/
+
+/* EOF */
@@ -41,14 +41,20 @@
  *                                                                         *
  ***************************************************************************/
 
+#define MEMORY_TAG	MEMORY_LINES
 #include "line_despatch.h"
 #include "report.h"
 #include "args.h"
 #include "line_edit.h"
 #include "io.h"
 #include "opts.h"
+#include "memory.h"
+#include "filesys.h"
+#include "platform.h"
 #include "bool.h"
+#include "stats.h"
 #include <stdio.h>
+#include <string.h>
 #include <ctype.h>
 
 /*!\ingroup line_despatch_internals line_despatch_interface
@@ -61,57 +67,445 @@
 
 /* Helpers ***********************************************************/
 
+/*! The number of lines of context around each hunk in \c --diff output */
+#define DIFF_CONTEXT	3
 
-/*! Print an unmodified line to output with no complications
+/*! Structure of a growable text buffer */
+typedef struct text_buf {
+	char *text;		/*!< The text, not null-terminated */
+	size_t len;		/*!< The length of the text */
+	size_t size;	/*!< The size of the heap block at \c text */
+} text_buf_t;
+
+/*! Structure of a line of text */
+typedef struct line_ref {
+	char const *text;	/*!< The start of the line */
+	size_t len;			/*!< Its length, including any newline */
+} line_ref_t;
+
+static void
+flushline_live(bool keep, char const *insert_text);
+
+/*!\ingroup line_despatch_internals_state_utils */
+/*@{*/
+
+/*! The global state of the Line Despatch module */
+STATE_DEF(line_despatch) {
+	/*! The public state of the Line Despatch module */
+	INCLUDE_PUBLIC(line_despatch);
+	/*! Pointer to the function that will be called to flush the
+	 *	the line-buffer to output. Will address flushline_dummy()
+	 *	(a no-op) when the \c --symbols option is specified, and
+	 *	otherwise \c flushline_line().
+	 */
+	void	 (*flushline)(bool,const char *);
+	/*! Count of contiguous lines that are dropped together */
+	size_t drop_run;
+	/*! With \c --diff, the input read since the current line was begun */
+	text_buf_t diff_old;
+	/*! With \c --diff, the output written since the current line was
+		begun */
+	text_buf_t diff_new;
+	/*! With \c --diff, the body of the current hunk */
+	text_buf_t hunk;
+	/*! With \c --diff, the latest unchanged lines not in the current hunk */
+	text_buf_t context[DIFF_CONTEXT];
+	/*! The number of lines in \c context */
+	int context_lines;
+	/*! The index in \c context of the next line to replace */
+	int context_next;
+	/*! The number of input lines diffed */
+	int old_line_num;
+	/*! The number of output lines diffed */
+	int new_line_num;
+	/*! Is a hunk begun? */
+	bool in_hunk;
+	/*! First input line of the current hunk */
+	int hunk_old_start;
+	/*! First output line of the current hunk */
+	int hunk_new_start;
+	/*! Number of input lines in the current hunk */
+	int hunk_old_lines;
+	/*! Number of output lines in the current hunk */
+	int hunk_new_lines;
+	/*! Number of unchanged lines at the end of the current hunk */
+	int hunk_trail;
+	/*! Number of unchanged lines since the end of the current hunk */
+	int hunk_gap;
+	/*! Has the header of the diff been written for the current file? */
+	bool diff_header_done;
+	/*! The real path of the current directory, for naming files in the
+		header of the diff */
+	heap_str cur_dir;
+} STATE_T(line_despatch);
+
+/*@}*/
+
+/*!\addtogroup line_despatch_internals_state_utils */
+/*@{*/
+
+IMPLEMENT(line_despatch,STATIC_INITABLE);
+
+USE_STATIC_INITIALISER(line_despatch) = {
+	{ 0, 0, 0 }, flushline_live, 0,
+	{ NULL, 0, 0 }, { NULL, 0, 0 }, { NULL, 0, 0 }, { { NULL, 0, 0 } },
+	0, 0, 0, 0, false, 0, 0, 0, 0, 0, 0, false, NULL
+};
+/*@}*/
+
+/*! Append text to a text buffer */
+static void
+text_buf_append(text_buf_t *buf, char const *text, size_t len)
+{
+	if (buf->len + len > buf->size) {
+		while (buf->len + len > buf->size) {
+			buf->size = buf->size ? buf->size * 2 : BUFSIZ;
+		}
+		buf->text = reallocate(buf->text,buf->size);
+	}
+	memcpy(buf->text + buf->len,text,len);
+	buf->len += len;
+}
+
+/*! Write text to output
+ *	\param	text	The text to write
+ *	\param	len		The length of the text
+ *
+ *	With \c --diff the text is kept to be diffed with the input
+ *	it replaces.
  */
 static void
-printline_fast(void)
+put_text(char const *text, size_t len)
+{
+	STATS_ADD(STATS_BYTES_OUT,len);
+	if (GET_PUBLIC(args,diff)) {
+		text_buf_append(&SET_STATE(line_despatch,diff_new),text,len);
+	}
+	else if (fwrite(text,1,len,GET_PUBLIC(io,output)) != len) {
+		bail(GRIPE_CANT_WRITE_FILE,"Write error on output\n");
+	}
+}
+
+/*! Write a null-terminated string to output */
+static void
+put_str(char const *str)
 {
-	fputs(GET_PUBLIC(io,line_start),GET_PUBLIC(io,output));
+	put_text(str,strlen(str));
 }
 
-/*! Print a line to output deleting chunks marked for
- *	unconditional deletion.
+/*! Write a diff line to the current hunk
+ *	\param	prefix	The prefix of the diff line: ' ', '-' or '+'
+ *	\param	line	The line of text
  */
 static void
-printline_cut(void)
+hunk_line(char prefix, line_ref_t line)
+{
+	text_buf_t *hunk = &SET_STATE(line_despatch,hunk);
+	text_buf_append(hunk,&prefix,1);
+	text_buf_append(hunk,line.text,line.len);
+	if (!line.len || line.text[line.len - 1] != '\n') {
+		static char const no_eol[] = "\n\\ No newline at end of file\n";
+		text_buf_append(hunk,no_eol,sizeof(no_eol) - 1);
+	}
+}
+
+/*! Write a hunk range to output in unified diff format */
+static void
+put_range(char prefix, int start, int lines)
 {
-	char *leader = GET_PUBLIC(io,line_start);
-	char *follower = leader;
-	int concat_risk = 0;
-	for (	;*leader; leader += (*leader != 0)) {
-		for (	;!DELETEABLE(*leader); ++leader) {};
-		if (fwrite(follower,1,leader - follower,GET_PUBLIC(io,output)) !=
-			leader - follower) {
-			bail(GRIPE_CANT_WRITE_FILE,"Write error on output\n");
+	FILE *out = GET_PUBLIC(io,output);
+	if (lines == 1) {
+		fprintf(out,"%c%d",prefix,start);
+	}
+	else {
+		fprintf(out,"%c%d,%d",prefix,lines ? start : start - 1,lines);
+	}
+}
+
+/*! Get the name of the input file as it is to appear in the header of
+ *	the diff.
+ *
+ *	Input filenames are absolute. A file beneath the current directory is
+ *	named relative to it, so that the diff may be applied with
+ *	<tt>patch -p0</tt> from the same directory.
+ */
+static char const *
+diff_filename(void)
+{
+	char const *filename = GET_PUBLIC(io,filename);
+	char const *cur_dir = GET_STATE(line_despatch,cur_dir);
+	size_t len;
+	if (!cur_dir) {
+		cur_dir = SET_STATE(line_despatch,cur_dir) = fs_real_path(".",NULL);
+		if (!cur_dir) {
+			return filename;
 		}
+	}
+	len = strlen(cur_dir);
+	if (!strncmp(filename,cur_dir,len) && filename[len] == PATH_DELIM) {
+		return filename + len + 1;
+	}
+	return filename;
+}
 
-		follower = leader;
-		concat_risk = !isspace(follower[-1]);
-		for (	;*leader && DELETEABLE(*leader); ++leader) {};
-		concat_risk += (*leader && !isspace(*leader));
-		if (concat_risk == 2) {
-			fputc(' ',GET_PUBLIC(io,output));
+/*! Write the current hunk to output, with the header of the
+ *	diff first if the hunk is the first for the input file.
+ */
+static void
+end_hunk(void)
+{
+	FILE *out = GET_PUBLIC(io,output);
+	text_buf_t *hunk = &SET_STATE(line_despatch,hunk);
+	if (!GET_STATE(line_despatch,diff_header_done)) {
+		char const *filename = diff_filename();
+		fprintf(out,"--- %s\n+++ %s\n",filename,filename);
+		SET_STATE(line_despatch,diff_header_done) = true;
+	}
+	fputs("@@ ",out);
+	put_range('-',GET_STATE(line_despatch,hunk_old_start),
+		GET_STATE(line_despatch,hunk_old_lines));
+	fputc(' ',out);
+	put_range('+',GET_STATE(line_despatch,hunk_new_start),
+		GET_STATE(line_despatch,hunk_new_lines));
+	fputs(" @@\n",out);
+	if (fwrite(hunk->text,1,hunk->len,out) != hunk->len) {
+		bail(GRIPE_CANT_WRITE_FILE,"Write error on output\n");
+	}
+	hunk->len = 0;
+	SET_STATE(line_despatch,in_hunk) = false;
+}
+
+/*! Get the \c n-th latest line of context not in the current hunk,
+ *	counting from 1.
+ */
+static line_ref_t
+context_line(int n)
+{
+	line_ref_t line;
+	int i = GET_STATE(line_despatch,context_next) - n;
+	text_buf_t const *buf;
+	if (i < 0) {
+		i += DIFF_CONTEXT;
+	}
+	buf = &GET_STATE(line_despatch,context)[i];
+	line.text = buf->text;
+	line.len = buf->len;
+	return line;
+}
+
+/*! Diff an unchanged line
+ *
+ *	The line is added to the current hunk if it is within \c DIFF_CONTEXT
+ *	lines of the last change. Otherwise it is kept as possible context for
+ *	the next hunk, and the current hunk is ended once the next change is
+ *	too far away for the hunks to be joined.
+ */
+static void
+diff_unchanged(line_ref_t line)
+{
+	++SET_STATE(line_despatch,old_line_num);
+	++SET_STATE(line_despatch,new_line_num);
+	if (GET_STATE(line_despatch,in_hunk) &&
+		GET_STATE(line_despatch,hunk_trail) < DIFF_CONTEXT) {
+		hunk_line(' ',line);
+		++SET_STATE(line_despatch,hunk_old_lines);
+		++SET_STATE(line_despatch,hunk_new_lines);
+		++SET_STATE(line_despatch,hunk_trail);
+	}
+	else {
+		text_buf_t *buf = &SET_STATE(line_despatch,context)
+			[GET_STATE(line_despatch,context_next)];
+		buf->len = 0;
+		text_buf_append(buf,line.text,line.len);
+		SET_STATE(line_despatch,context_next) =
+			(GET_STATE(line_despatch,context_next) + 1) % DIFF_CONTEXT;
+		if (GET_STATE(line_despatch,context_lines) < DIFF_CONTEXT) {
+			++SET_STATE(line_despatch,context_lines);
+		}
+		if (GET_STATE(line_despatch,in_hunk) &&
+			++SET_STATE(line_despatch,hunk_gap) > DIFF_CONTEXT) {
+			end_hunk();
 		}
-		follower = leader;
 	}
-	if (*follower) {
-		fputc(*follower,GET_PUBLIC(io,output));
+}
+
+/*! Diff a block of changed lines
+ *	\param	old		The input lines replaced
+ *	\param	old_lines	The number of input lines
+ *	\param	new		The output lines replacing them
+ *	\param	new_lines	The number of output lines
+ */
+static void
+diff_changed(	line_ref_t const *old, int old_lines,
+				line_ref_t const *new, int new_lines)
+{
+	int i;
+	int context;
+	if (!GET_STATE(line_despatch,in_hunk)) {
+		context = GET_STATE(line_despatch,context_lines);
+		SET_STATE(line_despatch,in_hunk) = true;
+		SET_STATE(line_despatch,hunk_old_start) =
+			GET_STATE(line_despatch,old_line_num) - context + 1;
+		SET_STATE(line_despatch,hunk_new_start) =
+			GET_STATE(line_despatch,new_line_num) - context + 1;
+		SET_STATE(line_despatch,hunk_old_lines) =
+			SET_STATE(line_despatch,hunk_new_lines) = 0;
+	}
+	else {
+		context = GET_STATE(line_despatch,hunk_gap);
+	}
+	for (i = context; i; --i) {
+		hunk_line(' ',context_line(i));
+	}
+	SET_STATE(line_despatch,hunk_old_lines) += context + old_lines;
+	SET_STATE(line_despatch,hunk_new_lines) += context + new_lines;
+	SET_STATE(line_despatch,context_lines) = 0;
+	SET_STATE(line_despatch,hunk_trail) = 0;
+	SET_STATE(line_despatch,hunk_gap) = 0;
+	for (i = 0; i < old_lines; ++i) {
+		hunk_line('-',old[i]);
 	}
+	for (i = 0; i < new_lines; ++i) {
+		hunk_line('+',new[i]);
+	}
+	SET_STATE(line_despatch,old_line_num) += old_lines;
+	SET_STATE(line_despatch,new_line_num) += new_lines;
+}
+
+/*! Split text into lines
+ *	\param	buf		The text to split
+ *	\param	lines	Receives the address of a heap array of the lines
+ *	\return The number of lines
+ */
+static int
+split_lines(text_buf_t const *buf, line_ref_t **lines)
+{
+	char const *cp = buf->text;
+	char const *end = cp + buf->len;
+	int count = 0;
+	int size = 0;
+	*lines = NULL;
+	while (cp < end) {
+		char const *eol = memchr(cp,'\n',end - cp);
+		char const *next = eol ? eol + 1 : end;
+		if (count == size) {
+			size = size ? size * 2 : 8;
+			*lines = reallocate(*lines,size * sizeof(line_ref_t));
+		}
+		(*lines)[count].text = cp;
+		(*lines)[count].len = next - cp;
+		++count;
+		cp = next;
+	}
+	return count;
+}
+
+/*! Say whether two lines are the same */
+static bool
+same_line(line_ref_t const *l, line_ref_t const *r)
+{
+	return l->len == r->len && !memcmp(l->text,r->text,l->len);
 }
 
-/*! Print an output line that may contain superfluous
- *	parentheses marked for deletion, but no other parts
- *	marked for deletion.
+/*! Diff the input read and output written since the last call.
  *
- *	In this case we have not materially simplified the line and just restore
- *	the parentheses before printing the line.
+ *	Input and output are diffed a line of input at a time: the
+ *	output written since a line was begun replaces that line (which
+ *	may span several physical lines). Physical lines common to the
+ *	beginning or end of both are unchanged.
  */
 static void
-printline_restore_paren(void)
+diff_flush(void)
 {
-	restore_paren();
-	printline_fast();
+	text_buf_t *old_buf = &SET_STATE(line_despatch,diff_old);
+	text_buf_t *new_buf = &SET_STATE(line_despatch,diff_new);
+	if (old_buf->len != new_buf->len ||
+		memcmp(old_buf->text,new_buf->text,old_buf->len)) {
+		line_ref_t *old;
+		line_ref_t *new;
+		int old_lines = split_lines(old_buf,&old);
+		int new_lines = split_lines(new_buf,&new);
+		int head;
+		int tail;
+		for (head = 0; head < old_lines && head < new_lines &&
+				same_line(old + head,new + head); ++head) {
+			diff_unchanged(old[head]);
+		}
+		for (tail = 0; tail < old_lines - head && tail < new_lines - head &&
+			same_line(old + old_lines - tail - 1,new + new_lines - tail - 1);
+				++tail) {}
+		diff_changed(old + head,old_lines - head - tail,
+			new + head,new_lines - head - tail);
+		for (	;tail; --tail) {
+			diff_unchanged(old[old_lines - tail]);
+		}
+		free(old);
+		free(new);
+	}
+	else if (old_buf->len) {
+		/* The commonest case: one unchanged line */
+		line_ref_t *old;
+		int old_lines = split_lines(old_buf,&old);
+		int i;
+		for (i = 0; i < old_lines; ++i) {
+			diff_unchanged(old[i]);
+		}
+		free(old);
+	}
+	old_buf->len = new_buf->len = 0;
+}
+
+
+
+/*! Print an unmodified line to output with no complications
+ */
+static void
+printline_fast(void)
+{
+	put_str(GET_PUBLIC(io,line_start));
+}
+
+/*! Write a span of the line-buffer to output
+ *	\param	start	Offset of the start of the span
+ *	\param	end		Offset just past the end of the span
+ */
+static void
+write_span(size_t start, size_t end)
+{
+	put_text(GET_PUBLIC(io,line_start) + start,end - start);
+}
+
+/*! Print a line to output deleting the chunks in the edit list.
+ *
+ *	Overlapping or adjoining edits are deleted as one chunk. The text
+ *	surviving between chunks is written directly. If deleting a chunk
+ *	would bring together two non-space characters we write a space in
+ *	its place.
+ */
+static void
+printline_cut(void)
+{
+	char const *line = GET_PUBLIC(io,line_start);
+	edit_t const *edits = GET_PUBLIC(line_edit,edits);
+	size_t count = GET_PUBLIC(line_edit,edit_count);
+	size_t done = 0;
+	size_t i = 0;
+	while (i < count) {
+		size_t start = edits[i].start;
+		size_t end = edits[i].end;
+		for (++i; i < count && edits[i].start <= end; ++i) {
+			if (edits[i].end > end) {
+				end = edits[i].end;
+			}
+		}
+		write_span(done,start);
+		done = end;
+		if (start && !isspace((unsigned char)line[start - 1]) &&
+			line[end] && !isspace((unsigned char)line[end])) {
+			put_text(" ",1);
+		}
+	}
+	put_str(line + done);
 }
 
 /*!	Print an output line containing chunks marked for
@@ -120,7 +514,7 @@ printline_restore_paren(void)
  *	We will delete all these chunks only if and only if some of them
  *	represent truth-functional simplifications of the line.
  *  Otherwise the only logical deletions will represent superfluous parentheses.
- *	We will then restore those parentheses before printing the line.
+ *	We will then disregard them and print the line as it stands.
  */
 static void
 printline_slow(void)
@@ -130,7 +524,7 @@ printline_slow(void)
 		printline_cut();
 	}
 	else {
-		printline_restore_paren();
+		printline_fast();
 	}
 }
 
@@ -182,8 +576,9 @@ flushline_live(bool keep, char const *insert_text)
 	if (insert_text) {
 		/* Replacing a contradictory input line with a
 		 * diagnostic comment or #error */
-		fputs(insert_text,GET_PUBLIC(io,output));
+		put_str(insert_text);
 		++SET_PUBLIC(line_despatch,lines_changed);
+		++SET_PUBLIC(line_despatch,lines_inserted);
 		return;
 	}
 	if (keep ^ GET_PUBLIC(args,complement)) {
@@ -193,9 +588,9 @@ flushline_live(bool keep, char const *insert_text)
 		discard_policy_t discard_policy = GET_PUBLIC(args,discard_policy);
 		if (discard_policy == DISCARD_BLANK) {
 			++SET_PUBLIC(line_despatch,lines_changed);
-			putc('\n', GET_PUBLIC(io,output));
+			put_text("\n",1);
 			for (	;extension_lines; --extension_lines) {
-				putc('\n', GET_PUBLIC(io,output));
+				put_text("\n",1);
 			}
 		}
 		else if (discard_policy == DISCARD_DROP) {
@@ -203,7 +598,7 @@ flushline_live(bool keep, char const *insert_text)
 			++SET_PUBLIC(line_despatch,lines_dropped);
 		}
 		else {
-			fputs("//sunifdef < ",GET_PUBLIC(io,output));
+			put_str("//sunifdef < ");
 			++SET_PUBLIC(line_despatch,lines_changed);
 			printline_fast();
 		}
@@ -212,33 +607,6 @@ flushline_live(bool keep, char const *insert_text)
 
 /*@}*/
 
-/*!\ingroup line_despatch_internals_state_utils */
-/*@{*/
-
-/*! The global state of the Line Despatch module */
-STATE_DEF(line_despatch) {
-	/*! The public state of the Line Despatch module */
-	INCLUDE_PUBLIC(line_despatch);
-	/*! Pointer to the function that will be called to flush the
-	 *	the line-buffer to output. Will address flushline_dummy()
-	 *	(a no-op) when the \c --symbols option is specified, and
-	 *	otherwise \c flushline_line().
-	 */
-	void	 (*flushline)(bool,const char *);
-	/*! Count of contiguous lines that are dropped together */
-	size_t drop_run;
-} STATE_T(line_despatch);
-
-/*@}*/
-
-/*!\addtogroup line_despatch_internals_state_utils */
-/*@{*/
-
-IMPLEMENT(line_despatch,STATIC_INITABLE);
-
-USE_STATIC_INITIALISER(line_despatch) = { { 0, 0 }, flushline_live, false };
-/*@}*/
-
 /* API ***************************************************************/
 
 void
@@ -254,10 +622,12 @@ print(void)
 		if (GET_STATE(line_despatch,drop_run)) {
 			int line_num = GET_PUBLIC(io,line_num);
 			size_t extension_lines = GET_PUBLIC(io,extension_lines);
+			char directive[32];
 			if (extension_lines) {
 				--line_num;
 			}
-			printf("#line %d\n",line_num);
+			sprintf(directive,"#line %d\n",line_num);
+			put_str(directive);
 			--SET_PUBLIC(line_despatch,lines_dropped);
 			++SET_PUBLIC(line_despatch,lines_changed);
 		}
@@ -282,4 +652,52 @@ substitute(const char *replacement)
 	GET_STATE(line_despatch,flushline)(false,replacement);
 }
 
+size_t
+drop_run(void)
+{
+	return GET_STATE(line_despatch,drop_run);
+}
+
+void
+set_drop_run(size_t run)
+{
+	SET_STATE(line_despatch,drop_run) = run;
+}
+
+void
+diff_input(char const *text, size_t len)
+{
+	text_buf_append(&SET_STATE(line_despatch,diff_old),text,len);
+}
+
+void
+diff_sync(void)
+{
+	diff_flush();
+}
+
+void
+diff_close(bool error)
+{
+	int i;
+	if (!error) {
+		diff_flush();
+		if (GET_STATE(line_despatch,in_hunk)) {
+			end_hunk();
+		}
+	}
+	SET_STATE(line_despatch,diff_old).len = 0;
+	SET_STATE(line_despatch,diff_new).len = 0;
+	SET_STATE(line_despatch,hunk).len = 0;
+	for (i = 0; i < DIFF_CONTEXT; ++i) {
+		SET_STATE(line_despatch,context)[i].len = 0;
+	}
+	SET_STATE(line_despatch,context_lines) = 0;
+	SET_STATE(line_despatch,context_next) = 0;
+	SET_STATE(line_despatch,old_line_num) = 0;
+	SET_STATE(line_despatch,new_line_num) = 0;
+	SET_STATE(line_despatch,in_hunk) = false;
+	SET_STATE(line_despatch,diff_header_done) = false;
+}
+
 /* EOF */
@@ -45,6 +45,8 @@
  ***************************************************************************/
 
 #include "opts.h"
+#include "bool.h"
+#include <stddef.h>
 
 /*!\ingroup line_despatch_module, line_despatch_interface
  *\file line_despatch.h
@@ -82,6 +84,42 @@ substitute(const char *replacement);
 extern void
 line_despatch_no_op(void);
 
+/*! Get the number of contiguous lines dropped since the last line
+ *	was printed. This is counted only when the \c --line option is
+ *	in force.
+ */
+extern size_t
+drop_run(void);
+
+/*! Set the number of contiguous lines dropped since the last line
+ *	was printed.
+ *	\param	run	The number to set.
+ */
+extern void
+set_drop_run(size_t run);
+
+/*! Record input text read when the \c --diff option is in force
+ *	\param	text	The text read
+ *	\param	len		The length of the text
+ */
+extern void
+diff_input(char const *text, size_t len);
+
+/*! Diff the input read since the last call against the output
+ *	written since the last call, when the \c --diff option is in force.
+ *	This is called when a new line of input is begun.
+ */
+extern void
+diff_sync(void);
+
+/*! Finish the diff of the current input file when the \c --diff option
+ *	is in force, writing any pending hunk to output.
+ *	\param	error	Was processing of the file abandoned on an error? If so
+ *					pending hunks are discarded.
+ */
+extern void
+diff_close(bool error);
+
 /*@}*/
 
 /*!	\ingroup line_despatch_interface_state_utils */
@@ -91,6 +129,7 @@ line_despatch_no_op(void);
 PUBLIC_STATE_DEF(line_despatch) {
 	int lines_dropped;	/*!< Number of input lines dropped */
 	int lines_changed; /*!< Number of input lines changed */
+	int lines_inserted; /*!< Number of diagnostic lines inserted */
 } PUBLIC_STATE_T(line_despatch);
 /*@}*/
 
@@ -35,11 +35,13 @@
  *   DAMAGE.                                                               *
  *                                                                         *
  ***************************************************************************/
+#define MEMORY_TAG	MEMORY_LINES
 #include "line_edit.h"
 #include "io.h"
 #include "report.h"
 #include "line_despatch.h"
 #include "symbol_table.h" 
+#include "stats.h"
 #include <string.h>
  
 /*!\ingroup line_edit_module, line_edit_interface, line_edit_internals
@@ -47,17 +49,78 @@
  * This file implements the Line Edit module
  */
 
+/*!\ingroup line_edit_internals_state_utils */
+/*@{*/
+/*! The global state of the Line Edit module */
+STATE_DEF(line_edit) {
+	/*! The public state of the Line Edit module */
+	INCLUDE_PUBLIC(line_edit);
+	/*! The number of edits for which the edit list has room */
+	size_t edits_size;
+} STATE_T(line_edit);
+/*@}*/
+
+/*!\addtogroup line_edit_internals_state_utils */
+/*@{*/
+IMPLEMENT(line_edit,ZERO_INITABLE);
+/*@}*/
+
+
 /*! \addtogroup line_edit_internals */
 /*@{*/
 
 
-/*!	Macro function that marks a character block as logically deleted in the
- *	course of simplifying a directive, by setting all chars with a deletion
- *	placeholder
- *	\param	start	The start of the text to be deleted.
- *	\param	end		Just past the text to be deleted.
+/*! Add an edit to the edit list, keeping the list in order of offset.
+ *	\param	start	Offset of the text to be deleted.
+ *	\param	end		Offset just past the text to be deleted.
+ *	\param	kind	The kind of deletion.
+ *
+ *	Edits are mostly added in order of offset, so the list is
+ *	searched from the end for the insertion point.
  */
-#define DELETE_CHARS(start,end) memset(start,DELETEABLE_CHR,end - start)
+static void
+add_edit(size_t start, size_t end, edit_kind_t kind)
+{
+	edit_t *edits;
+	size_t i = GET_PUBLIC(line_edit,edit_count);
+	if (i == GET_STATE(line_edit,edits_size)) {
+		SET_STATE(line_edit,edits_size) = i ? i * 2 : 16;
+		SET_PUBLIC(line_edit,edits) =
+			reallocate(GET_PUBLIC(line_edit,edits),
+				GET_STATE(line_edit,edits_size) * sizeof(edit_t));
+	}
+	edits = GET_PUBLIC(line_edit,edits);
+	for (	;i && edits[i - 1].start > start; --i) {
+		edits[i] = edits[i - 1];
+	}
+	edits[i].start = start;
+	edits[i].end = end;
+	edits[i].kind = kind;
+	++SET_PUBLIC(line_edit,edit_count);
+}
+
+/*! Say whether an offset in the line-buffer is logically deleted */
+static bool
+is_edited(size_t off)
+{
+	edit_t const *edits = GET_PUBLIC(line_edit,edits);
+	size_t i = GET_PUBLIC(line_edit,edit_count);
+	for (	;i; --i) {
+		if (edits[i - 1].start <= off && off < edits[i - 1].end) {
+			return true;
+		}
+	}
+	return false;
+}
+
+/*! Get the character at an offset in the line-buffer, or 0 if that
+ *	character is logically deleted.
+ */
+static char
+live_char(size_t off)
+{
+	return is_edited(off) ? '\0' : GET_PUBLIC(io,line_start)[off];
+}
 
 
 /*! Replace text at the end of the line-buffer
@@ -74,10 +137,18 @@
 static void
 tail_edit(char *where, const char *what)
 {
+	size_t off = where - GET_PUBLIC(io,line_start);
 	assert(GET_PUBLIC(io,line_start) <= where &&
 			where < GET_PUBLIC(io,line_end));
 	ensure_buf(strlen(what));
+	where = GET_PUBLIC(io,line_start) + off;
 	strcpy(where,what);
+	/* Edits within the replaced text are moot */
+	while (GET_PUBLIC(line_edit,edit_count) &&
+		GET_PUBLIC(line_edit,edits)[GET_PUBLIC(line_edit,edit_count) - 1].end
+			> off) {
+		--SET_PUBLIC(line_edit,edit_count);
+	}
 }
 
 /*@}*/
@@ -94,35 +165,16 @@ keywordedit(const char *replacement)
 
 
 void
-delete_paren(char *lparen, char *rparen)
+delete_paren(size_t lparen, size_t rparen)
 {
-#if 0
-	if (*lparen == '(' && *rparen == ')' ) {	
-		if ((lparen[-1] == ' ' ||
-			lparen[-1] == '(' ||
-			lparen[1] == ' ' ||
-			lparen[1] == '(' )
-			 &&
-			(rparen[-1] == ' ' ||
-			rparen[-1] == ')' ||
-			rparen[1] == ' ' ||
-			rparen[1] == ')' ||
-			rparen[1] == '\n'))
-			
-		{
-			*lparen = DELETEABLE_LPAREN;
-			*rparen = DELETEABLE_RPAREN;
-			SET_PUBLIC(line_edit,simplification_state) |= BRACKETS_PRUNED;
-		}
-	}
-#endif
-	if (*lparen == '(' && *rparen == ')' ) {
-		if ((!symchar(lparen[-1]) || !symchar(lparen[1]))
+	if (live_char(lparen) == '(' && live_char(rparen) == ')' ) {
+		if ((!symchar(live_char(lparen - 1)) || !symchar(live_char(lparen + 1)))
 			 &&
-			(!symchar(rparen[-1]) || !symchar(rparen[1])))
+			(!symchar(live_char(rparen - 1)) || !symchar(live_char(rparen + 1))))
 		{
-			*lparen = DELETEABLE_LPAREN;
-			*rparen = DELETEABLE_RPAREN;
+			add_edit(lparen,lparen + 1,EDIT_PAREN);
+			add_edit(rparen,rparen + 1,EDIT_PAREN);
+			STATS_COUNT(STATS_PAREN_EDITS);
 			SET_PUBLIC(line_edit,simplification_state) |= BRACKETS_PRUNED;
 		}
 	}
@@ -130,41 +182,23 @@ delete_paren(char *lparen, char *rparen)
 }
 
 void
-restore_paren(void)
-{
-	char *buf = GET_PUBLIC(io,line_start);	
-	for (	;*buf; ++buf) {
-		if (*buf == DELETEABLE_LPAREN) {
-			*buf = '(';
-		}
-		else if (*buf == DELETEABLE_RPAREN) {
-			*buf = ')';
-		}
-	};
-}
-
-void
-cut_text(char *start, char *end)
+cut_text(size_t start, size_t end)
 {
 	 /* Set up for printing a line with deleted chunks */
 	SET_PUBLIC(line_edit,simplification_state) |= OPS_CUT;
-	DELETE_CHARS(start,end);
 	/* Never delete the terminal newline in directive */
-	if (!*end) {
-		end[-1] = '\n';
+	if (!GET_PUBLIC(io,line_start)[end]) {
+		--end;
 	}
+	add_edit(start,end,EDIT_CUT);
+	STATS_COUNT(STATS_CUT_EDITS);
 }
 
-/*!\ingroup line_edit_internals_state_utils */
-/*@{*/
-/*! The Line Edit module has no private state */ 
-NO_PRIVATE_STATE(line_edit);
-/*@}*/
-
-/*!\addtogroup line_edit_internals_state_utils */
-/*@{*/
-IMPLEMENT(line_edit,ZERO_INITABLE);
-/*@}*/
-
+void
+clear_edits(void)
+{
+	SET_PUBLIC(line_edit,simplification_state) = UNSIMPLIFIED;
+	SET_PUBLIC(line_edit,edit_count) = 0;
+}
 
 /* EOF */
@@ -49,25 +49,18 @@
 /*!	\addtogroup line_edit_interface */
 /*@{*/
 
-/*! This character is provisionally inserted in the line
-	buffer to mark it for eventual deletion
-*/
-#define DELETEABLE_CHR  ((char)001)	
-/*! This character is provisionally inserted in the line
-	buffer in place of a '(' that will eventually be
-	deleted if the line is significantly simplified.
-*/
-#define DELETEABLE_LPAREN ((char)002)
-/*! This character is provisionally inserted in the line
-	buffer in place of a ')' that will eventually be
-	deleted if the line is significantly simplified.
-*/
-#define DELETEABLE_RPAREN ((char)003)
-/*! Macro function to decide if a character in the line-buffer is deleteable
- *	\param ch	The character to test.
- *	\return		Non-zero if the character may be deleted.
- */ 
-#define DELETEABLE(ch) ((ch) < 4)
+/*! Enumeration of the kinds of logical deletion from a directive */
+typedef enum {
+	EDIT_CUT,	/*!< Text deleted through truth-functional simplification */
+	EDIT_PAREN	/*!< A superfluous parenthesis */
+} edit_kind_t;
+
+/*! Structure representing a logical deletion from the line-buffer */
+typedef struct edit {
+	size_t start;	/*!< Offset in the line-buffer of the deleted text */
+	size_t end;		/*!< Offset just past the deleted text */
+	edit_kind_t kind;	/*!< The kind of deletion */
+} edit_t;
 
 /*! Enumeration of the possible simplification states of an
  *	<tt>#i</tt>-directive in the line-buffer 
@@ -92,57 +85,47 @@ keywordedit(const char *replacement);
 
 /*! Logically delete a pair of redundant parentheses from a 
  *	<tt>#</tt>-directive in the line-buffer.
- *	\param	lparen	Pointer to the '('
- *	\param	rparen	Poiunter to the ')'
+ *	\param	lparen	Offset in the line-buffer of the '('
+ *	\param	rparen	Offset in the line-buffer of the ')'
  *
- *	Logical deletion is done by inserting \c DELETEABLE_LPAREN
- *	in the line-buffer in place of the '(' and \c DELETEABLE_RPAREN
- *	in place of the ')'.
+ *	Logical deletion is done by adding an \c EDIT_PAREN edit for each
+ *	parenthesis to the edit list.
  *
  *	If evaluation of the directive results in material simplification
  * (i.e. results in deletions other	than deletions of redundant parentheses),
  *	then the logically	deleted parentheses will be physically deleted when
- *	evaluation is complete.
+ *	the line is output.
  *
  *	If evaluation of the directive results in no materal simplification
- *	then the logically deleted parentheses will finally be restored
- *	by restore_paren();
+ *	then the edit list is disregarded and the parentheses are output.
  *
  *	The function updates the module state with \c BRACKETS_PRUNED
  */
 void
-delete_paren(char *lparen, char *rparen);  
-
-/*! Restore logically deleted parentheses to the <tt>#</tt>-directive in the
- *	line buffer	when we cannot materially simplify it. 
- *
- *	This is done on the principle that if we cannot materially simplify
- *	the directive then wev will leave it alone.
- *
- *	The function does not bother to retract \c BRACKETS_PRUNED from the module
- *	state, because this is superflous whenever the the function is called. 
- */
-void
-restore_paren(void);
+delete_paren(size_t lparen, size_t rparen);  
 
 /*!	Logically delete part of a <tt>#</tt>-directive in the line buffer.
- *	\param	start	The start of the text to delete
- *	\param	end		The address just past the text to delete.
+ *	\param	start	Offset in the line-buffer of the text to delete
+ *	\param	end		Offset just past the text to delete.
  *
- *	The logical deletion is done by filling the line-buffer from \c start
- *	to \c end with \c DELETEABLE_CHR. Logical deletion is efficient because
- *	it avoids shuffling down terminal segments of the buffer in the course
- *	of evaluation, when the effect of such editing may be obliterated by
- *	subsequent deletions. Physical deletion is performed only once at the
- *	end of evaluation, by removing all logically deleted portions of the
- *	line-buffer.
+ *	The logical deletion is done by adding an \c EDIT_CUT edit to the edit
+ *	list. The line-buffer itself is not touched: when the line is output
+ *	only the text between the edits is written. Deletion is thus done
+ *	once at the end of evaluation, when the effect of any edit may have
+ *	been obliterated by subsequent deletions.
  *
  *	The function is only called to delete a truth-functionally redundant
  *	operator and one of its operands, so it updates the module state with
  *	\c OPS_CUT
  */
 void
-cut_text(char *start, char *end);
+cut_text(size_t start, size_t end);
+
+/*! Discard all logical deletions and mark the current line unsimplified.
+ *	Called before a new line is evaluated.
+ */
+void
+clear_edits(void);
 
 /*@}*/
 
@@ -154,6 +137,11 @@ PUBLIC_STATE_DEF(line_edit) {
 	char*	keyword; /*!< Pointer to keyword of the current directive */
 	int simplification_state;
 		/*!< The simplification state of the current directive */
+	edit_t *edits;
+		/*!< The logical deletions from the current directive, in
+			order of offset */
+	size_t edit_count;
+		/*!< The number of logical deletions in \c edits */
 } PUBLIC_STATE_T(line_edit);
 /*@}*/
 
@@ -49,6 +49,16 @@
 #include "platform.h"
 #include "exception.h"
 #include "dataset.h"
+#include "lex_map.h"
+#include "checkpoint.h"
+#include "manifest.h"
+#include "cache.h"
+#include "daemon.h"
+#include "process.h"
+#include "watch.h"
+#include "stats.h"
+#include "timeline.h"
+#include "profile.h"
 
 /*! \ingroup main_module
  * \file main.c
@@ -72,25 +82,15 @@ main(int argc, char *argv[])
 	atexit(exit_diagnostics);
 	parse_executable(argv);
 	parse_args(argc,argv);
+	if (GET_PUBLIC(args,daemon_socket) != NULL) {
+		daemon_serve();
+	}
 	finish_args();
 	process();
 	give_up_confused(); /* bug */
 	return 0;
 }
 
-static void
-line_debug(int line)
-{
-	if (line < 0) {
-		/* Call with negative value to write line numbers */
-		printf("%d\n",GET_PUBLIC(io,line_num));
-	}
-	else if (line > 0 && line == GET_PUBLIC(io,line_num)) {
-		/* Call with positive line number and put breakpoint here ... */
-		fputs("Here",stderr);	
-	}
-}
-
 /*! Initialise all module states */
 static void
 ready(void)
@@ -106,69 +106,78 @@ ready(void)
 	INITIALISE(symbol_table);
 	INITIALISE(line_despatch);
 	INITIALISE(categorical);
+	INITIALISE(lex_map);
+	INITIALISE(checkpoint);
+	INITIALISE(manifest);
+	INITIALISE(cache);
+	INITIALISE(daemon);
+	INITIALISE(watch);
+	INITIALISE(stats);
+	INITIALISE(timeline);
+	INITIALISE(profile);
+	INITIALISE(exception);
+}
+
+/*! Say whether a directory in the input file tree merely
+	contains one other directory, and so need not be reported on
+	entry or exit. A directory whose file tree is not known is
+	reported.
+*/
+static bool
+merely_parent(file_tree_h file_tree)
+{
+	file_tree_count_t count;
+	if (!file_tree) {
+		return false;
+	}
+	file_tree_count(file_tree,FT_COUNT_CHILDREN | FT_COUNT_ALL,&count);
+	return count.dirs == 1 && count.files == 0;
 }
 
 /*! The \c file_tree_callback_t that is
-	iterated over the input file tree.
+	iterated over the input dataset.
 */
 static void
 node_proc(	file_tree_h file_tree,
 			char const *name,
 			file_tree_traverse_state_t context)
 {
-	static int error;
 	switch(context) {
 	case FT_AT_FILE:
-		processing_file(name);
-		open_io(name);
-		if_control_toplevel();
-		chew_toplevel();
-		exceptions_enabled = GET_PUBLIC(args,keepgoing);
-		error = catch();
-		for (;!error && !input_eof();) {
-			line_type_t lineval;
-			line_debug(0);
-			lineval = eval_line();
-			if (!weed_categorical_directive(lineval)) {
-				transition(lineval);
-			}
-			debug(DBG_19,lineval);
-		}
-		if (if_depth() && !error && input_eof()) {
-			early_eof();
+		if (manifest_unchanged(name)) {
+			++SET_PUBLIC(dataset,donefiles);
+			break;
 		}
-		exceptions_enabled = false;
-		close_io(false);
+		timeline_begin_file(name);
+		process_file(name);
+		timeline_end_file();
 		break;
 	case FT_ENTERING_DIR:
-		{
-			file_tree_count_t count;
-			file_tree_count(file_tree,FT_COUNT_CHILDREN | FT_COUNT_ALL,&count);
-			/* Don't report entry to a directory if it is merely
-				the parent of another */
-			if (count.dirs != 1 || count.files != 0) {
-				entering_dir(name);
-			}
+		/* Don't report entry to a directory if it is merely
+			the parent of another */
+		if (!merely_parent(file_tree)) {
+			entering_dir(name);
+			timeline_enter_dir(name);
 		}
 		break;
 	case FT_LEAVING_DIR:
-		{
-			file_tree_count_t count;
-			file_tree_count(file_tree,FT_COUNT_CHILDREN | FT_COUNT_ALL,&count);
-			/* Don't report leaving a directory if it is merely
-				the parent of another */
-			if (count.dirs != 1 || count.files != 0) {
-				leaving_dir(name);
-			}
+		/* Don't report leaving a directory if it is merely
+			the parent of another */
+		if (!merely_parent(file_tree)) {
+			timeline_leave_dir();
+			leaving_dir(name);
 		}
 		break;
 	case FT_ENTERING_TREE:
-		if (file_tree_is_empty(file_tree)) {
+		if (dataset_is_empty()) {
 			node_proc(file_tree,STDIN_NAME,FT_AT_FILE);
 		}
 		break;
 	case FT_LEAVING_TREE:
 		io_toplevel();
+		manifest_save();
+		cache_finish();
+		daemon_disconnect();
 		break;
 	default:
 		assert(false);
@@ -178,8 +187,10 @@ node_proc(	file_tree_h file_tree,
 static void
 process(void)
 {
-	file_tree_h tree = GET_PUBLIC(dataset,file_tree);
-	file_tree_traverse(tree,node_proc);
+	dataset_traverse(node_proc);
+	if (GET_PUBLIC(args,watch)) {
+		watch_run(node_proc);
+	}
 	exit(exitcode());
 }
 
@@ -0,0 +1,379 @@
+/***************************************************************************
+ *   Copyright (C) 2004, 2006 Symbian Software Ltd.                        *
+ *   All rights reserved.                                                  *
+ *   Copyright (C) 2007, 2008 Mike Kinghan, imk@strudl.org                 *
+ *   All rights reserved.                                                  *
+ *                                                                         *
+ *   Contributed originally by Mike Kinghan, imk@strudl.org                *
+ *                                                                         *
+ *   Redistribution and use in source and binary forms, with or without    *
+ *   modification, are permitted provided that the following conditions    *
+ *   are met:                                                              *
+ *                                                                         *
+ *   Redistributions of source code must retain the above copyright        *
+ *   notice, this list of conditions and the following disclaimer.         *
+ *                                                                         *
+ *   Redistributions in binary form must reproduce the above copyright     *
+ *   notice, this list of conditions and the following disclaimer in the   *
+ *   documentation and/or other materials provided with the distribution.  *
+ *                                                                         *
+ *   Neither the name of Symbian Software Ltd. nor the names of its        *
+ *   contributors may be used to endorse or promote products derived from  *
+ *   this software without specific prior written permission.              *
+ *                                                                         *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS   *
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT     *
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS    *
+ *   FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE        *
+ *   COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,   *
+ *   INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,  *
+ *   BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS *
+ *   OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED    *
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,*
+ *   OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF *
+ *   THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH  *
+ *   DAMAGE.                                                               *
+ *                                                                         *
+ ***************************************************************************/
+#include "manifest.h"
+#include "args.h"
+#include "filesys.h"
+#include "memory.h"
+#include "report.h"
+#include "hash.h"
+#include "io.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+/*!\ingroup manifest_module, manifest_interface, manifest_internals
+ *\file manifest.c
+ * This file implements the Manifest module.
+ *
+ *	The entry of a file records the state in which the run left it, i.e.
+ *	after it was replaced by its output. Processing that output again with
+ *	the same options would change nothing, so a file that still matches
+ *	its entry can be skipped. Only files processed without warnings or
+ *	errors are entered, so that skipping a file never hides a diagnostic.
+ */
+
+/*! \addtogroup manifest_internals */
+/*@{*/
+
+/*! The first line of a manifest file */
+#define MANIFEST_MAGIC	"sunifdef-manifest 1"
+
+/*! The longest filename accepted from a manifest file */
+#define MANIFEST_MAX_NAME	65536
+
+/*! Mask of all exit flags */
+#define ALL_EXIT_FLAGS		(~0)
+
+/*! Mask of the exit flags that prevent a file being entered */
+#define DIAGNOSED_FLAGS	(MSGCLASS_WARNING | MSGCLASS_ERROR | MSGCLASS_ABEND)
+
+/*! Structure of the entry of a file in the manifest */
+typedef struct manifest_entry {
+	/*! The name of the file */
+	heap_str	name;
+	/*! The stamp of the file as it was left */
+	fs_stamp_t	stamp;
+	/*! The time at which the entry was made */
+	long		recorded;
+	/*! Hash of the contents of the file */
+	hash_t		hash;
+	/*! Fingerprint of the options with which it was processed */
+	hash_t		fingerprint;
+} manifest_entry_t;
+
+/*@}*/
+
+/*! \addtogroup manifest_internals_state_utils */
+/*@{*/
+
+/*! The state of the Manifest module */
+STATE_DEF(manifest) {
+	manifest_entry_t **slots;	/*!< Hash table, with open addressing, of
+									the entries by filename. NULL marks an
+									empty slot */
+	size_t	size;		/*!< The number of slots, a power of 2 */
+	size_t	count;		/*!< The number of entries */
+	bool	loaded;		/*!< Has the manifest file been read? */
+	int		flags;		/*!< Exit flags raised before the current file */
+} STATE_T(manifest);
+
+NO_PUBLIC_STATE(manifest);
+
+IMPLEMENT(manifest,USER_INITABLE);
+
+DEFINE_USER_INIT(manifest)(STATE_T(manifest) * manifest_st)
+{
+	(void)manifest_st;
+}
+
+DEFINE_USER_FINIS(manifest)(STATE_T(manifest) * manifest_st)
+{
+	size_t i;
+	for (i = 0; i < manifest_st->size; ++i) {
+		if (manifest_st->slots[i]) {
+			free(manifest_st->slots[i]->name);
+			free(manifest_st->slots[i]);
+		}
+	}
+	free(manifest_st->slots);
+}
+/*@}*/
+
+/*! \addtogroup manifest_internals */
+/*@{*/
+
+/*! Get the slot of a file in the manifest.
+	\return	The slot that holds the entry of \c filename, or the empty
+			slot at which it would be inserted.
+ */
+static manifest_entry_t **
+find_slot(char const *filename)
+{
+	size_t mask = GET_STATE(manifest,size) - 1;
+	size_t slot = (size_t)hash_str(HASH_INIT,filename) & mask;
+	manifest_entry_t **slots = GET_STATE(manifest,slots);
+	for (	;slots[slot]; slot = (slot + 1) & mask) {
+		if (!strcmp(slots[slot]->name,filename)) {
+			break;
+		}
+	}
+	return slots + slot;
+}
+
+/*! Get the entry of a file in the manifest, making a new entry if there
+	is none. The table is kept at most half full.
+ */
+static manifest_entry_t *
+get_entry(char const *filename)
+{
+	manifest_entry_t **slot;
+	if ((GET_STATE(manifest,count) + 1) * 2 > GET_STATE(manifest,size)) {
+		manifest_entry_t **old = GET_STATE(manifest,slots);
+		size_t old_size = GET_STATE(manifest,size);
+		size_t i;
+		SET_STATE(manifest,size) = old_size ? old_size * 2 : 256;
+		SET_STATE(manifest,slots) =
+			callocate(GET_STATE(manifest,size),sizeof(manifest_entry_t *));
+		for (i = 0; i < old_size; ++i) {
+			if (old[i]) {
+				*find_slot(old[i]->name) = old[i];
+			}
+		}
+		free(old);
+	}
+	slot = find_slot(filename);
+	if (!*slot) {
+		size_t len = strlen(filename);
+		*slot = callocate(1,sizeof(manifest_entry_t));
+		(*slot)->name = allocate(len + 1);
+		memcpy((*slot)->name,filename,len + 1);
+		++SET_STATE(manifest,count);
+	}
+	return *slot;
+}
+
+/*! Find the entry of a file in the manifest, or NULL if there is none */
+static manifest_entry_t *
+find_entry(char const *filename)
+{
+	if (!GET_STATE(manifest,count)) {
+		return NULL;
+	}
+	return *find_slot(filename);
+}
+
+/*! Say whether two file stamps are the same */
+static bool
+same_stamp(fs_stamp_t const *lhs, fs_stamp_t const *rhs)
+{
+	return lhs->size == rhs->size && lhs->mtime == rhs->mtime &&
+		lhs->mtime_ns == rhs->mtime_ns && lhs->inode == rhs->inode &&
+		lhs->device == rhs->device;
+}
+
+/*! Hash the contents of a file.
+	\return	True iff the file was read.
+ */
+static bool
+hash_file(char const *filename, hash_t *hash)
+{
+	char buf[BUFSIZ];
+	size_t got;
+	FILE *in = fopen(filename,"rb");
+	if (in == NULL) {
+		return false;
+	}
+	*hash = HASH_INIT;
+	while ((got = fread(buf,1,sizeof(buf),in)) != 0) {
+		*hash = hash_bytes(*hash,buf,got);
+	}
+	got = ferror(in);
+	fclose(in);
+	return !got;
+}
+
+/*! Read the manifest file, if it exists. If it is not well formed,
+	the entries read so far are kept; the rest are lost.
+ */
+static void
+load(void)
+{
+	char magic[sizeof(MANIFEST_MAGIC)];
+	char const *manifest_file = GET_PUBLIC(args,manifest_file);
+	unsigned long count, i;
+	heap_str name = NULL;
+	FILE *in;
+	SET_STATE(manifest,loaded) = true;
+	in = fopen(manifest_file,"rb");
+	if (in == NULL) {
+		return;
+	}
+	if (!fgets(magic,sizeof(magic),in) || strcmp(magic,MANIFEST_MAGIC) ||
+		fscanf(in," files %lu",&count) != 1) {
+		fclose(in);
+		return;
+	}
+	name = allocate(MANIFEST_MAX_NAME + 1);
+	for (i = 0; i < count; ++i) {
+		manifest_entry_t entry;
+		manifest_entry_t *slot;
+		unsigned long len;
+		if (fscanf(in," %lx %lx %lu %lu %ld %ld %ld %ld %lu",
+				&entry.fingerprint,&entry.hash,&entry.stamp.device,
+				&entry.stamp.inode,&entry.stamp.size,&entry.stamp.mtime,
+				&entry.stamp.mtime_ns,&entry.recorded,&len) != 9 ||
+			len == 0 || len > MANIFEST_MAX_NAME || fgetc(in) != ' ' ||
+			fread(name,1,len,in) != len || memchr(name,'\0',len)) {
+			break;
+		}
+		name[len] = '\0';
+		slot = get_entry(name);
+		entry.name = slot->name;
+		*slot = entry;
+	}
+	free(name);
+	fclose(in);
+}
+
+/*@}*/
+
+/* API ***************************************************************/
+
+bool
+manifest_unchanged(char const *filename)
+{
+	manifest_entry_t *entry;
+	fs_stamp_t stamp;
+	if (GET_PUBLIC(args,manifest_file) == NULL) {
+		return false;
+	}
+	if (!GET_STATE(manifest,loaded)) {
+		load();
+	}
+	entry = find_entry(filename);
+	if (entry == NULL || entry->fingerprint != GET_PUBLIC(args,fingerprint) ||
+		!fs_stamp(filename,&stamp) || stamp.size != entry->stamp.size) {
+		return false;
+	}
+	/* A file modified in the second in which it was entered may have
+		been modified after it was entered */
+	if (!same_stamp(&stamp,&entry->stamp) ||
+		entry->stamp.mtime >= entry->recorded) {
+		hash_t hash;
+		if (!hash_file(filename,&hash) || hash != entry->hash) {
+			return false;
+		}
+		entry->stamp = stamp;
+		entry->recorded = (long)time(NULL);
+	}
+	report(PROGRESS_UNCHANGED,NULL,
+		"File \"%s\" is unchanged since it was processed",filename);
+	return true;
+}
+
+void
+manifest_open(void)
+{
+	if (GET_PUBLIC(args,manifest_file) != NULL) {
+		SET_STATE(manifest,flags) = get_exit_flags(ALL_EXIT_FLAGS);
+		set_exit_flags(ALL_EXIT_FLAGS,false);
+	}
+}
+
+void
+manifest_close(char const *filename, bool error)
+{
+	manifest_entry_t *entry;
+	fs_stamp_t stamp;
+	hash_t hash;
+	int raised;
+	if (GET_PUBLIC(args,manifest_file) == NULL) {
+		return;
+	}
+	raised = get_exit_flags(ALL_EXIT_FLAGS);
+	set_exit_flags(GET_STATE(manifest,flags),true);
+	if (!error && !(raised & DIAGNOSED_FLAGS) &&
+		fs_stamp(filename,&stamp) && hash_file(filename,&hash)) {
+		entry = get_entry(filename);
+		entry->stamp = stamp;
+		entry->recorded = (long)time(NULL);
+		entry->hash = hash;
+		entry->fingerprint = GET_PUBLIC(args,fingerprint);
+	}
+	else if ((entry = find_entry(filename)) != NULL) {
+		/* Don't match it again */
+		entry->fingerprint = ~GET_PUBLIC(args,fingerprint);
+	}
+}
+
+void
+manifest_save(void)
+{
+	char const *manifest_file = GET_PUBLIC(args,manifest_file);
+	size_t namelen;
+	heap_str tempname;
+	FILE *out;
+	size_t i;
+	if (manifest_file == NULL || !GET_STATE(manifest,loaded)) {
+		return;
+	}
+	namelen = strlen(manifest_file);
+	tempname = allocate(namelen + sizeof("_XXXXXX"));
+	strcpy(tempname,manifest_file);
+	strcpy(tempname + namelen,"_XXXXXX");
+	if (!fs_tempname(tempname)) {
+		bail(GRIPE_NO_TEMPFILE,"Cannot create temporary file");
+	}
+	out = open_file(tempname,"wb");
+	fprintf(out,"%s\nfiles %lu\n",MANIFEST_MAGIC,
+		(unsigned long)GET_STATE(manifest,count));
+	for (i = 0; i < GET_STATE(manifest,size); ++i) {
+		manifest_entry_t const *entry = GET_STATE(manifest,slots)[i];
+		if (entry) {
+			size_t len = strlen(entry->name);
+			fprintf(out,"%lx %lx %lu %lu %ld %ld %ld %ld %lu ",
+				entry->fingerprint,entry->hash,entry->stamp.device,
+				entry->stamp.inode,entry->stamp.size,entry->stamp.mtime,
+				entry->stamp.mtime_ns,entry->recorded,(unsigned long)len);
+			fwrite(entry->name,1,len,out);
+			fputc('\n',out);
+		}
+	}
+	if (fclose(out)) {
+		remove(tempname);
+		bail(GRIPE_CANT_WRITE_FILE,"Write error on file %s",tempname);
+	}
+	if (rename(tempname,manifest_file)) {
+		remove(tempname);
+		bail(GRIPE_CANT_RENAME_FILE,
+			"Cannot rename file \"%s\" as \"%s\"",tempname,manifest_file);
+	}
+	free(tempname);
+}
+
+/* EOF */
@@ -0,0 +1,107 @@
+#ifndef MANIFEST_H
+#define MANIFEST_H
+/***************************************************************************
+ *   Copyright (C) 2004, 2006 Symbian Software Ltd.                        *
+ *   All rights reserved.                                                  *
+ *   Copyright (C) 2007, 2008 Mike Kinghan, imk@strudl.org                 *
+ *   All rights reserved.                                                  *
+ *                                                                         *
+ *   Contributed originally by Mike Kinghan, imk@strudl.org                *
+ *                                                                         *
+ *   Redistribution and use in source and binary forms, with or without    *
+ *   modification, are permitted provided that the following conditions    *
+ *   are met:                                                              *
+ *                                                                         *
+ *   Redistributions of source code must retain the above copyright        *
+ *   notice, this list of conditions and the following disclaimer.         *
+ *                                                                         *
+ *   Redistributions in binary form must reproduce the above copyright     *
+ *   notice, this list of conditions and the following disclaimer in the   *
+ *   documentation and/or other materials provided with the distribution.  *
+ *                                                                         *
+ *   Neither the name of Symbian Software Ltd. nor the names of its        *
+ *   contributors may be used to endorse or promote products derived from  *
+ *   this software without specific prior written permission.              *
+ *                                                                         *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS   *
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT     *
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS    *
+ *   FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE        *
+ *   COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,   *
+ *   INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,  *
+ *   BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS *
+ *   OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED    *
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,*
+ *   OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF *
+ *   THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH  *
+ *   DAMAGE.                                                               *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "opts.h"
+#include "bool.h"
+
+/*!\ingroup manifest_module, manifest_interface
+ *\file manifest.h
+ * This file provides the Manifest module interface.
+ *
+ *	When the \c --manifest option is in force the Manifest module
+ *	records, for each input file that is processed without warnings or
+ *	errors, the size, modification time and content hash of the file as
+ *	it is left by the run, together with the fingerprint of the options.
+ *	The manifest is saved in the file named by the option.
+ *
+ *	On a later run an input file that still matches its entry under the
+ *	same options is the output of an earlier run with those options and
+ *	is skipped: it is not opened, parsed or replaced.
+ */
+
+/*! \addtogroup manifest_interface */
+/*@{*/
+
+/*! Say whether an input file is unchanged since it was last processed
+	with the same options, when the \c --manifest option is in force.
+
+	\param	filename	The name of the input file.
+	\return	True iff the file is to be skipped.
+
+	A file whose size, identity and modification time match its entry is
+	unchanged without being read, unless it was modified in the second in
+	which the entry was made. A file of the same size but a different
+	modification time is unchanged if its content hash matches.
+*/
+extern bool
+manifest_unchanged(char const *filename);
+
+/*! Begin processing the current input file, if the \c --manifest option
+	is in force. Called after \c manifest_unchanged() has returned false.
+*/
+extern void
+manifest_open(void);
+
+/*! Finish processing an input file, if the \c --manifest option is in
+	force, and record it in the manifest unless it was abandoned or
+	raised warnings or errors.
+
+	\param	filename	The name of the input file.
+	\param	error		Was processing abandoned?
+*/
+extern void
+manifest_close(char const *filename, bool error);
+
+/*! Save the manifest atomically in the file named by the
+	\c --manifest option, if it is in force and any input file has
+	been met.
+*/
+extern void
+manifest_save(void);
+
+/*@}*/
+
+/*! \addtogroup manifest_interface_state_utils */
+/*@{*/
+IMPORT_INITOR(manifest);
+IMPORT_FINITOR(manifest);
+/*@}*/
+
+#endif /* EOF */
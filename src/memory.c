@@ -38,10 +38,28 @@
 #include "report.h"
 #include "memory.h"
 #include "ptr_vector.h"
+#include "thread.h"
+#include "platform.h"
+#include <string.h>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+#ifdef UNIX
+#include <sys/resource.h>
+#else
+#include <windows.h>
+#include <psapi.h>
+#endif
 
 /*!	\ingroup memory_interface, memory_internals
  *	\file memory.c
  *	This file implements the Memory module.
+ *
+ *	The account of allocations is kept in static storage rather than a
+ *	module state, since module states are themselves allocated. It is
+ *	guarded by a lock, as allocations are made on several threads. Only
+ *	allocations are accounted: \c free() is called directly throughout,
+ *	so the bytes in use are taken from the C library instead.
  */
 
 /* Helpers ***********************************************************/
@@ -49,6 +67,30 @@
 /*! \addtogroup memory_internals */
 /*@{*/
 
+/*! The state of accounting */
+static struct {
+	bool	on;		/*!< Are allocations being accounted? */
+	bool	in_lines;	/*!< Are input lines being processed? */
+	thread_lock_t lock;	/*!< Lock guarding \c account */
+	memory_account_t account;	/*!< The account of allocations */
+} accounting;
+
+/*! Account an allocation or reallocation.
+	\param	tag		The tag of the allocation.
+	\param	bytes	The bytes allocated.
+*/
+static void
+account(memory_tag_t tag, size_t bytes)
+{
+	thread_lock(accounting.lock);
+	++accounting.account.allocations[tag];
+	accounting.account.bytes[tag] += bytes;
+	if (accounting.in_lines) {
+		++accounting.account.line_allocations;
+	}
+	thread_unlock(accounting.lock);
+}
+
 /*! Terminate the program with an out of memory diagnositic
  *	if a putative heap pointer is null.
  *
@@ -68,20 +110,29 @@ no_alloc_fail(void *ptr)
 /* API ***************************************************************/
 
 void *
-allocate(size_t bytes)
+allocate_tagged(size_t bytes, memory_tag_t tag)
 {
+	if (accounting.on) {
+		account(tag,bytes);
+	}
 	return no_alloc_fail(calloc(bytes,1));
 }
 
 void *
-reallocate(void *ptr, size_t bytes)
+reallocate_tagged(void *ptr, size_t bytes, memory_tag_t tag)
 {
+	if (accounting.on) {
+		account(tag,bytes);
+	}
 	return no_alloc_fail(realloc(ptr,bytes));
 }
 	
 void *
-callocate(size_t items, size_t size)
+callocate_tagged(size_t items, size_t size, memory_tag_t tag)
 {
+	if (accounting.on) {
+		account(tag,items * size);
+	}
 	return no_alloc_fail(calloc(items,size));
 }
 
@@ -93,4 +144,64 @@ void release(void **pp)
 	}
 }
 
+void
+memory_account_start(void)
+{
+	accounting.lock = thread_lock_new();
+	accounting.on = true;
+}
+
+void
+memory_in_lines(bool in_lines)
+{
+	accounting.in_lines = in_lines;
+}
+
+void
+memory_get_account(memory_account_t *account)
+{
+	if (!accounting.on) {
+		memset(account,0,sizeof(memory_account_t));
+		return;
+	}
+	thread_lock(accounting.lock);
+	memcpy(account,&accounting.account,sizeof(memory_account_t));
+	thread_unlock(accounting.lock);
+}
+
+size_t
+memory_live(void)
+{
+#if defined(__GLIBC__) && \
+	(__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+	struct mallinfo2 info = mallinfo2();
+	return info.uordblks + info.hblkhd;
+#else
+	return 0;
+#endif
+}
+
+size_t
+memory_peak_rss(void)
+{
+#ifdef UNIX
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF,&usage)) {
+		return 0;
+	}
+#ifdef __APPLE__
+	return (size_t)usage.ru_maxrss;
+#else
+	return (size_t)usage.ru_maxrss * 1024;
+#endif
+#else
+	PROCESS_MEMORY_COUNTERS counters;
+	if (!GetProcessMemoryInfo(GetCurrentProcess(),&counters,
+		sizeof(counters))) {
+		return 0;
+	}
+	return counters.PeakWorkingSetSize;
+#endif
+}
+
 /* EOF */
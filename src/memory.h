@@ -39,12 +39,17 @@
  ***************************************************************************/
 
 #include "opts.h"
+#include "bool.h"
 #include <stddef.h>
 #include <stdlib.h>
 
 /*!\ingroup memory_module, memory_interface
  *\file memory.h
  * This file provides the Memory module interface
+ *
+ *	With the \c --stats option the allocations are accounted by tag.
+ *	The tag of an allocation is the \c MEMORY_TAG of the source file
+ *	that makes it.
  */
 
 /*!	\addtogroup memory_interface */
@@ -53,17 +58,75 @@
 /*! Type to represent strings allocated on the heap */
 typedef char * heap_str;
 
+/*! Enumeration of the tags by which allocations are accounted */
+typedef enum {
+	MEMORY_OTHER,		/*!< Anything not tagged otherwise */
+	MEMORY_LINES,		/*!< Line buffers and the lexing of input */
+	MEMORY_SYMBOLS,		/*!< The symbol table */
+	MEMORY_FILE_TREE,	/*!< The input file tree and file names */
+	MEMORY_DIAGNOSTICS,	/*!< Diagnostics */
+	MEMORY_EVALUATOR,	/*!< The evaluator */
+	MEMORY_TAGS			/*!< The number of tags */
+} memory_tag_t;
+
+#ifndef MEMORY_TAG
+/*! The tag of the allocations made in a source file. A source file
+	that tags its allocations otherwise defines \c MEMORY_TAG before it
+	includes any header.
+*/
+#define MEMORY_TAG	MEMORY_OTHER
+#endif
+
+/*! Structure of the account of allocations */
+typedef struct {
+	unsigned long allocations[MEMORY_TAGS];
+		/*!< Allocations and reallocations by tag */
+	unsigned long bytes[MEMORY_TAGS];
+		/*!< Bytes allocated and reallocated by tag */
+	unsigned long line_allocations;
+		/*!< Allocations and reallocations while processing input lines */
+} memory_account_t;
+
 /*! \c malloc() wrapper; bails on failure */
-extern void *
-allocate(size_t bytes);
+#define allocate(bytes)	allocate_tagged(bytes,MEMORY_TAG)
 
 /*! \c realloc() wrapper; bails on failure */ 
-extern void *
-reallocate(void *ptr, size_t bytes);
+#define reallocate(ptr,bytes)	reallocate_tagged(ptr,bytes,MEMORY_TAG)
 
 /*! \c calloc() wrapper; bails on failure */ 
+#define callocate(items,size)	callocate_tagged(items,size,MEMORY_TAG)
+
+/*! Allocate zeroed memory; bail on failure.
+	\param	bytes	The number of bytes to allocate.
+	\param	tag		The tag by which the allocation is accounted.
+	\return	The allocated memory.
+
+	Call through \c allocate().
+*/
+extern void *
+allocate_tagged(size_t bytes, memory_tag_t tag);
+
+/*! Reallocate memory; bail on failure.
+	\param	ptr		The memory to reallocate, or NULL.
+	\param	bytes	The new size of the memory.
+	\param	tag		The tag by which the reallocation is accounted.
+	\return	The reallocated memory.
+
+	Call through \c reallocate().
+*/
+extern void *
+reallocate_tagged(void *ptr, size_t bytes, memory_tag_t tag);
+
+/*! Allocate zeroed memory for an array; bail on failure.
+	\param	items	The number of elements of the array.
+	\param	size	The size of an element.
+	\param	tag		The tag by which the allocation is accounted.
+	\return	The allocated memory.
+
+	Call through \c callocate().
+*/
 extern void *
-callocate(size_t items, size_t size);
+callocate_tagged(size_t items, size_t size, memory_tag_t tag);
 
 /*! Safely free a pointer.
 	\param		pp	Address of the pointer to be freed
@@ -74,6 +137,39 @@ callocate(size_t items, size_t size);
 extern void
 release(void **pp);
 
+/*! Start accounting allocations.
+
+	Call before any threads are started.
+*/
+extern void
+memory_account_start(void);
+
+/*! Say whether input lines are being processed, for the count of
+	allocations per line.
+	\param	in_lines	Are input lines being processed?
+*/
+extern void
+memory_in_lines(bool in_lines);
+
+/*! Get the account of allocations.
+	\param	account	Receives the account.
+*/
+extern void
+memory_get_account(memory_account_t *account);
+
+/*! Get the number of bytes of heap in use, where the C library can tell.
+	\return	The bytes in use, or 0 if it is not known.
+*/
+extern size_t
+memory_live(void);
+
+/*! Get the peak resident set size of the process, where the system can
+	tell.
+	\return	The peak bytes resident, or 0 if it is not known.
+*/
+extern size_t
+memory_peak_rss(void);
+
 /*@}*/ 
  
 #endif /* EOF */
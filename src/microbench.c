@@ -0,0 +1,753 @@
+/***************************************************************************
+ *   Copyright (C) 2004, 2006 Symbian Software Ltd.                        *
+ *   All rights reserved.                                                  *
+ *   Copyright (C) 2007, 2008 Mike Kinghan, imk@strudl.org                 *
+ *   All rights reserved.                                                  *
+ *                                                                         *
+ *   Contributed originally by Mike Kinghan, imk@strudl.org                *
+ *                                                                         *
+ *   Redistribution and use in source and binary forms, with or without    *
+ *   modification, are permitted provided that the following conditions    *
+ *   are met:                                                              *
+ *                                                                         *
+ *   Redistributions of source code must retain the above copyright        *
+ *   notice, this list of conditions and the following disclaimer.         *
+ *                                                                         *
+ *   Redistributions in binary form must reproduce the above copyright     *
+ *   notice, this list of conditions and the following disclaimer in the   *
+ *   documentation and/or other materials provided with the distribution.  *
+ *                                                                         *
+ *   Neither the name of Symbian Software Ltd. nor the names of its        *
+ *   contributors may be used to endorse or promote products derived from  *
+ *   this software without specific prior written permission.              *
+ *                                                                         *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS   *
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT     *
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS    *
+ *   FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE        *
+ *   COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,   *
+ *   INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,  *
+ *   BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS *
+ *   OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED    *
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,*
+ *   OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF *
+ *   THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH  *
+ *   DAMAGE.                                                               *
+ *                                                                         *
+ ***************************************************************************/
+#include "report.h"
+#include "evaluator.h"
+#include "categorical.h"
+#include "line_despatch.h"
+#include "line_edit.h"
+#include "if_control.h"
+#include "args.h"
+#include "symbol_table.h"
+#include "io.h"
+#include "chew.h"
+#include "platform.h"
+#include "exception.h"
+#include "dataset.h"
+#include "lex_map.h"
+#include "checkpoint.h"
+#include "manifest.h"
+#include "cache.h"
+#include "daemon.h"
+#include "watch.h"
+#include "stats.h"
+#include "timeline.h"
+#include "profile.h"
+#include "file_tree.h"
+#include "filesys.h"
+#include "memory.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+/*! \ingroup microbench_module
+ * \file microbench.c
+ *	This file implements the Sunifdef microbenchmark program.
+ *
+ *	The program is linked from the same objects as sunifdef and drives
+ *	the kernels of the lexer, evaluator, output and file tree through
+ *	their nearest public entry points: \c readon() through \c get_line()
+ *	and \c printline_cut() through \c print(). Each kernel is run in
+ *	batches of units of work, calibrated to take a target time, and the
+ *	median and median absolute deviation of the batches are reported.
+ */
+
+/*! \addtogroup microbench_module */
+/*@{*/
+
+#ifdef UNIX
+/*! The null device, to which output is written */
+#define NULL_DEVICE "/dev/null"
+#else
+#define NULL_DEVICE "NUL"
+#endif
+
+/*! The directory created for the file tree kernels */
+#define TREE_ROOT "microbench.tmp"
+
+/*! Directories in the directory created for the file tree kernels */
+#define TREE_DIRS	16
+
+/*! Files in each directory created for the file tree kernels */
+#define TREE_FILES	64
+
+/*! Lines in each input generated for the line kernels */
+#define INPUT_LINES	4096
+
+/*! Keys looked up in each unit of work of the \c find_sym() kernels */
+#define LOOKUPS		1024
+
+/*! Symbols used in generated input: SYM0 to SYM15 are defined,
+	SYM16 to SYM31 undefined and the rest unknown */
+#define INPUT_SYMBOLS	48
+
+/*! Default number of batches timed for each kernel */
+#define DEFAULT_BATCHES	21
+
+/*! Default target time of a batch in milliseconds */
+#define DEFAULT_TARGET_MS	20
+
+/*! Type of the kinds of input generated for the line kernels */
+typedef enum {
+	MIX_PLAIN,	/*!< Code and comments, no directives */
+	MIX_IFDEF,	/*!< With \c #ifdef, \c #ifndef, \c #else and \c #endif */
+	MIX_IF		/*!< With \c #if and \c #elif on compound expressions */
+} mix_t;
+
+/*! Structure of a kernel */
+typedef struct {
+	char const *name;	/*!< The name of the kernel */
+	void (*setup)(size_t param);	/*!< Prepare the kernel, setting
+										\c unit_ops and \c unit_bytes */
+	void (*run)(size_t units);	/*!< Run units of work */
+	void (*teardown)(void);	/*!< Release what \c setup acquired */
+	size_t param;	/*!< Parameter passed to \c setup */
+} kernel_t;
+
+/*! Operations in a unit of work of the current kernel */
+static size_t unit_ops;
+
+/*! Bytes processed in a unit of work of the current kernel,
+	or 0 if bytes are not meaningful for the kernel */
+static size_t unit_bytes;
+
+/*! The stream from which the line kernels read */
+static FILE *input;
+
+/*! The stream to which the output kernels write */
+static FILE *output;
+
+/*! The state of the generator of input */
+static unsigned long random_state;
+
+/*! Keys looked up by the \c find_sym() kernels */
+static char **keys;
+
+/*! Symbols added to the symbol table by the \c find_sym() kernels */
+static size_t table_symbols;
+
+/*! The file tree built by the file tree kernels */
+static file_tree_h tree;
+
+/*! Get a pseudo-random integer in [0,n), the same on every platform */
+static unsigned
+uniform(unsigned n)
+{
+	random_state = (random_state * 1664525UL + 1013904223UL) & 0xffffffffUL;
+	return (unsigned)((random_state >> 8) % n);
+}
+
+/*! Read the processor's cycle counter, or return 0 if it is
+	not available. On x86 this is the time-stamp counter, which counts
+	at a constant reference rate. */
+static unsigned long long
+read_cycles(void)
+{
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+	return __builtin_ia32_rdtsc();
+#elif defined(_MSC_VER)
+	return __rdtsc();
+#else
+	return 0;
+#endif
+}
+
+/*! Write a line of generated input.
+	\param	out		The stream to write to.
+	\param	mix		The kind of input.
+	\param	depth	Pointer to the current depth of \c #if nesting.
+	\param	elsed	Array of flags, one per depth, set when an \c #else
+					has been written at that depth.
+*/
+static void
+gen_line(FILE *out, mix_t mix, int *depth, bool *elsed)
+{
+	unsigned kind = uniform(10);
+	if (mix == MIX_PLAIN || kind < 6) {
+		if (uniform(5) == 0) {
+			fputs("/* the value of this flag is not yet known */\n",out);
+		}
+		else {
+			fprintf(out,"\tint v%u = %u;%s\n",uniform(1000),uniform(100000),
+				uniform(3) ? "" : " /* count */");
+		}
+	}
+	else if (*depth == 0 || (kind < 8 && *depth < 4)) {
+		unsigned sym = uniform(INPUT_SYMBOLS);
+		if (mix == MIX_IFDEF) {
+			fprintf(out,"#if%sdef SYM%u\n",uniform(2) ? "" : "n",sym);
+		}
+		else if (uniform(2)) {
+			fprintf(out,"#if defined(SYM%u) && SYM%u > 0\n",sym,
+				uniform(INPUT_SYMBOLS));
+		}
+		else {
+			fprintf(out,"#if (SYM%u || SYM%u) && !defined(SYM%u)\n",sym,
+				uniform(INPUT_SYMBOLS),uniform(INPUT_SYMBOLS));
+		}
+		elsed[++*depth] = false;
+	}
+	else if (kind < 9 && !elsed[*depth]) {
+		if (mix == MIX_IF && uniform(2)) {
+			fprintf(out,"#elif !defined(SYM%u) || (SYM%u)\n",
+				uniform(INPUT_SYMBOLS),uniform(INPUT_SYMBOLS));
+		}
+		else {
+			fputs("#else\n",out);
+			elsed[*depth] = true;
+		}
+	}
+	else {
+		fputs("#endif\n",out);
+		--*depth;
+	}
+}
+
+/*! Open a generated input for the line kernels, setting \c unit_ops
+	and \c unit_bytes to its lines and bytes.
+	\param	mix		The kind of input.
+	\param	text	NULL, or a single line to use as the input.
+*/
+static void
+open_input(mix_t mix, char const *text)
+{
+	input = tmpfile();
+	if (!input) {
+		bail(GRIPE_NO_TEMPFILE,"Cannot create temporary file");
+	}
+	random_state = 20080101UL + mix;
+	if (text) {
+		fputs(text,input);
+		unit_ops = 1;
+	}
+	else {
+		int depth = 0;
+		bool elsed[8];
+		for (unit_ops = 0; unit_ops < INPUT_LINES; ++unit_ops) {
+			gen_line(input,mix,&depth,elsed);
+		}
+		for (	;depth; --depth, ++unit_ops) {
+			fputs("#endif\n",input);
+		}
+	}
+	unit_bytes = (size_t)ftell(input);
+	rewind(input);
+	io_use_streams(input,output);
+	open_io("[microbench]");
+}
+
+/*! Rewind the input of a line kernel to its start */
+static void
+rewind_input(void)
+{
+	seek_input(0,0);
+	if_control_toplevel();
+	chew_toplevel();
+}
+
+/*! Close the input of a line kernel */
+static void
+close_input_stream(void)
+{
+	close_io(0);
+	fclose(input);
+	input = NULL;
+}
+
+/* Kernels ***********************************************************/
+
+/*! Set up \c chew_on() on a line of whitespace and comments */
+static void
+setup_chew_on(size_t param)
+{
+	(void)param;
+	open_input(MIX_PLAIN,
+		"  \t/* a comment of several words */  \t/* another */   "
+		"/* and a third, longer comment before the code */ \tcode();\n");
+	if (!get_line()) {
+		bail(GRIPE_CANT_READ_INPUT,"Cannot read input");
+	}
+	chew_toplevel();
+	unit_bytes = chew_on(GET_PUBLIC(io,line_start)) -
+		GET_PUBLIC(io,line_start);
+}
+
+/*! Run \c chew_on() over the loaded line */
+static void
+run_chew_on(size_t units)
+{
+	for (	;units; --units) {
+		chew_toplevel();
+		(void)chew_on(GET_PUBLIC(io,line_start));
+	}
+}
+
+/*! Set up \c readon() on input of code and comments */
+static void
+setup_readon(size_t param)
+{
+	(void)param;
+	open_input(MIX_PLAIN,NULL);
+}
+
+/*! Read all the lines of the input with \c get_line(), which
+	reads each with \c readon() */
+static void
+run_readon(size_t units)
+{
+	for (	;units; --units) {
+		rewind_input();
+		while (get_line()) {}
+	}
+}
+
+/*! Set up \c eval_line() on a kind of input */
+static void
+setup_eval_line(size_t mix)
+{
+	open_input((mix_t)mix,NULL);
+}
+
+/*! Evaluate all the lines of the input with \c eval_line() */
+static void
+run_eval_line(size_t units)
+{
+	for (	;units; --units) {
+		rewind_input();
+		while (eval_line() != LT_EOF) {}
+	}
+}
+
+/*! Set up \c print() on a directive with the given simplification.
+	\param	state	\c OPS_CUT for a directive that loses operands, whose
+		printing is done by \c printline_cut(), or \c BRACKETS_PRUNED for
+		one that only loses redundant parentheses, which are kept on output
+		as \c restore_paren() once kept them.
+*/
+static void
+setup_print(size_t state)
+{
+	simplification_state_t simplified;
+	open_input(MIX_IF,state == OPS_CUT ?
+		"#if defined(SYM0) && UNKNOWN_A || (UNKNOWN_B && defined(SYM16))\n" :
+		"#if ((UNKNOWN_A)) || (UNKNOWN_B)\n");
+	if (eval_line() == LT_EOF) {
+		bail(GRIPE_CANT_READ_INPUT,"Cannot read input");
+	}
+	simplified = GET_PUBLIC(line_edit,simplification_state);
+	if (state == OPS_CUT ? !(simplified & OPS_CUT) :
+		simplified != BRACKETS_PRUNED) {
+		bail(GRIPE_INVALID_ARGS,"Directive is not simplified as expected");
+	}
+}
+
+/*! Print the evaluated directive */
+static void
+run_print(size_t units)
+{
+	for (	;units; --units) {
+		print();
+	}
+}
+
+/*! Tear down a line kernel */
+static void
+teardown_input(void)
+{
+	close_input_stream();
+}
+
+/*! Set up \c find_sym() on a symbol table of a given size.
+	\param	size	The number of symbols to have been added to the
+		symbol table, besides those of the options.
+
+	Symbols are added in order, so the table is only ever appended to.
+	Three quarters of the keys are in the table and the rest just miss.
+*/
+static void
+setup_find_sym(size_t size)
+{
+	char name[16];
+	size_t i;
+	for (	;table_symbols < size; ++table_symbols) {
+		sprintf(name,"K%06u",(unsigned)table_symbols);
+		add_specified_symbol(true,name);
+	}
+	random_state = 20080101UL;
+	keys = allocate(LOOKUPS * sizeof(char *));
+	unit_bytes = 0;
+	for (i = 0; i < LOOKUPS; ++i) {
+		sprintf(name,"K%06u%s",uniform((unsigned)size),
+			uniform(4) ? "" : "Z");
+		keys[i] = allocate(strlen(name) + 1);
+		strcpy(keys[i],name);
+		unit_bytes += strlen(name);
+	}
+	unit_ops = LOOKUPS;
+}
+
+/*! Look up all the keys */
+static void
+run_find_sym(size_t units)
+{
+	for (	;units; --units) {
+		size_t i;
+		for (i = 0; i < LOOKUPS; ++i) {
+			(void)find_sym(keys[i],NULL);
+		}
+	}
+}
+
+/*! Tear down a \c find_sym() kernel */
+static void
+teardown_find_sym(void)
+{
+	size_t i;
+	for (i = 0; i < LOOKUPS; ++i) {
+		free(keys[i]);
+	}
+	free(keys);
+	keys = NULL;
+}
+
+/*! Create the directory tree for the file tree kernels */
+static void
+make_tree_dirs(void)
+{
+	char name[64];
+	int dir, file;
+	if (!fs_make_dir(TREE_ROOT)) {
+		bail(GRIPE_CANT_WRITE_FILE,"Cannot create directory \"%s\"",
+			TREE_ROOT);
+	}
+	for (dir = 0; dir < TREE_DIRS; ++dir) {
+		sprintf(name,"%s%cd%02d",TREE_ROOT,PATH_DELIM,dir);
+		if (!fs_make_dir(name)) {
+			bail(GRIPE_CANT_WRITE_FILE,"Cannot create directory \"%s\"",
+				name);
+		}
+		for (file = 0; file < TREE_FILES; ++file) {
+			sprintf(name,"%s%cd%02d%cf%02d.c",TREE_ROOT,PATH_DELIM,dir,
+				PATH_DELIM,file);
+			fclose(open_file(name,"w"));
+		}
+	}
+	unit_ops = TREE_DIRS * TREE_FILES;
+	unit_bytes = 0;
+}
+
+/*! Remove the directory tree for the file tree kernels */
+static void
+remove_tree_dirs(void)
+{
+	char name[64];
+	int dir, file;
+	for (dir = 0; dir < TREE_DIRS; ++dir) {
+		for (file = 0; file < TREE_FILES; ++file) {
+			sprintf(name,"%s%cd%02d%cf%02d.c",TREE_ROOT,PATH_DELIM,dir,
+				PATH_DELIM,file);
+			remove(name);
+		}
+		sprintf(name,"%s%cd%02d",TREE_ROOT,PATH_DELIM,dir);
+		remove(name);
+	}
+	remove(TREE_ROOT);
+}
+
+/*! Set up \c file_tree_add() on the created directory tree */
+static void
+setup_file_tree_add(size_t param)
+{
+	(void)param;
+	make_tree_dirs();
+}
+
+/*! Build a file tree of the directory tree and dispose of it */
+static void
+run_file_tree_add(size_t units)
+{
+	for (	;units; --units) {
+		file_tree_h ft = file_tree_new();
+		file_tree_add(ft,TREE_ROOT,NULL,1);
+		file_tree_dispose(&ft);
+	}
+}
+
+/*! Tear down the \c file_tree_add() kernel */
+static void
+teardown_file_tree_add(void)
+{
+	remove_tree_dirs();
+}
+
+/*! Set up \c file_tree_traverse() on a file tree of the created
+	directory tree */
+static void
+setup_traverse(size_t param)
+{
+	(void)param;
+	make_tree_dirs();
+	tree = file_tree_new();
+	file_tree_add(tree,TREE_ROOT,NULL,1);
+	unit_ops = file_tree_count(tree,FT_COUNT_ALL,NULL);
+}
+
+/*! The \c file_tree_callback_t of the traversal kernel */
+static void
+count_node(	file_tree_h file_tree,
+			char const *name,
+			file_tree_traverse_state_t context)
+{
+	(void)file_tree;
+	(void)name;
+	(void)context;
+}
+
+/*! Traverse the file tree */
+static void
+run_traverse(size_t units)
+{
+	for (	;units; --units) {
+		file_tree_traverse(tree,count_node);
+	}
+}
+
+/*! Tear down the traversal kernel */
+static void
+teardown_traverse(void)
+{
+	file_tree_dispose(&tree);
+	remove_tree_dirs();
+}
+
+/*! The kernels, in the order they are run */
+static kernel_t const kernels[] = {
+	{ "chew_on", setup_chew_on, run_chew_on, teardown_input, 0 },
+	{ "readon", setup_readon, run_readon, teardown_input, 0 },
+	{ "eval_line/plain", setup_eval_line, run_eval_line, teardown_input,
+		MIX_PLAIN },
+	{ "eval_line/ifdef", setup_eval_line, run_eval_line, teardown_input,
+		MIX_IFDEF },
+	{ "eval_line/if", setup_eval_line, run_eval_line, teardown_input,
+		MIX_IF },
+	{ "printline_cut", setup_print, run_print, teardown_input, OPS_CUT },
+	{ "print_paren", setup_print, run_print, teardown_input,
+		BRACKETS_PRUNED },
+	{ "find_sym/16", setup_find_sym, run_find_sym, teardown_find_sym, 16 },
+	{ "find_sym/256", setup_find_sym, run_find_sym, teardown_find_sym, 256 },
+	{ "find_sym/4096", setup_find_sym, run_find_sym, teardown_find_sym,
+		4096 },
+	{ "file_tree_add", setup_file_tree_add, run_file_tree_add,
+		teardown_file_tree_add, 0 },
+	{ "traverse", setup_traverse, run_traverse, teardown_traverse, 0 }
+};
+
+/*! The number of kernels */
+#define KERNELS (sizeof(kernels) / sizeof(kernels[0]))
+
+/*! Compare doubles for \c qsort() */
+static int
+compare_doubles(void const *lhs, void const *rhs)
+{
+	double l = *(double const *)lhs;
+	double r = *(double const *)rhs;
+	return l < r ? -1 : l > r;
+}
+
+/*! Get the median of an array of doubles, sorting it */
+static double
+median(double *values, size_t count)
+{
+	qsort(values,count,sizeof(double),compare_doubles);
+	return count % 2 ? values[count / 2] :
+		(values[count / 2 - 1] + values[count / 2]) / 2;
+}
+
+/*! Time a kernel and report its results.
+	\param	kernel		The kernel.
+	\param	batches		The number of batches to time.
+	\param	target		The target time of a batch in seconds.
+*/
+static void
+bench(kernel_t const *kernel, int batches, double target)
+{
+	double *ns = allocate(batches * sizeof(double));
+	double *cycles = allocate(batches * sizeof(double));
+	double *deviation = allocate(batches * sizeof(double));
+	size_t units = 1;
+	double ns_median, cycles_median;
+	int i;
+	kernel->setup(kernel->param);
+	/* Warm up and find the units of work that take the target time */
+	for (	;;) {
+		double start = stats_wall_clock();
+		kernel->run(units);
+		if (stats_wall_clock() - start >= target || units >= (size_t)1 << 30) {
+			break;
+		}
+		units *= 2;
+	}
+	for (i = 0; i < batches; ++i) {
+		unsigned long long start_cycles = read_cycles();
+		double start = stats_wall_clock();
+		kernel->run(units);
+		ns[i] = (stats_wall_clock() - start) * 1e9 / (units * unit_ops);
+		cycles[i] = (double)(read_cycles() - start_cycles) /
+			(units * unit_ops);
+	}
+	kernel->teardown();
+	ns_median = median(ns,batches);
+	cycles_median = median(cycles,batches);
+	for (i = 0; i < batches; ++i) {
+		deviation[i] = ns[i] > ns_median ? ns[i] - ns_median :
+			ns_median - ns[i];
+	}
+	printf("%-16s %10lu %12.2f %7.2f%% %12.2f %12.1f ",kernel->name,
+		(unsigned long)(units * unit_ops),ns_median,
+		median(deviation,batches) * 100 / ns_median,ns[0],cycles_median);
+	if (unit_bytes && cycles_median > 0) {
+		printf("%11.4f\n",(double)unit_bytes / unit_ops / cycles_median);
+	}
+	else {
+		printf("%11s\n","-");
+	}
+	fflush(stdout);
+	free(ns);
+	free(cycles);
+	free(deviation);
+}
+
+/*! Write the usage of the program to stdout */
+static void
+usage(char const *prog)
+{
+	printf("Usage: %s [-bBATCHES] [-tMILLISECONDS] [KERNEL...]\n"
+		"Time the kernels of sunifdef, or only those whose names begin "
+		"with one of the KERNELs.\n"
+		"-bBATCHES        Time BATCHES batches of each kernel. "
+		"Default %d.\n"
+		"-tMILLISECONDS   Run each batch for about MILLISECONDS. "
+		"Default %d.\n"
+		"Reports the operations in a batch, the median and median absolute "
+		"deviation of the time per operation across batches, the least "
+		"time per operation, the median cycles per operation and the "
+		"bytes processed per cycle. Cycles are read from the time-stamp "
+		"counter where there is one, and are 0 elsewhere.\n",
+		prog,DEFAULT_BATCHES,DEFAULT_TARGET_MS);
+}
+
+/*! Initialise all module states */
+static void
+ready(void)
+{
+	INITIALISE(chew);
+	INITIALISE(diagnostic);
+	INITIALISE(evaluator);
+	INITIALISE(if_control);
+	INITIALISE(io);
+	INITIALISE(dataset);
+	INITIALISE(line_edit);
+	INITIALISE(args);
+	INITIALISE(symbol_table);
+	INITIALISE(line_despatch);
+	INITIALISE(categorical);
+	INITIALISE(lex_map);
+	INITIALISE(checkpoint);
+	INITIALISE(manifest);
+	INITIALISE(cache);
+	INITIALISE(daemon);
+	INITIALISE(watch);
+	INITIALISE(stats);
+	INITIALISE(timeline);
+	INITIALISE(profile);
+	INITIALISE(exception);
+}
+
+/*! The microbenchmark program. */
+int
+main(int argc, char *argv[])
+{
+	char *defs[2 + INPUT_SYMBOLS];
+	char names[INPUT_SYMBOLS][16];
+	int batches = DEFAULT_BATCHES;
+	double target = DEFAULT_TARGET_MS / 1000.0;
+	int first_kernel = argc;
+	int i;
+	size_t k;
+
+	for (i = 1; i < argc && argv[i][0] == '-'; ++i) {
+		if (argv[i][1] == 'b' && atoi(argv[i] + 2) > 0) {
+			batches = atoi(argv[i] + 2);
+		}
+		else if (argv[i][1] == 't' && atoi(argv[i] + 2) > 0) {
+			target = atoi(argv[i] + 2) / 1000.0;
+		}
+		else if (argv[i][1] == 'h') {
+			usage(argv[0]);
+			return EXIT_SUCCESS;
+		}
+		else {
+			usage(argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+	first_kernel = i;
+
+	ready();
+	parse_executable(argv);
+	/* The options: define SYM0 to SYM15 and undefine SYM16 to SYM31 */
+	defs[0] = argv[0];
+	for (i = 0; i < 32; ++i) {
+		sprintf(names[i],"-%cSYM%d%s",i < 16 ? 'D' : 'U',i,i < 16 ? "=1" : "");
+		defs[i + 1] = names[i];
+	}
+	defs[33] = NULL;
+	parse_args(33,defs);
+	finish_args();
+	output = open_file(NULL_DEVICE,"w");
+
+	printf("%-16s %10s %12s %8s %12s %12s %11s\n","Kernel","Ops/batch",
+		"ns/op","+/-","Least ns/op","Cycles/op","Bytes/cycle");
+	for (k = 0; k < KERNELS; ++k) {
+		bool wanted = first_kernel == argc;
+		for (i = first_kernel; i < argc && !wanted; ++i) {
+			wanted = !strncmp(kernels[k].name,argv[i],strlen(argv[i]));
+		}
+		if (wanted) {
+			bench(&kernels[k],batches,target);
+		}
+	}
+	fclose(output);
+	return EXIT_SUCCESS;
+}
+
+/*@}*/
+
+/* EOF */
@@ -0,0 +1,448 @@
+/***************************************************************************
+ *   Copyright (C) 2004, 2006 Symbian Software Ltd.                        *
+ *   All rights reserved.                                                  *
+ *   Copyright (C) 2007, 2008 Mike Kinghan, imk@strudl.org                 *
+ *   All rights reserved.                                                  *
+ *                                                                         *
+ *   Contributed originally by Mike Kinghan, imk@strudl.org                *
+ *                                                                         *
+ *   Redistribution and use in source and binary forms, with or without    *
+ *   modification, are permitted provided that the following conditions    *
+ *   are met:                                                              *
+ *                                                                         *
+ *   Redistributions of source code must retain the above copyright        *
+ *   notice, this list of conditions and the following disclaimer.         *
+ *                                                                         *
+ *   Redistributions in binary form must reproduce the above copyright     *
+ *   notice, this list of conditions and the following disclaimer in the   *
+ *   documentation and/or other materials provided with the distribution.  *
+ *                                                                         *
+ *   Neither the name of Symbian Software Ltd. nor the names of its        *
+ *   contributors may be used to endorse or promote products derived from  *
+ *   this software without specific prior written permission.              *
+ *                                                                         *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS   *
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT     *
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS    *
+ *   FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE        *
+ *   COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,   *
+ *   INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,  *
+ *   BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS *
+ *   OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED    *
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,*
+ *   OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF *
+ *   THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH  *
+ *   DAMAGE.                                                               *
+ *                                                                         *
+ ***************************************************************************/
+
+#define MEMORY_TAG	MEMORY_FILE_TREE
+#include "name_rules.h"
+#include "memory.h"
+#include "platform.h"
+#include "hash.h"
+#include <string.h>
+
+/*!\ingroup name_rules_module name_rules_interface name_rules_internals
+ *\file name_rules.c
+ * This file implements the Name Rules module
+ */
+
+/*! \addtogroup name_rules_internals */
+/*@{*/
+
+/*! Enumeration of the kinds of token in a compiled glob pattern */
+typedef enum {
+	GLOB_LITERAL,	/*!< Characters to be matched exactly */
+	GLOB_ANY,		/*!< \c ? */
+	GLOB_CLASS,		/*!< \c [...] */
+	GLOB_STAR,		/*!< \c * */
+	GLOB_DEEP		/*!< \c ** */
+} glob_token_kind_t;
+
+/*! Structure of a token in a compiled glob pattern */
+typedef struct glob_token {
+	glob_token_kind_t kind;	/*!< The kind of token */
+	char const *text;		/*!< For \c GLOB_LITERAL, the characters */
+	size_t len;				/*!< For \c GLOB_LITERAL, the number of
+								characters */
+	unsigned char class[32];	/*!< For \c GLOB_CLASS, a bitmap of the
+									characters matched */
+} glob_token_t;
+
+/*! Structure of a compiled glob pattern */
+typedef struct glob {
+	heap_str text;			/*!< The literal characters of the pattern */
+	glob_token_t *tokens;	/*!< The tokens of the pattern */
+	size_t count;			/*!< The number of tokens */
+	bool whole_path;		/*!< Is the pattern matched against
+								pathnames, not leafnames? */
+	bool absolute;			/*!< Is the pattern matched only against
+								whole pathnames? */
+} glob_t;
+
+/*! Structure of a hashed set of strings, with open addressing */
+typedef struct str_set {
+	heap_str *slots;	/*!< The slots of the set, NULL if empty */
+	size_t size;		/*!< The number of slots, a power of 2 */
+	size_t count;		/*!< The number of strings in the set */
+} str_set_t;
+
+/*! Structure of a set of name rules */
+struct name_rules {
+	str_set_t extensions;	/*!< Extensions to be matched */
+	str_set_t leafnames;	/*!< Leafnames to be matched exactly */
+	glob_t *globs;			/*!< Other glob patterns */
+	size_t glob_count;		/*!< The number of \c globs */
+};
+
+/*! Get the slot of a string in a set of strings.
+	\param	set		The set.
+	\param	str		The string, not necessarily nul-terminated.
+	\param	len		The length of \c str.
+	\return	The slot that holds \c str, or the empty slot
+			at which it would be inserted.
+ */
+static heap_str *
+str_set_slot(str_set_t const *set, char const *str, size_t len)
+{
+	size_t mask = set->size - 1;
+	size_t slot = (size_t)hash_bytes(HASH_INIT,str,len) & mask;
+	for (	;set->slots[slot]; slot = (slot + 1) & mask) {
+		if (!strncmp(set->slots[slot],str,len) &&
+			set->slots[slot][len] == '\0') {
+			break;
+		}
+	}
+	return set->slots + slot;
+}
+
+/*! Say whether a set of strings contains a string */
+static bool
+str_set_contains(str_set_t const *set, char const *str, size_t len)
+{
+	return set->count && *str_set_slot(set,str,len) != NULL;
+}
+
+/*! Add a string to a set of strings, if not already present.
+	The set is kept at most half full.
+ */
+static void
+str_set_add(str_set_t *set, char const *str)
+{
+	size_t len = strlen(str);
+	heap_str *slot;
+	if ((set->count + 1) * 2 > set->size) {
+		str_set_t bigger;
+		size_t i;
+		bigger.size = set->size ? set->size * 2 : 16;
+		bigger.count = set->count;
+		bigger.slots = callocate(bigger.size,sizeof(heap_str));
+		for (i = 0; i < set->size; ++i) {
+			if (set->slots[i]) {
+				*str_set_slot(&bigger,set->slots[i],strlen(set->slots[i])) =
+					set->slots[i];
+			}
+		}
+		free(set->slots);
+		*set = bigger;
+	}
+	slot = str_set_slot(set,str,len);
+	if (!*slot) {
+		*slot = allocate(len + 1);
+		memcpy(*slot,str,len + 1);
+		++set->count;
+	}
+}
+
+/*! Release the strings and slots of a set of strings */
+static void
+str_set_clear(str_set_t *set)
+{
+	size_t i;
+	for (i = 0; i < set->size; ++i) {
+		free(set->slots[i]);
+	}
+	free(set->slots);
+	set->slots = NULL;
+	set->size = set->count = 0;
+}
+
+/*! Add a character to the class of a glob token */
+#define CLASS_SET(tok,ch) \
+	((tok)->class[(unsigned char)(ch) >> 3] |= 1 << ((unsigned char)(ch) & 7))
+
+/*! Test whether a character is in the class of a glob token */
+#define CLASS_HAS(tok,ch) \
+	(((tok)->class[(unsigned char)(ch) >> 3] >> ((unsigned char)(ch) & 7)) & 1)
+
+/*! Compile a character class of a glob pattern.
+	\param	tok		The token to receive the class.
+	\param	cp		Pointer just past the \c '[' that opens the class.
+	\return	Pointer just past the \c ']' that closes the class, or
+			NULL if the class is not closed.
+ */
+static char const *
+compile_class(glob_token_t *tok, char const *cp)
+{
+	bool negate = *cp == '!' || *cp == '^';
+	size_t i;
+	if (negate) {
+		++cp;
+	}
+	memset(tok->class,0,sizeof(tok->class));
+	/* A ']' first in the class is literal */
+	if (*cp == ']') {
+		CLASS_SET(tok,*cp);
+		++cp;
+	}
+	for (	;*cp != ']'; ++cp) {
+		if (!*cp) {
+			return NULL;
+		}
+		if (cp[1] == '-' && cp[2] && cp[2] != ']') {
+			int ch;
+			for (ch = (unsigned char)cp[0]; ch <= (unsigned char)cp[2]; ++ch) {
+				CLASS_SET(tok,ch);
+			}
+			cp += 2;
+		}
+		else {
+			CLASS_SET(tok,*cp);
+		}
+	}
+	if (negate) {
+		for (i = 0; i < sizeof(tok->class); ++i) {
+			tok->class[i] = (unsigned char)~tok->class[i];
+		}
+	}
+	/* A class never matches a path delimiter */
+	tok->class[(unsigned char)PATH_DELIM >> 3] &=
+		(unsigned char)~(1 << ((unsigned char)PATH_DELIM & 7));
+	return cp + 1;
+}
+
+/*! Compile a glob pattern.
+	\param	glob	The compiled pattern to be filled in.
+	\param	pattern	The pattern.
+	\return	True if \c pattern is well-formed, else false.
+ */
+static bool
+compile_glob(glob_t *glob, char const *pattern)
+{
+	char const *cp = pattern;
+	char *lit;
+	size_t len = strlen(pattern);
+	glob->tokens = allocate((len + 1) * sizeof(glob_token_t));
+	glob->text = lit = allocate(len + 1);
+	glob->count = 0;
+	glob->whole_path = strchr(pattern,PATH_DELIM) != NULL;
+	glob->absolute = *pattern == PATH_DELIM;
+	while (*cp) {
+		glob_token_t *tok = glob->tokens + glob->count;
+		switch(*cp) {
+		case '*':
+			tok->kind = cp[1] == '*' ? GLOB_DEEP : GLOB_STAR;
+			while (*cp == '*') {
+				++cp;
+			}
+			break;
+		case '?':
+			tok->kind = GLOB_ANY;
+			++cp;
+			break;
+		case '[':
+			tok->kind = GLOB_CLASS;
+			cp = compile_class(tok,cp + 1);
+			if (!cp) {
+				return false;
+			}
+			break;
+		default:
+			tok->kind = GLOB_LITERAL;
+			tok->text = lit;
+			for (	;*cp && !strchr("*?[",*cp); ++cp) {
+#if PATH_DELIM != '\\'
+				if (*cp == '\\' && cp[1]) {
+					++cp;
+				}
+#endif
+				*lit++ = *cp;
+			}
+			tok->len = lit - tok->text;
+		}
+		++glob->count;
+	}
+	return true;
+}
+
+/*! Match the tokens of a glob pattern against a string.
+	\param	tok		The first token to match.
+	\param	end		Pointer just past the last token.
+	\param	str		The string.
+	\return	True iff the tokens match the whole of \c str.
+ */
+static bool
+match_tokens(glob_token_t const *tok, glob_token_t const *end, char const *str)
+{
+	for (	;tok != end; ++tok) {
+		switch(tok->kind) {
+		case GLOB_LITERAL:
+			if (strncmp(str,tok->text,tok->len)) {
+				return false;
+			}
+			str += tok->len;
+			break;
+		case GLOB_ANY:
+			if (!*str || *str == PATH_DELIM) {
+				return false;
+			}
+			++str;
+			break;
+		case GLOB_CLASS:
+			if (!*str || !CLASS_HAS(tok,*str)) {
+				return false;
+			}
+			++str;
+			break;
+		case GLOB_STAR:
+		case GLOB_DEEP:
+			for (	;; ++str) {
+				if (match_tokens(tok + 1,end,str)) {
+					return true;
+				}
+				if (!*str || (*str == PATH_DELIM && tok->kind == GLOB_STAR)) {
+					return false;
+				}
+			}
+		}
+	}
+	return *str == '\0';
+}
+
+/*! Match a compiled glob pattern against a file.
+	\param	glob		The pattern.
+	\param	fullname	The absolute pathname of the file.
+	\param	leafname	The leafname of the file.
+	\return	True iff the pattern matches.
+ */
+static bool
+match_glob(glob_t const *glob, char const *fullname, char const *leafname)
+{
+	glob_token_t const *end = glob->tokens + glob->count;
+	char const *cp;
+	if (!glob->whole_path) {
+		return match_tokens(glob->tokens,end,leafname);
+	}
+	if (glob->absolute) {
+		return match_tokens(glob->tokens,end,fullname);
+	}
+	/* Try the pattern at each component */
+	for (cp = fullname; cp; cp = strchr(cp,PATH_DELIM)) {
+		if (*cp == PATH_DELIM) {
+			++cp;
+		}
+		if (match_tokens(glob->tokens,end,cp)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+/*@}*/
+
+/* API ***************************************************************/
+
+name_rules_h
+name_rules_new(void)
+{
+	return callocate(1,sizeof(struct name_rules));
+}
+
+void
+name_rules_dispose(name_rules_h *rules)
+{
+	if (*rules) {
+		size_t i;
+		str_set_clear(&(*rules)->extensions);
+		str_set_clear(&(*rules)->leafnames);
+		for (i = 0; i < (*rules)->glob_count; ++i) {
+			free((*rules)->globs[i].tokens);
+			free((*rules)->globs[i].text);
+		}
+		free((*rules)->globs);
+		release((void **)rules);
+	}
+}
+
+bool
+name_rules_add_glob(name_rules_h rules, char const *pattern)
+{
+	glob_t glob;
+	if (!compile_glob(&glob,pattern)) {
+		free(glob.tokens);
+		free(glob.text);
+		return false;
+	}
+	if (!glob.whole_path && glob.count == 1 &&
+		glob.tokens[0].kind == GLOB_LITERAL) {
+		/* A plain leafname */
+		str_set_add(&rules->leafnames,glob.text);
+	}
+	else if (!glob.whole_path && glob.count == 2 &&
+		glob.tokens[0].kind == GLOB_STAR &&
+		glob.tokens[1].kind == GLOB_LITERAL &&
+		glob.tokens[1].text[0] == '.' && glob.tokens[1].len > 1 &&
+		!memchr(glob.tokens[1].text + 1,'.',glob.tokens[1].len - 1)) {
+		/* "*.ext" */
+		str_set_add(&rules->extensions,glob.tokens[1].text + 1);
+	}
+	else {
+		rules->globs = reallocate(rules->globs,
+			(rules->glob_count + 1) * sizeof(glob_t));
+		rules->globs[rules->glob_count++] = glob;
+		return true;
+	}
+	free(glob.tokens);
+	free(glob.text);
+	return true;
+}
+
+void
+name_rules_add_extension(name_rules_h rules, char const *ext)
+{
+	str_set_add(&rules->extensions,ext);
+}
+
+bool
+name_rules_empty(name_rules_h rules)
+{
+	return !rules->extensions.count && !rules->leafnames.count &&
+		!rules->glob_count;
+}
+
+bool
+name_rules_match(	name_rules_h rules,
+					char const *fullname,
+					char const *leafname)
+{
+	size_t i;
+	if (rules->extensions.count) {
+		char const *ext = strrchr(leafname,'.');
+		if (ext && ext[1] &&
+			str_set_contains(&rules->extensions,ext + 1,strlen(ext + 1))) {
+			return true;
+		}
+	}
+	if (str_set_contains(&rules->leafnames,leafname,strlen(leafname))) {
+		return true;
+	}
+	for (i = 0; i < rules->glob_count; ++i) {
+		if (match_glob(rules->globs + i,fullname,leafname)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+/* EOF */
@@ -0,0 +1,124 @@
+#ifndef NAME_RULES_H
+#define NAME_RULES_H
+
+/***************************************************************************
+ *   Copyright (C) 2004, 2006 Symbian Software Ltd.                        *
+ *   All rights reserved.                                                  *
+ *   Copyright (C) 2007, 2008 Mike Kinghan, imk@strudl.org                 *
+ *   All rights reserved.                                                  *
+ *                                                                         *
+ *   Contributed originally by Mike Kinghan, imk@strudl.org                *
+ *                                                                         *
+ *   Redistribution and use in source and binary forms, with or without    *
+ *   modification, are permitted provided that the following conditions    *
+ *   are met:                                                              *
+ *                                                                         *
+ *   Redistributions of source code must retain the above copyright        *
+ *   notice, this list of conditions and the following disclaimer.         *
+ *                                                                         *
+ *   Redistributions in binary form must reproduce the above copyright     *
+ *   notice, this list of conditions and the following disclaimer in the   *
+ *   documentation and/or other materials provided with the distribution.  *
+ *                                                                         *
+ *   Neither the name of Symbian Software Ltd. nor the names of its        *
+ *   contributors may be used to endorse or promote products derived from  *
+ *   this software without specific prior written permission.              *
+ *                                                                         *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS   *
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT     *
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS    *
+ *   FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE        *
+ *   COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,   *
+ *   INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,  *
+ *   BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS *
+ *   OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED    *
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,*
+ *   OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF *
+ *   THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH  *
+ *   DAMAGE.                                                               *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "opts.h"
+#include "bool.h"
+#include <stddef.h>
+
+/*!\ingroup name_rules_module, name_rules_interface
+ *\file name_rules.h
+ * This file provides the Name Rules module interface.
+ *
+ *	A set of name rules is a set of glob patterns and file extensions
+ *	that is compiled once and then matched against many filenames.
+ */
+
+/*! \addtogroup name_rules_interface */
+/*@{*/
+
+/*! Abstract type of a compiled set of name rules */
+typedef struct name_rules * name_rules_h;
+
+/*! Create a new, empty set of name rules.
+	\return	The new set.
+ */
+extern name_rules_h
+name_rules_new(void);
+
+/*! Dispose of a set of name rules.
+	\param	rules	Pointer to the set to be destroyed. The
+					set addressed by this pointer is set to \c NULL
+					on return.
+ */
+extern void
+name_rules_dispose(name_rules_h *rules);
+
+/*! Compile a glob pattern into a set of name rules.
+
+	\param	rules	The set of rules.
+	\param	glob	The glob pattern.
+	\return	True if \c glob is well-formed and has been added, else
+			false.
+
+	In a pattern, \c * matches any characters except a path delimiter,
+	\c ** matches any characters, \c ? matches any one character except
+	a path delimiter and \c [...] matches any one character in the class,
+	or not in it if the class begins with \c ! or \c ^.
+
+	A pattern without a path delimiter is matched against leafnames.
+	An absolute pattern is matched against whole absolute pathnames.
+	Any other pattern is matched against the trailing components of
+	absolute pathnames.
+ */
+extern bool
+name_rules_add_glob(name_rules_h rules, char const *glob);
+
+/*! Add a file extension to a set of name rules.
+
+	\param	rules	The set of rules.
+	\param	ext		The extension, without the \c '.'. It matches
+					a leafname whose extension, following the last
+					\c '.', is the same.
+ */
+extern void
+name_rules_add_extension(name_rules_h rules, char const *ext);
+
+/*! Say whether a set of name rules is empty */
+extern bool
+name_rules_empty(name_rules_h rules);
+
+/*! Say whether a filename matches any of a set of name rules.
+
+	\param	rules		The set of rules.
+	\param	fullname	The absolute pathname of the file.
+	\param	leafname	The leafname of the file, within \c fullname.
+	\return	True iff any rule matches.
+
+	The function does not modify \c rules and may be called concurrently.
+ */
+extern bool
+name_rules_match(	name_rules_h rules,
+					char const *fullname,
+					char const *leafname);
+
+/*@}*/
+
+#endif /* EOF */
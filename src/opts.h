@@ -46,7 +46,13 @@
 #include "config.h"
 #endif
 
+#ifdef SUNIFDEF_LIBRARY
+/*! The library keeps the module states of each context on the heap
+ *	and attaches them per thread */
+#define THREAD_LOCAL_STATE
+#else
 #define DEFAULT_STATIC_STATE
+#endif
 
 #include "state_utils.h"
 
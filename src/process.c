@@ -0,0 +1,157 @@
+/***************************************************************************
+ *   Copyright (C) 2004, 2006 Symbian Software Ltd.                        *
+ *   All rights reserved.                                                  *
+ *   Copyright (C) 2007, 2008 Mike Kinghan, imk@strudl.org                 *
+ *   All rights reserved.                                                  *
+ *                                                                         *
+ *   Contributed originally by Mike Kinghan, imk@strudl.org                *
+ *                                                                         *
+ *   Redistribution and use in source and binary forms, with or without    *
+ *   modification, are permitted provided that the following conditions    *
+ *   are met:                                                              *
+ *                                                                         *
+ *   Redistributions of source code must retain the above copyright        *
+ *   notice, this list of conditions and the following disclaimer.         *
+ *                                                                         *
+ *   Redistributions in binary form must reproduce the above copyright     *
+ *   notice, this list of conditions and the following disclaimer in the   *
+ *   documentation and/or other materials provided with the distribution.  *
+ *                                                                         *
+ *   Neither the name of Symbian Software Ltd. nor the names of its        *
+ *   contributors may be used to endorse or promote products derived from  *
+ *   this software without specific prior written permission.              *
+ *                                                                         *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS   *
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT     *
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS    *
+ *   FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE        *
+ *   COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,   *
+ *   INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,  *
+ *   BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS *
+ *   OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED    *
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,*
+ *   OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF *
+ *   THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH  *
+ *   DAMAGE.                                                               *
+ *                                                                         *
+ ***************************************************************************/
+#include "process.h"
+#include "report.h"
+#include "evaluator.h"
+#include "categorical.h"
+#include "if_control.h"
+#include "args.h"
+#include "io.h"
+#include "chew.h"
+#include "exception.h"
+#include "checkpoint.h"
+#include "manifest.h"
+#include "cache.h"
+#include "daemon.h"
+#include "line_despatch.h"
+#include "report.h"
+#include "stats.h"
+#include "trace.h"
+#include <stdio.h>
+
+/*!\ingroup process_module
+ *\file process.c
+ * This file implements the Process module.
+ */
+
+/*! \addtogroup process_module */
+/*@{*/
+
+/*! Mask of all exit flags */
+#define ALL_EXIT_FLAGS		(~0)
+
+/*! Debugging aid: set a breakpoint at a given line of input. */
+static void
+line_debug(int line)
+{
+	if (line < 0) {
+		/* Call with negative value to write line numbers */
+		printf("%d\n",GET_PUBLIC(io,line_num));
+	}
+	else if (line > 0 && line == GET_PUBLIC(io,line_num)) {
+		/* Call with positive line number and put breakpoint here ... */
+		fputs("Here",stderr);	
+	}
+}
+
+/*@}*/
+
+/* API ***************************************************************/
+
+void
+process_file(char const *filename)
+{
+	bool catching = !GET_PUBLIC(exception,enabled);
+	bool cached;
+	int error = 0;
+	stats_phase_t phase = STATS_PHASE(STATS_OPEN);
+	TRACE_TEXT(TRACE_FILE,0,filename,(size_t)-1);
+	processing_file(filename);
+	open_io(filename);
+	if_control_toplevel();
+	chew_toplevel();
+	checkpoint_open();
+	manifest_open();
+	cached = cache_open();
+	if (catching) {
+		SET_PUBLIC(exception,enabled) = GET_PUBLIC(args,keepgoing);
+		error = catch();
+	}
+	if (!error && !cached) {
+		cached = daemon_forward();
+	}
+	for (;!error && !cached && !input_eof() && !checkpoint_line();) {
+		line_type_t lineval;
+		STATS_LINE();
+		line_debug(0);
+		STATS_PHASE(STATS_LEX);
+		lineval = eval_line();
+		STATS_PHASE(STATS_WRITE);
+		if (!weed_categorical_directive(lineval)) {
+			transition(lineval);
+		}
+		TRACE(TRACE_TRANSITION,lineval,if_state(),if_depth());
+	}
+	STATS_LINES_END();
+	if (if_depth() && !error && input_eof()) {
+		early_eof();
+	}
+	if (catching) {
+		SET_PUBLIC(exception,enabled) = false;
+	}
+	/* Closing flushes the output */
+	STATS_PHASE(STATS_WRITE);
+	close_io(false);
+	STATS_PHASE(phase);
+}
+
+int
+process_stream(	char const *name,
+				FILE *input,
+				FILE *output,
+				FILE *diagnostics)
+{
+	volatile int error;
+	set_exit_flags(ALL_EXIT_FLAGS,false);
+	SET_PUBLIC(line_despatch,lines_dropped) = 0;
+	SET_PUBLIC(line_despatch,lines_changed) = 0;
+	SET_PUBLIC(line_despatch,lines_inserted) = 0;
+	divert_diagnostics(diagnostics);
+	io_use_streams(input,output);
+	SET_PUBLIC(exception,enabled) = true;
+	error = catch();
+	if (!error) {
+		process_file(name);
+	}
+	SET_PUBLIC(exception,enabled) = false;
+	io_use_streams(NULL,NULL);
+	divert_diagnostics(NULL);
+	return error;
+}
+
+/* EOF */
@@ -0,0 +1,91 @@
+#ifndef PROCESS_H
+#define PROCESS_H
+/***************************************************************************
+ *   Copyright (C) 2004, 2006 Symbian Software Ltd.                        *
+ *   All rights reserved.                                                  *
+ *   Copyright (C) 2007, 2008 Mike Kinghan, imk@strudl.org                 *
+ *   All rights reserved.                                                  *
+ *                                                                         *
+ *   Contributed originally by Mike Kinghan, imk@strudl.org                *
+ *                                                                         *
+ *   Redistribution and use in source and binary forms, with or without    *
+ *   modification, are permitted provided that the following conditions    *
+ *   are met:                                                              *
+ *                                                                         *
+ *   Redistributions of source code must retain the above copyright        *
+ *   notice, this list of conditions and the following disclaimer.         *
+ *                                                                         *
+ *   Redistributions in binary form must reproduce the above copyright     *
+ *   notice, this list of conditions and the following disclaimer in the   *
+ *   documentation and/or other materials provided with the distribution.  *
+ *                                                                         *
+ *   Neither the name of Symbian Software Ltd. nor the names of its        *
+ *   contributors may be used to endorse or promote products derived from  *
+ *   this software without specific prior written permission.              *
+ *                                                                         *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS   *
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT     *
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS    *
+ *   FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE        *
+ *   COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,   *
+ *   INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,  *
+ *   BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS *
+ *   OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED    *
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,*
+ *   OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF *
+ *   THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH  *
+ *   DAMAGE.                                                               *
+ *                                                                         *
+ ***************************************************************************/
+#include "opts.h"
+#include <stdio.h>
+
+/*!\ingroup process_module
+ *\file process.h
+ * This file provides the Process module interface.
+ *
+ *	The Process module processes a single input file. It is shared by
+ *	the \c sunifdef program, which processes the files of the input
+ *	dataset, and by the \c libsunifdef library and the \c --daemon server,
+ *	which process streams on behalf of callers.
+ */
+
+/*! \addtogroup process_module */
+/*@{*/
+
+/*! Process an input file, writing its output and diagnostics.
+
+	\param	filename	The name of the input file, or \c STDIN_NAME.
+
+	The file is read from the streams supplied by \c io_use_streams(),
+	if any; otherwise it is opened by name. If exceptions are not already
+	enabled by the caller then they are enabled for the file with
+	\c --keepgoing, so that a parse error abandons only this file.
+*/
+extern void
+process_file(char const *filename);
+
+/*! Process an input stream on behalf of a caller, starting afresh.
+
+	\param	name		The name of the input, for diagnostics.
+	\param	input		A readable and seekable stream of the input.
+	\param	output		The stream to which the output is written.
+	\param	diagnostics	NULL, or a stream to which diagnostics are
+						written instead of \c stderr.
+	\return	0 if the input is processed, else the reason code of the
+			error that abandoned it. The output is then incomplete.
+
+	The exit flags and the counts of lines dropped, changed and inserted
+	are reset beforehand, so that afterwards they reflect only this input.
+	Errors are caught, and abends are caught too if the exception module
+	is hosted. The streams belong to the caller.
+*/
+extern int
+process_stream(	char const *name,
+				FILE *input,
+				FILE *output,
+				FILE *diagnostics);
+
+/*@}*/
+
+#endif /* EOF */
@@ -0,0 +1,358 @@
+/***************************************************************************
+ *   Copyright (C) 2004, 2006 Symbian Software Ltd.                        *
+ *   All rights reserved.                                                  *
+ *   Copyright (C) 2007, 2008 Mike Kinghan, imk@strudl.org                 *
+ *   All rights reserved.                                                  *
+ *                                                                         *
+ *   Contributed originally by Mike Kinghan, imk@strudl.org                *
+ *                                                                         *
+ *   Redistribution and use in source and binary forms, with or without    *
+ *   modification, are permitted provided that the following conditions    *
+ *   are met:                                                              *
+ *                                                                         *
+ *   Redistributions of source code must retain the above copyright        *
+ *   notice, this list of conditions and the following disclaimer.         *
+ *                                                                         *
+ *   Redistributions in binary form must reproduce the above copyright     *
+ *   notice, this list of conditions and the following disclaimer in the   *
+ *   documentation and/or other materials provided with the distribution.  *
+ *                                                                         *
+ *   Neither the name of Symbian Software Ltd. nor the names of its        *
+ *   contributors may be used to endorse or promote products derived from  *
+ *   this software without specific prior written permission.              *
+ *                                                                         *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS   *
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT     *
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS    *
+ *   FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE        *
+ *   COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,   *
+ *   INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,  *
+ *   BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS *
+ *   OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED    *
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,*
+ *   OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF *
+ *   THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH  *
+ *   DAMAGE.                                                               *
+ *                                                                         *
+ ***************************************************************************/
+#include "profile.h"
+#include "args.h"
+#include "io.h"
+#include "memory.h"
+#include "ptr_vector.h"
+#include "symbol_table.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+/*!\ingroup profile_module, profile_interface, profile_internals
+ *\file profile.c
+ * This file implements the Profile module.
+ *
+ *	The symbols and the normalised expressions are kept in tables sorted
+ *	by key, like the symbol table, and looked up by binary search.
+ *	A symbol's standing in the symbol table is recorded when the symbol
+ *	is first looked up, since with \c --symbols unknown symbols are
+ *	added to the symbol table later.
+ */
+
+/*! \addtogroup profile_internals */
+/*@{*/
+
+/*! Enumeration of the standing of a symbol */
+typedef enum {
+	SYMBOL_DEFINED,		/*!< Defined by \c --define */
+	SYMBOL_UNDEFINED,	/*!< Undefined by \c --undef */
+	SYMBOL_UNKNOWN		/*!< Neither defined nor undefined */
+} symbol_standing_t;
+
+/*! The names of the standings of symbols, indexed by
+	\c symbol_standing_t */
+static char const * const standing_names[] = {
+	"defined",
+	"undefined",
+	"unknown"
+};
+
+/*! Structure of an entry in a table of symbols or expressions */
+typedef struct {
+	unsigned long count;	/*!< Lookups or evaluations */
+	unsigned long outcomes[PROFILE_OUTCOMES];	/*!< For an expression,
+													evaluations by outcome */
+	unsigned long short_circuited;	/*!< For an expression, evaluations
+										in which an operand was
+										short-circuited */
+	symbol_standing_t standing;	/*!< For a symbol, its standing */
+	char key[1];	/*!< The symbol or normalised expression, extended
+						as required */
+} profile_entry_t;
+
+/*@}*/
+
+/*! \addtogroup profile_internals_state_utils */
+/*@{*/
+
+/*! The state of the Profile module */
+STATE_DEF(profile) {
+	INCLUDE_PUBLIC(profile);	/*!< The public state of the Profile
+									module */
+	ptr_vector_h symbols;		/*!< The table of symbols */
+	ptr_vector_h expressions;	/*!< The table of expressions */
+	heap_str	buf;	/*!< Buffer in which expressions are normalised */
+	size_t		buf_size;	/*!< The size of \c buf */
+	FILE *	out;	/*!< NULL, or the file to which the report is
+						appended */
+} STATE_T(profile);
+
+IMPLEMENT(profile,USER_INITABLE);
+
+DEFINE_USER_INIT(profile)(STATE_T(profile) * profile_st)
+{
+	(void)profile_st;
+}
+
+DEFINE_USER_FINIS(profile)(STATE_T(profile) * profile_st)
+{
+	if (profile_st->symbols) {
+		ptr_vector_dispose(&profile_st->symbols);
+	}
+	if (profile_st->expressions) {
+		ptr_vector_dispose(&profile_st->expressions);
+	}
+	free(profile_st->buf);
+	if (profile_st->out) {
+		fclose(profile_st->out);
+	}
+}
+/*@}*/
+
+/*! \addtogroup profile_internals */
+/*@{*/
+
+/*! Find the entry for a key in a table, entering it if it is new.
+	\param	table	The table to search.
+	\param	key		The start of the key.
+	\param	len		The length of the key.
+	\param	is_new	Receives true if the entry is new, else false.
+	\return	The entry for the key.
+*/
+static profile_entry_t *
+find_entry(ptr_vector_h table, char const *key, size_t len, bool *is_new)
+{
+	size_t lo = 0;
+	size_t hi = ptr_vector_count(table);
+	profile_entry_t *entry;
+	while (lo < hi) {
+		size_t mid = lo + (hi - lo) / 2;
+		int comp;
+		entry = ptr_vector_at(table,mid);
+		comp = strncmp(key,entry->key,len);
+		if (comp == 0 && entry->key[len] != '\0') {
+			/* Key in table is longer than `key' */
+			comp = -1;
+		}
+		if (comp == 0) {
+			*is_new = false;
+			return entry;
+		}
+		if (comp < 0) {
+			hi = mid;
+		}
+		else {
+			lo = mid + 1;
+		}
+	}
+	entry = callocate(1,sizeof(profile_entry_t) + len);
+	memcpy(entry->key,key,len);
+	ptr_vector_insert(table,lo,entry);
+	*is_new = true;
+	return entry;
+}
+
+/*! Normalise an expression into the module's buffer, dropping comments
+	and whitespace except for one space where it separates two symbol
+	characters.
+	\param	text	The start of the expression.
+	\param	len		The length of the expression.
+	\return	The length of the normalised expression.
+*/
+static size_t
+normalise(char const *text, size_t len)
+{
+	char const *end = text + len;
+	size_t out = 0;
+	bool space = false;
+	if (len + 1 > GET_STATE(profile,buf_size)) {
+		SET_STATE(profile,buf_size) = len + 1;
+		SET_STATE(profile,buf) = reallocate(GET_STATE(profile,buf),len + 1);
+	}
+	while (text < end) {
+		if (text[0] == '/' && text + 1 < end && text[1] == '*') {
+			for (text += 2;
+				text + 1 < end && !(text[0] == '*' && text[1] == '/');
+				++text) {}
+			text += 2;
+			space = true;
+		}
+		else if (text[0] == '/' && text + 1 < end && text[1] == '/') {
+			break;
+		}
+		else if (isspace((unsigned char)*text)) {
+			++text;
+			space = true;
+		}
+		else {
+			if (space && out && symchar(SET_STATE(profile,buf)[out - 1]) &&
+				symchar(*text)) {
+				SET_STATE(profile,buf)[out++] = ' ';
+			}
+			SET_STATE(profile,buf)[out++] = *text++;
+			space = false;
+		}
+	}
+	return out;
+}
+
+/*! Compare two entries by descending count and then by key, for
+	\c qsort() */
+static int
+ranking(void const *lhs, void const *rhs)
+{
+	profile_entry_t const *l = *(profile_entry_t * const *)lhs;
+	profile_entry_t const *r = *(profile_entry_t * const *)rhs;
+	if (l->count != r->count) {
+		return l->count > r->count ? -1 : 1;
+	}
+	return strcmp(l->key,r->key);
+}
+
+/*! Rank the entries of a table.
+	\param	table	The table to rank.
+	\return	A heap array of the entries of \c table, ranked, or NULL if
+		the table is empty.
+*/
+static profile_entry_t **
+rank(ptr_vector_h table)
+{
+	size_t count = ptr_vector_count(table);
+	profile_entry_t **ranked;
+	if (!count) {
+		return NULL;
+	}
+	ranked = allocate(count * sizeof(profile_entry_t *));
+	memcpy(ranked,ptr_vector_start(table),count * sizeof(profile_entry_t *));
+	qsort(ranked,count,sizeof(profile_entry_t *),ranking);
+	return ranked;
+}
+
+/*! Write the ranked symbols */
+static void
+report_symbols(FILE *out)
+{
+	ptr_vector_h table = GET_STATE(profile,symbols);
+	profile_entry_t **ranked = rank(table);
+	size_t count = ptr_vector_count(table);
+	size_t i;
+	fprintf(out,"%12s  %-9s  %s\n","Lookups","Standing","Symbol");
+	for (i = 0; i < count; ++i) {
+		fprintf(out,"%12lu  %-9s  %s\n",ranked[i]->count,
+			standing_names[ranked[i]->standing],ranked[i]->key);
+	}
+	free(ranked);
+}
+
+/*! Write the ranked expressions */
+static void
+report_expressions(FILE *out)
+{
+	ptr_vector_h table = GET_STATE(profile,expressions);
+	profile_entry_t **ranked = rank(table);
+	size_t count = ptr_vector_count(table);
+	size_t i;
+	fprintf(out,"%12s %10s %10s %10s %10s  %s\n","Evaluations","True",
+		"False","Insoluble","Shorted","Expression");
+	for (i = 0; i < count; ++i) {
+		fprintf(out,"%12lu %10lu %10lu %10lu %10lu  %s\n",ranked[i]->count,
+			ranked[i]->outcomes[PROFILE_TRUE],
+			ranked[i]->outcomes[PROFILE_FALSE],
+			ranked[i]->outcomes[PROFILE_INSOLUBLE],
+			ranked[i]->short_circuited,ranked[i]->key);
+	}
+	free(ranked);
+}
+
+/*@}*/
+
+/* API ***************************************************************/
+
+void
+profile_start(void)
+{
+	if (GET_PUBLIC(args,profile_file)) {
+		SET_STATE(profile,out) = open_file(GET_PUBLIC(args,profile_file),"a");
+	}
+	SET_STATE(profile,symbols) = ptr_vector_new();
+	SET_STATE(profile,expressions) = ptr_vector_new();
+	SET_PUBLIC(profile,enabled) = true;
+}
+
+void
+profile_symbol(char const *name, size_t len, int symind)
+{
+	bool is_new;
+	profile_entry_t *entry =
+		find_entry(GET_STATE(profile,symbols),name,len,&is_new);
+	if (is_new) {
+		if (symind < 0) {
+			entry->standing = SYMBOL_UNKNOWN;
+		}
+		else if (SYMBOL(symind)->sym_def == NULL) {
+			entry->standing = SYMBOL_UNDEFINED;
+		}
+		else {
+			entry->standing = SYMBOL_DEFINED;
+		}
+	}
+	++entry->count;
+}
+
+void
+profile_expression(char const *text, size_t len, profile_outcome_t outcome,
+	bool short_circuited)
+{
+	bool is_new;
+	profile_entry_t *entry;
+	len = normalise(text,len);
+	entry = find_entry(GET_STATE(profile,expressions),GET_STATE(profile,buf),
+		len,&is_new);
+	++entry->count;
+	++entry->outcomes[outcome];
+	if (short_circuited) {
+		++entry->short_circuited;
+	}
+}
+
+void
+profile_report(void)
+{
+	FILE *out;
+	if (!GET_PUBLIC(profile,enabled)) {
+		return;
+	}
+	SET_PUBLIC(profile,enabled) = false;
+	if (GET_STATE(profile,out)) {
+		/* The FILE may be stdout by another name, e.g. /dev/stdout, so
+			let the output get there first */
+		fflush(stdout);
+	}
+	out = GET_STATE(profile,out) ? GET_STATE(profile,out) : stderr;
+	report_symbols(out);
+	report_expressions(out);
+	if (GET_STATE(profile,out)) {
+		fclose(GET_STATE(profile,out));
+		SET_STATE(profile,out) = NULL;
+	}
+}
+
+/* EOF */
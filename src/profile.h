@@ -0,0 +1,153 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+/***************************************************************************
+ *   Copyright (C) 2004, 2006 Symbian Software Ltd.                        *
+ *   All rights reserved.                                                  *
+ *   Copyright (C) 2007, 2008 Mike Kinghan, imk@strudl.org                 *
+ *   All rights reserved.                                                  *
+ *                                                                         *
+ *   Contributed originally by Mike Kinghan, imk@strudl.org                *
+ *                                                                         *
+ *   Redistribution and use in source and binary forms, with or without    *
+ *   modification, are permitted provided that the following conditions    *
+ *   are met:                                                              *
+ *                                                                         *
+ *   Redistributions of source code must retain the above copyright        *
+ *   notice, this list of conditions and the following disclaimer.         *
+ *                                                                         *
+ *   Redistributions in binary form must reproduce the above copyright     *
+ *   notice, this list of conditions and the following disclaimer in the   *
+ *   documentation and/or other materials provided with the distribution.  *
+ *                                                                         *
+ *   Neither the name of Symbian Software Ltd. nor the names of its        *
+ *   contributors may be used to endorse or promote products derived from  *
+ *   this software without specific prior written permission.              *
+ *                                                                         *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS   *
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT     *
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS    *
+ *   FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE        *
+ *   COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,   *
+ *   INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,  *
+ *   BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS *
+ *   OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED    *
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,*
+ *   OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF *
+ *   THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH  *
+ *   DAMAGE.                                                               *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "opts.h"
+#include "bool.h"
+#include <stddef.h>
+
+/*!\ingroup profile_module, profile_interface
+ *\file profile.h
+ * This file provides the Profile module interface.
+ *
+ *	With the \c --profile option the Profile module counts the lookups
+ *	of each symbol in \c #if, \c #ifdef and \c #ifndef directives and the
+ *	evaluations of each distinct \c #if and \c #elif expression, with
+ *	their outcomes, and at exit reports the symbols and the expressions
+ *	ranked by count. The symbols that are neither defined nor undefined
+ *	by \c --define and \c --undef, and the expressions that are never
+ *	resolved, are those that do not change the output.
+ *
+ *	Expressions are told apart after normalisation: comments and
+ *	whitespace are dropped, except for one space to separate two
+ *	identifiers or numbers.
+ */
+
+/*! \addtogroup profile_interface */
+/*@{*/
+
+/*! Enumeration of the outcomes of evaluating an expression */
+typedef enum {
+	PROFILE_TRUE,		/*!< The expression is true */
+	PROFILE_FALSE,		/*!< The expression is false */
+	PROFILE_INSOLUBLE,	/*!< The expression is neither true nor false */
+	PROFILE_OUTCOMES	/*!< The number of outcomes */
+} profile_outcome_t;
+
+/*! Count a lookup of a symbol if the \c --profile option is in force.
+	\param	name	The start of the symbol.
+	\param	len		The length of the symbol.
+	\param	symind	The value returned by \c find_sym() for the symbol.
+*/
+#define PROFILE_SYMBOL(name,len,symind) \
+	(GET_PUBLIC(profile,enabled) ? \
+		profile_symbol(name,len,symind) : (void)0)
+
+/*! Count an evaluation of an expression if the \c --profile option is
+	in force.
+	\param	text	The start of the expression.
+	\param	len		The length of the expression.
+	\param	outcome	The \c profile_outcome_t of the evaluation.
+	\param	shorts	The value of the public \c short_circuits before the
+					evaluation.
+*/
+#define PROFILE_EXPRESSION(text,len,outcome,shorts) \
+	(GET_PUBLIC(profile,enabled) ? \
+		profile_expression(text,len,outcome, \
+			GET_PUBLIC(profile,short_circuits) != (shorts)) : (void)0)
+
+/*! Count a short-circuited operand if the \c --profile option is in
+	force */
+#define PROFILE_SHORT_CIRCUIT() \
+	do { \
+		if (GET_PUBLIC(profile,enabled)) { \
+			++SET_PUBLIC(profile,short_circuits); \
+		} \
+	} while(0)
+
+/*! Start profiling.
+
+	The file to which the report is to be appended, if any, is opened
+	now so that it cannot fail at exit.
+*/
+extern void
+profile_start(void);
+
+/*! Count a lookup of a symbol.
+	\param	name	The start of the symbol.
+	\param	len		The length of the symbol.
+	\param	symind	The value returned by \c find_sym() for the symbol.
+
+	Call through \c PROFILE_SYMBOL().
+*/
+extern void
+profile_symbol(char const *name, size_t len, int symind);
+
+/*! Count an evaluation of an expression.
+	\param	text	The start of the expression.
+	\param	len		The length of the expression.
+	\param	outcome	The outcome of the evaluation.
+	\param	short_circuited	Was an operand short-circuited?
+
+	Call through \c PROFILE_EXPRESSION().
+*/
+extern void
+profile_expression(char const *text, size_t len, profile_outcome_t outcome,
+	bool short_circuited);
+
+/*! Write the report, if the \c --profile option is in force. */
+extern void
+profile_report(void);
+
+/*@}*/
+
+/*! \addtogroup profile_interface_state_utils */
+/*@{*/
+
+/*! The public state of the Profile module */
+PUBLIC_STATE_DEF(profile) {
+	bool enabled;	/*!< Is the \c --profile option in force? */
+	unsigned long short_circuits;	/*!< The count of operands
+										short-circuited */
+} PUBLIC_STATE_T(profile);
+
+IMPORT(profile);
+/*@}*/
+
+#endif /* EOF */
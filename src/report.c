@@ -36,6 +36,7 @@
  *                                                                         *
  ***************************************************************************/
 
+#define MEMORY_TAG	MEMORY_DIAGNOSTICS
 #include "opts.h"
 #include "platform.h"
 #include "report.h"
@@ -48,6 +49,12 @@
 #include "evaluator.h"
 #include "exception.h"
 #include "dataset.h"
+#include "cache.h"
+#include "profile.h"
+#include "stats.h"
+#include "timeline.h"
+#include "trace.h"
+#include "thread.h"
 #include <stdarg.h>
 #include <stdio.h>
 #include <string.h>
@@ -61,79 +68,6 @@
 /*! \addtogroup report_internals */
 /*@{*/
 
-/*! Prefixes for debugging names of the comment states */
-static char const * const comment_name[] = {
-	"NO","C","CXX",	"STARTING",	"FINISHING","PSEUDO"
-};
-
-/*! Prefixes for debugging names of the line states */
-static char const * const linestate_name[] = {
-	"VACANT","DIRECTIVE","CODE"
-};
-
-/*! Debugging names of the \c #if states */
-static char const * const ifstate_name[] = {
-	"OUTSIDE", "FALSE_PREFIX", "TRUE_PREFIX",
-	"PASS_MIDDLE", "FALSE_MIDDLE", "TRUE_MIDDLE",
-	"PASS_ELSE", "FALSE_ELSE", "TRUE_ELSE",
-	"FALSE_TRAILER"
-};
-
-/*! Debugging names of the input line types */
-static char const * const linetype_name[] = {
-	"TRUEI", "FALSEI", "IF", "TRUE", "FALSE",
-	"ELIF", "ELTRUE", "ELFALSE", "ELSE", "ENDIF",
-	"DODGY TRUEI", "DODGY FALSEI",
-	"DODGY IF", "DODGY TRUE", "DODGY FALSE",
-	"DODGY ELIF", "DODGY ELTRUE", "DODGY ELFALSE",
-	"DODGY ELSE", "DODGY ENDIF",
-	"PLAIN", "EOF",
-	"CONSISTENT DEFINE KEEP","CONSISTENT DEFINE DROP",
-	"CONTRADICTORY DEFINE","DIFFERING DEFINE",
-	"CONSISTENT UNDEF KEEP", "CONSISTENT UNDEF DROP",
-	"CONTRADICTORY UNDEF"
-};
-
-
-/*! Get the debugging name of the current comment state
- *	\return A pointer to the name in static storage.
- */
-static char const *
-get_comment_type_name(void)
-{
-	return comment_name[GET_PUBLIC(chew,comment_state)];
-}
-
-/*! Get the debugging name of the current line state
- *	\return A pointer to the name in static storage.
- */
-static char const *
-get_linestate_name(void)
-{
-	return linestate_name[GET_PUBLIC(chew,line_state)];
-}
-
-/*! Get the debugging name of the current \c #if state
- *	\return A pointer to the name in static storage.
- */
-static char const *
-if_state_name(void)
-{
-	return ifstate_name[if_state()];
-}
-
-/*! Get the debugging name of a line type.
- *
- *	\param	type	The line type whose name is wanted.
- *	\return	The debugging name of \em type.
- */
-static char const *
-get_linetype_name(line_type_t type)
-{
-	return linetype_name[type];
-}
-
-
 /*! Compose an output message.
 
 	The function interface is the same as that of
@@ -194,10 +128,14 @@ vreport(reason_code_t reason, heap_str *buf, const char *format, va_list argp);
 /*! \ingroup report_internals_state_utils */
 /*@{*/
 
+/*! The stream to which diagnostics are written */
+#define DIAGNOSTIC_STREAM\
+	(GET_STATE(diagnostic,stream) ? GET_STATE(diagnostic,stream) : stderr)
+
 /*! The global state of the Diagnostic module */
 STATE_DEF(diagnostic) {
-	bool		dbg; /*!< Is --debug enabled? */
 	unsigned int	exitstat; /*!< Program exit status */
+	FILE *		stream; /*!< NULL, or the stream that replaces \c stderr */
 } STATE_T(diagnostic);
 /*@}*/
 
@@ -227,7 +165,7 @@ vreport(reason_code_t reason, heap_str *bufp, const char *format, va_list argp)
 		assert(bufp);
 		if (*bufp) {
 			char *mess = *bufp;
-			fputs(mess,stderr);
+			fputs(mess,DIAGNOSTIC_STREAM);
 			release((void **)bufp);
 		}
 	}
@@ -238,7 +176,7 @@ vreport(reason_code_t reason, heap_str *bufp, const char *format, va_list argp)
 		int msgclass = MSGCLASS_NONE;
 		size_t depth = if_depth();
 		if (!bufp) {
-			dest = stderr;
+			dest = DIAGNOSTIC_STREAM;
 			buflen = -1;
 		}
 		else {
@@ -467,6 +405,17 @@ give_up_confused(void)
 void
 vbail(int reason, const char *msg, va_list argp)
 {
+	thread_trap_t *trap = thread_get_trap();
+	if (trap) {
+		/* Leave the error to the thread that awaits this one */
+		trap->reason = reason;
+		trap->msg[0] = '\0';
+		if (msg) {
+			vsnprintf(trap->msg,sizeof(trap->msg),msg,argp);
+			trap->msg[sizeof(trap->msg) - 1] = '\0';
+		}
+		longjmp(trap->context,1);
+	}
 	close_io(true);
 	if (msg) {
 		vreport(reason,NULL,msg,argp);
@@ -474,7 +423,8 @@ vbail(int reason, const char *msg, va_list argp)
 	else {
 		SET_STATE(diagnostic,exitstat) |= reason & MSGEVENT_MASK;
 	}
-	if (exceptions_enabled && ((reason & MSGEVENT_MASK) != MSGCLASS_ABEND)) {
+	if (GET_PUBLIC(exception,enabled) && (GET_PUBLIC(exception,hosted) ||
+		(reason & MSGEVENT_MASK) != MSGCLASS_ABEND)) {
 		throw(reason);
 	}
 	exit(exitcode());
@@ -491,123 +441,22 @@ bail(int reason, const char *format,...)
 }
 
 void
-debugging(bool on)
+divert_diagnostics(FILE *stream)
 {
-	SET_STATE(diagnostic,dbg) = on;
-}
-
-void
-debug(dbg_code_t how,...)
-{
-	if (GET_STATE(diagnostic,dbg)) {
-		va_list ap;
-		va_start(ap, how);
-		switch(how)
-		{
-		case DBG_1:
-			vreport(MSGCLASS_NONE,NULL,"eval%d !",ap);
-			break;
-		case DBG_2:
-			vreport(MSGCLASS_NONE,NULL,"eval%d (",ap);
-			break;
-		case DBG_3:
-			vreport(MSGCLASS_NONE,NULL,"eval%d number",ap);
-			break;
-		case DBG_4:
-			vreport(MSGCLASS_NONE,NULL,"eval%d defined",ap);
-			break;
-		case DBG_5:
-			vreport(MSGCLASS_NONE,NULL,"eval%d symbol",ap);
-			break;
-		case DBG_6:
-			vreport(MSGCLASS_NONE,NULL,"eval%d bad expr",ap);
-			break;
-		case DBG_7:
-			vreport(MSGCLASS_NONE,NULL,"eval%d = %d",ap);
-			break;
-		case DBG_8:
-			vreport(MSGCLASS_NONE,NULL,"eval%d",ap);
-			break;
-		case DBG_9:
-			vreport(MSGCLASS_NONE,NULL,"eval%d %s",ap);
-			break;
-		case DBG_10:
-			vreport(MSGCLASS_NONE,NULL,"eval%d = %d",ap);
-			break;
-		case DBG_11:
-			vreport(MSGCLASS_NONE,NULL,"eval %s",ap);
-			break;
-		case DBG_12:
-			vreport(MSGCLASS_NONE,NULL,"eval = %d",ap);
-			break;
-		case DBG_13:
-			vreport(MSGCLASS_NONE,NULL,"eval #define %.*s",ap);
-			break;
-		case DBG_14:
-		{
-			size_t safelen = va_arg(ap,size_t);
-			char const * define = va_arg(ap,char const *);
-			int linetype = va_arg(ap,int);
-			char const * const linetype_name = get_linetype_name(linetype);
-			report(MSGCLASS_NONE,NULL,"eval #define %.*s = %s",
-				safelen,define,linetype_name);
-			break;
-		}
-		case DBG_15:
-			vreport(MSGCLASS_NONE,NULL,"eval #undef %.*s",ap);
-			break;
-		case DBG_16:
-		{
-			size_t safelen = va_arg(ap,size_t);
-			char const * define = va_arg(ap,char const *);
-			int linetype = va_arg(ap,int);
-			char const * const linetype_name = get_linetype_name(linetype);
-			report(MSGCLASS_NONE,NULL,"eval #undef %.*s = %s",
-				safelen,define,linetype_name);
-			break;
-		}
-		case DBG_17:
-			report(MSGCLASS_NONE,NULL,"parser %s comment %s line",
-				get_comment_type_name(), get_linestate_name());
-			break;
-		case DBG_18:
-			vreport(MSGCLASS_NONE,NULL,"find_sym %s %s",ap);
-			break;
-		case DBG_19:
-		{
-			int linetype = va_arg(ap,int);
-			report(MSGCLASS_NONE,NULL,"process %s -> %s depth %d",
-		    	get_linetype_name(linetype),
-		    	if_state_name(),
-				if_depth());
-			break;
-		}
-		case DBG_20:
-			vreport(MSGCLASS_NONE,NULL,"eval%d +",ap);
-			break;
-		case DBG_21:
-			vreport(MSGCLASS_NONE,NULL,"eval%d -",ap);
-			break;
-		case DBG_22:
-			vreport(MSGCLASS_NONE,NULL,"eval%d ~",ap);
-			break;
-		default:
-			assert(false);
-		}
-		va_end(ap);
-	}
+	SET_STATE(diagnostic,stream) = stream;
 }
 
 void
 exit_diagnostics(void)
 {
-	size_t infiles =
-		file_tree_count(GET_PUBLIC(dataset,file_tree),FT_COUNT_FILES,NULL);
+	size_t infiles;
 	unsigned donefiles = GET_PUBLIC(dataset,donefiles);
 	unsigned errorfiles = GET_PUBLIC(dataset,errorfiles);
 	char * diagnostic_status = "";
 
 	int ret = exitcode();
+	dataset_halt();
+	infiles = dataset_count();
 	if_control_toplevel();
 	io_toplevel();
 
@@ -633,6 +482,7 @@ exit_diagnostics(void)
 			"%d out %d files reached were valid; "
 			"%d were abandoned due to parse errors",
 			donefiles - errorfiles,donefiles,errorfiles);
+		cache_report();
 		if (infiles == donefiles && errorfiles == 0) {
 			if (GET_STATE(diagnostic,exitstat) &
 				EVENT_SUMMARY_DROPPED_LINES & ISSUE_MASK) {
@@ -656,6 +506,10 @@ exit_diagnostics(void)
 			}
 		}
 	}
+	timeline_finish();
+	stats_report();
+	profile_report();
+	trace_dump();
 }
 
 void
@@ -41,6 +41,7 @@
 
 #include "opts.h"
 #include "bool.h"
+#include <stdio.h>
 #include <stddef.h>
 #include <stdarg.h>
 
@@ -126,6 +127,16 @@ typedef enum {
 	PROGRESS_FILE_TALLY = (53 << PROGRESS_SHIFT) | MSGCLASS_PROGRESS,
 		/*! Report a commandline argument parsed */
 	PROGRESS_GOT_OPTIONS = (54 << PROGRESS_SHIFT) | MSGCLASS_PROGRESS,
+		/*! Report resuming an input file from a checkpoint */
+	PROGRESS_RESUMING = (62 << PROGRESS_SHIFT) | MSGCLASS_PROGRESS,
+		/*! Report splicing previous output at a checkpoint */
+	PROGRESS_SPLICING = (63 << PROGRESS_SHIFT) | MSGCLASS_PROGRESS,
+		/*! Report skipping an input file that is in the manifest */
+	PROGRESS_UNCHANGED = (64 << PROGRESS_SHIFT) | MSGCLASS_PROGRESS,
+		/*! Report serving clients with \c --daemon */
+	PROGRESS_SERVING = (67 << PROGRESS_SHIFT) | MSGCLASS_PROGRESS,
+		/*! Report watching directories with \c --watch */
+	PROGRESS_WATCHING = (68 << PROGRESS_SHIFT) | MSGCLASS_PROGRESS,
 
 
 	/*! The progress summaries bitfield is offset this amount. */
@@ -138,6 +149,9 @@ typedef enum {
 		(56 << PROGRESS_SUMMARY_SHIFT) | MSGCLASS_INFO | MSGCLASS_SUMMARY,
 	PROGRESS_SUMMARY_ALL_DONE =
 		(57 << PROGRESS_SUMMARY_SHIFT) | MSGCLASS_PROGRESS | MSGCLASS_SUMMARY,
+		/*! Report files found in and added to the output cache */
+	PROGRESS_SUMMARY_CACHE =
+		(65 << PROGRESS_SUMMARY_SHIFT) | MSGCLASS_INFO | MSGCLASS_SUMMARY,
 
 	/*! The gripes bitfield is offset this amount */
 	GRIPE_SHIFT = 4,
@@ -195,14 +209,14 @@ typedef enum {
 	GRIPE_DIR_IGNORED = (41 << GRIPE_SHIFT) | MSGCLASS_WARNING,
 	/*! An integer constant evaluates > INT_MAX */
 	GRIPE_INT_OVERFLOW = (60 << GRIPE_SHIFT | MSGCLASS_WARNING),
-	/* MAX REASON = 60. When you add a new gripe, you must give it
-		it the MAX GRIPE gripe number, increment MAX REASON in this
-		comment and move this comment adjacent to your new gripe
-	   The maximum reason */
 
 	/*! A symbol that evaluates to an empty string is an
 		operand in an expression */
 	GRIPE_EMPTY_SYMBOL = (58 << GRIPE_SHIFT) | MSGCLASS_WARNING,
+	/*! Changes were lost by \c --watch, so directories are searched again */
+	GRIPE_WATCH_OVERFLOW = (70 << GRIPE_SHIFT) | MSGCLASS_WARNING,
+	/*! \c --debug was given to a build without tracing */
+	GRIPE_NO_TRACE = (71 << GRIPE_SHIFT) | MSGCLASS_WARNING,
 	/*! An orphan \c #elif was found in input */
 	GRIPE_ORPHAN_ELIF = (8 << GRIPE_SHIFT) | MSGCLASS_ERROR,
 	/*! An orphan \c #else was found in input */
@@ -272,36 +286,20 @@ typedef enum {
 	/*! Cannot open directory */
 	GRIPE_CANT_OPEN_DIR = (42 << GRIPE_SHIFT) | MSGCLASS_ABEND,
 	/*! Read error on directory */
-	GRIPE_CANT_READ_DIR = (43 << GRIPE_SHIFT) | MSGCLASS_ABEND
+	GRIPE_CANT_READ_DIR = (43 << GRIPE_SHIFT) | MSGCLASS_ABEND,
+	/*! Cannot start a thread */
+	GRIPE_CANT_START_THREAD = (61 << GRIPE_SHIFT) | MSGCLASS_ABEND,
+	/*! Cannot serve on or connect to a socket */
+	GRIPE_CANT_USE_SOCKET = (66 << GRIPE_SHIFT) | MSGCLASS_ABEND,
+	/*! Cannot watch a directory for changes */
+	GRIPE_CANT_WATCH = (69 << GRIPE_SHIFT) | MSGCLASS_ABEND
+	/* MAX REASON = 71. When you add a new gripe, you must give it
+		it the MAX GRIPE gripe number, increment MAX REASON in this
+		comment and move this comment adjacent to your new gripe
+	   The maximum reason */
 
 } reason_code_t;
 
-/*! Arbitary codes to select the behaviour of the \c debug() function */
-typedef enum {
-	DBG_1 = 1,
-	DBG_2,
-	DBG_3,
-	DBG_4,
-	DBG_5,
-	DBG_6,
-	DBG_8,
-	DBG_7,
-	DBG_9,
-	DBG_10,
-	DBG_11,
-	DBG_12,
-	DBG_13,
-	DBG_14,
-	DBG_15,
-	DBG_16,
-	DBG_17,
-	DBG_18,
-	DBG_19,
-	DBG_20,
-	DBG_21,
-	DBG_22
-} dbg_code_t;
-
 /*! Set or clear event summary or severity flags in the exit status.
 	\param bits		The bits to be set or cleared
 	\param set		If \em true, then \em bits are set in the
@@ -474,18 +472,12 @@ vbail(int reason, const char *msg, va_list argp);
 extern void
 bail(int retcode, const char *format,...);
 
-/*! Turn debugging output on or off
- *	\param on	If \em true, debugging output is enabled; otherwise disabled.
- */
-extern void
-debugging(bool on);
-
-/*! Write debugging info on \c stderr.
- * \param how	A code that selects how the function will compose
- *	debugging output from the subsequent arguments.
+/*! Write diagnostics to a stream instead of \c stderr
+ *	\param stream	The stream to which diagnostics are written, or NULL
+ *	to write them to \c stderr.
  */
 extern void
-debug(dbg_code_t how,...);
+divert_diagnostics(FILE *stream);
 
 /*! Write summary diagnostics on \c stderr at exit.
  *	The summary diagnostics will be output unless \c --gag \c summary
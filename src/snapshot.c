@@ -0,0 +1,516 @@
+/***************************************************************************
+ *   Copyright (C) 2004, 2006 Symbian Software Ltd.                        *
+ *   All rights reserved.                                                  *
+ *   Copyright (C) 2007, 2008 Mike Kinghan, imk@strudl.org                 *
+ *   All rights reserved.                                                  *
+ *                                                                         *
+ *   Contributed originally by Mike Kinghan, imk@strudl.org                *
+ *                                                                         *
+ *   Redistribution and use in source and binary forms, with or without    *
+ *   modification, are permitted provided that the following conditions    *
+ *   are met:                                                              *
+ *                                                                         *
+ *   Redistributions of source code must retain the above copyright        *
+ *   notice, this list of conditions and the following disclaimer.         *
+ *                                                                         *
+ *   Redistributions in binary form must reproduce the above copyright     *
+ *   notice, this list of conditions and the following disclaimer in the   *
+ *   documentation and/or other materials provided with the distribution.  *
+ *                                                                         *
+ *   Neither the name of Symbian Software Ltd. nor the names of its        *
+ *   contributors may be used to endorse or promote products derived from  *
+ *   this software without specific prior written permission.              *
+ *                                                                         *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS   *
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT     *
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS    *
+ *   FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE        *
+ *   COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,   *
+ *   INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,  *
+ *   BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS *
+ *   OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED    *
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,*
+ *   OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF *
+ *   THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH  *
+ *   DAMAGE.                                                               *
+ *                                                                         *
+ ***************************************************************************/
+#define MEMORY_TAG	MEMORY_FILE_TREE
+#include "snapshot.h"
+#include "memory.h"
+#include "platform.h"
+#include "report.h"
+#include "thread.h"
+#include "hash.h"
+#include "io.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <ctype.h>
+#include <string.h>
+#include <time.h>
+
+/*!\ingroup snapshot_module snapshot_interface snapshot_internals
+ *\file snapshot.c
+ * This file implements the Snapshot module
+ */
+
+/*! \addtogroup snapshot_internals */
+/*@{*/
+
+/*! The first line of a snapshot file */
+#define SNAPSHOT_MAGIC	"sunifdef snapshot 1\n"
+
+/*! The longest leafname or directory name accepted from a snapshot file */
+#define SNAPSHOT_MAX_NAME	65536
+
+/*! Structure of an entry in the listing of a directory */
+typedef struct snapshot_entry {
+	size_t name;			/*!< The offset of the leafname in the
+								names of the listing */
+	size_t len;				/*!< The length of the leafname */
+	fs_obj_type_t type;		/*!< The type of the entry */
+} snapshot_entry_t;
+
+/*! Structure of the listing of a directory */
+struct snapshot_listing {
+	heap_str dirname;		/*!< The real name of the directory */
+	fs_stamp_t stamp;		/*!< The stamp of the directory when listed */
+	long listed;			/*!< The time at which it was listed */
+	char *names;			/*!< The leafnames of the entries, each
+								nul-terminated */
+	size_t names_len;		/*!< Bytes used in \c names */
+	size_t names_size;		/*!< Capacity of \c names */
+	snapshot_entry_t *entries;	/*!< The entries, in the order read */
+	size_t count;			/*!< The number of entries */
+	size_t size;			/*!< Capacity of \c entries */
+	bool used;				/*!< Has the listing been found current or
+								recorded since the snapshot was loaded? */
+	struct snapshot_listing *next;	/*!< The next listing replaced in the
+										snapshot, or NULL */
+};
+
+/*! Structure of a snapshot */
+struct snapshot {
+	snapshot_listing_h *slots;	/*!< Hash table, with open addressing, of
+									the listings by directory name. NULL
+									marks an empty slot */
+	size_t size;			/*!< The number of slots, a power of 2 */
+	size_t count;			/*!< The number of listings */
+	snapshot_listing_h replaced;	/*!< Listings replaced by newer ones.
+										They are kept until the snapshot
+										is disposed, as another thread may
+										still be reading one */
+	thread_lock_t lock;		/*!< Lock on the snapshot */
+};
+
+/*! Dispose of a listing */
+static void
+listing_dispose(snapshot_listing_h listing)
+{
+	free(listing->dirname);
+	free(listing->names);
+	free(listing->entries);
+	free(listing);
+}
+
+/*! Dispose of all the listings in a snapshot, leaving it empty */
+static void
+clear(snapshot_h snap)
+{
+	size_t i;
+	for (i = 0; i < snap->size; ++i) {
+		if (snap->slots[i]) {
+			listing_dispose(snap->slots[i]);
+		}
+	}
+	while (snap->replaced) {
+		snapshot_listing_h next = snap->replaced->next;
+		listing_dispose(snap->replaced);
+		snap->replaced = next;
+	}
+	free(snap->slots);
+	snap->slots = NULL;
+	snap->size = snap->count = 0;
+}
+
+/*! Say whether two directory stamps are the same */
+static bool
+same_stamp(fs_stamp_t const *lhs, fs_stamp_t const *rhs)
+{
+	return lhs->device == rhs->device && lhs->inode == rhs->inode &&
+		lhs->mtime == rhs->mtime && lhs->mtime_ns == rhs->mtime_ns;
+}
+
+/*! Get the slot of a directory in a snapshot.
+	\return	The slot that holds the listing of \c dirname, or the empty
+			slot at which it would be inserted.
+ */
+static snapshot_listing_h *
+find_slot(snapshot_h snap, char const *dirname)
+{
+	size_t mask = snap->size - 1;
+	size_t slot = (size_t)hash_str(HASH_INIT,dirname) & mask;
+	for (	;snap->slots[slot]; slot = (slot + 1) & mask) {
+		if (!strcmp(snap->slots[slot]->dirname,dirname)) {
+			break;
+		}
+	}
+	return snap->slots + slot;
+}
+
+/*! Insert a listing into a snapshot, replacing any listing of the same
+	directory. The table is kept at most half full.
+	\return	False if the table cannot be grown for want of memory.
+
+	The function does not bail, as it is called with the lock held.
+ */
+static bool
+insert(snapshot_h snap, snapshot_listing_h listing)
+{
+	snapshot_listing_h *slot;
+	if ((snap->count + 1) * 2 > snap->size) {
+		snapshot_listing_h *old = snap->slots;
+		size_t old_size = snap->size;
+		size_t size = old_size ? old_size * 2 : 64;
+		size_t i;
+		snapshot_listing_h *slots = calloc(size,sizeof(snapshot_listing_h));
+		if (!slots) {
+			return false;
+		}
+		snap->size = size;
+		snap->slots = slots;
+		for (i = 0; i < old_size; ++i) {
+			if (old[i]) {
+				*find_slot(snap,old[i]->dirname) = old[i];
+			}
+		}
+		free(old);
+	}
+	slot = find_slot(snap,listing->dirname);
+	if (*slot) {
+		(*slot)->next = snap->replaced;
+		snap->replaced = *slot;
+	}
+	else {
+		++snap->count;
+	}
+	*slot = listing;
+	return true;
+}
+
+/*! Structure of the contents of a snapshot file being parsed */
+typedef struct reader {
+	char *pos;			/*!< The next character to be parsed */
+	char const *end;	/*!< The end of the contents, which are
+							nul-terminated */
+} reader_t;
+
+/*! Parse a number, followed by a space or newline, from a
+	snapshot file.
+	\param	in		The contents being parsed.
+	\param	value	Receives the number.
+	\return	True iff a number is parsed.
+ */
+static bool
+read_number(reader_t *in, long *value)
+{
+	char *after;
+	if (!isdigit((unsigned char)*in->pos) && *in->pos != '-') {
+		return false;
+	}
+	*value = strtol(in->pos,&after,10);
+	if (after == in->pos || (*after != ' ' && *after != '\n')) {
+		return false;
+	}
+	in->pos = after + 1;
+	return true;
+}
+
+/*! Parse a length-prefixed name, followed by a newline, from a
+	snapshot file.
+	\param	in		The contents being parsed.
+	\param	len		Receives the length of the name.
+	\return	The name, within the contents, or NULL if it is ill-formed.
+ */
+static char *
+read_name(reader_t *in, size_t *len)
+{
+	long name_len;
+	char *name;
+	if (!read_number(in,&name_len) || name_len <= 0 ||
+		name_len > SNAPSHOT_MAX_NAME ||
+		name_len >= in->end - in->pos) {
+		return NULL;
+	}
+	name = in->pos;
+	if (name[name_len] != '\n' || memchr(name,'\0',name_len)) {
+		return NULL;
+	}
+	in->pos += name_len + 1;
+	*len = name_len;
+	return name;
+}
+
+/*! Parse a keyword, followed by a space, from a snapshot file */
+static bool
+read_keyword(reader_t *in, char const *keyword)
+{
+	size_t len = strlen(keyword);
+	if (strncmp(in->pos,keyword,len) || in->pos[len] != ' ') {
+		return false;
+	}
+	in->pos += len + 1;
+	return true;
+}
+
+/*! Write a length-prefixed name to a snapshot file */
+static void
+write_name(FILE *out, char const *name, size_t len)
+{
+	fprintf(out,"%lu ",(unsigned long)len);
+	fwrite(name,1,len,out);
+	fputc('\n',out);
+}
+
+/*! Read the listings from a snapshot file into a snapshot.
+	\return	True iff the file is well formed.
+ */
+static bool
+read_listings(snapshot_h snap, reader_t *in)
+{
+	long dirs, d;
+	if (strncmp(in->pos,SNAPSHOT_MAGIC,sizeof(SNAPSHOT_MAGIC) - 1)) {
+		return false;
+	}
+	in->pos += sizeof(SNAPSHOT_MAGIC) - 1;
+	if (!read_keyword(in,"dirs") || !read_number(in,&dirs)) {
+		return false;
+	}
+	for (d = 0; d < dirs; ++d) {
+		snapshot_listing_h listing;
+		fs_stamp_t stamp;
+		long device, inode, listed, count, i;
+		size_t len;
+		char *name;
+		if (!read_keyword(in,"dir") ||
+			!read_number(in,&device) || !read_number(in,&inode) ||
+			!read_number(in,&stamp.mtime) || !read_number(in,&stamp.mtime_ns) ||
+			!read_number(in,&listed) || !read_number(in,&count) ||
+			(name = read_name(in,&len)) == NULL) {
+			return false;
+		}
+		stamp.size = 0;
+		stamp.device = (unsigned long)device;
+		stamp.inode = (unsigned long)inode;
+		name[len] = '\0';
+		listing = snapshot_listing_new(name,&stamp);
+		listing->listed = listed;
+		if (!insert(snap,listing)) {
+			bail(GRIPE_OUT_OF_MEMORY,"Out of memory");
+		}
+		for (i = 0; i < count; ++i) {
+			long type;
+			if (!read_number(in,&type) || type < FS_OBJ_NONE ||
+				type > (FS_OBJ_SLINK | FS_OBJ_FILE | FS_OBJ_DIR) ||
+				(name = read_name(in,&len)) == NULL ||
+				memchr(name,PATH_DELIM,len)) {
+				return false;
+			}
+			snapshot_listing_add(listing,name,len,(fs_obj_type_t)type);
+		}
+	}
+	return in->pos == in->end;
+}
+
+/*! Write a listing to a snapshot file */
+static void
+write_listing(FILE *out, snapshot_listing_h listing)
+{
+	size_t i;
+	fprintf(out,"dir %ld %ld %ld %ld %ld %lu ",
+		(long)listing->stamp.device,(long)listing->stamp.inode,
+		listing->stamp.mtime,listing->stamp.mtime_ns,
+		listing->listed,(unsigned long)listing->count);
+	write_name(out,listing->dirname,strlen(listing->dirname));
+	for (i = 0; i < listing->count; ++i) {
+		snapshot_entry_t const *entry = listing->entries + i;
+		fprintf(out,"%d ",(int)entry->type);
+		write_name(out,listing->names + entry->name,entry->len);
+	}
+}
+
+/*@}*/
+
+/* API ***************************************************************/
+
+snapshot_h
+snapshot_load(char const *filename)
+{
+	snapshot_h snap = callocate(1,sizeof(struct snapshot));
+	FILE *in = fopen(filename,"rb");
+	snap->lock = thread_lock_new();
+	if (in) {
+		reader_t reader;
+		heap_str contents;
+		long size;
+		fseek(in,0,SEEK_END);
+		size = ftell(in);
+		fseek(in,0,SEEK_SET);
+		if (size < 0) {
+			size = 0;
+		}
+		contents = allocate(size + 1);
+		if (fread(contents,1,size,in) != (size_t)size) {
+			size = 0;
+		}
+		fclose(in);
+		contents[size] = '\0';
+		reader.pos = contents;
+		reader.end = contents + size;
+		if (!read_listings(snap,&reader)) {
+			/* Forget a damaged snapshot */
+			clear(snap);
+		}
+		free(contents);
+	}
+	return snap;
+}
+
+void
+snapshot_save(snapshot_h snap, char const *filename)
+{
+	size_t namelen = strlen(filename);
+	heap_str tempname = allocate(namelen + sizeof("_XXXXXX"));
+	unsigned long dirs = 0;
+	size_t i;
+	FILE *out;
+	strcpy(tempname,filename);
+	strcpy(tempname + namelen,"_XXXXXX");
+	if (!fs_tempname(tempname)) {
+		bail(GRIPE_NO_TEMPFILE,"Cannot create temporary file");
+	}
+	out = open_file(tempname,"wb");
+	for (i = 0; i < snap->size; ++i) {
+		dirs += snap->slots[i] && snap->slots[i]->used;
+	}
+	fprintf(out,"%sdirs %lu\n",SNAPSHOT_MAGIC,dirs);
+	for (i = 0; i < snap->size; ++i) {
+		if (snap->slots[i] && snap->slots[i]->used) {
+			write_listing(out,snap->slots[i]);
+		}
+	}
+	if (fclose(out)) {
+		remove(tempname);
+		bail(GRIPE_CANT_WRITE_FILE,"Write error on file %s",tempname);
+	}
+	if (rename(tempname,filename)) {
+		remove(tempname);
+		bail(GRIPE_CANT_RENAME_FILE,
+			"Cannot rename file \"%s\" as \"%s\"",tempname,filename);
+	}
+	free(tempname);
+}
+
+void
+snapshot_dispose(snapshot_h *snap)
+{
+	if (*snap) {
+		clear(*snap);
+		thread_lock_dispose(&(*snap)->lock);
+		free(*snap);
+		*snap = NULL;
+	}
+}
+
+snapshot_listing_h
+snapshot_find(snapshot_h snap, char const *dirname, fs_stamp_t const *stamp)
+{
+	snapshot_listing_h listing = NULL;
+	thread_lock(snap->lock);
+	if (snap->count) {
+		listing = *find_slot(snap,dirname);
+		/* A directory modified in the second in which it was listed
+			may have been modified after it was listed */
+		if (listing && same_stamp(&listing->stamp,stamp) &&
+			listing->stamp.mtime < listing->listed) {
+			listing->used = true;
+		}
+		else {
+			listing = NULL;
+		}
+	}
+	thread_unlock(snap->lock);
+	return listing;
+}
+
+snapshot_listing_h
+snapshot_listing_new(char const *dirname, fs_stamp_t const *stamp)
+{
+	snapshot_listing_h listing = callocate(1,sizeof(struct snapshot_listing));
+	size_t len = strlen(dirname);
+	listing->dirname = allocate(len + 1);
+	memcpy(listing->dirname,dirname,len + 1);
+	listing->stamp = *stamp;
+	listing->listed = (long)time(NULL);
+	return listing;
+}
+
+void
+snapshot_listing_add(	snapshot_listing_h listing,
+						char const *leafname,
+						size_t len,
+						fs_obj_type_t type)
+{
+	snapshot_entry_t *entry;
+	if (listing->count == listing->size) {
+		listing->size = listing->size ? listing->size * 2 : 16;
+		listing->entries = reallocate(listing->entries,
+			listing->size * sizeof(snapshot_entry_t));
+	}
+	while (listing->names_len + len + 1 > listing->names_size) {
+		listing->names_size =
+			listing->names_size ? listing->names_size * 2 : 256;
+		listing->names = reallocate(listing->names,listing->names_size);
+	}
+	entry = listing->entries + listing->count++;
+	entry->name = listing->names_len;
+	entry->len = len;
+	entry->type = type;
+	memcpy(listing->names + listing->names_len,leafname,len);
+	listing->names[listing->names_len + len] = '\0';
+	listing->names_len += len + 1;
+}
+
+void
+snapshot_record(snapshot_h snap, snapshot_listing_h *listing)
+{
+	bool inserted;
+	(*listing)->used = true;
+	thread_lock(snap->lock);
+	inserted = insert(snap,*listing);
+	thread_unlock(snap->lock);
+	if (!inserted) {
+		bail(GRIPE_OUT_OF_MEMORY,"Out of memory");
+	}
+	*listing = NULL;
+}
+
+size_t
+snapshot_listing_count(snapshot_listing_h listing)
+{
+	return listing->count;
+}
+
+char const *
+snapshot_listing_entry(	snapshot_listing_h listing,
+						size_t which,
+						size_t *len,
+						fs_obj_type_t *type)
+{
+	snapshot_entry_t const *entry = listing->entries + which;
+	*len = entry->len;
+	*type = entry->type;
+	return listing->names + entry->name;
+}
+
+/* EOF */
@@ -0,0 +1,166 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+/***************************************************************************
+ *   Copyright (C) 2004, 2006 Symbian Software Ltd.                        *
+ *   All rights reserved.                                                  *
+ *   Copyright (C) 2007, 2008 Mike Kinghan, imk@strudl.org                 *
+ *   All rights reserved.                                                  *
+ *                                                                         *
+ *   Contributed originally by Mike Kinghan, imk@strudl.org                *
+ *                                                                         *
+ *   Redistribution and use in source and binary forms, with or without    *
+ *   modification, are permitted provided that the following conditions    *
+ *   are met:                                                              *
+ *                                                                         *
+ *   Redistributions of source code must retain the above copyright        *
+ *   notice, this list of conditions and the following disclaimer.         *
+ *                                                                         *
+ *   Redistributions in binary form must reproduce the above copyright     *
+ *   notice, this list of conditions and the following disclaimer in the   *
+ *   documentation and/or other materials provided with the distribution.  *
+ *                                                                         *
+ *   Neither the name of Symbian Software Ltd. nor the names of its        *
+ *   contributors may be used to endorse or promote products derived from  *
+ *   this software without specific prior written permission.              *
+ *                                                                         *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS   *
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT     *
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS    *
+ *   FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE        *
+ *   COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,   *
+ *   INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,  *
+ *   BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS *
+ *   OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED    *
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,*
+ *   OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF *
+ *   THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH  *
+ *   DAMAGE.                                                               *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "filesys.h"
+#include "bool.h"
+#include <stddef.h>
+
+/*!\ingroup snapshot_module, snapshot_interface
+ *\file snapshot.h
+ * This file provides the Snapshot module interface.
+ *
+ *	A snapshot records the listing of each directory searched, with the
+ *	identity and modification time of the directory when it was listed.
+ *	It is saved in a file at the end of a run and loaded at the start of
+ *	the next, so that a directory that has not been modified since it
+ *	was listed need not be read again.
+ */
+
+/*! \addtogroup snapshot_interface */
+/*@{*/
+
+/*! Abstract type of a directory snapshot */
+typedef struct snapshot * snapshot_h;
+
+/*! Abstract type of the listing of a directory in a snapshot */
+typedef struct snapshot_listing * snapshot_listing_h;
+
+/*! Load a snapshot from a file.
+
+	\param	filename	The name of the file.
+	\return	The snapshot saved in \c filename, or an empty snapshot
+			if the file does not exist or is not a well-formed snapshot.
+ */
+extern snapshot_h
+snapshot_load(char const *filename);
+
+/*! Save a snapshot in a file.
+
+	\param	snap		The snapshot.
+	\param	filename	The name of the file.
+
+	The listings saved are those found current or recorded since the
+	snapshot was loaded. The file is written under a temporary name and
+	then renamed, so that it is never left half written. The function
+	bails if the file cannot be written.
+ */
+extern void
+snapshot_save(snapshot_h snap, char const *filename);
+
+/*! Dispose of a snapshot.
+	\param	snap	Pointer to the snapshot to be destroyed. The
+					snapshot addressed by this pointer is set to \c NULL
+					on return.
+ */
+extern void
+snapshot_dispose(snapshot_h *snap);
+
+/*! Find the current listing of a directory in a snapshot.
+
+	\param	snap	The snapshot.
+	\param	dirname	The real name of the directory.
+	\param	stamp	The identity and modification time of the directory
+					now.
+	\return	The listing of \c dirname, if one was recorded with the same
+			stamp and the directory was not modified in the second in
+			which it was listed, else NULL.
+
+	The function may be called concurrently.
+ */
+extern snapshot_listing_h
+snapshot_find(snapshot_h snap, char const *dirname, fs_stamp_t const *stamp);
+
+/*! Begin a new listing of a directory, to be recorded in a snapshot.
+
+	\param	dirname	The real name of the directory.
+	\param	stamp	The identity and modification time of the directory,
+					got before it is read.
+	\return	The new, empty listing.
+ */
+extern snapshot_listing_h
+snapshot_listing_new(char const *dirname, fs_stamp_t const *stamp);
+
+/*! Add an entry to a new listing of a directory.
+
+	\param	listing		The listing.
+	\param	leafname	The leafname of the entry.
+	\param	len			The length of \c leafname.
+	\param	type		The type of the entry.
+ */
+extern void
+snapshot_listing_add(	snapshot_listing_h listing,
+						char const *leafname,
+						size_t len,
+						fs_obj_type_t type);
+
+/*! Record a new listing of a directory in a snapshot, replacing any
+	listing of the same directory.
+
+	\param	snap	The snapshot.
+	\param	listing	Pointer to the listing, which the snapshot takes
+					over. It is set to \c NULL on return.
+
+	The function may be called concurrently.
+ */
+extern void
+snapshot_record(snapshot_h snap, snapshot_listing_h *listing);
+
+/*! Get the number of entries in the listing of a directory */
+extern size_t
+snapshot_listing_count(snapshot_listing_h listing);
+
+/*! Get an entry in the listing of a directory.
+
+	\param	listing		The listing.
+	\param	which		The index of the entry.
+	\param	len			Receives the length of the leafname.
+	\param	type		Receives the type of the entry.
+	\return	The leafname of the entry.
+ */
+extern char const *
+snapshot_listing_entry(	snapshot_listing_h listing,
+						size_t which,
+						size_t *len,
+						fs_obj_type_t *type);
+
+/*@}*/
+
+#endif /* EOF */
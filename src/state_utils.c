@@ -99,6 +99,14 @@ module_finitor(
 		*public_state = NULL;
 	}
 }
+
+void *
+module_attacher(void **state, void **public_state, void *instance)
+{
+	void *attached = *state;
+	*state = *public_state = instance;
+	return attached;
+}
 /*@}*/
 
 /* EOF */
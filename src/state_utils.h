@@ -62,6 +62,19 @@
 #define STATE_ALLOCATOR (malloc)
 #endif
 
+#ifdef THREAD_LOCAL_STATE
+#ifdef _MSC_VER
+/*! Storage class of the handles to dynamic module states, which are
+ *	thread-local when \c THREAD_LOCAL_STATE is defined
+ */
+#define STATE_LOCAL __declspec(thread)
+#else
+#define STATE_LOCAL __thread
+#endif
+#else
+#define STATE_LOCAL
+#endif
+
 /*! Generated name for module global state instance */
 #define STATE(module)	module##_state
 /*! Generated name for module public state instance */
@@ -82,6 +95,8 @@
 #define INITOR(module)	module##_initor
 /*!	Generated name for module finalising function */
 #define FINITOR(module)	module##_finitor
+/*!	Generated name for module attaching function */
+#define ATTACHER(module)	module##_attach
 /*! Generated name for module static initialiser */
 #define STATIC_INITIALISER(module)	module##_static_initialiser
 /*! Generated name for pointer to module static initialiser */
@@ -106,6 +121,8 @@
 #define DECL_INITOR(module)	void INITOR(module)(void)
 /*! Declare generated module finalising function */
 #define DECL_FINITOR(module)	void FINITOR(module)(void)
+/*! Declare generated module attaching function */
+#define DECL_ATTACHER(module)	void * ATTACHER(module)(void * state)
 /*! Declare a static initialiser for the module */
 #define DECL_STATIC_INITIALISER(module)\
 	static const STATE_T(module) STATIC_INITIALISER(module)
@@ -144,8 +161,8 @@
  *	when state is in dynamic storage
  */
 #define DECL_DYNAMIC_STATE(module)\
-	 STATE_T(module) * HANDLE(module) = NULL;\
-	 PUBLIC_STATE_T(module) * PUBLIC_HANDLE(module) = NULL
+	 STATE_LOCAL STATE_T(module) * HANDLE(module) = NULL;\
+	 STATE_LOCAL PUBLIC_STATE_T(module) * PUBLIC_HANDLE(module) = NULL
 
 /*! Declare module's state in static storage, with handles to global and
  *	public state.
@@ -160,10 +177,12 @@
 #define IMPORT_INITOR(module)	extern DECL_INITOR(module)
 /*! Extern declaration of generated module finalsing function */
 #define IMPORT_FINITOR(module)	extern DECL_FINITOR(module)
+/*! Extern declaration of generated module attaching function */
+#define IMPORT_ATTACHER(module)	extern DECL_ATTACHER(module)
 
 /*! Extern declaration of handle to module's public state */
 #define IMPORT_STATE(module)\
-extern PUBLIC_STATE_T(module) * PUBLIC_HANDLE(module)
+extern STATE_LOCAL PUBLIC_STATE_T(module) * PUBLIC_HANDLE(module)
 
 /*! Get the value of a field from the module's global state, accessed through
  *	the module's handle.
@@ -206,7 +225,16 @@ DECL_FINITOR(module) {\
 		IS_STATIC(module),\
 		(void **)(char *)&HANDLE(module),\
 		(void **)(char *)&PUBLIC_HANDLE(module),\
-		USER_INIT_HANDLE(module));\
+		USER_FINIS_HANDLE(module));\
+}
+
+/*! Define the generated module attaching function \c ATTACHER(module) */
+#define DEFINE_ATTACHER(module)\
+DECL_ATTACHER(module) {\
+	return module_attacher(\
+		(void **)(char *)&HANDLE(module),\
+		(void **)(char *)&PUBLIC_HANDLE(module),\
+		state);\
 }
 
 /*! Initialise a module's global state
@@ -270,6 +298,23 @@ module_finitor(
 	void **state,
 	void **public_state,
 	void (*user_finis)());
+
+/*! Attach a module to a dynamic instance of its global state
+ *	\param	state	Pointer to the handle of the module's global state.
+ *	\param	public_state	Pointer to the handle of the module's public
+ *							state.
+ *	\param	instance	\c NULL, or an instance of the module's global state
+ *						returned by an earlier call.
+ *	\return	The instance to which the module was attached.
+ *
+ *	The function assigns \c instance to <tt>*state</tt> and
+ *	<tt>*public_state</tt>. An instance detached by assigning \c NULL
+ *	can be initialised afresh with \c INITIALISE(module) and later
+ *	reattached. With \c THREAD_LOCAL_STATE the handles are thread-local, so
+ *	threads can attach a module to different instances at once.
+ */
+extern void *
+module_attacher(void **state, void **public_state, void *instance);
 			
 /*@}*/
 
@@ -659,7 +704,8 @@ enum module_initialisation_type {
 	DECL_USER_INIT_HANDLE(module);\
 	DECL_USER_FINIS_HANDLE(module);\
 	DEFINE_INITOR(module)\
-	DEFINE_FINITOR(module)
+	DEFINE_FINITOR(module)\
+	DEFINE_ATTACHER(module)
 	/* Implement the module's state dynamically */
 
 #ifdef DEFAULT_STATIC_STATE
@@ -887,7 +933,7 @@ typedef STATE_T(module) PUBLIC_STATE_T(module)
  * 	user-finalised or not.
  *	\param	module	Name of the module
  */
-#define FINALISE(module)	INITOR(module)()
+#define FINALISE(module)	FINITOR(module)()
 
 /*! Finalise and then initialise the module's state appropriately
  *	\param module	Name of the module
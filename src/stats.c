@@ -0,0 +1,434 @@
+/***************************************************************************
+ *   Copyright (C) 2004, 2006 Symbian Software Ltd.                        *
+ *   All rights reserved.                                                  *
+ *   Copyright (C) 2007, 2008 Mike Kinghan, imk@strudl.org                 *
+ *   All rights reserved.                                                  *
+ *                                                                         *
+ *   Contributed originally by Mike Kinghan, imk@strudl.org                *
+ *                                                                         *
+ *   Redistribution and use in source and binary forms, with or without    *
+ *   modification, are permitted provided that the following conditions    *
+ *   are met:                                                              *
+ *                                                                         *
+ *   Redistributions of source code must retain the above copyright        *
+ *   notice, this list of conditions and the following disclaimer.         *
+ *                                                                         *
+ *   Redistributions in binary form must reproduce the above copyright     *
+ *   notice, this list of conditions and the following disclaimer in the   *
+ *   documentation and/or other materials provided with the distribution.  *
+ *                                                                         *
+ *   Neither the name of Symbian Software Ltd. nor the names of its        *
+ *   contributors may be used to endorse or promote products derived from  *
+ *   this software without specific prior written permission.              *
+ *                                                                         *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS   *
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT     *
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS    *
+ *   FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE        *
+ *   COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,   *
+ *   INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,  *
+ *   BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS *
+ *   OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED    *
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,*
+ *   OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF *
+ *   THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH  *
+ *   DAMAGE.                                                               *
+ *                                                                         *
+ ***************************************************************************/
+#include "stats.h"
+#include "args.h"
+#include "dataset.h"
+#include "io.h"
+#include "memory.h"
+#include "platform.h"
+#include "report.h"
+#include "timeline.h"
+#include <stdio.h>
+
+#ifdef UNIX
+#include <time.h>
+#else
+#include <windows.h>
+#endif
+
+/*!\ingroup stats_module, stats_interface, stats_internals
+ *\file stats.c
+ * This file implements the Stats module.
+ *
+ *	The phase changes several times on each input line, and reading the
+ *	CPU clock costs a system call, which would swamp the work measured.
+ *	So only the wall clock is read on each change of phase, and the CPU
+ *	clock is read when \c STATS_CPU_INTERVAL has passed. The CPU time
+ *	between two readings is divided between the phases in proportion to
+ *	their wall-clock time in the interval.
+ *
+ *	The text report is a table of the phases and a table of the
+ *	counters. The JSON report is a single line, so that the reports
+ *	of successive runs can be appended to one file and read as
+ *	JSON lines.
+ */
+
+/*! \addtogroup stats_internals */
+/*@{*/
+
+/*! The names of the phases, indexed by \c stats_phase_t */
+static char const * const phase_names[STATS_PHASES] = {
+	"walk",
+	"open",
+	"read",
+	"lex",
+	"evaluate",
+	"write",
+	"rename"
+};
+
+/*! The names of the counters, indexed by \c stats_counter_t */
+static char const * const counter_names[STATS_COUNTERS] = {
+	"bytes_in",
+	"bytes_out",
+	"lines",
+	"if",
+	"ifdef",
+	"ifndef",
+	"elif",
+	"else",
+	"endif",
+	"define",
+	"undef",
+	"error",
+	"other",
+	"find_sym",
+	"evaluations",
+	"short_circuits",
+	"cut_edits",
+	"paren_edits"
+};
+
+/*! The names of the memory tags, indexed by \c memory_tag_t */
+static char const * const memory_tag_names[MEMORY_TAGS] = {
+	"other",
+	"lines",
+	"symbols",
+	"file_tree",
+	"diagnostics",
+	"evaluator"
+};
+
+/*! The wall-clock time in seconds after which the CPU clock is read */
+#define STATS_CPU_INTERVAL	0.001
+
+/*! Say whether a counter counts directives */
+#define IS_DIRECTIVE_COUNTER(counter) \
+	((counter) >= STATS_DIR_IF && (counter) <= STATS_DIR_OTHER)
+
+/*@}*/
+
+/*! \addtogroup stats_internals_state_utils */
+/*@{*/
+
+/*! The state of the Stats module */
+STATE_DEF(stats) {
+	INCLUDE_PUBLIC(stats);	/*!< The public state of the Stats module */
+	stats_phase_t phase;	/*!< The current phase */
+	double	start_wall;		/*!< Wall-clock time at the start, in seconds */
+	double	start_cpu;		/*!< CPU time at the start, in seconds */
+	double	mark_wall;		/*!< Wall-clock time at the last change of
+								phase */
+	double	mark_cpu;		/*!< CPU time at the last reading of the CPU
+								clock */
+	double	mark_cpu_wall;	/*!< Wall-clock time at the last reading of the
+								CPU clock */
+	double	span[STATS_PHASES];	/*!< Wall-clock time charged to each
+									phase since the last reading of the CPU
+									clock */
+	double	wall[STATS_PHASES];	/*!< Wall-clock time charged to each
+									phase */
+	double	cpu[STATS_PHASES];	/*!< CPU time charged to each phase */
+	size_t	peak_live;	/*!< The peak of heap in use sampled */
+	FILE *	out;	/*!< NULL, or the file to which the report is
+						appended */
+} STATE_T(stats);
+
+IMPLEMENT(stats,USER_INITABLE);
+
+DEFINE_USER_INIT(stats)(STATE_T(stats) * stats_st)
+{
+	(void)stats_st;
+}
+
+DEFINE_USER_FINIS(stats)(STATE_T(stats) * stats_st)
+{
+	if (stats_st->out) {
+		fclose(stats_st->out);
+	}
+}
+/*@}*/
+
+/*! \addtogroup stats_internals */
+/*@{*/
+
+/*! Read the wall-clock time, in seconds from an arbitrary origin */
+static double
+read_wall_clock(void)
+{
+#ifdef UNIX
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC,&ts);
+	return (double)ts.tv_sec + ts.tv_nsec / 1e9;
+#else
+	LARGE_INTEGER count, freq;
+	QueryPerformanceCounter(&count);
+	QueryPerformanceFrequency(&freq);
+	return (double)count.QuadPart / (double)freq.QuadPart;
+#endif
+}
+
+/*! Read the CPU time of the process, in seconds */
+static double
+read_cpu_clock(void)
+{
+#ifdef UNIX
+	struct timespec ts;
+	clock_gettime(CLOCK_PROCESS_CPUTIME_ID,&ts);
+	return (double)ts.tv_sec + ts.tv_nsec / 1e9;
+#else
+	FILETIME created, exited, kernel, user;
+	ULARGE_INTEGER k, u;
+	GetProcessTimes(GetCurrentProcess(),&created,&exited,&kernel,&user);
+	k.LowPart = kernel.dwLowDateTime;
+	k.HighPart = kernel.dwHighDateTime;
+	u.LowPart = user.dwLowDateTime;
+	u.HighPart = user.dwHighDateTime;
+	/* FILETIMEs are in units of 100ns */
+	return (double)(k.QuadPart + u.QuadPart) / 1e7;
+#endif
+}
+
+/*! Read the CPU clock and divide the CPU time since it was last read
+	between the phases in proportion to their wall-clock time since then.
+*/
+static void
+charge_cpu(void)
+{
+	double cpu = read_cpu_clock();
+	double spent = cpu - GET_STATE(stats,mark_cpu);
+	double span = GET_STATE(stats,mark_wall) - GET_STATE(stats,mark_cpu_wall);
+	int i;
+	if (span <= 0) {
+		SET_STATE(stats,cpu)[GET_STATE(stats,phase)] += spent;
+	}
+	for (i = 0; i < STATS_PHASES; ++i) {
+		if (span > 0) {
+			SET_STATE(stats,cpu)[i] += spent * GET_STATE(stats,span)[i] / span;
+		}
+		SET_STATE(stats,span)[i] = 0;
+	}
+	SET_STATE(stats,mark_cpu) = cpu;
+	SET_STATE(stats,mark_cpu_wall) = GET_STATE(stats,mark_wall);
+}
+
+/*! Charge the time since the last change of phase to the current phase */
+static void
+charge(void)
+{
+	stats_phase_t phase = GET_STATE(stats,phase);
+	double wall = read_wall_clock();
+	if (GET_PUBLIC(timeline,enabled)) {
+		timeline_charge(phase,GET_STATE(stats,mark_wall),wall);
+	}
+	SET_STATE(stats,wall)[phase] += wall - GET_STATE(stats,mark_wall);
+	SET_STATE(stats,span)[phase] += wall - GET_STATE(stats,mark_wall);
+	SET_STATE(stats,mark_wall) = wall;
+	if (wall - GET_STATE(stats,mark_cpu_wall) >= STATS_CPU_INTERVAL) {
+		charge_cpu();
+	}
+}
+
+/*! Sample the heap in use for its peak */
+static void
+sample_live(void)
+{
+	size_t live = memory_live();
+	if (live > GET_STATE(stats,peak_live)) {
+		SET_STATE(stats,peak_live) = live;
+	}
+}
+
+/*! Get the allocations per input line.
+	\param	account	The account of allocations.
+	\return	The allocations made on input lines per line.
+*/
+static double
+per_line(memory_account_t const *account)
+{
+	unsigned long lines = GET_PUBLIC(stats,counts)[STATS_LINES];
+	return lines ? (double)account->line_allocations / lines : 0.0;
+}
+
+/*! Write the report as text */
+static void
+report_text(FILE *out, double wall, double cpu)
+{
+	memory_account_t account;
+	int i;
+	fprintf(out,"%-16s %12s %12s\n","Phase","Wall (s)","CPU (s)");
+	for (i = 0; i < STATS_PHASES; ++i) {
+		fprintf(out,"%-16s %12.6f %12.6f\n",phase_names[i],
+			GET_STATE(stats,wall)[i],GET_STATE(stats,cpu)[i]);
+	}
+	fprintf(out,"%-16s %12.6f %12.6f\n","total",wall,cpu);
+	fprintf(out,"%-16s %12s\n","Counter","Value");
+	fprintf(out,"%-16s %12u\n","files",GET_PUBLIC(dataset,donefiles));
+	fprintf(out,"%-16s %12u\n","errorfiles",GET_PUBLIC(dataset,errorfiles));
+	for (i = 0; i < STATS_COUNTERS; ++i) {
+		char name[32];
+		sprintf(name,IS_DIRECTIVE_COUNTER(i) ? "#%s" : "%s",counter_names[i]);
+		fprintf(out,"%-16s %12lu\n",name,GET_PUBLIC(stats,counts)[i]);
+	}
+	memory_get_account(&account);
+	fprintf(out,"%-16s %12s %12s\n","Memory","Allocations","Bytes");
+	for (i = 0; i < MEMORY_TAGS; ++i) {
+		fprintf(out,"%-16s %12lu %12lu\n",memory_tag_names[i],
+			account.allocations[i],account.bytes[i]);
+	}
+	fprintf(out,"%-16s %12lu\n","line_allocations",account.line_allocations);
+	fprintf(out,"%-16s %12.6f\n","per_line",per_line(&account));
+	fprintf(out,"%-16s %12lu\n","peak_live",
+		(unsigned long)GET_STATE(stats,peak_live));
+	fprintf(out,"%-16s %12lu\n","peak_rss",(unsigned long)memory_peak_rss());
+}
+
+/*! Write the report as a JSON object on one line */
+static void
+report_json(FILE *out, double wall, double cpu)
+{
+	memory_account_t account;
+	int i;
+	fprintf(out,"{\"version\":\"%s\",\"files\":%u,\"errorfiles\":%u,"
+		"\"wall\":%.6f,\"cpu\":%.6f,\"phases\":{",VERSION,
+		GET_PUBLIC(dataset,donefiles),GET_PUBLIC(dataset,errorfiles),
+		wall,cpu);
+	for (i = 0; i < STATS_PHASES; ++i) {
+		fprintf(out,"%s\"%s\":{\"wall\":%.6f,\"cpu\":%.6f}",i ? "," : "",
+			phase_names[i],GET_STATE(stats,wall)[i],GET_STATE(stats,cpu)[i]);
+	}
+	fputs("},\"counters\":{",out);
+	for (i = 0; i < STATS_COUNTERS; ++i) {
+		if (i == STATS_DIR_IF) {
+			fputs(",\"directives\":{",out);
+		}
+		else if (i) {
+			fputc(',',out);
+		}
+		fprintf(out,"\"%s\":%lu",counter_names[i],GET_PUBLIC(stats,counts)[i]);
+		if (i == STATS_DIR_OTHER) {
+			fputc('}',out);
+		}
+	}
+	memory_get_account(&account);
+	fputs("},\"memory\":{\"tags\":{",out);
+	for (i = 0; i < MEMORY_TAGS; ++i) {
+		fprintf(out,"%s\"%s\":{\"allocations\":%lu,\"bytes\":%lu}",
+			i ? "," : "",memory_tag_names[i],account.allocations[i],
+			account.bytes[i]);
+	}
+	fprintf(out,"},\"line_allocations\":%lu,\"per_line\":%.6f,"
+		"\"peak_live\":%lu,\"peak_rss\":%lu}}\n",account.line_allocations,
+		per_line(&account),(unsigned long)GET_STATE(stats,peak_live),
+		(unsigned long)memory_peak_rss());
+}
+
+/*@}*/
+
+/* API ***************************************************************/
+
+void
+stats_start(void)
+{
+	if (GET_PUBLIC(args,stats_file)) {
+		SET_STATE(stats,out) = open_file(GET_PUBLIC(args,stats_file),"a");
+	}
+	SET_STATE(stats,start_wall) = SET_STATE(stats,mark_wall) =
+		SET_STATE(stats,mark_cpu_wall) = read_wall_clock();
+	SET_STATE(stats,start_cpu) = SET_STATE(stats,mark_cpu) = read_cpu_clock();
+	SET_STATE(stats,phase) = STATS_WALK;
+	SET_PUBLIC(stats,timing) = true;
+	SET_PUBLIC(stats,enabled) = GET_PUBLIC(args,stats_format) != STATS_NO;
+	SET_PUBLIC(stats,sampling) = !GET_PUBLIC(stats,enabled);
+	if (GET_PUBLIC(stats,enabled)) {
+		memory_account_start();
+	}
+}
+
+stats_phase_t
+stats_phase(stats_phase_t phase)
+{
+	stats_phase_t left = GET_STATE(stats,phase);
+	if (phase != left) {
+		charge();
+		SET_STATE(stats,phase) = phase;
+	}
+	return left;
+}
+
+void
+stats_line(bool more)
+{
+	bool timed;
+	if (GET_PUBLIC(stats,enabled)) {
+		memory_in_lines(more);
+		if (!more) {
+			sample_live();
+		}
+		return;
+	}
+	timed = !more ||
+		GET_PUBLIC(io,line_num) % STATS_SAMPLE_LINES == 0;
+	if (timed == GET_PUBLIC(stats,timing)) {
+		return;
+	}
+	if (timed) {
+		double wall = read_wall_clock();
+		timeline_charge_untimed(GET_STATE(stats,mark_wall),wall);
+		SET_STATE(stats,mark_wall) = wall;
+	}
+	else {
+		charge();
+	}
+	SET_PUBLIC(stats,timing) = timed;
+}
+
+double
+stats_wall_clock(void)
+{
+	return read_wall_clock();
+}
+
+void
+stats_report(void)
+{
+	FILE *out;
+	double wall, cpu;
+	if (!GET_PUBLIC(stats,enabled)) {
+		return;
+	}
+	charge();
+	charge_cpu();
+	sample_live();
+	SET_PUBLIC(stats,enabled) = false;
+	wall = GET_STATE(stats,mark_wall) - GET_STATE(stats,start_wall);
+	cpu = GET_STATE(stats,mark_cpu) - GET_STATE(stats,start_cpu);
+	out = GET_STATE(stats,out) ? GET_STATE(stats,out) : stderr;
+	if (GET_PUBLIC(args,stats_format) == STATS_JSON) {
+		report_json(out,wall,cpu);
+	}
+	else {
+		report_text(out,wall,cpu);
+	}
+	if (GET_STATE(stats,out)) {
+		fclose(GET_STATE(stats,out));
+		SET_STATE(stats,out) = NULL;
+	}
+}
+
+/* EOF */
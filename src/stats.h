@@ -0,0 +1,205 @@
+#ifndef STATS_H
+#define STATS_H
+/***************************************************************************
+ *   Copyright (C) 2004, 2006 Symbian Software Ltd.                        *
+ *   All rights reserved.                                                  *
+ *   Copyright (C) 2007, 2008 Mike Kinghan, imk@strudl.org                 *
+ *   All rights reserved.                                                  *
+ *                                                                         *
+ *   Contributed originally by Mike Kinghan, imk@strudl.org                *
+ *                                                                         *
+ *   Redistribution and use in source and binary forms, with or without    *
+ *   modification, are permitted provided that the following conditions    *
+ *   are met:                                                              *
+ *                                                                         *
+ *   Redistributions of source code must retain the above copyright        *
+ *   notice, this list of conditions and the following disclaimer.         *
+ *                                                                         *
+ *   Redistributions in binary form must reproduce the above copyright     *
+ *   notice, this list of conditions and the following disclaimer in the   *
+ *   documentation and/or other materials provided with the distribution.  *
+ *                                                                         *
+ *   Neither the name of Symbian Software Ltd. nor the names of its        *
+ *   contributors may be used to endorse or promote products derived from  *
+ *   this software without specific prior written permission.              *
+ *                                                                         *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS   *
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT     *
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS    *
+ *   FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE        *
+ *   COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,   *
+ *   INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,  *
+ *   BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS *
+ *   OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED    *
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,*
+ *   OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF *
+ *   THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH  *
+ *   DAMAGE.                                                               *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "opts.h"
+#include "bool.h"
+
+/*!\ingroup stats_module, stats_interface
+ *\file stats.h
+ * This file provides the Stats module interface.
+ *
+ *	When the \c --stats option is in force the Stats module accounts
+ *	the wall-clock and CPU time of the run to the phases of processing
+ *	and counts the work done, and reports the results at exit in text
+ *	or as a JSON object.
+ *
+ *	Time is charged to the phase that is current when it passes, so the
+ *	times of the phases are exclusive and add up to the time of the run.
+ *	Time that is not spent on an input file is charged to the search of
+ *	the input file tree.
+ *
+ *	The phases are also timed for the \c --trace option, which passes
+ *	them on to the Timeline module. With \c --trace alone nothing is
+ *	counted or reported, and to keep the cost of the clock down the
+ *	phases of only one input line in \c STATS_SAMPLE_LINES are timed.
+ *	The time of the lines between is passed on untimed.
+ *
+ *	With \c --stats the allocations are also accounted by the Memory
+ *	module, and the report gives the allocations and bytes by tag, the
+ *	allocations per input line and the peak of heap in use, which is
+ *	sampled at the end of each input file.
+ */
+
+/*! \addtogroup stats_interface */
+/*@{*/
+
+/*! With \c --trace alone, the interval in input lines at which the
+	phases of a line are timed */
+#define STATS_SAMPLE_LINES	16
+
+/*! Enumeration of the phases of processing */
+typedef enum {
+	STATS_WALK,		/*!< Searching the input file tree, and all else */
+	STATS_OPEN,		/*!< Opening an input file and its output */
+	STATS_READ,		/*!< Reading input lines */
+	STATS_LEX,		/*!< Lexing input lines */
+	STATS_EVAL,		/*!< Evaluating \c #if and \c #elif expressions */
+	STATS_WRITE,	/*!< Despatching and writing output lines */
+	STATS_RENAME,	/*!< Replacing and backing up input files */
+	STATS_PHASES	/*!< The number of phases */
+} stats_phase_t;
+
+/*! Enumeration of the counters */
+typedef enum {
+	STATS_BYTES_IN,		/*!< Bytes of input lines read */
+	STATS_BYTES_OUT,	/*!< Bytes of output lines written */
+	STATS_LINES,		/*!< Input lines read */
+	STATS_DIR_IF,		/*!< \c #if directives */
+	STATS_DIR_IFDEF,	/*!< \c #ifdef directives */
+	STATS_DIR_IFNDEF,	/*!< \c #ifndef directives */
+	STATS_DIR_ELIF,		/*!< \c #elif directives */
+	STATS_DIR_ELSE,		/*!< \c #else directives */
+	STATS_DIR_ENDIF,	/*!< \c #endif directives */
+	STATS_DIR_DEFINE,	/*!< \c #define directives */
+	STATS_DIR_UNDEF,	/*!< \c #undef directives */
+	STATS_DIR_ERROR,	/*!< \c #error directives */
+	STATS_DIR_OTHER,	/*!< Other directives */
+	STATS_FIND_SYM,		/*!< Calls of \c find_sym() */
+	STATS_EVALS,		/*!< Expressions evaluated */
+	STATS_SHORT_CIRCUITS,	/*!< Operands skipped by short-circuiting */
+	STATS_CUT_EDITS,	/*!< Chunks cut from directives */
+	STATS_PAREN_EDITS,	/*!< Pairs of parentheses deleted */
+	STATS_COUNTERS		/*!< The number of counters */
+} stats_counter_t;
+
+/*! Add to a counter if the \c --stats option is in force */
+#define STATS_ADD(counter,n) \
+	do { \
+		if (GET_PUBLIC(stats,enabled)) { \
+			SET_PUBLIC(stats,counts)[counter] += (n); \
+		} \
+	} while(0)
+
+/*! Count one more if the \c --stats option is in force */
+#define STATS_COUNT(counter)	STATS_ADD(counter,1)
+
+/*! Enter a phase if the phases are being timed.
+	\return	The phase that is left. Enter it again to resume it.
+*/
+#define STATS_PHASE(phase) \
+	(GET_PUBLIC(stats,timing) ? stats_phase(phase) : (phase))
+
+/*! Mark the start of an input line, if the lines are being sampled or
+	counted */
+#define STATS_LINE() \
+	(GET_PUBLIC(stats,enabled) || GET_PUBLIC(stats,sampling) ? \
+		stats_line(true) : (void)0)
+
+/*! Mark the end of the input lines of a file, if the lines are being
+	sampled or counted */
+#define STATS_LINES_END() \
+	(GET_PUBLIC(stats,enabled) || GET_PUBLIC(stats,sampling) ? \
+		stats_line(false) : (void)0)
+
+/*! Start timing the phases, in the phase \c STATS_WALK, and with the
+	\c --stats option start counting.
+
+	The file to which the report is to be appended, if any, is opened
+	now so that it cannot fail at exit.
+*/
+extern void
+stats_start(void);
+
+/*! Enter a phase, charging the time since the last change of phase to
+	the phase that is left.
+
+	\param	phase	The phase to enter.
+	\return	The phase that is left.
+
+	Call through \c STATS_PHASE().
+*/
+extern stats_phase_t
+stats_phase(stats_phase_t phase);
+
+/*! Mark the start of an input line or the end of the last.
+
+	\param	more	Is an input line to follow?
+
+	With \c --stats, allocations are counted as made on input lines
+	until the end of the last, and the peak of heap in use is sampled
+	then.
+
+	With \c --trace alone, the phases are timed after the last line and
+	for every line whose number is a multiple of \c STATS_SAMPLE_LINES.
+	When timing resumes the time since it stopped is passed to the
+	Timeline module untimed.
+
+	Call through \c STATS_LINE() or \c STATS_LINES_END().
+*/
+extern void
+stats_line(bool more);
+
+/*! Read the wall-clock time.
+	\return	The time in seconds from an arbitrary origin.
+*/
+extern double
+stats_wall_clock(void);
+
+/*! Write the report, if the \c --stats option is in force. */
+extern void
+stats_report(void);
+
+/*@}*/
+
+/*! \addtogroup stats_interface_state_utils */
+/*@{*/
+
+/*! The public state of the Stats module */
+PUBLIC_STATE_DEF(stats) {
+	bool enabled;	/*!< Is the \c --stats option in force? */
+	bool timing;	/*!< Are the phases being timed? */
+	bool sampling;	/*!< Are the phases of only some lines timed? */
+	unsigned long counts[STATS_COUNTERS];	/*!< The counters */
+} PUBLIC_STATE_T(stats);
+
+IMPORT(stats);
+/*@}*/
+
+#endif /* EOF */
@@ -35,10 +35,13 @@
  *   DAMAGE.                                                               *
  *                                                                         *
  ***************************************************************************/
+#define MEMORY_TAG	MEMORY_SYMBOLS
 #include "symbol_table.h"
 #include "chew.h"
 #include "args.h"
 #include "report.h"
+#include "stats.h"
+#include "trace.h"
 #include <stddef.h>
 #include <stdio.h>
 
@@ -74,11 +77,11 @@ find_sym(char *str, char ** end)
 {
 	char *cp;
 	const char *name = NULL;
-	const char *def = NULL;
 	size_t symind;
 	int comp;
 	size_t symbols = ptr_vector_count(GET_STATE(symbol_table,sym_tab));
 
+	STATS_COUNT(STATS_FIND_SYM);
 	cp = chew_sym(str);
 	if (end) {
 		*end = cp;
@@ -92,7 +95,6 @@ find_sym(char *str, char ** end)
 		ptrdiff_t len;
 		eval_result_t * pos = SYMBOL(symind);
 		name = pos->sym_name;
-		def = pos->sym_def;
 		len = cp - str;
 		comp = strncmp(str,name,len);
 		if (comp <= 0) {
@@ -107,7 +109,8 @@ find_sym(char *str, char ** end)
 		}
 	}
 	if (comp == 0) {
-		debug(DBG_18, name, (def ? def : ""));
+		TRACE_TEXTS(TRACE_FIND_SYM,name,
+			(SYMBOL(symind)->sym_def ? SYMBOL(symind)->sym_def : ""));
 		return (int)symind;
 	}
 	return (int)~symind;
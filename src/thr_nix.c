@@ -0,0 +1,186 @@
+/***************************************************************************
+ *   Copyright (C) 2004, 2006 Symbian Software Ltd.                        *
+ *   All rights reserved.                                                  *
+ *   Copyright (C) 2007, 2008 Mike Kinghan, imk@strudl.org                 *
+ *   All rights reserved.                                                  *
+ *                                                                         *
+ *   Contributed originally by Mike Kinghan, imk@strudl.org                *
+ *                                                                         *
+ *   Redistribution and use in source and binary forms, with or without    *
+ *   modification, are permitted provided that the following conditions    *
+ *   are met:                                                              *
+ *                                                                         *
+ *   Redistributions of source code must retain the above copyright        *
+ *   notice, this list of conditions and the following disclaimer.         *
+ *                                                                         *
+ *   Redistributions in binary form must reproduce the above copyright     *
+ *   notice, this list of conditions and the following disclaimer in the   *
+ *   documentation and/or other materials provided with the distribution.  *
+ *                                                                         *
+ *   Neither the name of Symbian Software Ltd. nor the names of its        *
+ *   contributors may be used to endorse or promote products derived from  *
+ *   this software without specific prior written permission.              *
+ *                                                                         *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS   *
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT     *
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS    *
+ *   FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE        *
+ *   COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,   *
+ *   INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,  *
+ *   BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS *
+ *   OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED    *
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,*
+ *   OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF *
+ *   THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH  *
+ *   DAMAGE.                                                               *
+ *                                                                         *
+ ***************************************************************************/
+
+/*! \file thr_nix.c
+ * \ingroup thread_module thread_unix thread_unix_internals
+ *
+ * This file implements the thread module for Unix.
+ */
+#include "platform.h"
+
+#ifdef UNIX
+
+#include <pthread.h>
+#include <unistd.h>
+#include "thread.h"
+#include "memory.h"
+#include "report.h"
+
+/*! \addtogroup thread_unix_internals */
+/*@{*/
+
+/*! Structure implementing \e thread_t for Unix */
+typedef struct thread_nix {
+	/*! The pthreads handle of the thread */
+	pthread_t	id;
+	/*! The function run by the thread */
+	thread_proc_t proc;
+	/*! The argument passed to \e proc */
+	void *arg;
+} thread_nix_t;
+
+/*! Start routine for all threads. Call the thread's function
+	with its argument.
+	\param		thread	Pointer to the \e thread_nix_t of the thread.
+	\return		NULL
+*/
+static void *
+thread_main(void *thread)
+{
+	thread_nix_t *self = thread;
+	self->proc(self->arg);
+	return NULL;
+}
+
+/*! The trap for errors on the calling thread, or NULL */
+static __thread thread_trap_t *cur_trap;
+
+/*@}*/
+
+/* API ***************************************************************/
+
+thread_t
+thread_start(thread_proc_t proc, void *arg)
+{
+	thread_nix_t *thread = allocate(sizeof(thread_nix_t));
+	thread->proc = proc;
+	thread->arg = arg;
+	if (pthread_create(&thread->id,NULL,thread_main,thread)) {
+		bail(GRIPE_CANT_START_THREAD,"Cannot start a thread");
+	}
+	return thread;
+}
+
+void
+thread_join(thread_t thread)
+{
+	thread_nix_t *self = thread;
+	pthread_join(self->id,NULL);
+	release((void **)&self);
+}
+
+thread_lock_t
+thread_lock_new(void)
+{
+	pthread_mutex_t *mutex = allocate(sizeof(pthread_mutex_t));
+	pthread_mutex_init(mutex,NULL);
+	return mutex;
+}
+
+void
+thread_lock_dispose(thread_lock_t *lock)
+{
+	pthread_mutex_destroy(*lock);
+	release(lock);
+}
+
+void
+thread_lock(thread_lock_t lock)
+{
+	pthread_mutex_lock(lock);
+}
+
+void
+thread_unlock(thread_lock_t lock)
+{
+	pthread_mutex_unlock(lock);
+}
+
+thread_cond_t
+thread_cond_new(void)
+{
+	pthread_cond_t *cond = allocate(sizeof(pthread_cond_t));
+	pthread_cond_init(cond,NULL);
+	return cond;
+}
+
+void
+thread_cond_dispose(thread_cond_t *cond)
+{
+	pthread_cond_destroy(*cond);
+	release(cond);
+}
+
+void
+thread_cond_wait(thread_cond_t cond, thread_lock_t lock)
+{
+	pthread_cond_wait(cond,lock);
+}
+
+void
+thread_cond_broadcast(thread_cond_t cond)
+{
+	pthread_cond_broadcast(cond);
+}
+
+void
+thread_set_trap(thread_trap_t *trap)
+{
+	cur_trap = trap;
+}
+
+thread_trap_t *
+thread_get_trap(void)
+{
+	return cur_trap;
+}
+
+int
+thread_cpus(void)
+{
+#ifdef _SC_NPROCESSORS_ONLN
+	long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+	return cpus > 0 ? (int)cpus : 1;
+#else
+	return 1;
+#endif
+}
+
+#endif
+
+/* EOF */
@@ -0,0 +1,187 @@
+/***************************************************************************
+ *   Copyright (C) 2004, 2006 Symbian Software Ltd.                        *
+ *   All rights reserved.                                                  *
+ *   Copyright (C) 2007, 2008 Mike Kinghan, imk@strudl.org                 *
+ *   All rights reserved.                                                  *
+ *                                                                         *
+ *   Contributed originally by Mike Kinghan, imk@strudl.org                *
+ *                                                                         *
+ *   Redistribution and use in source and binary forms, with or without    *
+ *   modification, are permitted provided that the following conditions    *
+ *   are met:                                                              *
+ *                                                                         *
+ *   Redistributions of source code must retain the above copyright        *
+ *   notice, this list of conditions and the following disclaimer.         *
+ *                                                                         *
+ *   Redistributions in binary form must reproduce the above copyright     *
+ *   notice, this list of conditions and the following disclaimer in the   *
+ *   documentation and/or other materials provided with the distribution.  *
+ *                                                                         *
+ *   Neither the name of Symbian Software Ltd. nor the names of its        *
+ *   contributors may be used to endorse or promote products derived from  *
+ *   this software without specific prior written permission.              *
+ *                                                                         *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS   *
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT     *
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS    *
+ *   FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE        *
+ *   COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,   *
+ *   INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,  *
+ *   BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS *
+ *   OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED    *
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,*
+ *   OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF *
+ *   THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH  *
+ *   DAMAGE.                                                               *
+ *                                                                         *
+ ***************************************************************************/
+
+/*! \file thr_win.c
+ * \ingroup thread_module thread_windows thread_windows_internals
+ *
+ * This file implements the thread module for windows.
+ */
+#include "platform.h"
+
+#ifdef WINDOWS
+
+#include "thread.h"
+#include "memory.h"
+#include "report.h"
+#include <windows.h>
+
+/*! \addtogroup thread_windows_internals */
+/*@{*/
+
+/*! Structure implementing \e thread_t for Windows */
+typedef struct thread_win {
+	/*! The Windows handle of the thread */
+	HANDLE	handle;
+	/*! The function run by the thread */
+	thread_proc_t proc;
+	/*! The argument passed to \e proc */
+	void *arg;
+} thread_win_t;
+
+/*! Start routine for all threads. Call the thread's function
+	with its argument.
+	\param		thread	Pointer to the \e thread_win_t of the thread.
+	\return		0
+*/
+static DWORD WINAPI
+thread_main(LPVOID thread)
+{
+	thread_win_t *self = thread;
+	self->proc(self->arg);
+	return 0;
+}
+
+#ifdef _MSC_VER
+/*! The trap for errors on the calling thread, or NULL */
+static __declspec(thread) thread_trap_t *cur_trap;
+#else
+static __thread thread_trap_t *cur_trap;
+#endif
+
+/*@}*/
+
+/* API ***************************************************************/
+
+thread_t
+thread_start(thread_proc_t proc, void *arg)
+{
+	thread_win_t *thread = allocate(sizeof(thread_win_t));
+	thread->proc = proc;
+	thread->arg = arg;
+	thread->handle = CreateThread(NULL,0,thread_main,thread,0,NULL);
+	if (thread->handle == NULL) {
+		bail(GRIPE_CANT_START_THREAD,"Cannot start a thread");
+	}
+	return thread;
+}
+
+void
+thread_join(thread_t thread)
+{
+	thread_win_t *self = thread;
+	WaitForSingleObject(self->handle,INFINITE);
+	CloseHandle(self->handle);
+	release((void **)&self);
+}
+
+thread_lock_t
+thread_lock_new(void)
+{
+	CRITICAL_SECTION *section = allocate(sizeof(CRITICAL_SECTION));
+	InitializeCriticalSection(section);
+	return section;
+}
+
+void
+thread_lock_dispose(thread_lock_t *lock)
+{
+	DeleteCriticalSection(*lock);
+	release(lock);
+}
+
+void
+thread_lock(thread_lock_t lock)
+{
+	EnterCriticalSection(lock);
+}
+
+void
+thread_unlock(thread_lock_t lock)
+{
+	LeaveCriticalSection(lock);
+}
+
+thread_cond_t
+thread_cond_new(void)
+{
+	CONDITION_VARIABLE *cond = allocate(sizeof(CONDITION_VARIABLE));
+	InitializeConditionVariable(cond);
+	return cond;
+}
+
+void
+thread_cond_dispose(thread_cond_t *cond)
+{
+	release(cond);
+}
+
+void
+thread_cond_wait(thread_cond_t cond, thread_lock_t lock)
+{
+	SleepConditionVariableCS(cond,lock,INFINITE);
+}
+
+void
+thread_cond_broadcast(thread_cond_t cond)
+{
+	WakeAllConditionVariable(cond);
+}
+
+void
+thread_set_trap(thread_trap_t *trap)
+{
+	cur_trap = trap;
+}
+
+thread_trap_t *
+thread_get_trap(void)
+{
+	return cur_trap;
+}
+
+int
+thread_cpus(void)
+{
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return info.dwNumberOfProcessors > 0 ? (int)info.dwNumberOfProcessors : 1;
+}
+
+#endif
+
+/* EOF */
@@ -0,0 +1,183 @@
+#ifndef THREAD_H
+#define THREAD_H
+
+/***************************************************************************
+ *   Copyright (C) 2004, 2006 Symbian Software Ltd.                        *
+ *   All rights reserved.                                                  *
+ *   Copyright (C) 2007, 2008 Mike Kinghan, imk@strudl.org                 *
+ *   All rights reserved.                                                  *
+ *                                                                         *
+ *   Contributed originally by Mike Kinghan, imk@strudl.org                *
+ *                                                                         *
+ *   Redistribution and use in source and binary forms, with or without    *
+ *   modification, are permitted provided that the following conditions    *
+ *   are met:                                                              *
+ *                                                                         *
+ *   Redistributions of source code must retain the above copyright        *
+ *   notice, this list of conditions and the following disclaimer.         *
+ *                                                                         *
+ *   Redistributions in binary form must reproduce the above copyright     *
+ *   notice, this list of conditions and the following disclaimer in the   *
+ *   documentation and/or other materials provided with the distribution.  *
+ *                                                                         *
+ *   Neither the name of Symbian Software Ltd. nor the names of its        *
+ *   contributors may be used to endorse or promote products derived from  *
+ *   this software without specific prior written permission.              *
+ *                                                                         *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS   *
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT     *
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS    *
+ *   FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE        *
+ *   COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,   *
+ *   INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,  *
+ *   BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS *
+ *   OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED    *
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,*
+ *   OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF *
+ *   THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH  *
+ *   DAMAGE.                                                               *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "opts.h"
+#include <setjmp.h>
+
+/*! \file thread.h
+ * \ingroup thread_module thread_interface
+ *
+ * This file provides the Thread module interface
+ */
+
+/*!\addtogroup thread_interface */
+/*@{*/
+
+/*! Abstract type of thread handle */
+typedef void * thread_t;
+
+/*! Abstract type of mutual exclusion lock */
+typedef void * thread_lock_t;
+
+/*! Abstract type of condition on which threads can wait */
+typedef void * thread_cond_t;
+
+/*! The size of the buffer in which a trapped diagnostic is kept */
+#define THREAD_TRAP_MSG_SIZE	256
+
+/*! Structure of a trap for errors on a thread other than the main thread.
+
+	A bail on a thread that has set a trap neither reports the error nor
+	returns to the main thread's exception context. It records the error
+	in the trap and returns to the trap's context, so that the error can
+	be raised by the thread that awaits the work.
+*/
+typedef struct thread_trap {
+	jmp_buf	context;	/*!< The context to which a bail returns */
+	int		reason;		/*!< The reason code of the bail */
+	char	msg[THREAD_TRAP_MSG_SIZE];
+		/*!< The diagnostic of the bail, possibly truncated, or empty */
+} thread_trap_t;
+
+/*! Type of function that is run by a thread.
+	\param	arg	The argument passed to thread_start().
+*/
+typedef void (*thread_proc_t)(void *arg);
+
+/*! Start a thread.
+
+	\param		proc	The function to be run by the thread.
+	\param		arg		The argument to be passed to \em proc.
+
+	\return	A handle to the started thread.
+
+	The function bails if a thread cannot be started.
+*/
+extern thread_t
+thread_start(thread_proc_t proc, void *arg);
+
+/*! Wait for a thread to finish and release its handle.
+
+	\param		thread	The handle of the thread to be joined.
+*/
+extern void
+thread_join(thread_t thread);
+
+/*! Create a mutual exclusion lock.
+
+	\return	A handle to the new lock, which is not held.
+*/
+extern thread_lock_t
+thread_lock_new(void);
+
+/*! Destroy a mutual exclusion lock.
+
+	\param		lock	Pointer to the handle of the lock, which
+						is set NULL.
+*/
+extern void
+thread_lock_dispose(thread_lock_t *lock);
+
+/*! Acquire a mutual exclusion lock, waiting until it is free. */
+extern void
+thread_lock(thread_lock_t lock);
+
+/*! Release a mutual exclusion lock. */
+extern void
+thread_unlock(thread_lock_t lock);
+
+/*! Create a condition on which threads can wait.
+
+	\return	A handle to the new condition.
+*/
+extern thread_cond_t
+thread_cond_new(void);
+
+/*! Destroy a condition.
+
+	\param		cond	Pointer to the handle of the condition, which
+						is set NULL.
+*/
+extern void
+thread_cond_dispose(thread_cond_t *cond);
+
+/*! Wait for a condition to be signalled.
+
+	\param		cond	The condition to wait for.
+	\param		lock	A lock held by the caller. It is released
+						while waiting and held again on return.
+
+	The condition may have been signalled on return for a reason other
+	than the caller's, so the caller must test what it waits for again.
+*/
+extern void
+thread_cond_wait(thread_cond_t cond, thread_lock_t lock);
+
+/*! Wake all the threads waiting for a condition. */
+extern void
+thread_cond_broadcast(thread_cond_t cond);
+
+/*! Set the trap for errors on the calling thread.
+
+	\param		trap	The trap, or NULL to clear the trap.
+
+	The caller must \c setjmp() on \c trap->context before anything
+	that may bail. The main thread never sets a trap.
+*/
+extern void
+thread_set_trap(thread_trap_t *trap);
+
+/*! Get the trap for errors on the calling thread.
+
+	\return	The trap set by thread_set_trap(), or NULL.
+*/
+extern thread_trap_t *
+thread_get_trap(void);
+
+/*! Get the number of processors online in the host system,
+	or 1 if this cannot be determined.
+*/
+extern int
+thread_cpus(void);
+
+/*@}*/
+
+#endif /* EOF */
@@ -0,0 +1,446 @@
+/***************************************************************************
+ *   Copyright (C) 2004, 2006 Symbian Software Ltd.                        *
+ *   All rights reserved.                                                  *
+ *   Copyright (C) 2007, 2008 Mike Kinghan, imk@strudl.org                 *
+ *   All rights reserved.                                                  *
+ *                                                                         *
+ *   Contributed originally by Mike Kinghan, imk@strudl.org                *
+ *                                                                         *
+ *   Redistribution and use in source and binary forms, with or without    *
+ *   modification, are permitted provided that the following conditions    *
+ *   are met:                                                              *
+ *                                                                         *
+ *   Redistributions of source code must retain the above copyright        *
+ *   notice, this list of conditions and the following disclaimer.         *
+ *                                                                         *
+ *   Redistributions in binary form must reproduce the above copyright     *
+ *   notice, this list of conditions and the following disclaimer in the   *
+ *   documentation and/or other materials provided with the distribution.  *
+ *                                                                         *
+ *   Neither the name of Symbian Software Ltd. nor the names of its        *
+ *   contributors may be used to endorse or promote products derived from  *
+ *   this software without specific prior written permission.              *
+ *                                                                         *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS   *
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT     *
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS    *
+ *   FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE        *
+ *   COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,   *
+ *   INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,  *
+ *   BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS *
+ *   OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED    *
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,*
+ *   OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF *
+ *   THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH  *
+ *   DAMAGE.                                                               *
+ *                                                                         *
+ ***************************************************************************/
+#include "timeline.h"
+#include "args.h"
+#include "dataset.h"
+#include "io.h"
+#include "memory.h"
+#include <stdio.h>
+#include <string.h>
+
+/*!\ingroup timeline_module, timeline_interface, timeline_internals
+ *\file timeline.c
+ * This file implements the Timeline module.
+ *
+ *	Events are written as they end, so the trace file holds the spans
+ *	of all the files done even if the run is cut short. Spans are
+ *	complete (\c "X") events, except that the spans of directories are
+ *	begin and end (\c "B", \c "E") events, since a directory is left
+ *	only after its files are written. Times are in microseconds from
+ *	the start of the run.
+ *
+ *	Only runs of a stage that last for at least \c TIMELINE_MIN_RUN
+ *	are written as spans of their own. The time of every stage is
+ *	totalled in the \c args of the file's span.
+ *
+ *	The slowest input files and the histogram of the time per file are
+ *	written in the \c otherData object of the trace, which viewers show
+ *	as metadata.
+ */
+
+/*! \addtogroup timeline_internals */
+/*@{*/
+
+/*! Enumeration of the stages of processing an input file */
+typedef enum {
+	STAGE_NONE = -1,	/*!< Not a stage */
+	STAGE_OPEN,		/*!< Opening the file and its output */
+	STAGE_READ,		/*!< Reading input lines */
+	STAGE_LEX_EVAL,	/*!< Lexing input lines and evaluating expressions */
+	STAGE_WRITE,	/*!< Writing output lines */
+	STAGE_COMMIT,	/*!< Replacing the file with its output */
+	STAGES			/*!< The number of stages */
+} stage_t;
+
+/*! The names of the stages, indexed by \c stage_t */
+static char const * const stage_names[STAGES] = {
+	"open",
+	"read",
+	"lex_eval",
+	"write",
+	"commit"
+};
+
+/*! The stage of each phase of processing, indexed by \c stats_phase_t */
+static stage_t const stage_of_phase[STATS_PHASES] = {
+	STAGE_NONE,		/* STATS_WALK */
+	STAGE_OPEN,		/* STATS_OPEN */
+	STAGE_READ,		/* STATS_READ */
+	STAGE_LEX_EVAL,	/* STATS_LEX */
+	STAGE_LEX_EVAL,	/* STATS_EVAL */
+	STAGE_WRITE,	/* STATS_WRITE */
+	STAGE_COMMIT	/* STATS_RENAME */
+};
+
+/*! The number of buckets of the histogram. The upper bound of bucket
+	\em i is 2^i microseconds, and the last bucket has no bound.
+*/
+#define TIMELINE_BUCKETS	26
+
+/*! Structure of an entry in the list of the slowest input files */
+typedef struct {
+	heap_str name;	/*!< The name of the file */
+	double	time;	/*!< The time taken by the file, in seconds */
+} slow_file_t;
+
+/*@}*/
+
+/*! \addtogroup timeline_internals_state_utils */
+/*@{*/
+
+/*! The state of the Timeline module */
+STATE_DEF(timeline) {
+	INCLUDE_PUBLIC(timeline);	/*!< The public state of the Timeline
+									module */
+	FILE *	out;		/*!< The trace file */
+	double	start;		/*!< Wall-clock time at the start */
+	unsigned long events;	/*!< The number of events written */
+	char const * file;	/*!< The current input file, or NULL */
+	double	file_start;	/*!< Wall-clock time at the start of the current
+							input file */
+	unsigned file_errors;	/*!< The count of files in error at the start
+								of the current input file */
+	double	stage_time[STAGES];	/*!< Time spent in each stage of the
+									current input file */
+	double	untimed;	/*!< Time spent on lines of the current input file
+							whose stages were not timed */
+	stage_t	run_stage;	/*!< The stage of the current run */
+	double	run_start;	/*!< Wall-clock time at the start of the current
+							run */
+	double	run_end;	/*!< Wall-clock time at the last charge to the
+							current run */
+	unsigned dirs;		/*!< The number of directory spans open */
+	unsigned files;		/*!< The number of input files timed */
+	slow_file_t slowest[TIMELINE_SLOWEST];	/*!< The slowest input files,
+												slowest first */
+	unsigned slow_count;	/*!< The number of entries in \c slowest */
+	unsigned long histogram[TIMELINE_BUCKETS];	/*!< The count of input
+													files by time taken */
+} STATE_T(timeline);
+
+IMPLEMENT(timeline,USER_INITABLE);
+
+DEFINE_USER_INIT(timeline)(STATE_T(timeline) * timeline_st)
+{
+	(void)timeline_st;
+}
+
+DEFINE_USER_FINIS(timeline)(STATE_T(timeline) * timeline_st)
+{
+	unsigned i;
+	if (timeline_st->out) {
+		fclose(timeline_st->out);
+	}
+	for (i = 0; i < timeline_st->slow_count; ++i) {
+		free(timeline_st->slowest[i].name);
+	}
+}
+/*@}*/
+
+/*! \addtogroup timeline_internals */
+/*@{*/
+
+/*! Convert a wall-clock time to microseconds from the start of the
+	trace */
+#define TIMESTAMP(wall)	(((wall) - GET_STATE(timeline,start)) * 1e6)
+
+/*! Write a string as a JSON string literal.
+	\param	out	The file to write to.
+	\param	str	The string to write.
+*/
+static void
+write_json_string(FILE *out, char const *str)
+{
+	fputc('"',out);
+	for (; *str; ++str) {
+		unsigned char ch = (unsigned char)*str;
+		if (ch == '"' || ch == '\\') {
+			fputc('\\',out);
+			fputc(ch,out);
+		}
+		else if (ch < 0x20) {
+			fprintf(out,"\\u%04x",ch);
+		}
+		else {
+			fputc(ch,out);
+		}
+	}
+	fputc('"',out);
+}
+
+/*! Begin a trace event, separating it from the last.
+	\param	name	The name of the event.
+	\param	cat		The category of the event.
+	\param	ph		The phase of the event, in the trace-event sense.
+	\param	wall	The wall-clock time of the event.
+
+	The event is left open for further fields.
+*/
+static void
+begin_event(char const *name, char const *cat, char ph, double wall)
+{
+	FILE *out = GET_STATE(timeline,out);
+	if (SET_STATE(timeline,events)++) {
+		fputs(",\n",out);
+	}
+	fputs("{\"name\":",out);
+	write_json_string(out,name);
+	fprintf(out,",\"cat\":\"%s\",\"ph\":\"%c\",\"ts\":%.3f,"
+		"\"pid\":1,\"tid\":1",cat,ph,TIMESTAMP(wall));
+}
+
+/*! Write the span of the current run of a stage, if it is long enough
+	to be shown.
+*/
+static void
+end_run(void)
+{
+	double dur = GET_STATE(timeline,run_end) - GET_STATE(timeline,run_start);
+	if (GET_STATE(timeline,run_stage) != STAGE_NONE &&
+		dur >= TIMELINE_MIN_RUN) {
+		begin_event(stage_names[GET_STATE(timeline,run_stage)],"stage",'X',
+			GET_STATE(timeline,run_start));
+		fprintf(GET_STATE(timeline,out),",\"dur\":%.3f}",dur * 1e6);
+	}
+	SET_STATE(timeline,run_stage) = STAGE_NONE;
+}
+
+/*! Divide the time spent on untimed lines of the current input file
+	between the stages that lines pass through, in proportion to the time
+	timed in each.
+*/
+static void
+apportion_untimed(void)
+{
+	double *stage_time = SET_STATE(timeline,stage_time);
+	double timed = stage_time[STAGE_READ] + stage_time[STAGE_LEX_EVAL] +
+		stage_time[STAGE_WRITE];
+	int i;
+	if (timed <= 0) {
+		stage_time[STAGE_LEX_EVAL] += GET_STATE(timeline,untimed);
+		return;
+	}
+	for (i = STAGE_READ; i <= STAGE_WRITE; ++i) {
+		stage_time[i] += GET_STATE(timeline,untimed) * stage_time[i] / timed;
+	}
+}
+
+/*! Enter an input file in the list of the slowest, if it is one.
+	\param	name	The name of the file.
+	\param	time	The time taken by the file, in seconds.
+*/
+static void
+rank_file(char const *name, double time)
+{
+	slow_file_t *slowest = SET_STATE(timeline,slowest);
+	unsigned i = GET_STATE(timeline,slow_count);
+	if (i == TIMELINE_SLOWEST) {
+		if (time <= slowest[i - 1].time) {
+			return;
+		}
+		free(slowest[--i].name);
+	}
+	else {
+		++SET_STATE(timeline,slow_count);
+	}
+	for (; i && slowest[i - 1].time < time; --i) {
+		slowest[i] = slowest[i - 1];
+	}
+	slowest[i].name = allocate(strlen(name) + 1);
+	strcpy(slowest[i].name,name);
+	slowest[i].time = time;
+}
+
+/*! Count an input file in the histogram.
+	\param	time	The time taken by the file, in seconds.
+*/
+static void
+count_file(double time)
+{
+	double bound = 1e-6;
+	unsigned i;
+	for (i = 0; i < TIMELINE_BUCKETS - 1 && time > bound; ++i) {
+		bound *= 2;
+	}
+	++SET_STATE(timeline,histogram)[i];
+}
+
+/*! Write the slowest input files and the histogram */
+static void
+write_summary(void)
+{
+	FILE *out = GET_STATE(timeline,out);
+	unsigned i;
+	fprintf(out,"\n],\"otherData\":{\"version\":\"%s\",\"files\":%u,"
+		"\"slowest\":[",VERSION,GET_STATE(timeline,files));
+	for (i = 0; i < GET_STATE(timeline,slow_count); ++i) {
+		fputs(i ? ",{\"file\":" : "{\"file\":",out);
+		write_json_string(out,GET_STATE(timeline,slowest)[i].name);
+		fprintf(out,",\"us\":%.3f}",GET_STATE(timeline,slowest)[i].time * 1e6);
+	}
+	fputs("],\"histogram\":[",out);
+	for (i = 0; i < TIMELINE_BUCKETS; ++i) {
+		if (i) {
+			fputc(',',out);
+		}
+		if (i < TIMELINE_BUCKETS - 1) {
+			fprintf(out,"{\"le_us\":%lu,",1UL << i);
+		}
+		else {
+			fputs("{\"le_us\":null,",out);
+		}
+		fprintf(out,"\"files\":%lu}",GET_STATE(timeline,histogram)[i]);
+	}
+	fputs("]}}\n",out);
+}
+
+/*@}*/
+
+/* API ***************************************************************/
+
+void
+timeline_start(void)
+{
+	SET_STATE(timeline,out) = open_file(GET_PUBLIC(args,trace_file),"w");
+	SET_STATE(timeline,start) = stats_wall_clock();
+	SET_STATE(timeline,run_stage) = STAGE_NONE;
+	fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n",
+		GET_STATE(timeline,out));
+	begin_event("process_name","__metadata",'M',GET_STATE(timeline,start));
+	fprintf(GET_STATE(timeline,out),",\"args\":{\"name\":\"%s\"}}",
+		GET_PUBLIC(args,prog_name));
+	SET_PUBLIC(timeline,enabled) = true;
+}
+
+void
+timeline_begin_file(char const *filename)
+{
+	if (!GET_PUBLIC(timeline,enabled)) {
+		return;
+	}
+	SET_STATE(timeline,file) = filename;
+	SET_STATE(timeline,file_errors) = GET_PUBLIC(dataset,errorfiles);
+	memset(SET_STATE(timeline,stage_time),0,STAGES * sizeof(double));
+	SET_STATE(timeline,untimed) = 0;
+	SET_STATE(timeline,file_start) = stats_wall_clock();
+}
+
+void
+timeline_end_file(void)
+{
+	FILE *out = GET_STATE(timeline,out);
+	double end, time;
+	int i;
+	if (!GET_PUBLIC(timeline,enabled) || !GET_STATE(timeline,file)) {
+		return;
+	}
+	end = stats_wall_clock();
+	time = end - GET_STATE(timeline,file_start);
+	end_run();
+	apportion_untimed();
+	begin_event(GET_STATE(timeline,file),"file",'X',
+		GET_STATE(timeline,file_start));
+	fprintf(out,",\"dur\":%.3f,\"args\":{",time * 1e6);
+	for (i = 0; i < STAGES; ++i) {
+		fprintf(out,"\"%s_us\":%.3f,",stage_names[i],
+			GET_STATE(timeline,stage_time)[i] * 1e6);
+	}
+	fprintf(out,"\"error\":%s}}",
+		GET_PUBLIC(dataset,errorfiles) != GET_STATE(timeline,file_errors) ?
+			"true" : "false");
+	++SET_STATE(timeline,files);
+	rank_file(GET_STATE(timeline,file),time);
+	count_file(time);
+	SET_STATE(timeline,file) = NULL;
+}
+
+void
+timeline_enter_dir(char const *dirname)
+{
+	if (GET_PUBLIC(timeline,enabled)) {
+		begin_event(dirname,"dir",'B',stats_wall_clock());
+		fputc('}',GET_STATE(timeline,out));
+		++SET_STATE(timeline,dirs);
+	}
+}
+
+void
+timeline_leave_dir(void)
+{
+	if (GET_PUBLIC(timeline,enabled) && GET_STATE(timeline,dirs)) {
+		begin_event("","dir",'E',stats_wall_clock());
+		fputc('}',GET_STATE(timeline,out));
+		--SET_STATE(timeline,dirs);
+	}
+}
+
+void
+timeline_charge(stats_phase_t phase, double from, double to)
+{
+	stage_t stage = stage_of_phase[phase];
+	if (!GET_STATE(timeline,file) || stage == STAGE_NONE) {
+		return;
+	}
+	if (from < GET_STATE(timeline,file_start)) {
+		from = GET_STATE(timeline,file_start);
+	}
+	SET_STATE(timeline,stage_time)[stage] += to - from;
+	if (stage != GET_STATE(timeline,run_stage)) {
+		end_run();
+		SET_STATE(timeline,run_stage) = stage;
+		SET_STATE(timeline,run_start) = from;
+	}
+	SET_STATE(timeline,run_end) = to;
+}
+
+void
+timeline_charge_untimed(double from, double to)
+{
+	if (GET_STATE(timeline,file)) {
+		end_run();
+		SET_STATE(timeline,untimed) += to - from;
+	}
+}
+
+void
+timeline_finish(void)
+{
+	if (!GET_PUBLIC(timeline,enabled)) {
+		return;
+	}
+	timeline_end_file();
+	while (GET_STATE(timeline,dirs)) {
+		timeline_leave_dir();
+	}
+	SET_PUBLIC(timeline,enabled) = false;
+	write_summary();
+	fclose(GET_STATE(timeline,out));
+	SET_STATE(timeline,out) = NULL;
+}
+
+/* EOF */
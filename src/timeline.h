@@ -0,0 +1,142 @@
+#ifndef TIMELINE_H
+#define TIMELINE_H
+/***************************************************************************
+ *   Copyright (C) 2004, 2006 Symbian Software Ltd.                        *
+ *   All rights reserved.                                                  *
+ *   Copyright (C) 2007, 2008 Mike Kinghan, imk@strudl.org                 *
+ *   All rights reserved.                                                  *
+ *                                                                         *
+ *   Contributed originally by Mike Kinghan, imk@strudl.org                *
+ *                                                                         *
+ *   Redistribution and use in source and binary forms, with or without    *
+ *   modification, are permitted provided that the following conditions    *
+ *   are met:                                                              *
+ *                                                                         *
+ *   Redistributions of source code must retain the above copyright        *
+ *   notice, this list of conditions and the following disclaimer.         *
+ *                                                                         *
+ *   Redistributions in binary form must reproduce the above copyright     *
+ *   notice, this list of conditions and the following disclaimer in the   *
+ *   documentation and/or other materials provided with the distribution.  *
+ *                                                                         *
+ *   Neither the name of Symbian Software Ltd. nor the names of its        *
+ *   contributors may be used to endorse or promote products derived from  *
+ *   this software without specific prior written permission.              *
+ *                                                                         *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS   *
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT     *
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS    *
+ *   FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE        *
+ *   COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,   *
+ *   INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,  *
+ *   BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS *
+ *   OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED    *
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,*
+ *   OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF *
+ *   THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH  *
+ *   DAMAGE.                                                               *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "opts.h"
+#include "bool.h"
+#include "stats.h"
+
+/*!\ingroup timeline_module, timeline_interface
+ *\file timeline.h
+ * This file provides the Timeline module interface.
+ *
+ *	With the \c --trace option the Timeline module writes a timeline of
+ *	the run to a file in the Chrome trace-event JSON format, which can be
+ *	loaded in \c chrome://tracing or Perfetto. Each input file is a span,
+ *	and within it the stages of processing the file are spans: open,
+ *	read, lex and evaluate, write and commit. The spans of directories
+ *	enclose the spans of their files. The trace ends with the slowest
+ *	input files and a histogram of the time taken per file.
+ *
+ *	The stages are timed by the Stats module. Unless the \c --stats
+ *	option is also given, the stages of only a sample of the input lines
+ *	are timed and the times of reading, lexing and evaluating, and
+ *	writing each file are estimates.
+ */
+
+/*! \addtogroup timeline_interface */
+/*@{*/
+
+/*! The number of the slowest input files that are listed */
+#define TIMELINE_SLOWEST	10
+
+/*! The shortest time in seconds for which a stage must run to be a span
+	of its own. The stages of processing interleave on each line, and
+	shorter runs are only added into the totals of the file's span.
+*/
+#define TIMELINE_MIN_RUN	0.00005
+
+/*! Open the trace file and start the timeline. */
+extern void
+timeline_start(void);
+
+/*! Begin the span of an input file.
+	\param	filename	The name of the file.
+*/
+extern void
+timeline_begin_file(char const *filename);
+
+/*! End the span of the current input file. */
+extern void
+timeline_end_file(void);
+
+/*! Begin the span of a directory.
+	\param	dirname		The name of the directory.
+*/
+extern void
+timeline_enter_dir(char const *dirname);
+
+/*! End the span of the innermost directory. */
+extern void
+timeline_leave_dir(void);
+
+/*! Account a period spent in a phase of processing to the stages of
+	the current input file, if any.
+
+	\param	phase	The phase.
+	\param	from	The wall-clock time at the start of the period.
+	\param	to		The wall-clock time at the end of the period.
+
+	Called by the Stats module on each change of phase.
+*/
+extern void
+timeline_charge(stats_phase_t phase, double from, double to);
+
+/*! Account a period spent on input lines whose phases were not timed
+	to the current input file.
+
+	\param	from	The wall-clock time at the start of the period.
+	\param	to		The wall-clock time at the end of the period.
+
+	The period is divided between the stages of reading, lexing and
+	evaluating, and writing in proportion to the time timed in each.
+*/
+extern void
+timeline_charge_untimed(double from, double to);
+
+/*! End any open spans, write the slowest input files and the histogram,
+	and close the trace file, if the \c --trace option is in force.
+*/
+extern void
+timeline_finish(void);
+
+/*@}*/
+
+/*! \addtogroup timeline_interface_state_utils */
+/*@{*/
+
+/*! The public state of the Timeline module */
+PUBLIC_STATE_DEF(timeline) {
+	bool enabled;	/*!< Is the \c --trace option in force? */
+} PUBLIC_STATE_T(timeline);
+
+IMPORT(timeline);
+/*@}*/
+
+#endif /* EOF */
@@ -0,0 +1,391 @@
+/***************************************************************************
+ *   Copyright (C) 2004, 2006 Symbian Software Ltd.                        *
+ *   All rights reserved.                                                  *
+ *   Copyright (C) 2007, 2008 Mike Kinghan, imk@strudl.org                 *
+ *   All rights reserved.                                                  *
+ *                                                                         *
+ *   Contributed originally by Mike Kinghan, imk@strudl.org                *
+ *                                                                         *
+ *   Redistribution and use in source and binary forms, with or without    *
+ *   modification, are permitted provided that the following conditions    *
+ *   are met:                                                              *
+ *                                                                         *
+ *   Redistributions of source code must retain the above copyright        *
+ *   notice, this list of conditions and the following disclaimer.         *
+ *                                                                         *
+ *   Redistributions in binary form must reproduce the above copyright     *
+ *   notice, this list of conditions and the following disclaimer in the   *
+ *   documentation and/or other materials provided with the distribution.  *
+ *                                                                         *
+ *   Neither the name of Symbian Software Ltd. nor the names of its        *
+ *   contributors may be used to endorse or promote products derived from  *
+ *   this software without specific prior written permission.              *
+ *                                                                         *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS   *
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT     *
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS    *
+ *   FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE        *
+ *   COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,   *
+ *   INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,  *
+ *   BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS *
+ *   OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED    *
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,*
+ *   OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF *
+ *   THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH  *
+ *   DAMAGE.                                                               *
+ *                                                                         *
+ ***************************************************************************/
+#include "trace.h"
+#include "report.h"
+
+#ifdef SUNIFDEF_TRACE
+
+#include "args.h"
+#include "chew.h"
+#include "if_control.h"
+#include "io.h"
+#include "memory.h"
+#include "platform.h"
+#include "thread.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#endif /* SUNIFDEF_TRACE */
+
+/*!\ingroup trace_module, trace_interface, trace_internals
+ *\file trace.c
+ * This file implements the Trace module.
+ *
+ *	Each thread that records an event is given a ring buffer of
+ *	\c TRACE_RING_SIZE records on its first event. The ring buffers are
+ *	chained, so that all of them can be decoded at exit. A record holds
+ *	the event, the input line number, up to three integer arguments and
+ *	up to \c TRACE_TEXT_MAX bytes of text, copied from the line buffer
+ *	or the symbol table. It is decoded as the text that was formerly
+ *	written by \c debug() as each event happened.
+ */
+
+#ifdef SUNIFDEF_TRACE
+
+/*! \addtogroup trace_internals */
+/*@{*/
+
+/*! The number of records in a ring buffer. A power of 2 */
+#define TRACE_RING_SIZE		16384
+
+/*! The number of bytes of text in a record */
+#define TRACE_TEXT_MAX		40
+
+#ifdef _MSC_VER
+/*! Storage class of the ring buffer of a thread */
+#define TRACE_LOCAL __declspec(thread)
+#else
+#define TRACE_LOCAL __thread
+#endif
+
+/*! Structure of a trace record, 64 bytes */
+typedef struct trace_record {
+	unsigned	seq;	/*!< The sequence number of the record in its ring */
+	int			line;	/*!< The input line number, or 0 */
+	unsigned short	event;	/*!< The \c trace_event_t */
+	unsigned short	len;	/*!< The number of bytes of text */
+	int			args[3];	/*!< The integer arguments */
+	char		text[TRACE_TEXT_MAX];	/*!< The text arguments. A second
+											text follows the first after
+											a nul */
+} trace_record_t;
+
+/*! Structure of the ring buffer of a thread */
+typedef struct trace_ring {
+	struct trace_ring *next;	/*!< The next ring buffer */
+	unsigned	thread;	/*!< The index of the thread, from 0 */
+	unsigned	count;	/*!< The number of records ever written */
+	trace_record_t records[TRACE_RING_SIZE];	/*!< The records */
+} trace_ring_t;
+
+/*! Prefixes for debugging names of the comment states */
+static char const * const comment_name[] = {
+	"NO","C","CXX",	"STARTING",	"FINISHING","PSEUDO"
+};
+
+/*! Prefixes for debugging names of the line states */
+static char const * const linestate_name[] = {
+	"VACANT","DIRECTIVE","CODE"
+};
+
+/*! Debugging names of the \c #if states */
+static char const * const ifstate_name[] = {
+	"OUTSIDE", "FALSE_PREFIX", "TRUE_PREFIX",
+	"PASS_MIDDLE", "FALSE_MIDDLE", "TRUE_MIDDLE",
+	"PASS_ELSE", "FALSE_ELSE", "TRUE_ELSE",
+	"FALSE_TRAILER"
+};
+
+/*! Debugging names of the input line types */
+static char const * const linetype_name[] = {
+	"IF", "TRUE", "FALSE", "ELIF", "ELTRUE", "ELFALSE", "ELSE", "ENDIF",
+	"PLAIN", "EOF", "?",
+	"CONSISTENT DEFINE KEEP","CONSISTENT DEFINE DROP",
+	"CONTRADICTORY DEFINE","DIFFERING DEFINE",
+	"CONSISTENT UNDEF KEEP", "CONSISTENT UNDEF DROP",
+	"CONTRADICTORY UNDEF"
+};
+
+/*! The ring buffer of the calling thread, if any */
+static TRACE_LOCAL trace_ring_t * ring;
+
+/*! The chain of ring buffers */
+static trace_ring_t * rings;
+
+/*! The number of ring buffers */
+static unsigned ring_count;
+
+/*! Lock on the chain of ring buffers */
+static thread_lock_t rings_lock;
+
+/*! Give the calling thread a ring buffer */
+static trace_ring_t *
+new_ring(void)
+{
+	trace_ring_t *fresh = callocate(1,sizeof(trace_ring_t));
+	thread_lock(rings_lock);
+	fresh->thread = ring_count++;
+	fresh->next = rings;
+	rings = fresh;
+	thread_unlock(rings_lock);
+	return fresh;
+}
+
+/*! Get the name in a table of names for a value that indexes it,
+	or "?" if the value is out of range.
+*/
+#define NAME_OF(table,value) \
+	((unsigned)(value) < sizeof(table) / sizeof(table[0]) ? \
+		table[value] : "?")
+
+/*! Decode a record as text.
+	\param	out			The stream on which to write.
+	\param	filename	The name of the file in which the record was made,
+						or NULL.
+	\param	rec			The record.
+*/
+static void
+decode(FILE *out, char const *filename, trace_record_t const *rec)
+{
+	int const *args = rec->args;
+	char const *text2 = rec->text + strlen(rec->text) + 1;
+	if (text2 > rec->text + rec->len) {
+		text2 = "";
+	}
+	fprintf(out,"%s: ",GET_PUBLIC(args,prog_name));
+	if (filename) {
+		fprintf(out,"%s: ",filename);
+	}
+	if (rec->line) {
+		fprintf(out,"line %d: ",rec->line);
+	}
+	switch(rec->event) {
+	case TRACE_PARSER_STATE:
+		fprintf(out,"parser %s comment %s line",
+			NAME_OF(comment_name,args[0]),NAME_OF(linestate_name,args[1]));
+		break;
+	case TRACE_TRANSITION:
+		fprintf(out,"process %s -> %s depth %d",
+			NAME_OF(linetype_name,args[0]),NAME_OF(ifstate_name,args[1]),
+			args[2]);
+		break;
+	case TRACE_FIND_SYM:
+		fprintf(out,"find_sym %s %s",rec->text,text2);
+		break;
+	case TRACE_EVAL_IF:
+		fprintf(out,"eval %s",rec->text);
+		break;
+	case TRACE_EVAL_IF_VALUE:
+		fprintf(out,"eval = %d",args[0]);
+		break;
+	case TRACE_EVAL_DEFINE:
+		fprintf(out,"eval #define %s",rec->text);
+		break;
+	case TRACE_EVAL_DEFINE_TYPE:
+		fprintf(out,"eval #define %s = %s",rec->text,
+			NAME_OF(linetype_name,args[0]));
+		break;
+	case TRACE_EVAL_UNDEF:
+		fprintf(out,"eval #undef %s",rec->text);
+		break;
+	case TRACE_EVAL_UNDEF_TYPE:
+		fprintf(out,"eval #undef %s = %s",rec->text,
+			NAME_OF(linetype_name,args[0]));
+		break;
+	case TRACE_EVAL_TABLE:
+		fprintf(out,"eval%d",args[0]);
+		break;
+	case TRACE_EVAL_OP:
+		fprintf(out,"eval%d %s",args[0],rec->text);
+		break;
+	case TRACE_EVAL_TABLE_VALUE:
+	case TRACE_EVAL_UNARY_VALUE:
+		fprintf(out,"eval%d = %d",args[0],args[1]);
+		break;
+	case TRACE_EVAL_NOT:
+		fprintf(out,"eval%d !",args[0]);
+		break;
+	case TRACE_EVAL_COMPL:
+		fprintf(out,"eval%d ~",args[0]);
+		break;
+	case TRACE_EVAL_PLUS:
+		fprintf(out,"eval%d +",args[0]);
+		break;
+	case TRACE_EVAL_MINUS:
+		fprintf(out,"eval%d -",args[0]);
+		break;
+	case TRACE_EVAL_PAREN:
+		fprintf(out,"eval%d (",args[0]);
+		break;
+	case TRACE_EVAL_NUMBER:
+		fprintf(out,"eval%d number",args[0]);
+		break;
+	case TRACE_EVAL_DEFINED:
+		fprintf(out,"eval%d defined",args[0]);
+		break;
+	case TRACE_EVAL_SYMBOL:
+		fprintf(out,"eval%d symbol",args[0]);
+		break;
+	case TRACE_EVAL_BAD:
+		fprintf(out,"eval%d bad expr",args[0]);
+		break;
+	default:
+		fprintf(out,"event %u",rec->event);
+	}
+	fputc('\n',out);
+}
+
+/*! Decode the records of a ring buffer, oldest first */
+static void
+decode_ring(FILE *out, trace_ring_t const *buffer)
+{
+	unsigned seq = 0;
+	char const *filename = NULL;
+	if (buffer->count > TRACE_RING_SIZE) {
+		seq = buffer->count - TRACE_RING_SIZE;
+		fprintf(out,"%s: trace of thread %u: %u earlier records lost\n",
+			GET_PUBLIC(args,prog_name),buffer->thread,seq);
+	}
+	for (	;seq != buffer->count; ++seq) {
+		trace_record_t const *rec =
+			buffer->records + (seq & (TRACE_RING_SIZE - 1));
+		if (rec->event == TRACE_FILE) {
+			filename = rec->text;
+			continue;
+		}
+		decode(out,filename,rec);
+	}
+}
+
+/*@}*/
+
+bool trace_enabled;
+
+/* API ***************************************************************/
+
+void
+trace_event(trace_event_t event,
+			int arg0,
+			int arg1,
+			int arg2,
+			char const *text,
+			size_t len,
+			char const *text2)
+{
+	trace_record_t *rec;
+	if (!ring) {
+		ring = new_ring();
+	}
+	rec = ring->records + (ring->count & (TRACE_RING_SIZE - 1));
+	rec->seq = ring->count++;
+	rec->line = GET_PUBLIC(io,line_num);
+	rec->event = (unsigned short)event;
+	rec->args[0] = arg0;
+	rec->args[1] = arg1;
+	rec->args[2] = arg2;
+	rec->len = 0;
+	if (text) {
+		if (len == (size_t)-1) {
+			len = strlen(text);
+		}
+		if (event == TRACE_FILE && len >= TRACE_TEXT_MAX) {
+			/* Keep the tail of a long filename */
+			text += len - (TRACE_TEXT_MAX - 1);
+			len = TRACE_TEXT_MAX - 1;
+		}
+		else if (len >= TRACE_TEXT_MAX) {
+			len = TRACE_TEXT_MAX - 1;
+		}
+		memcpy(rec->text,text,len);
+		rec->len = (unsigned short)len;
+	}
+	rec->text[rec->len] = '\0';
+	if (text2 && rec->len + 1 < TRACE_TEXT_MAX) {
+		size_t len2 = strlen(text2);
+		size_t room = TRACE_TEXT_MAX - rec->len - 2;
+		if (len2 > room) {
+			len2 = room;
+		}
+		memcpy(rec->text + rec->len + 1,text2,len2);
+		rec->len += (unsigned short)(len2 + 1);
+		rec->text[rec->len] = '\0';
+	}
+}
+
+void
+trace_start(void)
+{
+	if (!rings_lock) {
+		rings_lock = thread_lock_new();
+	}
+	trace_enabled = true;
+}
+
+void
+trace_dump(void)
+{
+	trace_ring_t *first = NULL;
+	trace_ring_t *next;
+	if (!trace_enabled) {
+		return;
+	}
+	trace_enabled = false;
+	/* The chain is newest first. Decode the first thread first */
+	for (	;rings; rings = next) {
+		next = rings->next;
+		rings->next = first;
+		first = rings;
+	}
+	for (	;first; first = next) {
+		next = first->next;
+		decode_ring(stderr,first);
+		free(first);
+	}
+	fflush(stderr);
+}
+
+#else /* !SUNIFDEF_TRACE */
+
+/* API ***************************************************************/
+
+void
+trace_start(void)
+{
+	report(GRIPE_NO_TRACE,NULL,
+		"--debug is ignored: tracing is not compiled in");
+}
+
+void
+trace_dump(void)
+{
+}
+
+#endif /* SUNIFDEF_TRACE */
+
+/* EOF */
@@ -0,0 +1,189 @@
+#ifndef TRACE_H
+#define TRACE_H
+/***************************************************************************
+ *   Copyright (C) 2004, 2006 Symbian Software Ltd.                        *
+ *   All rights reserved.                                                  *
+ *   Copyright (C) 2007, 2008 Mike Kinghan, imk@strudl.org                 *
+ *   All rights reserved.                                                  *
+ *                                                                         *
+ *   Contributed originally by Mike Kinghan, imk@strudl.org                *
+ *                                                                         *
+ *   Redistribution and use in source and binary forms, with or without    *
+ *   modification, are permitted provided that the following conditions    *
+ *   are met:                                                              *
+ *                                                                         *
+ *   Redistributions of source code must retain the above copyright        *
+ *   notice, this list of conditions and the following disclaimer.         *
+ *                                                                         *
+ *   Redistributions in binary form must reproduce the above copyright     *
+ *   notice, this list of conditions and the following disclaimer in the   *
+ *   documentation and/or other materials provided with the distribution.  *
+ *                                                                         *
+ *   Neither the name of Symbian Software Ltd. nor the names of its        *
+ *   contributors may be used to endorse or promote products derived from  *
+ *   this software without specific prior written permission.              *
+ *                                                                         *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS   *
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT     *
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS    *
+ *   FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE        *
+ *   COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,   *
+ *   INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,  *
+ *   BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS *
+ *   OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED    *
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,*
+ *   OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF *
+ *   THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH  *
+ *   DAMAGE.                                                               *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "opts.h"
+#include "bool.h"
+#include <stddef.h>
+
+/*!\ingroup trace_module, trace_interface
+ *\file trace.h
+ * This file provides the Trace module interface.
+ *
+ *	The Trace module records the steps of the parser and the evaluator
+ *	for debugging. Tracing is compiled in only if \c SUNIFDEF_TRACE is
+ *	defined, e.g. by <tt>./configure CPPFLAGS=-DSUNIFDEF_TRACE</tt>.
+ *	Otherwise the \c TRACE macros expand to nothing and their arguments
+ *	are not evaluated, so tracing costs nothing.
+ *
+ *	When tracing is compiled in and the \c --debug option is in force,
+ *	each event is written as a fixed-size binary record to a ring buffer
+ *	belonging to the thread. No text is formatted as events happen. The
+ *	records are decoded as text on \c stderr at exit. When a ring buffer
+ *	wraps, the oldest records are lost.
+ */
+
+/*! \addtogroup trace_interface */
+/*@{*/
+
+/*! Enumeration of trace events. The arguments of each are described */
+typedef enum {
+	TRACE_FILE,		/*!< Processing a file. Text: the filename */
+	TRACE_PARSER_STATE,	/*!< A line is lexed. Args: the comment state
+							and the line state */
+	TRACE_TRANSITION,	/*!< A line is despatched. Args: the line type,
+							the \c #if state and the \c #if depth */
+	TRACE_FIND_SYM,	/*!< A symbol is found. Text: its name and its
+						definition */
+	TRACE_EVAL_IF,	/*!< An \c #if expression is evaluated. Text: the
+						expression */
+	TRACE_EVAL_IF_VALUE,	/*!< An \c #if expression is evaluated. Arg: the
+								value */
+	TRACE_EVAL_DEFINE,	/*!< A \c #define is evaluated. Text: the
+							directive */
+	TRACE_EVAL_DEFINE_TYPE,	/*!< A \c #define is evaluated. Arg: the line
+								type. Text: the directive */
+	TRACE_EVAL_UNDEF,	/*!< An \c #undef is evaluated. Text: the
+							directive */
+	TRACE_EVAL_UNDEF_TYPE,	/*!< An \c #undef is evaluated. Arg: the line
+								type. Text: the directive */
+	TRACE_EVAL_TABLE,	/*!< A binary operator table is entered. Arg: the
+							precedence level */
+	TRACE_EVAL_OP,	/*!< A binary operator is met. Arg: the level.
+						Text: the operator */
+	TRACE_EVAL_TABLE_VALUE,	/*!< A binary operator table is evaluated.
+								Args: the level and the value */
+	TRACE_EVAL_NOT,		/*!< A \c ! operand. Arg: the level */
+	TRACE_EVAL_COMPL,	/*!< A \c ~ operand. Arg: the level */
+	TRACE_EVAL_PLUS,	/*!< A unary \c + operand. Arg: the level */
+	TRACE_EVAL_MINUS,	/*!< A unary \c - operand. Arg: the level */
+	TRACE_EVAL_PAREN,	/*!< A parenthesised operand. Arg: the level */
+	TRACE_EVAL_NUMBER,	/*!< A numeral operand. Arg: the level */
+	TRACE_EVAL_DEFINED,	/*!< A \c defined operand. Arg: the level */
+	TRACE_EVAL_SYMBOL,	/*!< A symbol operand. Arg: the level */
+	TRACE_EVAL_BAD,		/*!< A bad operand. Arg: the level */
+	TRACE_EVAL_UNARY_VALUE,	/*!< An operand is evaluated. Args: the
+								level and the value */
+	TRACE_EVENTS		/*!< The number of events */
+} trace_event_t;
+
+#ifdef SUNIFDEF_TRACE
+
+/*! Is the \c --debug option in force? */
+extern bool trace_enabled;
+
+/*! Trace an event with integer arguments.
+	\param	event	The \c trace_event_t
+	\param	arg0	The first argument, or 0
+	\param	arg1	The second argument, or 0
+	\param	arg2	The third argument, or 0
+
+	The macro is an expression of type \c void.
+*/
+#define TRACE(event,arg0,arg1,arg2) \
+	(trace_enabled ? \
+		trace_event(event,(int)(arg0),(int)(arg1),(int)(arg2),NULL,0,NULL) : \
+		(void)0)
+
+/*! Trace an event with an integer argument and a text argument.
+	\param	event	The \c trace_event_t
+	\param	arg0	The integer argument, or 0
+	\param	text	The text
+	\param	len		The length of \c text
+
+	The macro is an expression of type \c void.
+*/
+#define TRACE_TEXT(event,arg0,text,len) \
+	(trace_enabled ? \
+		trace_event(event,(int)(arg0),0,0,text,len,NULL) : (void)0)
+
+/*! Trace an event with two null-terminated text arguments.
+
+	The macro is an expression of type \c void.
+*/
+#define TRACE_TEXTS(event,text,text2) \
+	(trace_enabled ? \
+		trace_event(event,0,0,0,text,(size_t)-1,text2) : (void)0)
+
+/*! Record an event in the ring buffer of the calling thread.
+
+	\param	event	The \c trace_event_t
+	\param	arg0	The first integer argument
+	\param	arg1	The second integer argument
+	\param	arg2	The third integer argument
+	\param	text	NULL, or a text argument
+	\param	len		The length of \c text, or <tt>(size_t)-1</tt> if it
+					is null-terminated
+	\param	text2	NULL, or a second null-terminated text argument
+
+	The text is truncated to fit the record. Call through the \c TRACE
+	macros.
+*/
+extern void
+trace_event(trace_event_t event,
+			int arg0,
+			int arg1,
+			int arg2,
+			char const *text,
+			size_t len,
+			char const *text2);
+
+#else /* !SUNIFDEF_TRACE */
+
+#define TRACE(event,arg0,arg1,arg2)		((void)0)
+#define TRACE_TEXT(event,arg0,text,len)	((void)0)
+#define TRACE_TEXTS(event,text,text2)	((void)0)
+
+#endif /* SUNIFDEF_TRACE */
+
+/*! Start tracing for the \c --debug option.
+
+	If tracing is not compiled in a warning is given and there is no
+	tracing.
+*/
+extern void
+trace_start(void);
+
+/*! Decode the trace records on \c stderr, if tracing is in force. */
+extern void
+trace_dump(void);
+
+/*@}*/
+
+#endif /* EOF */
@@ -0,0 +1,525 @@
+/***************************************************************************
+ *   Copyright (C) 2004, 2006 Symbian Software Ltd.                        *
+ *   All rights reserved.                                                  *
+ *   Copyright (C) 2007, 2008 Mike Kinghan, imk@strudl.org                 *
+ *   All rights reserved.                                                  *
+ *                                                                         *
+ *   Contributed originally by Mike Kinghan, imk@strudl.org                *
+ *                                                                         *
+ *   Redistribution and use in source and binary forms, with or without    *
+ *   modification, are permitted provided that the following conditions    *
+ *   are met:                                                              *
+ *                                                                         *
+ *   Redistributions of source code must retain the above copyright        *
+ *   notice, this list of conditions and the following disclaimer.         *
+ *                                                                         *
+ *   Redistributions in binary form must reproduce the above copyright     *
+ *   notice, this list of conditions and the following disclaimer in the   *
+ *   documentation and/or other materials provided with the distribution.  *
+ *                                                                         *
+ *   Neither the name of Symbian Software Ltd. nor the names of its        *
+ *   contributors may be used to endorse or promote products derived from  *
+ *   this software without specific prior written permission.              *
+ *                                                                         *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS   *
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT     *
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS    *
+ *   FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE        *
+ *   COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,   *
+ *   INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,  *
+ *   BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS *
+ *   OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED    *
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,*
+ *   OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF *
+ *   THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH  *
+ *   DAMAGE.                                                               *
+ *                                                                         *
+ ***************************************************************************/
+#include "watch.h"
+#include "args.h"
+#include "dataset.h"
+#include "filesys.h"
+#include "hash.h"
+#include "memory.h"
+#include "platform.h"
+#include "report.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __linux__
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+#endif
+
+/*!\ingroup watch_module, watch_interface, watch_internals
+ *\file watch.c
+ * This file implements the Watch module.
+ *
+ *	The module is implemented with \c inotify, so it is only available
+ *	on Linux. Each directory searched for input files is watched for files
+ *	written and closed or moved in, and for directories created or moved
+ *	in. Files are not taken up when they are created, because a file
+ *	replaced while its writer still has it open would lose the rest of
+ *	what is written. The directories above the input paths are in the
+ *	input file tree but are not watched, lest files beside the inputs
+ *	be taken for inputs.
+ *
+ *	Each file processed is entered in a table with its stamp as it was
+ *	left, so that the events raised by replacing it are recognised and
+ *	do not set off another round. Events for files that no longer exist,
+ *	such as the temporary output files, are ignored.
+ */
+
+/*! \addtogroup watch_internals */
+/*@{*/
+
+/*! The events watched in each directory */
+#define WATCH_EVENTS	(IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_MOVE_SELF)
+
+/*! The size of the buffer in which events are read */
+#define WATCH_BUFSIZE	65536
+
+/*! Structure of the entry of a file in the table of files met */
+typedef struct watched_file {
+	heap_str	name;		/*!< The name of the file */
+	fs_stamp_t	stamp;		/*!< Its stamp as it was left when processed */
+	bool		processed;	/*!< Has it been processed? */
+	bool		pending;	/*!< Is it to be processed in this batch? */
+} watched_file_t;
+
+/*! Dispose of a vector of names, if any, and of the names in it */
+static void
+dispose_names(ptr_vector_h *names)
+{
+	if (*names) {
+		heap_str *name = (heap_str *)ptr_vector_start(*names);
+		heap_str *end = (heap_str *)ptr_vector_end(*names);
+		for (	;name != end; ++name) {
+			free(*name);
+		}
+		ptr_vector_dispose(names);
+	}
+}
+
+/*@}*/
+
+/*! \addtogroup watch_internals_state_utils */
+/*@{*/
+
+/*! The state of the Watch module */
+STATE_DEF(watch) {
+	int		fd;			/*!< The inotify instance */
+	heap_str *	dirs;	/*!< The name of the directory watched by each
+							watch descriptor, or NULL */
+	size_t	dirs_size;	/*!< The number of elements of \c dirs */
+	unsigned watched;	/*!< The number of directories watched */
+	watched_file_t **slots;	/*!< Hash table, with open addressing, of the
+								files met, by name. NULL marks an empty
+								slot */
+	size_t	size;		/*!< The number of slots, a power of 2 */
+	size_t	count;		/*!< The number of files met */
+	watched_file_t **pending;	/*!< The files to be processed in this
+									batch */
+	size_t	pending_count;	/*!< The number of elements of \c pending */
+	size_t	pending_size;	/*!< The capacity of \c pending */
+	ptr_vector_h changed;	/*!< The names of files changed in this batch */
+	ptr_vector_h appeared;	/*!< The names of directories that appeared
+								in this batch */
+} STATE_T(watch);
+
+NO_PUBLIC_STATE(watch);
+
+IMPLEMENT(watch,USER_INITABLE);
+
+DEFINE_USER_INIT(watch)(STATE_T(watch) * watch_st)
+{
+	watch_st->fd = -1;
+}
+
+DEFINE_USER_FINIS(watch)(STATE_T(watch) * watch_st)
+{
+	size_t i;
+	for (i = 0; i < watch_st->dirs_size; ++i) {
+		free(watch_st->dirs[i]);
+	}
+	free(watch_st->dirs);
+	for (i = 0; i < watch_st->size; ++i) {
+		if (watch_st->slots[i]) {
+			free(watch_st->slots[i]->name);
+			free(watch_st->slots[i]);
+		}
+	}
+	free(watch_st->slots);
+	free(watch_st->pending);
+	dispose_names(&watch_st->changed);
+	dispose_names(&watch_st->appeared);
+}
+/*@}*/
+
+#ifdef __linux__
+
+/*! \addtogroup watch_internals */
+/*@{*/
+
+/*! Set when the watch is to stop */
+static volatile sig_atomic_t stopping;
+
+/*! Signal handler that stops the watch */
+static void
+stop(int signum)
+{
+	(void)signum;
+	stopping = 1;
+}
+
+/*! Get the slot of a file in the table of files met.
+	\return	The slot that holds the entry of \c filename, or the empty
+			slot at which it would be inserted.
+ */
+static watched_file_t **
+find_slot(char const *filename)
+{
+	size_t mask = GET_STATE(watch,size) - 1;
+	size_t slot = (size_t)hash_str(HASH_INIT,filename) & mask;
+	watched_file_t **slots = GET_STATE(watch,slots);
+	for (	;slots[slot]; slot = (slot + 1) & mask) {
+		if (!strcmp(slots[slot]->name,filename)) {
+			break;
+		}
+	}
+	return slots + slot;
+}
+
+/*! Get the entry of a file in the table of files met, making a new entry
+	if there is none. The table is kept at most half full.
+ */
+static watched_file_t *
+get_entry(char const *filename)
+{
+	watched_file_t **slot;
+	if ((GET_STATE(watch,count) + 1) * 2 > GET_STATE(watch,size)) {
+		watched_file_t **old = GET_STATE(watch,slots);
+		size_t old_size = GET_STATE(watch,size);
+		size_t i;
+		SET_STATE(watch,size) = old_size ? old_size * 2 : 256;
+		SET_STATE(watch,slots) =
+			callocate(GET_STATE(watch,size),sizeof(watched_file_t *));
+		for (i = 0; i < old_size; ++i) {
+			if (old[i]) {
+				*find_slot(old[i]->name) = old[i];
+			}
+		}
+		free(old);
+	}
+	slot = find_slot(filename);
+	if (!*slot) {
+		size_t len = strlen(filename);
+		*slot = callocate(1,sizeof(watched_file_t));
+		(*slot)->name = allocate(len + 1);
+		memcpy((*slot)->name,filename,len + 1);
+		++SET_STATE(watch,count);
+	}
+	return *slot;
+}
+
+/*! Say whether two file stamps are the same */
+static bool
+same_stamp(fs_stamp_t const *lhs, fs_stamp_t const *rhs)
+{
+	return lhs->size == rhs->size && lhs->mtime == rhs->mtime &&
+		lhs->mtime_ns == rhs->mtime_ns && lhs->inode == rhs->inode &&
+		lhs->device == rhs->device;
+}
+
+/*! Append a copy of a name to a vector of names */
+static void
+append_name(ptr_vector_h names, char const *name)
+{
+	size_t len = strlen(name);
+	heap_str copy = allocate(len + 1);
+	memcpy(copy,name,len + 1);
+	ptr_vector_append(names,copy);
+}
+
+/*! Start watching a directory, unless it is already watched or has
+	gone.
+ */
+static void
+add_watch(char const *dirname)
+{
+	int wd = inotify_add_watch(GET_STATE(watch,fd),dirname,
+		WATCH_EVENTS | IN_ONLYDIR);
+	size_t len;
+	if (wd < 0) {
+		if (errno == ENOENT || errno == ENOTDIR) {
+			return;
+		}
+		bail(GRIPE_CANT_WATCH,"Can't watch directory \"%s\": %s",
+			dirname,strerror(errno));
+	}
+	if ((size_t)wd >= GET_STATE(watch,dirs_size)) {
+		size_t old_size = GET_STATE(watch,dirs_size);
+		size_t size = old_size ? old_size : 64;
+		while (size <= (size_t)wd) {
+			size *= 2;
+		}
+		SET_STATE(watch,dirs) =
+			reallocate(GET_STATE(watch,dirs),size * sizeof(heap_str));
+		memset(GET_STATE(watch,dirs) + old_size,0,
+			(size - old_size) * sizeof(heap_str));
+		SET_STATE(watch,dirs_size) = size;
+	}
+	if (GET_STATE(watch,dirs)[wd]) {
+		return;
+	}
+	len = strlen(dirname);
+	SET_STATE(watch,dirs)[wd] = allocate(len + 1);
+	memcpy(GET_STATE(watch,dirs)[wd],dirname,len + 1);
+	++SET_STATE(watch,watched);
+}
+
+/*! Stop accounting for a watch that the system has removed */
+static void
+drop_watch(int wd)
+{
+	if ((size_t)wd < GET_STATE(watch,dirs_size) &&
+		GET_STATE(watch,dirs)[wd]) {
+		free(GET_STATE(watch,dirs)[wd]);
+		SET_STATE(watch,dirs)[wd] = NULL;
+		--SET_STATE(watch,watched);
+	}
+}
+
+/*! Watch the directories searched for input files since the last call,
+	and forget them.
+*/
+static void
+watch_searched(void)
+{
+	ptr_vector_h names = GET_PUBLIC(dataset,searched_dirs);
+	if (names) {
+		heap_str *name = (heap_str *)ptr_vector_start(names);
+		heap_str *end = (heap_str *)ptr_vector_end(names);
+		for (	;name != end; ++name) {
+			add_watch(*name);
+		}
+		dispose_names(&SET_PUBLIC(dataset,searched_dirs));
+	}
+}
+
+/*! The \c file_tree_callback_t that is passed to \c dataset_update().
+	It enters the files found in the batch to be processed.
+*/
+static void
+found_proc(	file_tree_h tree,
+			char const *name,
+			file_tree_traverse_state_t context)
+{
+	(void)tree;
+	if (context == FT_AT_FILE) {
+		watched_file_t *entry = get_entry(name);
+		if (entry->pending) {
+			return;
+		}
+		if (GET_STATE(watch,pending_count) == GET_STATE(watch,pending_size)) {
+			SET_STATE(watch,pending_size) = GET_STATE(watch,pending_size) ?
+				GET_STATE(watch,pending_size) * 2 : 64;
+			SET_STATE(watch,pending) = reallocate(GET_STATE(watch,pending),
+				GET_STATE(watch,pending_size) * sizeof(watched_file_t *));
+		}
+		SET_STATE(watch,pending)[SET_STATE(watch,pending_count)++] = entry;
+		entry->pending = true;
+	}
+}
+
+/*! Enter every file in the directories watched as changed, when events
+	have been lost.
+*/
+static void
+rescan(void)
+{
+	size_t i;
+	report(GRIPE_WATCH_OVERFLOW,NULL,
+		"Too many changes at once. Searching the watched directories again");
+	for (i = 0; i < GET_STATE(watch,dirs_size); ++i) {
+		char const *fullname;
+		fs_dir_t dir;
+		if (!GET_STATE(watch,dirs)[i]) {
+			continue;
+		}
+		dir = fs_open_dir(GET_STATE(watch,dirs)[i],NULL);
+		if (!dir) {
+			continue;
+		}
+		while (fs_read_dir(dir,&fullname) != NULL) {
+			if (FS_IS_DIR(fs_cur_entry_type(dir))) {
+				append_name(GET_STATE(watch,appeared),fullname);
+			}
+			else {
+				append_name(GET_STATE(watch,changed),fullname);
+			}
+		}
+		fs_close_dir(dir);
+	}
+}
+
+/*! Read the pending events and note the files changed and the
+	directories that appeared.
+*/
+static void
+read_events(void)
+{
+	union {
+		struct inotify_event event;
+		char bytes[WATCH_BUFSIZE];
+	} buf;
+	ssize_t len = read(GET_STATE(watch,fd),buf.bytes,sizeof(buf));
+	char const *at = buf.bytes;
+	if (len <= 0) {
+		return;
+	}
+	while (at < buf.bytes + len) {
+		struct inotify_event const *event = (struct inotify_event const *)at;
+		char const *dirname = (size_t)event->wd < GET_STATE(watch,dirs_size) ?
+			GET_STATE(watch,dirs)[event->wd] : NULL;
+		at += sizeof(struct inotify_event) + event->len;
+		if (event->mask & IN_Q_OVERFLOW) {
+			rescan();
+		}
+		else if (event->mask & IN_IGNORED) {
+			drop_watch(event->wd);
+		}
+		else if (event->mask & IN_MOVE_SELF) {
+			/* The name of the directory is stale. Its new name will be
+				searched if it appears where it is watched */
+			inotify_rm_watch(GET_STATE(watch,fd),event->wd);
+		}
+		else if (dirname && event->len) {
+			heap_str name = fs_compose_filename(dirname,event->name);
+			if (event->mask & IN_ISDIR) {
+				if (event->mask & (IN_CREATE | IN_MOVED_TO)) {
+					ptr_vector_append(GET_STATE(watch,appeared),name);
+					name = NULL;
+				}
+			}
+			else if (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO)) {
+				ptr_vector_append(GET_STATE(watch,changed),name);
+				name = NULL;
+			}
+			free(name);
+		}
+	}
+}
+
+/*! Wait for events.
+	\param	timeout	The longest time to wait in milliseconds, or -1 to
+					wait indefinitely.
+	\return True iff events are ready to be read.
+*/
+static bool
+await_events(int timeout)
+{
+	struct pollfd pfd;
+	pfd.fd = GET_STATE(watch,fd);
+	pfd.events = POLLIN;
+	pfd.revents = 0;
+	return poll(&pfd,1,timeout) > 0;
+}
+
+/*! Process a batch of changes.
+	\param	callback	The callback of \c watch_run().
+*/
+static void
+process_changes(file_tree_callback_t callback)
+{
+	heap_str *name, *end;
+	size_t i;
+	/* Search the directories first, so that their files are met once */
+	name = (heap_str *)ptr_vector_start(GET_STATE(watch,appeared));
+	end = (heap_str *)ptr_vector_end(GET_STATE(watch,appeared));
+	for (	;name != end; ++name) {
+		dataset_update(*name,found_proc);
+	}
+	name = (heap_str *)ptr_vector_start(GET_STATE(watch,changed));
+	end = (heap_str *)ptr_vector_end(GET_STATE(watch,changed));
+	for (	;name != end; ++name) {
+		dataset_update(*name,found_proc);
+	}
+	watch_searched();
+	dispose_names(&SET_STATE(watch,appeared));
+	dispose_names(&SET_STATE(watch,changed));
+	SET_STATE(watch,appeared) = ptr_vector_new();
+	SET_STATE(watch,changed) = ptr_vector_new();
+	for (i = 0; i < GET_STATE(watch,pending_count); ++i) {
+		watched_file_t *entry = GET_STATE(watch,pending)[i];
+		fs_stamp_t stamp;
+		entry->pending = false;
+		if (stopping || !fs_stamp(entry->name,&stamp) ||
+			(entry->processed && same_stamp(&stamp,&entry->stamp))) {
+			/* Gone, or as we left it */
+			continue;
+		}
+		callback(NULL,entry->name,FT_AT_FILE);
+		entry->processed = fs_stamp(entry->name,&entry->stamp);
+	}
+	if (GET_STATE(watch,pending_count)) {
+		SET_STATE(watch,pending_count) = 0;
+		callback(GET_PUBLIC(dataset,file_tree),NULL,FT_LEAVING_TREE);
+	}
+}
+
+/*@}*/
+
+/* API ***************************************************************/
+
+void
+watch_run(file_tree_callback_t callback)
+{
+	struct sigaction action;
+	SET_STATE(watch,fd) = inotify_init();
+	if (GET_STATE(watch,fd) < 0) {
+		bail(GRIPE_CANT_WATCH,"Can't watch for changes: %s",strerror(errno));
+	}
+	SET_STATE(watch,changed) = ptr_vector_new();
+	SET_STATE(watch,appeared) = ptr_vector_new();
+	watch_searched();
+	memset(&action,0,sizeof(action));
+	action.sa_handler = stop;
+	sigemptyset(&action.sa_mask);
+	/* No SA_RESTART, so that a signal interrupts poll() */
+	sigaction(SIGTERM,&action,NULL);
+	sigaction(SIGINT,&action,NULL);
+	report(PROGRESS_WATCHING,NULL,"Watching %u directories for changes",
+		GET_STATE(watch,watched));
+	while (!stopping) {
+		if (!await_events(-1)) {
+			continue;
+		}
+		read_events();
+		while (!stopping && await_events(WATCH_DEBOUNCE_MS)) {
+			read_events();
+		}
+		process_changes(callback);
+	}
+	close(GET_STATE(watch,fd));
+	SET_STATE(watch,fd) = -1;
+}
+
+#else /* !__linux__ */
+
+/* API ***************************************************************/
+
+void
+watch_run(file_tree_callback_t callback)
+{
+	(void)callback;
+	bail(GRIPE_INVALID_ARGS,"--watch is not supported on this platform");
+}
+
+#endif /* __linux__ */
+
+/* EOF */
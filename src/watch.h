@@ -0,0 +1,88 @@
+#ifndef WATCH_H
+#define WATCH_H
+/***************************************************************************
+ *   Copyright (C) 2004, 2006 Symbian Software Ltd.                        *
+ *   All rights reserved.                                                  *
+ *   Copyright (C) 2007, 2008 Mike Kinghan, imk@strudl.org                 *
+ *   All rights reserved.                                                  *
+ *                                                                         *
+ *   Contributed originally by Mike Kinghan, imk@strudl.org                *
+ *                                                                         *
+ *   Redistribution and use in source and binary forms, with or without    *
+ *   modification, are permitted provided that the following conditions    *
+ *   are met:                                                              *
+ *                                                                         *
+ *   Redistributions of source code must retain the above copyright        *
+ *   notice, this list of conditions and the following disclaimer.         *
+ *                                                                         *
+ *   Redistributions in binary form must reproduce the above copyright     *
+ *   notice, this list of conditions and the following disclaimer in the   *
+ *   documentation and/or other materials provided with the distribution.  *
+ *                                                                         *
+ *   Neither the name of Symbian Software Ltd. nor the names of its        *
+ *   contributors may be used to endorse or promote products derived from  *
+ *   this software without specific prior written permission.              *
+ *                                                                         *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS   *
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT     *
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS    *
+ *   FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE        *
+ *   COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,   *
+ *   INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,  *
+ *   BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS *
+ *   OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED    *
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,*
+ *   OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF *
+ *   THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH  *
+ *   DAMAGE.                                                               *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#include "opts.h"
+#include "file_tree.h"
+
+/*!\ingroup watch_module, watch_interface
+ *\file watch.h
+ * This file provides the Watch module interface.
+ *
+ *	With the \c --watch option, once the input files have been processed
+ *	the Watch module keeps watching the directories searched for them
+ *	and reprocesses the input files that change, so that the output stays
+ *	in step with the sources without full runs. Changes are collected
+ *	until they have been quiet for \c WATCH_DEBOUNCE_MS, and then only the
+ *	files changed are reprocessed. Directories that appear are searched
+ *	and watched in turn. While nothing changes the program sleeps.
+ */
+
+/*! \addtogroup watch_interface */
+/*@{*/
+
+/*! The time in milliseconds for which changes must be quiet before the
+	files changed are reprocessed */
+#define WATCH_DEBOUNCE_MS	200
+
+/*! Watch the directories searched for input files and reprocess input
+	files as they change, until the program receives \c SIGINT or
+	\c SIGTERM.
+
+	\param		callback	The \c file_tree_callback_t with which the input
+							dataset was traversed. It is called with
+							\c FT_AT_FILE for each file to be reprocessed,
+							and NULL for the tree, and with
+							\c FT_LEAVING_TREE after each batch of changes.
+
+	A file is not reprocessed when it is changed by its own replacement.
+*/
+extern void
+watch_run(file_tree_callback_t callback);
+
+/*@}*/
+
+/*! \addtogroup watch_interface_state_utils */
+/*@{*/
+IMPORT_INITOR(watch);
+IMPORT_FINITOR(watch);
+/*@}*/
+
+#endif /* EOF */
@@ -0,0 +1,257 @@
+#!/usr/bin/perl
+
+use strict;
+use Getopt::Long;
+use File::Path;
+use SunifdefLib;
+
+my $rootname = 'bench_scrap';
+my $wipe;
+my $seed = 20080101;
+my $files = 200;
+my $lines = 400;
+my $spread = 0.5;
+my $density = 0.15;
+my $depth = 4;
+my $symbols = 100;
+my $comments = 0.2;
+my $fanout = 20;
+my $help;
+my $verbosity = 'progress';
+my %optmap = (	'rootname' => \$rootname,
+				'wipe' => \$wipe,
+				'seed' => \$seed,
+				'files' => \$files,
+				'lines' => \$lines,
+				'spread' => \$spread,
+				'density' => \$density,
+				'depth' => \$depth,
+				'symbols' => \$symbols,
+				'comments' => \$comments,
+				'fanout' => \$fanout,
+				'help' => \$help,
+				'verbosity' => \$verbosity);
+my $prog = "bench_corpus";
+
+set_prog($prog);
+set_usage(	"$prog: - Create a synthetic tree of C source files for benchmarking sunifdef\n" .
+			"The same arguments always create the same tree, on any platform.\n" .
+			"Usage:\n" .
+			"$prog [--rootname DIRNAME] [--wipe] [--seed NUMBER] [--files NUMBER] " .
+			"[--lines NUMBER] [--spread REAL] [--density REAL] [--depth NUMBER] " .
+			"[--symbols NUMBER] [--comments REAL] [--fanout NUMBER] [--verbosity=LEVEL]\n" .
+			"$prog --help\n" .
+			"Arguments:\n" .
+			"     --help              Display this information on stdout.\n" .
+			"     --rootname DIRNAME  The name of the root directory of the tree. " .
+			"Default \"bench_scrap\". Must not already exist unless --wipe is specified.\n" .
+			"     --wipe              Remove the tree if it already exists.\n" .
+			"     --seed NUMBER       Seed the pseudo random number generator with NUMBER. " .
+			"Default 20080101.\n" .
+			"     --files NUMBER      Create NUMBER files. Default 200.\n" .
+			"     --lines NUMBER      The median number of lines in a file. Default 400.\n" .
+			"     --spread REAL       The spread of file sizes: sizes are log-normally distributed " .
+			"about the median with this standard deviation of the log. 0 makes all files " .
+			"the median size. Default 0.5.\n" .
+			"     --density REAL      The fraction of lines that are directives. Default 0.15.\n" .
+			"     --depth NUMBER      The maximum nesting depth of #if directives. Default 4.\n" .
+			"     --symbols NUMBER    The number of distinct symbols in directives. Default 100.\n" .
+			"     --comments REAL     The fraction of other lines that are comments. Default 0.2.\n" .
+			"     --fanout NUMBER     At most NUMBER files in a directory. Default 20.\n" .
+			"     --verbosity LEVEL   Display diagnostics with severity >= LEVEL, where " .
+    		"LEVEL = 'progress', 'info', 'warning', 'error' or 'fatal'. Default = 'progress'\n" .
+			"NUMBER must in all cases be > 0. Symbols are named SYM0, SYM1,... " .
+			"On success the numbers of files and bytes created are written to stdout.\n");
+
+sub next_random();
+sub uniform($);
+sub chance($);
+sub normal();
+sub symbol();
+sub gen_expression();
+sub gen_plain_line();
+sub gen_file($);
+
+GetOptions(	\%optmap,
+			'rootname=s',
+			'wipe!',
+			'seed=i',
+			'files=i',
+			'lines=i',
+			'spread=f',
+			'density=f',
+			'depth=i',
+			'symbols=i',
+			'comments=f',
+			'fanout=i',
+			'help!',
+			'verbosity=s')  or usage_error();
+
+set_verbosity($verbosity);
+
+if ($help) {
+	help();
+	exit(0);
+}
+
+foreach my $opt ('files','lines','depth','symbols','fanout') {
+	bail(1,"--$opt must be > 0") unless (${$optmap{$opt}} > 0);
+}
+bail(1,"--spread must be >= 0") if ($spread < 0);
+foreach my $opt ('density','comments') {
+	my $val = ${$optmap{$opt}};
+	bail(1,"--$opt must be >= 0 and <= 1") if ($val < 0 || $val > 1);
+}
+
+if ( -d "$rootname") {
+	if ($wipe) {
+		rmtree("$rootname");
+	}
+	else {
+		bail(1,"Root directory \"$rootname\" already exists");
+	}
+}
+
+# Perl's rand() differs between builds and platforms, so the tree is
+# made from a linear congruential generator of our own. Its products
+# stay below 2**53 and so are exact in either integer or double arithmetic.
+my $random = $seed % 4294967296;
+
+my @keywords = ( 'int', 'long', 'char', 'unsigned', 'static', 'return', 'if', 'while' );
+my @words = ( 'the', 'value', 'of', 'buffer', 'is', 'not', 'yet', 'known', 'when',
+	'this', 'returns', 'flag', 'count', 'set', 'each', 'line' );
+
+my $bytes = 0;
+progress("Creating $files files in \"$rootname\"");
+for (my $file = 0; $file < $files; ++$file) {
+	my $dir = sprintf("%s/d%u",$rootname,int($file / $fanout));
+	unless ( -d $dir) {
+		mkpath($dir) or bail(1,"Cannot create directory \"$dir\"");
+	}
+	$bytes += gen_file(sprintf("%s/f%u.%s",$dir,$file,$file % 4 ? 'c' : 'h'));
+}
+progress("Made $files files, $bytes bytes");
+print "files=$files bytes=$bytes\n";
+exit 0;
+
+sub next_random()
+{
+	$random = (1664525 * $random + 1013904223) % 4294967296;
+	return $random;
+}
+
+# A random integer in [0,$n)
+sub uniform($)
+{
+	my $n = shift;
+	return int(next_random() / 4294967296 * $n);
+}
+
+# True with probability $p
+sub chance($)
+{
+	my $p = shift;
+	return next_random() < $p * 4294967296;
+}
+
+# An approximately standard normal deviate, as the sum of 12 uniform deviates
+sub normal()
+{
+	my $sum = -6;
+	foreach (1..12) {
+		$sum += next_random() / 4294967296;
+	}
+	return $sum;
+}
+
+sub symbol()
+{
+	return "SYM" . uniform($symbols);
+}
+
+sub gen_expression()
+{
+	my $kind = uniform(6);
+	if ($kind == 0) {
+		return "defined(" . symbol() . ")";
+	}
+	elsif ($kind == 1) {
+		return symbol();
+	}
+	elsif ($kind == 2) {
+		return symbol() . " && !defined(" . symbol() . ")";
+	}
+	elsif ($kind == 3) {
+		return "(" . symbol() . " > " . uniform(4) . ") || " . symbol();
+	}
+	elsif ($kind == 4) {
+		return "defined " . symbol() . " || (defined(" . symbol() . ") && " .
+			symbol() . " == " . uniform(8) . ")";
+	}
+	return "!" . symbol();
+}
+
+sub gen_plain_line()
+{
+	if (chance($comments)) {
+		my $text = join(' ',map { $words[uniform(@words)] } (0..uniform(8)));
+		return uniform(2) ? "/* $text */" : "// $text";
+	}
+	my $line = sprintf("\t%s v%u = %u;",$keywords[uniform(@keywords)],
+		uniform(1000),uniform(100000));
+	$line .= " /* " . $words[uniform(@words)] . " */" unless uniform(3);
+	return $line;
+}
+
+# Write a file and return its size in bytes
+sub gen_file($)
+{
+	my $path = shift;
+	my $size = int($lines * exp($spread * normal()) + 0.5);
+	my @open = ();	# For each open #if, true if it has had an #else
+	my $text = "";
+	$size = 1 if ($size < 1);
+	for (my $line = 0; $line < $size; ++$line) {
+		if (!chance($density)) {
+			$text .= gen_plain_line() . "\n";
+			next;
+		}
+		my $kind = uniform(10);
+		if (@open == 0 || ($kind < 4 && @open < $depth)) {
+			my $form = uniform(4);
+			if ($form == 0) {
+				$text .= "#ifdef " . symbol() . "\n";
+			}
+			elsif ($form == 1) {
+				$text .= "#ifndef " . symbol() . "\n";
+			}
+			else {
+				$text .= "#if " . gen_expression() . "\n";
+			}
+			push(@open,0);
+		}
+		elsif ($kind < 6 && !$open[-1]) {
+			$text .= "#elif " . gen_expression() . "\n";
+		}
+		elsif ($kind < 7 && !$open[-1]) {
+			$text .= "#else\n";
+			$open[-1] = 1;
+		}
+		elsif ($kind < 9) {
+			$text .= "#endif\n";
+			pop(@open);
+		}
+		elsif (uniform(2)) {
+			$text .= "#define " . symbol() . " " . uniform(10) . "\n";
+		}
+		else {
+			$text .= "#undef " . symbol() . "\n";
+		}
+	}
+	$text .= "#endif\n" x scalar(@open);
+	open OUT,">$path" or bail(1,"Cannot open \"$path\" for writing");
+	binmode OUT;
+	print OUT $text;
+	close(OUT);
+	return length($text);
+}
@@ -0,0 +1,304 @@
+#!/usr/bin/perl
+
+use strict;
+use Getopt::Long;
+use File::Path;
+use File::Spec;
+use File::Find;
+use Cwd 'abs_path';
+use Time::HiRes qw(time);
+use SunifdefLib;
+
+my $pkgdir;
+my $execdir;
+my $seed = 20080101;
+my $files = 200;
+my $lines = 400;
+my $spread = 0.5;
+my $density = 0.15;
+my $depth = 4;
+my $symbols = 100;
+my $comments = 0.2;
+my $reps = 3;
+my $modes = "replace,recurse,symbols,blank,line";
+my $baseline;
+my $save;
+my $keep = 0;
+my $help;
+my $verbosity = 'progress';
+
+my $scrapdir;
+my $stats_file = "bench_stats.temp.txt";
+my $infiles_file = "bench_infiles.temp.txt";
+my $argfile = "bench_args.temp.txt";
+
+# The sunifdef arguments for each mode. DEFS stands for the file of
+# --define and --undefine options, and DIR for the corpus.
+my %mode_args = (
+	'replace' => "-r -fDEFS",
+	'recurse' => "-R -fDEFS DIR",
+	'symbols' => "--symbols all -R DIR",
+	'blank' => "-R -kb -fDEFS DIR",
+	'line' => "-R --line -fDEFS DIR"
+);
+
+sub make_corpus();
+sub list_input_file();
+sub run_mode($);
+sub read_stats();
+sub read_baseline($);
+sub write_baseline($\%);
+sub run(@);
+
+my %optmap = (	'pkgdir' => \$pkgdir,
+				'execdir' => \$execdir,
+				'seed' => \$seed,
+				'files' => \$files,
+				'lines' => \$lines,
+				'spread' => \$spread,
+				'density' => \$density,
+				'depth' => \$depth,
+				'symbols' => \$symbols,
+				'comments' => \$comments,
+				'reps' => \$reps,
+				'modes' => \$modes,
+				'baseline' => \$baseline,
+				'save' => \$save,
+				'keep' => \$keep,
+				'help' => \$help,
+				'verbosity' => \$verbosity);
+
+my $prog = "sunifdef_bench";
+
+END {
+	if (defined($scrapdir) && -d "$scrapdir") {
+		rmtree("$scrapdir") unless $keep;
+	}
+	unlink("$stats_file") if ( -f "$stats_file");
+	unlink("$infiles_file") if ( -f "$infiles_file");
+	unlink("$argfile") if ( -f "$argfile");
+}
+
+set_prog($prog);
+
+set_usage(
+	"$prog: Benchmark sunifdef on a synthetic source tree. " .
+	"The tree is created in PKGDIR/test_sunifdef/bench_scrap by bench_corpus.pl, " .
+	"identically for the same arguments, and recreated before each run of sunifdef. " .
+	"Each mode of sunifdef is run REPS times and the fastest run is reported, " .
+	"as files per second, megabytes per second and the peak resident set size.\n" .
+	"Usage:\n" .
+	"$prog [--verbosity=LEVEL] [--pkgdir PKGDIR] [--execdir EXECDIR] " .
+	"[--seed NUMBER] [--files NUMBER] [--lines NUMBER] [--spread REAL] " .
+	"[--density REAL] [--depth NUMBER] [--symbols NUMBER] [--comments REAL] " .
+	"[--reps NUMBER] [--modes MODE[,MODE...]] [--baseline FILE [--save]] [--keep]\n" .
+	"$prog --help\n" .
+	"Arguments:\n" .
+	"     --verbosity LEVEL   Display diagnostics with severity >= LEVEL, where " .
+	"LEVEL = 'progress', 'info', 'warning', 'error' or 'fatal. Default = 'progress'\n" .
+	"     --help              Display this information on stdout.\n" .
+	"     --pkgdir PKGDIR     The sunifdef package directory. Default '..'\n" .
+	"     --execdir EXECDIR   Directory from which to run sunifdef: Default 'PKGDIR/src'.\n" .
+	"     --seed, --files, --lines, --spread, --density, --depth, --symbols, --comments\n" .
+	"                         Passed to bench_corpus.pl to shape the tree. See " .
+	"bench_corpus.pl --help. Defaults 20080101, 200, 400, 0.5, 0.15, 4, 100, 0.2.\n" .
+	"     --reps NUMBER       Run each mode NUMBER times. Default 3.\n" .
+	"     --modes MODE,...    Run only these modes. Default 'replace,recurse,symbols,blank,line', " .
+	"which run sunifdef with -r, -R, --symbols all -R, -R -kb and -R --line respectively.\n" .
+	"     --baseline FILE     Compare the results with those saved in FILE, if it exists.\n" .
+	"     --save              Save the results in the --baseline FILE.\n" .
+	"     --keep              Do not delete the tree at exit.\n" .
+	"A quarter of the symbols are defined and a quarter undefined in every mode " .
+	"except symbols.\n");
+
+GetOptions(	\%optmap,
+			'pkgdir=s',
+			'execdir=s',
+			'seed=i',
+			'files=i',
+			'lines=i',
+			'spread=f',
+			'density=f',
+			'depth=i',
+			'symbols=i',
+			'comments=f',
+			'reps=i',
+			'modes=s',
+			'baseline=s',
+			'save!',
+			'keep!',
+			'help!',
+			'verbosity=s')  or usage_error();
+
+set_verbosity($verbosity);
+
+if ($help) {
+	help();
+	exit(0);
+}
+
+bail(1,"--reps must be > 0") unless ($reps > 0);
+usage_error("--save requires --baseline") if ($save && !defined($baseline));
+my @modes = split(/,/,$modes);
+foreach my $mode (@modes) {
+	usage_error("Unknown mode \"$mode\"") unless defined($mode_args{$mode});
+}
+
+unless (defined($pkgdir)) {
+	if (defined($ENV{'SUNIFDEF_PKGDIR'})) {
+		$pkgdir = "$ENV{'SUNIFDEF_PKGDIR'}";
+	}
+	else {
+		$pkgdir = File::Spec->updir();
+	}
+}
+
+$execdir = "$pkgdir/src" unless (defined($execdir));
+
+$pkgdir = abs_path($pkgdir);
+$execdir = abs_path($execdir);
+$scrapdir = "$pkgdir/test_sunifdef/bench_scrap";
+
+my $corpus_args = "--seed=$seed --files=$files --lines=$lines --spread=$spread " .
+	"--density=$density --depth=$depth --symbols=$symbols --comments=$comments";
+
+open OUT,">$argfile" or bail(1,"Cannot open \"$argfile\" for writing");
+for (my $sym = 0; $sym < int($symbols / 4); ++$sym) {
+	print OUT "-DSYM$sym=1\n";
+}
+for (my $sym = int($symbols / 4); $sym < int($symbols / 2); ++$sym) {
+	print OUT "-USYM$sym\n";
+}
+close(OUT);
+
+my $bytes = 0;
+progress("*** Corpus: $corpus_args ***");
+make_corpus();
+my @infiles_list = ();
+find(\&list_input_file,($scrapdir));
+@infiles_list = sort(@infiles_list);
+open OUT,">$infiles_file" or bail(1,"Cannot open \"$infiles_file\" for writing");
+foreach (@infiles_list) {
+	print OUT "$_\n";
+}
+close(OUT);
+progress("*** $files files, $bytes bytes ***");
+
+my %results = ();
+foreach my $mode (@modes) {
+	my ($best, $rss);
+	for (my $rep = 0; $rep < $reps; ++$rep) {
+		make_corpus() if ($rep || $mode ne $modes[0]);
+		my ($secs, $peak) = run_mode($mode);
+		$best = $secs if (!defined($best) || $secs < $best);
+		$rss = $peak if (!defined($rss) || $peak > $rss);
+	}
+	$best = 1e-6 if ($best <= 0);
+	$results{$mode} = [ $files / $best, $bytes / $best / 1048576, $rss / 1024 ];
+}
+
+my %saved = ();
+my $saved_corpus;
+if (defined($baseline) && -f "$baseline" && !$save) {
+	$saved_corpus = read_baseline(\%saved);
+	warn("Baseline \"$baseline\" is for a different corpus: $saved_corpus")
+		unless ($saved_corpus eq $corpus_args);
+}
+
+printf("%-10s %12s %12s %14s",'Mode','Files/s','MB/s','Peak RSS (KB)');
+printf(" %12s %12s %12s",'vs Files/s','vs MB/s','vs Peak RSS') if (%saved);
+print "\n";
+foreach my $mode (@modes) {
+	my @result = @{$results{$mode}};
+	printf("%-10s %12.1f %12.2f %14.0f",$mode,@result);
+	if (defined($saved{$mode})) {
+		my @was = @{$saved{$mode}};
+		foreach my $i (0..2) {
+			printf(" %+11.1f%%",$was[$i] ? ($result[$i] - $was[$i]) * 100 / $was[$i] : 0);
+		}
+	}
+	print "\n";
+}
+
+if ($save) {
+	write_baseline($baseline,%results);
+	progress("*** Saved baseline \"$baseline\" ***");
+}
+exit 0;
+
+sub make_corpus()
+{
+	my $out = `perl -Mstrict -I $pkgdir/perl -w $pkgdir/test_sunifdef/bench_corpus.pl --verbosity=fatal --wipe --rootname=$scrapdir $corpus_args`;
+	bail(1,"Cannot create corpus") if ($?);
+	$bytes = $1 if ($out =~ /bytes=(\d+)/);
+}
+
+sub list_input_file()
+{
+	push(@infiles_list,$File::Find::name) if ( -f $_);
+}
+
+# Run sunifdef in a mode. Return the seconds elapsed and the peak RSS in bytes.
+sub run_mode($)
+{
+	my $mode = shift;
+	my $args = $mode_args{$mode};
+	$args =~ s/DEFS/$argfile/;
+	$args =~ s/DIR/$scrapdir/;
+	$args .= " < $infiles_file" if ($mode eq 'replace');
+	unlink("$stats_file") if ( -f "$stats_file");
+	my $devnull = File::Spec->devnull();
+	my $start = time();
+	run("$execdir/sunifdef --stats=json,$stats_file $args > $devnull 2> $devnull");
+	my $secs = time() - $start;
+	my $peak = read_stats();
+	bail(1,"sunifdef failed in mode \"$mode\"") unless (defined($peak));
+	return ($secs, $peak);
+}
+
+# Get the peak RSS from the stats of the last run
+sub read_stats()
+{
+	open IN,"<$stats_file" or return undef;
+	my $json = <IN>;
+	close(IN);
+	return ($json =~ /"peak_rss":(\d+)/) ? $1 : undef;
+}
+
+# Read the results saved in a baseline. Return the corpus arguments
+sub read_baseline($)
+{
+	my $saved = shift;
+	my $corpus = "";
+	open IN,"<$baseline" or bail(1,"Cannot open \"$baseline\" for reading");
+	while (my $line = <IN>) {
+		chomp($line);
+		if ($line =~ /^corpus (.*)$/) {
+			$corpus = $1;
+		}
+		elsif ($line =~ /^(\w+) (\S+) (\S+) (\S+)$/) {
+			$saved->{$1} = [ $2, $3, $4 ];
+		}
+	}
+	close(IN);
+	return $corpus;
+}
+
+sub write_baseline($\%)
+{
+	my ($file, $results) = @_;
+	open OUT,">$file" or bail(1,"Cannot open \"$file\" for writing");
+	print OUT "corpus $corpus_args\n";
+	foreach my $mode (sort(keys(%$results))) {
+		printf OUT "%s %.1f %.2f %.0f\n",$mode,@{$results->{$mode}};
+	}
+	close(OUT);
+}
+
+sub run(@)
+{
+	my @cmd = @_;
+	progress("@cmd");
+	my $ret = system(@cmd);
+	return $ret >> 8;
+}
@@ -21,10 +21,12 @@ my $bail;
 
 my $scrapdir;
 my $arg_scrapdir;
+my $overlapdir;
 my $infiles = 0;
 my @scrap_files = ();
 my $sabotaged_files = 0;
 my @infiles_list = ();
+my %source_files = ();
 my $fails = 0;
 my $undefs = "";
 my $stderr_file = "stderr.temp.txt";
@@ -38,8 +40,12 @@ sub restore_backed_up_file();
 sub append_to_infile_list();
 sub run(@);
 sub run_noerr(@);
+sub run_timed($@);
 sub slurp($);
 sub check_test_result(@);
+sub check_eager_result($$$);
+sub summary($);
+sub read_source_file();
 
 my %optmap = (	'pkgdir' => \$pkgdir,
 				'execdir' => \$execdir,
@@ -58,6 +64,7 @@ END {
     if ( -d "$scrapdir") {
 	   rmtree("$scrapdir") unless $keep;
 	}   
+	rmtree("$overlapdir") if (defined($overlapdir) && -d "$overlapdir" && !$keep);
 	unless($fails) {
 		unlink("$stderr_file") if ( -f "$stderr_file");
 		unlink("$stdout_file") if ( -f "$stdout_file");
@@ -131,6 +138,7 @@ $execdir = abs_path($execdir);
 system("chmod -R +w $pkgdir") unless windows();
 
 $scrapdir = "$pkgdir/test_sunifdef/scrap";
+$overlapdir = "$pkgdir/test_sunifdef/overlap_scrap";
 if ($windows_exe && cygwin()) {
     $arg_scrapdir = cyg2win($scrapdir);
 }
@@ -211,11 +219,58 @@ progress("*** Done ***");
 check_test_result(4);
 
 progress("*** Bulk Test 5: to process $infiles files ***");
-# Run sunifdef with --recurse on the scrap tree again, this time
-# reading all the --undef options of test 2 from a file.
+# Run sunifdef as per the 2nd test with and without --eager, and test
+# that the files, the summary counts and the symbols listed are the same.
 
 # Restore all the files backed up by the last test.
 find(\&restore_backed_up_file,($scrapdir));
+run("$execdir/sunifdef $undefs --verbose --recurse --filter c,h --backup \"~\" $arg_scrapdir 2> $stderr_file");
+check_test_result(5);
+my $want_summary = summary($stderr_file);
+%source_files = ();
+find(\&read_source_file,($scrapdir));
+my %want_files = %source_files;
+find(\&restore_backed_up_file,($scrapdir));
+run("$execdir/sunifdef $undefs --eager --verbose --recurse --filter c,h --backup \"~\" $arg_scrapdir 2> $stderr_file");
+check_test_result(5);
+%source_files = ();
+find(\&read_source_file,($scrapdir));
+my $diffs = grep { $source_files{$_} ne $want_files{$_} } keys(%want_files);
+check_eager_result(5,$diffs == 0 && keys(%source_files) == keys(%want_files),
+	"$diffs files differ");
+check_eager_result(5,summary($stderr_file) eq $want_summary,"The summary differs");
+find(\&restore_backed_up_file,($scrapdir));
+run("$execdir/sunifdef --symbols all,locate --recurse --filter c,h $arg_scrapdir 2> $stderr_file 1> $stdout_file");
+my $want_symbols = join('',sort(split(/^/,slurp($stdout_file))));
+run("$execdir/sunifdef --symbols all,locate --eager --recurse --filter c,h $arg_scrapdir 2> $stderr_file 1> $stdout_file");
+check_eager_result(5,join('',sort(split(/^/,slurp($stdout_file)))) eq $want_symbols,
+	"The symbols listed differ");
+# Search a subdirectory and then its parent with several walker threads,
+# so that the subdirectory is met already in the file tree while its
+# siblings are being listed.
+rmtree($overlapdir);
+foreach my $i (1..40) {
+	mkpath("$overlapdir/d$i");
+	open OUT,">$overlapdir/d$i/f$i.c" or
+		die("Cannot open file \"$overlapdir/d$i/f$i.c\" for writing\n");
+	print OUT "#ifdef FOO$i\nint x;\n#endif\n";
+	close(OUT);
+}
+my $ret = run_timed(60,"$execdir/sunifdef","--jobs","1","-sfl","-R",
+	"$overlapdir/d1",$overlapdir);
+$want_symbols = join('',sort(split(/^/,slurp($stdout_file))));
+check_eager_result(5,$ret == 0,"Searching overlapping paths failed");
+$ret = run_timed(60,"$execdir/sunifdef","--eager","--jobs","4","-sfl","-R",
+	"$overlapdir/d1",$overlapdir);
+check_eager_result(5,$ret != -1,"Searching overlapping paths hung");
+check_eager_result(5,$ret == 0 &&
+	join('',sort(split(/^/,slurp($stdout_file)))) eq $want_symbols,
+	"Searching overlapping paths differs");
+rmtree($overlapdir);
+progress("*** Done ***");
+
+progress("*** Bulk Test 6: to process $infiles files ***");
+# Sabotage the scrap tree and run sunifdef with --recurse on it again
 
 # Sabotage many source files in the scrap tree by deleting
 # all occurrences of the #endif directive. Then run sunifdef
@@ -226,7 +281,7 @@ find(\&sabotage_source_file,($scrapdir));
 progress("*** Generated $sabotaged_files invalid input files ***");
 run("$execdir/sunifdef --symbols first --verbose --keepgoing --recurse --filter c,h $arg_scrapdir 2> $stderr_file");
 progress("*** Done ***");
-check_test_result(5,"$sabotaged_files were abandoned due to parse errors");
+check_test_result(6,"$sabotaged_files were abandoned due to parse errors");
 
 exit($fails);
 
@@ -250,6 +305,31 @@ sub check_test_result(@)
 	}
 }
 
+sub check_eager_result($$$)
+{
+	my ($test,$ok,$what) = @_;
+	unless ($ok) {
+		++$fails;
+		error("*** Bulk test $test: Failed! $what with --eager ****");
+		if ($bail) {
+			exit($fails);
+		}
+	}
+}
+
+# The summary diagnostics in a file of stderr
+sub summary($)
+{
+	my $stderr_text = slurp($_[0]);
+	return join('',grep { m/: \w+ 0x1[0-9a-f]{4}: / } split(/^/,$stderr_text));
+}
+
+sub read_source_file()
+{
+	my $file = $File::Find::name;
+	$source_files{$file} = slurp($file) if ($file =~ m/\.c$/ or $file =~ m/\.h$/);
+}
+
 sub tally_source_file()
 {
 	my $file = $File::Find::name;
@@ -307,6 +387,36 @@ sub run(@)
 	return $ret >> 8;
 }
 
+# Run a command with its stdout and stderr in the temporary files,
+# killing it if it runs longer than a given number of seconds. Return
+# its exit status, or -1 if it was killed.
+sub run_timed($@)
+{
+	my ($secs,@cmd) = @_;
+	progress("@cmd");
+	my $pid = fork();
+	die("Cannot fork: $!\n") unless defined($pid);
+	unless ($pid) {
+		open STDOUT,">$stdout_file" or exit(127);
+		open STDERR,">$stderr_file" or exit(127);
+		exec(@cmd) or exit(127);
+	}
+	my $ret;
+	eval {
+		local $SIG{ALRM} = sub { die("timeout\n"); };
+		alarm($secs);
+		waitpid($pid,0);
+		alarm(0);
+		$ret = $? >> 8;
+	};
+	if ($@) {
+		kill('KILL',$pid);
+		waitpid($pid,0);
+		return -1;
+	}
+	return $ret;
+}
+
 sub run_noerr(@)
 {
 	my $ret = run(@_);
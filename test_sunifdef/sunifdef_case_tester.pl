@@ -158,14 +158,15 @@ sub match_words($$)
 {
 	my ($actual_word,$expected_word) = @_;
 	return 1 if ($actual_word eq $expected_word);
-	return 0 unless ($expected_word =~ m#^\./(test_cases/(altfiles/)?test\d{4}(-\d)?\.c)(\(\d+\))$#);
+	return 0 unless ($expected_word =~ m#^\./(test_cases/(altfiles/)?test\d{4}(-\d)?\.c)(\(\d+\))?$#);
 	my $filename = $1;
-	my $lineno = $4;
+	my $lineno = defined($4) ? $4 : "";
 	my $expected_len = length($expected_word) - 2;
 	my $actual_len = length($actual_word);
 	$filename =~ s#/#\\#g if ($windows_exe);
 	my $substring = substr($actual_word,$actual_len - $expected_len);
 	if (substr($actual_word,$actual_len - $expected_len) eq "$filename$lineno") {
+		return 1 if ($actual_word eq "$filename$lineno");
 		$filename = "$pkgdir/test_sunifdef/$filename";
 		if ($windows_exe) {
     	   $filename =~ s#/#\\#g;
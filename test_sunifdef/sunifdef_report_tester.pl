@@ -0,0 +1,358 @@
+#!/usr/bin/perl
+
+use strict;
+use Getopt::Long;
+use File::Path;
+use File::Spec;
+use Cwd 'abs_path';
+use JSON::PP;
+use SunifdefLib;
+
+my $pkgdir;
+my $execdir;
+my $keep = 0;
+my $help;
+my $verbosity = 'progress';
+my $bail;
+
+my $scrapdir;
+my $fails = 0;
+my $stderr_file = "report_stderr.temp.txt";
+my $stdout_file = "report_stdout.temp.txt";
+
+sub known_lines();
+sub source_lines($);
+sub write_file($@);
+sub slurp($);
+sub read_json($);
+sub sunifdef($);
+sub check($$);
+sub stats($);
+sub test_stats();
+sub test_line_allocations();
+sub test_trace();
+sub test_debug();
+
+my %optmap = (	'pkgdir' => \$pkgdir,
+				'execdir' => \$execdir,
+				'keep' => \$keep,
+				'help' => \$help,
+				'verbosity' => \$verbosity,
+				'bail' => \$bail);
+
+my $prog = "sunifdef_report_tester";
+
+END {
+	if (defined($scrapdir) && -d "$scrapdir") {
+		rmtree("$scrapdir") unless $keep;
+	}
+	unless($fails) {
+		unlink("$stderr_file") if ( -f "$stderr_file");
+		unlink("$stdout_file") if ( -f "$stdout_file");
+	}
+}
+
+set_prog($prog);
+
+set_usage(
+	"$prog: Exercise the options with which sunifdef reports on a run. Input " .
+	"files are created in PKGDIR/test_sunifdef/report_scrap and sunifdef is run " .
+	"on them with each option. Each test checks that the report is well-formed " .
+	"and that what it counts matches the input.\n" .
+	"Usage:\n" .
+	"$prog [--verbosity=LEVEL] [--pkgdir PKGDIR] [--execdir EXECDIR] [--bail] [--keep]\n" .
+	"$prog --help\n" .
+	"Arguments:\n" .
+	"     --verbosity LEVEL   Display diagnostics with severity >= LEVEL, where " .
+	"LEVEL = 'progress', 'info', 'warning', 'error' or 'fatal. Default = 'progress'\n" .
+	"     --help              Display this information on stdout.\n" .
+	"     --pkgdir PKGDIR     The sunifdef package directory. Default '..'\n" .
+	"     --execdir EXECDIR   Directory from which to run sunifdef: Default 'PKGDIR/src'.\n" .
+	"     --bail              Quit at the first test failure.\n" .
+	"     --keep              Do not delete the test files at exit.\n");
+
+GetOptions(	\%optmap,
+			'pkgdir=s',
+			'execdir=s',
+			'keep!',
+			'help!',
+			'verbosity=s',
+			'bail!')  or usage_error();
+
+set_verbosity($verbosity);
+
+if ($help) {
+	help();
+	exit(0);
+}
+
+unless (defined($pkgdir)) {
+	if (defined($ENV{'SUNIFDEF_PKGDIR'})) {
+		$pkgdir = "$ENV{'SUNIFDEF_PKGDIR'}";
+	}
+	else {
+		$pkgdir = File::Spec->updir();
+	}
+}
+
+$execdir = "$pkgdir/src" unless (defined($execdir));
+
+$pkgdir = abs_path($pkgdir);
+$execdir = abs_path($execdir);
+$scrapdir = "$pkgdir/test_sunifdef/report_scrap";
+
+rmtree("$scrapdir") if ( -d "$scrapdir");
+mkpath("$scrapdir") or bail(1,"Cannot create directory \"$scrapdir\"");
+
+test_stats();
+test_line_allocations();
+test_trace();
+test_debug();
+
+print "$fails report tests failed\n";
+
+exit($fails);
+
+# --stats=json: the report has all its keys and counts the files, lines
+# and directives of the input.
+sub test_stats()
+{
+	my $input = "$scrapdir/stats.c";
+	progress("*** Report Test: --stats=json ***");
+	write_file($input,known_lines(),source_lines(3));
+	my $report = stats("-DFOO $input");
+	return unless defined($report);
+	foreach my $key ("version","files","errorfiles","wall","cpu",
+		"phases","counters","memory") {
+		check(exists($report->{$key}),"--stats has no \"$key\"");
+	}
+	foreach my $phase ("walk","open","read","lex","evaluate","write","rename") {
+		check(exists($report->{phases}{$phase}{wall}) &&
+			exists($report->{phases}{$phase}{cpu}),
+			"--stats has no wall and cpu times of phase \"$phase\"");
+	}
+	foreach my $key ("bytes_in","bytes_out","find_sym","evaluations",
+		"short_circuits","cut_edits","paren_edits") {
+		check(exists($report->{counters}{$key}),
+			"--stats has no counter \"$key\"");
+	}
+	foreach my $tag ("other","lines","symbols","file_tree","diagnostics",
+		"evaluator") {
+		check(exists($report->{memory}{tags}{$tag}{allocations}) &&
+			exists($report->{memory}{tags}{$tag}{bytes}),
+			"--stats has no allocations and bytes of tag \"$tag\"");
+	}
+	foreach my $key ("line_allocations","per_line","peak_live","peak_rss") {
+		check(exists($report->{memory}{$key}),"--stats has no \"memory.$key\"");
+	}
+	check($report->{files} == 1,"--stats counted $report->{files} files, expected 1");
+	check($report->{errorfiles} == 0,
+		"--stats counted $report->{errorfiles} error files, expected 0");
+	my $lines = $report->{counters}{lines};
+	check($lines == 42,"--stats counted $lines lines, expected 42");
+	my $bytes = -s $input;
+	check($report->{counters}{bytes_in} == $bytes,
+		"--stats counted $report->{counters}{bytes_in} bytes in, expected $bytes");
+	my %directives = ('if' => 4, 'ifdef' => 3, 'ifndef' => 1, 'elif' => 1,
+		'else' => 4, 'endif' => 8, 'define' => 1, 'undef' => 1, 'error' => 1,
+		'other' => 1);
+	foreach my $directive (sort(keys(%directives))) {
+		my $count = $report->{counters}{directives}{$directive};
+		check(defined($count) && $count == $directives{$directive},
+			"--stats counted " . (defined($count) ? $count : "no") .
+			" #$directive directives, expected $directives{$directive}");
+	}
+}
+
+# --stats=json: the allocations made while lines are processed are
+# only those that warm up the buffers of the first file. Once they are
+# warm, a file of the same lines makes no allocations per line.
+sub test_line_allocations()
+{
+	my @inputs = ("$scrapdir/warm.c","$scrapdir/steady.c");
+	progress("*** Report Test: --stats=json allocations per line ***");
+	foreach my $input (@inputs) {
+		write_file($input,source_lines(100));
+	}
+	my $warm = stats("-DFOO $inputs[0]");
+	my $both = stats("--replace -DFOO @inputs");
+	return unless (defined($warm) && defined($both));
+	my $lines = $both->{counters}{lines};
+	check($lines == 2000,"--stats counted $lines lines, expected 2000");
+	my $steady = $both->{memory}{line_allocations} -
+		$warm->{memory}{line_allocations};
+	check($steady == 0,
+		"--stats counted $steady allocations in a steady-state file, expected 0");
+	my $per_line = sprintf("%.6f",$both->{memory}{line_allocations} / $lines);
+	check($both->{memory}{per_line} == $per_line,
+		"--stats reported $both->{memory}{per_line} allocations per line, " .
+		"expected $per_line");
+}
+
+# --trace: the timeline is well-formed Chrome trace-event JSON with one
+# "file" span per input file and a "dir" span around each directory
+# searched.
+sub test_trace()
+{
+	my $tree = "$scrapdir/tracetree";
+	my $trace = "$scrapdir/trace.json";
+	my @inputs = ("$tree/a.c","$tree/sub/b.c","$tree/sub/c.c");
+	progress("*** Report Test: --trace ***");
+	mkpath("$tree/sub") or bail(1,"Cannot create directory \"$tree/sub\"");
+	foreach my $input (@inputs) {
+		write_file($input,source_lines(10));
+	}
+	sunifdef("--trace $trace -R --replace -DFOO $tree");
+	my $timeline = read_json($trace);
+	check(defined($timeline),"--trace did not write well-formed JSON");
+	return unless defined($timeline);
+	my $events = $timeline->{traceEvents};
+	check(ref($events) eq 'ARRAY',"--trace has no \"traceEvents\" array");
+	return unless (ref($events) eq 'ARRAY');
+	my %spans = ();
+	my $depth = 0;
+	foreach my $event (@$events) {
+		my $ph = $event->{ph};
+		check(defined($ph) && exists($event->{ts}) && exists($event->{pid}) &&
+			exists($event->{tid}),"--trace has an event without ph, ts, pid or tid");
+		next unless defined($ph);
+		if ($event->{cat} eq 'file') {
+			check($ph eq 'X' && $event->{dur} >= 0,
+				"--trace has a \"file\" event that is not a complete span");
+			++$spans{$event->{name}};
+		}
+		elsif ($event->{cat} eq 'dir') {
+			$depth += $ph eq 'B' ? 1 : $ph eq 'E' ? -1 : 0;
+			check($depth >= 0,"--trace ends a \"dir\" span that it did not begin");
+		}
+	}
+	check($depth == 0,"--trace leaves $depth \"dir\" spans open");
+	foreach my $input (@inputs) {
+		my $count = defined($spans{$input}) ? $spans{$input} : 0;
+		check($count == 1,
+			"--trace has $count \"file\" spans for \"$input\", expected 1");
+		delete($spans{$input});
+	}
+	foreach my $name (sort(keys(%spans))) {
+		check(0,"--trace has a \"file\" span for \"$name\", not an input file");
+	}
+	my $files = $timeline->{otherData}{files};
+	check(defined($files) && $files == @inputs,
+		"--trace counted " . (defined($files) ? $files : "no") .
+		" files, expected " . scalar(@inputs));
+}
+
+# --debug: tracing is compiled out unless SUNIFDEF_TRACE is defined. When
+# it is compiled out, --debug is ignored with a warning. When it is
+# compiled in, the trace records the despatch of every line of the input.
+# Either way the output is that of a run without --debug.
+sub test_debug()
+{
+	my $input = "$scrapdir/debug.c";
+	my $lines = 100;
+	progress("*** Report Test: --debug ***");
+	write_file($input,source_lines($lines / 10));
+	my (undef,$want_out) = sunifdef("-DFOO $input");
+	my ($ret,$out,$err) = sunifdef("--debug -DFOO $input");
+	check($out eq $want_out,"--debug output differs from a run without it");
+	if ($err =~ m/--debug is ignored: tracing is not compiled in/) {
+		my @diagnostics = split(/\n/,$err);
+		check(@diagnostics == 1,
+			"--debug wrote trace records although tracing is not compiled in");
+		return;
+	}
+	my %despatched = ();
+	while ($err =~ m/: line (\d+): process (\w+) -> /g) {
+		++$despatched{$1} unless ($2 eq 'EOF');
+	}
+	for (my $line = 1; $line <= $lines; ++$line) {
+		my $count = defined($despatched{$line}) ? $despatched{$line} : 0;
+		check($count == 1,
+			"--debug traced $count despatches of line $line, expected 1");
+	}
+	check($err =~ m/: line $lines: process EOF -> /,
+		"--debug did not trace the end of the input");
+}
+
+# Run sunifdef with --stats=json and return the report, or undef if it
+# is not well-formed.
+sub stats($)
+{
+	my $args = shift;
+	my $file = "$scrapdir/stats.json";
+	unlink("$file") if ( -f "$file");
+	sunifdef("--stats=json,$file $args");
+	my $report = read_json($file);
+	check(defined($report),"--stats=json did not write well-formed JSON");
+	return $report;
+}
+
+# Lines with one of each directive that is not in source_lines()
+sub known_lines()
+{
+	return ("#ifndef GUARD\n","#define GUARD\n","#include <stdio.h>\n",
+		"#if BAR\n","int bar;\n","#elif BAZ\n","int baz;\n","#else\n",
+		"#error No BAR or BAZ\n","#endif\n","#undef QUX\n","#endif\n");
+}
+
+# A C source of 10 lines for each of $blocks blocks, each with #ifdef FOO
+# and #if BAR.
+sub source_lines($)
+{
+	my $blocks = shift;
+	my @lines = ();
+	for (my $i = 0; $i < $blocks; ++$i) {
+		push(@lines,"#ifdef FOO\n","int foo_$i;\n","#else\n","int not_foo_$i;\n",
+			"#endif\n","int plain_$i;\n","#if BAR\n","int bar_$i;\n","#endif\n",
+			"/* comment $i */\n");
+	}
+	return @lines;
+}
+
+sub check($$)
+{
+	my ($ok,$what) = @_;
+	unless ($ok) {
+		++$fails;
+		error("*** Report test failed: $what ***");
+		exit($fails) if ($bail);
+	}
+}
+
+# Run sunifdef with the given arguments. Return its exit code, stdout and stderr.
+sub sunifdef($)
+{
+	my $args = shift;
+	progress("sunifdef $args");
+	my $ret = system("$execdir/sunifdef $args 1> $stdout_file 2> $stderr_file") >> 8;
+	return ($ret,slurp($stdout_file),slurp($stderr_file));
+}
+
+# Parse a JSON file. Return the value, or undef if the file is missing or
+# is not well-formed.
+sub read_json($)
+{
+	my $file = shift;
+	return undef unless ( -f "$file");
+	my $value = eval { decode_json(slurp($file)) };
+	return $value;
+}
+
+sub write_file($@)
+{
+	my ($file,@lines) = @_;
+	open OUT,">$file" or bail(1,"Cannot open \"$file\" for writing");
+	print OUT @lines;
+	close(OUT);
+}
+
+sub slurp($)
+{
+	my $terminator = $/;
+	open IN,"<$_[0]" or bail(1,"Cannot open file \"$_[0]\" for reading");
+	undef $/;
+	my $text = <IN>;
+	close(IN);
+	$/ = $terminator;
+	return defined($text) ? $text : "";
+}
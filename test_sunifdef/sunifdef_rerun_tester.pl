@@ -0,0 +1,514 @@
+#!/usr/bin/perl
+
+use strict;
+use Getopt::Long;
+use File::Path;
+use File::Spec;
+use Cwd 'abs_path';
+use IO::Socket::UNIX;
+use POSIX ":sys_wait_h";
+use SunifdefLib;
+
+my $pkgdir;
+my $execdir;
+my $keep = 0;
+my $help;
+my $verbosity = 'progress';
+my $bail;
+
+my $scrapdir;
+my $fails = 0;
+my $background_pid;
+my $stderr_file = "rerun_stderr.temp.txt";
+my $stdout_file = "rerun_stdout.temp.txt";
+
+sub source_lines($);
+sub write_file($@);
+sub slurp($);
+sub sunifdef($);
+sub check($$);
+sub check_incremental($$$@);
+sub test_incremental();
+sub test_manifest();
+sub cache_entries($);
+sub check_cache($$$$$);
+sub test_cache();
+sub check_snapshot($$$);
+sub test_snapshot();
+sub start_sunifdef($$);
+sub stop_sunifdef($);
+sub bad_request($$);
+sub check_client($$);
+sub test_daemon();
+sub await_file($$);
+sub test_watch();
+
+my %optmap = (	'pkgdir' => \$pkgdir,
+				'execdir' => \$execdir,
+				'keep' => \$keep,
+				'help' => \$help,
+				'verbosity' => \$verbosity,
+				'bail' => \$bail);
+
+my $prog = "sunifdef_rerun_tester";
+
+END {
+	stop_sunifdef($background_pid) if (defined($background_pid));
+	if (defined($scrapdir) && -d "$scrapdir") {
+		rmtree("$scrapdir") unless $keep;
+	}
+	unless($fails) {
+		unlink("$stderr_file") if ( -f "$stderr_file");
+		unlink("$stdout_file") if ( -f "$stdout_file");
+	}
+}
+
+set_prog($prog);
+
+set_usage(
+	"$prog: Exercise the options with which sunifdef keeps state from one " .
+	"run to the next. Input files are created in PKGDIR/test_sunifdef/rerun_scrap " .
+	"and sunifdef is run on them repeatedly, with the files edited between runs. " .
+	"Each test checks that the state is used when it should be and that the " .
+	"results are always those of a run without it. The modes in which one " .
+	"sunifdef process serves many runs are tested likewise.\n" .
+	"Usage:\n" .
+	"$prog [--verbosity=LEVEL] [--pkgdir PKGDIR] [--execdir EXECDIR] [--bail] [--keep]\n" .
+	"$prog --help\n" .
+	"Arguments:\n" .
+	"     --verbosity LEVEL   Display diagnostics with severity >= LEVEL, where " .
+	"LEVEL = 'progress', 'info', 'warning', 'error' or 'fatal. Default = 'progress'\n" .
+	"     --help              Display this information on stdout.\n" .
+	"     --pkgdir PKGDIR     The sunifdef package directory. Default '..'\n" .
+	"     --execdir EXECDIR   Directory from which to run sunifdef: Default 'PKGDIR/src'.\n" .
+	"     --bail              Quit at the first test failure.\n" .
+	"     --keep              Do not delete the test files at exit.\n");
+
+GetOptions(	\%optmap,
+			'pkgdir=s',
+			'execdir=s',
+			'keep!',
+			'help!',
+			'verbosity=s',
+			'bail!')  or usage_error();
+
+set_verbosity($verbosity);
+
+if ($help) {
+	help();
+	exit(0);
+}
+
+unless (defined($pkgdir)) {
+	if (defined($ENV{'SUNIFDEF_PKGDIR'})) {
+		$pkgdir = "$ENV{'SUNIFDEF_PKGDIR'}";
+	}
+	else {
+		$pkgdir = File::Spec->updir();
+	}
+}
+
+$execdir = "$pkgdir/src" unless (defined($execdir));
+
+$pkgdir = abs_path($pkgdir);
+$execdir = abs_path($execdir);
+$scrapdir = "$pkgdir/test_sunifdef/rerun_scrap";
+
+rmtree("$scrapdir") if ( -d "$scrapdir");
+mkpath("$scrapdir") or bail(1,"Cannot create directory \"$scrapdir\"");
+
+test_incremental();
+test_manifest();
+test_cache();
+test_snapshot();
+test_daemon();
+test_watch();
+
+print "$fails rerun tests failed\n";
+
+exit($fails);
+
+# --incremental: a rerun resumes from the last checkpoint before an edit
+# and splices in the saved output after it, and the output and exit code
+# are always those of a run without --incremental.
+sub test_incremental()
+{
+	my $input = "$scrapdir/incremental.c";
+	my $state = "$scrapdir/incremental.state";
+	foreach my $opts ("-DFOO -UBAR", "-DFOO -UBAR --line") {
+		my @lines = source_lines(100);
+		progress("*** Rerun Test: --incremental with $opts ***");
+		unlink("$state") if ( -f "$state");
+		write_file($input,@lines);
+		check_incremental($input,$state,$opts);
+		# Unchanged: the whole of the saved output is reused
+		check_incremental($input,$state,$opts,
+			"Reusing saved output of \"[^\"]*\" after line 0");
+		# Changed in the middle: resume before the change and splice after it
+		$lines[505] = "int edited;\n";
+		write_file($input,@lines);
+		check_incremental($input,$state,$opts,
+			"Resuming \"[^\"]*\" after line [1-9]",
+			"Reusing saved output of \"[^\"]*\" after line [1-9]");
+		# Lines inserted: resume before them. With --line the saved output
+		# cites the old line numbers, so it is not spliced in
+		splice(@lines,805,0,"int inserted1;\n","int inserted2;\n");
+		write_file($input,@lines);
+		check_incremental($input,$state,$opts,
+			"Resuming \"[^\"]*\" after line [1-9]");
+	}
+}
+
+# --manifest: a rerun with -r skips the files that are unchanged since
+# they were processed with the same options, and processes the files
+# that are edited and all the files when the options change.
+sub test_manifest()
+{
+	my @inputs = ("$scrapdir/manifest1.c","$scrapdir/manifest2.c");
+	my $manifest = "$scrapdir/manifest.txt";
+	my $unchanged = "File \"[^\"]*/%s\" is unchanged since it was processed";
+	my ($ret,$out,$err);
+	progress("*** Rerun Test: --manifest ***");
+	foreach my $input (@inputs) {
+		write_file($input,source_lines(10));
+	}
+	($ret,$out,$err) = sunifdef("-r -DFOO --verbose --manifest $manifest @inputs");
+	check($err !~ m/is unchanged/,"--manifest skipped a file on the first run");
+	check(slurp($inputs[0]) !~ m/#ifdef FOO/,"--manifest did not process a file");
+	# Unchanged: both files are skipped
+	($ret,$out,$err) = sunifdef("-r -DFOO --verbose --manifest $manifest @inputs");
+	foreach my $leaf ("manifest1.c","manifest2.c") {
+		my $pattern = sprintf($unchanged,$leaf);
+		check($err =~ m/$pattern/,"--manifest did not skip unchanged $leaf");
+	}
+	# One file edited: it alone is processed
+	write_file($inputs[0],slurp($inputs[0]),"#ifdef FOO\n","int added;\n","#endif\n");
+	($ret,$out,$err) = sunifdef("-r -DFOO --verbose --manifest $manifest @inputs");
+	my $pattern = sprintf($unchanged,"manifest1.c");
+	check($err !~ m/$pattern/,"--manifest skipped edited manifest1.c");
+	$pattern = sprintf($unchanged,"manifest2.c");
+	check($err =~ m/$pattern/,"--manifest did not skip unchanged manifest2.c");
+	check(slurp($inputs[0]) !~ m/#ifdef FOO/,"--manifest did not process edited manifest1.c");
+	# Options changed: both files are processed
+	($ret,$out,$err) = sunifdef("-r -DFOO -DBAR=1 --verbose --manifest $manifest @inputs");
+	check($err !~ m/is unchanged/,"--manifest skipped a file when the options changed");
+	foreach my $input (@inputs) {
+		check(slurp($input) !~ m/#if BAR/,"--manifest did not process $input with new options");
+	}
+}
+
+# --cache: a rerun takes the output of each file from the cache, a run
+# with other options misses, and when the cache outgrows --cache-size
+# the least recently used entries are evicted.
+sub test_cache()
+{
+	my $cache = "$scrapdir/cache";
+	my $sizing = "$scrapdir/cache_sizing";
+	progress("*** Rerun Test: --cache ***");
+	check_cache("-DFOO","--cache $cache",0,2,2);
+	check_cache("-DFOO","--cache $cache",2,0,2);
+	check_cache("-DFOO -UBAR","--cache $cache",0,2,4);
+	# Find the size of the entries for new options in a cache of their own
+	check_cache("-UFOO -DBAR=1","--cache $sizing",0,2,2);
+	my $size = 0;
+	foreach my $entry (cache_entries($sizing)) {
+		$size += -s $entry;
+	}
+	# Age the entries in the cache and add the new ones with a limit that
+	# holds them but not the old ones
+	my $old = time() - 3600;
+	utime($old,$old,cache_entries($cache));
+	my $limit = int($size * 100 / 80) + 64;
+	check_cache("-UFOO -DBAR=1","--cache $cache --cache-size $limit",0,2,2);
+	check_cache("-UFOO -DBAR=1","--cache $cache",2,0,2);
+	check_cache("-DFOO","--cache $cache",0,2,4);
+}
+
+# The entries in a cache directory.
+sub cache_entries($)
+{
+	my $cache = shift;
+	return glob("$cache/??/*");
+}
+
+# Run sunifdef -r with --cache options on new cache test files and check
+# that the files and exit code are those of a run without them, that the
+# numbers of files found in the cache and added are as expected, and the
+# number of entries after.
+sub check_cache($$$$$)
+{
+	my ($opts,$cache_opts,$hits,$added,$entries) = @_;
+	my @inputs = ("$scrapdir/cache1.c","$scrapdir/cache2.c");
+	my $cache = $1 if ($cache_opts =~ m/--cache (\S+)/);
+	write_file($inputs[0],source_lines(10));
+	write_file($inputs[1],source_lines(20));
+	my ($want_ret) = sunifdef("-r $opts @inputs");
+	my @want = map { slurp($_) } @inputs;
+	write_file($inputs[0],source_lines(10));
+	write_file($inputs[1],source_lines(20));
+	my ($ret,$out,$err) = sunifdef("-r $opts $cache_opts --verbose @inputs");
+	my @got = map { slurp($_) } @inputs;
+	check($ret == $want_ret,"--cache exit code $ret, expected $want_ret");
+	check("@got" eq "@want","--cache output differs from a run without it");
+	check($err =~ m/$hits out of 2 files were found in the output cache \(\d+%\); $added files were added/,
+		"--cache with $opts did not find $hits files and add $added");
+	my @entries = cache_entries($cache);
+	my $count = scalar(@entries);
+	check($count == $entries,"--cache left $count entries, expected $entries");
+}
+
+# --snapshot: a rerun with -R reuses the listing of a directory whose
+# mtime is unchanged, reads again a directory whose mtime has changed,
+# and reads all directories afresh when the snapshot file is damaged.
+# A file is added to a directory and its mtime put back to make the
+# reuse of the listing visible: the file is not found.
+sub test_snapshot()
+{
+	my $tree = "$scrapdir/snaptree";
+	my $snapshot = "$scrapdir/snapshot.txt";
+	my $old = time() - 3600;
+	progress("*** Rerun Test: --snapshot ***");
+	mkpath("$tree/sub") or bail(1,"Cannot create directory \"$tree/sub\"");
+	write_file("$tree/a.c","#ifdef SYM_a\n","#endif\n");
+	write_file("$tree/sub/b.c","#ifdef SYM_b\n","#endif\n");
+	utime($old,$old,$tree,"$tree/sub");
+	check_snapshot($snapshot,"SYM_b",undef);
+	# mtime unchanged: the listing is reused
+	write_file("$tree/sub/c.c","#ifdef SYM_c\n","#endif\n");
+	utime($old,$old,"$tree/sub");
+	check_snapshot($snapshot,"SYM_b","SYM_c");
+	# mtime changed: the directory is read again
+	utime($old + 60,$old + 60,"$tree/sub");
+	check_snapshot($snapshot,"SYM_c",undef);
+	# Damaged snapshots: all directories are read again
+	write_file("$tree/sub/d.c","#ifdef SYM_d\n","#endif\n");
+	utime($old + 60,$old + 60,"$tree/sub");
+	write_file($snapshot,"This is not a snapshot\n");
+	check_snapshot($snapshot,"SYM_d",undef);
+	write_file("$tree/sub/e.c","#ifdef SYM_e\n","#endif\n");
+	utime($old + 60,$old + 60,"$tree/sub");
+	my $saved = slurp($snapshot);
+	write_file($snapshot,substr($saved,0,length($saved) / 2));
+	check_snapshot($snapshot,"SYM_e",undef);
+}
+
+# Run sunifdef --symbols -R with --snapshot on the snapshot test tree and
+# check that the symbols listed include $found and exclude $missed. Unless
+# a symbol is to be missed, check that the output and exit code are those
+# of a run without --snapshot.
+sub check_snapshot($$$)
+{
+	my ($snapshot,$found,$missed) = @_;
+	my $tree = "$scrapdir/snaptree";
+	my ($ret,$out) = sunifdef("--symbols first,locate -R --snapshot $snapshot $tree");
+	check($out =~ m/\b$found\b/,"--snapshot did not list $found");
+	if (defined($missed)) {
+		check($out !~ m/\b$missed\b/,"--snapshot listed $missed from an unchanged directory");
+	}
+	else {
+		my ($want_ret,$want_out) = sunifdef("--symbols first,locate -R $tree");
+		check($ret == $want_ret,"--snapshot exit code $ret, expected $want_ret");
+		check($out eq $want_out,"--snapshot output differs from a run without it");
+	}
+}
+
+# --daemon and --client: a client run on each test case that takes the
+# symbols of the daemon has the output and exit code of a run without the
+# daemon, and invalid requests are refused without stopping the daemon.
+sub test_daemon()
+{
+	my $socket = "$scrapdir/daemon.sock";
+	my $opts = "-DFOO1 -UFOO2";
+	my @cases = grep { my $text = slurp($_);
+		$text =~ m/^\/\*\*ARGS: $opts \*\/$/m && $text !~ m/ALTFILES/ }
+		glob("$pkgdir/test_sunifdef/test_cases/*.c");
+	progress("*** Rerun Test: --daemon ***");
+	$background_pid = start_sunifdef("--daemon $socket --jobs 2 $opts",
+		"$scrapdir/daemon.log");
+	for (my $i = 0; $i < 100 && ! -S $socket; ++$i) {
+		select(undef,undef,undef,0.1);
+	}
+	check(-S $socket,"--daemon did not create $socket");
+	return unless (-S $socket);
+	check_client($socket,$_) foreach (@cases);
+	# Lengths beyond bounds, more of them than workers, and a bad kind
+	foreach my $len (2 ** 40, 2 ** 62, 2 ** 62 + 1) {
+		check(bad_request($socket,pack("i x![Q] Q Q",ord('D'),4,$len)),
+			"--daemon did not refuse a body of $len bytes");
+	}
+	check(bad_request($socket,pack("i x![Q] Q Q",ord('?'),4,4)),
+		"--daemon did not refuse an unknown request");
+	check_client($socket,$_) foreach (@cases);
+	stop_sunifdef($background_pid);
+	$background_pid = undef;
+	check(! -e $socket,"--daemon did not remove $socket when stopped");
+}
+
+# --watch: after the input tree is processed, a file that is edited and a
+# file in a directory that appears are processed, and a file beside the
+# input tree is not. --watch is refused without --recurse.
+sub test_watch()
+{
+	my $tree = "$scrapdir/watchtree";
+	my $beside = "$scrapdir/beside.c";
+	my $log = "$scrapdir/watch.log";
+	my @edited = ("#ifdef FOO\n","int edited;\n","#else\n","int not_edited;\n","#endif\n");
+	progress("*** Rerun Test: --watch ***");
+	my ($ret,$out,$err) = sunifdef("--watch -DFOO $beside");
+	check($ret != 0 && $err =~ m/--watch needs --recurse/,
+		"--watch without --recurse was not refused");
+	mkpath("$tree/sub") or bail(1,"Cannot create directory \"$tree/sub\"");
+	write_file("$tree/a.c",source_lines(1));
+	write_file("$tree/sub/b.c",source_lines(1));
+	$background_pid = start_sunifdef("--watch -R -DFOO --verbose $tree",$log);
+	check(await_file($log,"Watching 2 directories for changes"),
+		"--watch did not watch the 2 directories of the input tree");
+	check(slurp("$tree/sub/b.c") !~ m/#ifdef FOO/,"--watch did not process the input tree");
+	write_file($beside,@edited);
+	write_file("$tree/sub/b.c",@edited);
+	mkpath("$tree/new") or bail(1,"Cannot create directory \"$tree/new\"");
+	write_file("$tree/new/c.c",@edited);
+	check(await_file("$tree/sub/b.c","^int edited;\n\\z"),
+		"--watch did not reprocess an edited file");
+	check(await_file("$tree/new/c.c","^int edited;\n\\z"),
+		"--watch did not process a file in a new directory");
+	check(slurp($beside) eq join('',@edited),
+		"--watch processed a file beside the input tree");
+	stop_sunifdef($background_pid);
+	$background_pid = undef;
+}
+
+# Wait up to 10 seconds for the contents of a file to match a pattern.
+# Say whether they do.
+sub await_file($$)
+{
+	my ($file,$pattern) = @_;
+	for (my $i = 0; $i < 100; ++$i) {
+		return 1 if (-f $file && slurp($file) =~ m/$pattern/);
+		select(undef,undef,undef,0.1);
+	}
+	return 0;
+}
+
+# Run sunifdef --client on a test case and check that the output and exit
+# code are those of a run without the daemon.
+sub check_client($$)
+{
+	my ($socket,$case) = @_;
+	my ($want_ret,$want_out) = sunifdef("-DFOO1 -UFOO2 $case");
+	my ($ret,$out) = sunifdef("--client $socket $case");
+	check($ret == $want_ret,"--client exit code $ret on $case, expected $want_ret");
+	check($out eq $want_out,"--client output differs on $case");
+}
+
+# Send a request header to a daemon and say whether it is answered with
+# an error. The header is as the client has it in memory.
+sub bad_request($$)
+{
+	my ($socket,$header) = @_;
+	my $client = IO::Socket::UNIX->new(Type => SOCK_STREAM, Peer => $socket)
+		or return 0;
+	print $client $header,"name";
+	$client->flush();
+	my $reply = "";
+	while (length($reply) < 4 && read($client,my $buf,4 - length($reply))) {
+		$reply .= $buf;
+	}
+	close($client);
+	return length($reply) == 4 && unpack("i",$reply) != 0;
+}
+
+# Start sunifdef in the background with the given arguments and its
+# stdout and stderr in a file. Return its process id.
+sub start_sunifdef($$)
+{
+	my ($args,$log) = @_;
+	progress("sunifdef $args &");
+	my $pid = fork();
+	bail(1,"Cannot fork: $!") unless defined($pid);
+	unless ($pid) {
+		exec("exec $execdir/sunifdef $args 1> $log 2>&1") or exit(127);
+	}
+	return $pid;
+}
+
+# Stop sunifdef running in the background and wait for it to exit.
+sub stop_sunifdef($)
+{
+	my $pid = shift;
+	kill('TERM',$pid);
+	for (my $i = 0; $i < 100 && waitpid($pid,WNOHANG) == 0; ++$i) {
+		select(undef,undef,undef,0.1);
+	}
+	if (kill(0,$pid)) {
+		kill('KILL',$pid);
+		waitpid($pid,0);
+	}
+}
+
+# Run sunifdef on a file with --incremental and check that the output and
+# exit code are those of a run without it, and that the diagnostics match
+# the given patterns.
+sub check_incremental($$$@)
+{
+	my ($input,$state,$opts,@patterns) = @_;
+	my ($ret,$out,$err) = sunifdef("$opts --verbose --incremental $state $input");
+	my ($want_ret,$want_out) = sunifdef("$opts $input");
+	check($ret == $want_ret,"--incremental exit code $ret, expected $want_ret");
+	check($out eq $want_out,"--incremental output differs from a full run");
+	foreach my $pattern (@patterns) {
+		check($err =~ m/$pattern/,"--incremental did not report /$pattern/");
+	}
+}
+
+# A C source of 10 lines for each of $blocks blocks, each with #ifdef FOO
+# and #if BAR.
+sub source_lines($)
+{
+	my $blocks = shift;
+	my @lines = ();
+	for (my $i = 0; $i < $blocks; ++$i) {
+		push(@lines,"#ifdef FOO\n","int foo_$i;\n","#else\n","int not_foo_$i;\n",
+			"#endif\n","int plain_$i;\n","#if BAR\n","int bar_$i;\n","#endif\n",
+			"/* comment $i */\n");
+	}
+	return @lines;
+}
+
+sub check($$)
+{
+	my ($ok,$what) = @_;
+	unless ($ok) {
+		++$fails;
+		error("*** Rerun test failed: $what ***");
+		exit($fails) if ($bail);
+	}
+}
+
+# Run sunifdef with the given arguments. Return its exit code, stdout and stderr.
+sub sunifdef($)
+{
+	my $args = shift;
+	progress("sunifdef $args");
+	my $ret = system("$execdir/sunifdef $args 1> $stdout_file 2> $stderr_file") >> 8;
+	return ($ret,slurp($stdout_file),slurp($stderr_file));
+}
+
+sub write_file($@)
+{
+	my ($file,@lines) = @_;
+	open OUT,">$file" or bail(1,"Cannot open \"$file\" for writing");
+	print OUT @lines;
+	close(OUT);
+}
+
+sub slurp($)
+{
+	my $terminator = $/;
+	open IN,"<$_[0]" or bail(1,"Cannot open file \"$_[0]\" for reading");
+	undef $/;
+	my $text = <IN>;
+	close(IN);
+	$/ = $terminator;
+	return defined($text) ? $text : "";
+}
@@ -0,0 +1,18 @@
+/**ARGS:  -DFOO -UBAR */
+/**SYSCODE: = 1 | 16 | 32 */
+#ifdef FOO /* comment */
+KEEP ME
+#else
+DELETE ME
+#endif
+#if defined(BAR) || \
+    defined(BAZ) /* comment
+continues */
+DELETE ME
+#else // comment
+KEEP ME
+#endif
+int x; /\
+* split comment *\
+/
+KEEP ME
@@ -0,0 +1,1611 @@
+/**ARGS:  -DFOO -UBAR --jobs 2 */
+/**SYSCODE: = 1 | 16 */
+#if defined(BAR) && X1
+int dropped1;
+#endif
+int g2 = 3; /* opens a comment
+   continues
+   and closes */ int after2;
+static const char *s3 = "/* not a comment */";
+int g4 = 3; /* opens a comment
+   continues
+   and closes */ int after4;
+int e5 = 2; // trailing comment with "quote
+	int h6 = 4;
+#ifdef FOO
+int kept7;
+#else
+int dropped7;
+#endif
+	int h8 = 4;
+#if defined(BAR) && X9
+int dropped9;
+#endif
+static const char *s10 = "/* not a comment */";
+#if defined(BAR) && X11
+int dropped11;
+#endif
+int e12 = 2; // trailing comment with "quote
+int g13 = 3; /* opens a comment
+   continues
+   and closes */ int after13;
+int c14 = '"'; /* a comment */ int d14 = 1;
+static const char *s15 = "/* not a comment */";
+static const char *s16 = "/* not a comment */";
+char f17[] = "// not a comment either";
+int c18 = '"'; /* a comment */ int d18 = 1;
+#if defined(BAR) && X19
+int dropped19;
+#endif
+char f20[] = "// not a comment either";
+int c21 = '"'; /* a comment */ int d21 = 1;
+x22 = a / b * c;
+	int h23 = 4;
+x24 = a / b * c;
+	int h25 = 4;
+int e26 = 2; // trailing comment with "quote
+static const char *s27 = "/* not a comment */";
+int c28 = '"'; /* a comment */ int d28 = 1;
+x29 = a / b * c;
+#ifdef FOO
+int kept30;
+#else
+int dropped30;
+#endif
+static const char *s31 = "/* not a comment */";
+static const char *s32 = "/* not a comment */";
+#ifdef FOO
+int kept33;
+#else
+int dropped33;
+#endif
+int e34 = 2; // trailing comment with "quote
+char f35[] = "// not a comment either";
+int g36 = 3; /* opens a comment
+   continues
+   and closes */ int after36;
+#ifdef FOO
+int kept37;
+#else
+int dropped37;
+#endif
+char f38[] = "// not a comment either";
+x39 = a / b * c;
+char f40[] = "// not a comment either";
+static const char *s41 = "/* not a comment */";
+int c42 = '"'; /* a comment */ int d42 = 1;
+int e43 = 2; // trailing comment with "quote
+	int h44 = 4;
+static const char *s45 = "/* not a comment */";
+x46 = a / b * c;
+int e47 = 2; // trailing comment with "quote
+char f48[] = "// not a comment either";
+int c49 = '"'; /* a comment */ int d49 = 1;
+char f50[] = "// not a comment either";
+	int h51 = 4;
+x52 = a / b * c;
+x53 = a / b * c;
+int c54 = '"'; /* a comment */ int d54 = 1;
+#ifdef FOO
+int kept55;
+#else
+int dropped55;
+#endif
+static const char *s56 = "/* not a comment */";
+int g57 = 3; /* opens a comment
+   continues
+   and closes */ int after57;
+static const char *s58 = "/* not a comment */";
+static const char *s59 = "/* not a comment */";
+int e60 = 2; // trailing comment with "quote
+static const char *s61 = "/* not a comment */";
+int e62 = 2; // trailing comment with "quote
+x63 = a / b * c;
+char f64[] = "// not a comment either";
+#if defined(BAR) && X65
+int dropped65;
+#endif
+	int h66 = 4;
+	int h67 = 4;
+char f68[] = "// not a comment either";
+x69 = a / b * c;
+#ifdef FOO
+int kept70;
+#else
+int dropped70;
+#endif
+#ifdef FOO
+int kept71;
+#else
+int dropped71;
+#endif
+char f72[] = "// not a comment either";
+int e73 = 2; // trailing comment with "quote
+static const char *s74 = "/* not a comment */";
+#ifdef FOO
+int kept75;
+#else
+int dropped75;
+#endif
+int c76 = '"'; /* a comment */ int d76 = 1;
+int c77 = '"'; /* a comment */ int d77 = 1;
+#if defined(BAR) && X78
+int dropped78;
+#endif
+char f79[] = "// not a comment either";
+int g80 = 3; /* opens a comment
+   continues
+   and closes */ int after80;
+	int h81 = 4;
+static const char *s82 = "/* not a comment */";
+static const char *s83 = "/* not a comment */";
+	int h84 = 4;
+	int h85 = 4;
+char f86[] = "// not a comment either";
+static const char *s87 = "/* not a comment */";
+#if defined(BAR) && X88
+int dropped88;
+#endif
+static const char *s89 = "/* not a comment */";
+char f90[] = "// not a comment either";
+	int h91 = 4;
+	int h92 = 4;
+int e93 = 2; // trailing comment with "quote
+	int h94 = 4;
+int c95 = '"'; /* a comment */ int d95 = 1;
+int e96 = 2; // trailing comment with "quote
+#if defined(BAR) && X97
+int dropped97;
+#endif
+x98 = a / b * c;
+int c99 = '"'; /* a comment */ int d99 = 1;
+char f100[] = "// not a comment either";
+int e101 = 2; // trailing comment with "quote
+#if defined(BAR) && X102
+int dropped102;
+#endif
+x103 = a / b * c;
+int g104 = 3; /* opens a comment
+   continues
+   and closes */ int after104;
+x105 = a / b * c;
+static const char *s106 = "/* not a comment */";
+int e107 = 2; // trailing comment with "quote
+int g108 = 3; /* opens a comment
+   continues
+   and closes */ int after108;
+int e109 = 2; // trailing comment with "quote
+int g110 = 3; /* opens a comment
+   continues
+   and closes */ int after110;
+#ifdef FOO
+int kept111;
+#else
+int dropped111;
+#endif
+	int h112 = 4;
+static const char *s113 = "/* not a comment */";
+static const char *s114 = "/* not a comment */";
+int e115 = 2; // trailing comment with "quote
+int c116 = '"'; /* a comment */ int d116 = 1;
+#ifdef FOO
+int kept117;
+#else
+int dropped117;
+#endif
+char f118[] = "// not a comment either";
+int e119 = 2; // trailing comment with "quote
+char f120[] = "// not a comment either";
+static const char *s121 = "/* not a comment */";
+int e122 = 2; // trailing comment with "quote
+int g123 = 3; /* opens a comment
+   continues
+   and closes */ int after123;
+static const char *s124 = "/* not a comment */";
+int c125 = '"'; /* a comment */ int d125 = 1;
+#if defined(BAR) && X126
+int dropped126;
+#endif
+int e127 = 2; // trailing comment with "quote
+int c128 = '"'; /* a comment */ int d128 = 1;
+int g129 = 3; /* opens a comment
+   continues
+   and closes */ int after129;
+int g130 = 3; /* opens a comment
+   continues
+   and closes */ int after130;
+#if defined(BAR) && X131
+int dropped131;
+#endif
+char f132[] = "// not a comment either";
+	int h133 = 4;
+static const char *s134 = "/* not a comment */";
+static const char *s135 = "/* not a comment */";
+	int h136 = 4;
+static const char *s137 = "/* not a comment */";
+int c138 = '"'; /* a comment */ int d138 = 1;
+	int h139 = 4;
+#if defined(BAR) && X140
+int dropped140;
+#endif
+#ifdef FOO
+int kept141;
+#else
+int dropped141;
+#endif
+int e142 = 2; // trailing comment with "quote
+int g143 = 3; /* opens a comment
+   continues
+   and closes */ int after143;
+char f144[] = "// not a comment either";
+int g145 = 3; /* opens a comment
+   continues
+   and closes */ int after145;
+x146 = a / b * c;
+char f147[] = "// not a comment either";
+#ifdef FOO
+int kept148;
+#else
+int dropped148;
+#endif
+int c149 = '"'; /* a comment */ int d149 = 1;
+static const char *s150 = "/* not a comment */";
+int e151 = 2; // trailing comment with "quote
+x152 = a / b * c;
+int c153 = '"'; /* a comment */ int d153 = 1;
+#ifdef FOO
+int kept154;
+#else
+int dropped154;
+#endif
+	int h155 = 4;
+char f156[] = "// not a comment either";
+char f157[] = "// not a comment either";
+int e158 = 2; // trailing comment with "quote
+#if defined(BAR) && X159
+int dropped159;
+#endif
+static const char *s160 = "/* not a comment */";
+static const char *s161 = "/* not a comment */";
+static const char *s162 = "/* not a comment */";
+#ifdef FOO
+int kept163;
+#else
+int dropped163;
+#endif
+#if defined(BAR) && X164
+int dropped164;
+#endif
+int c165 = '"'; /* a comment */ int d165 = 1;
+char f166[] = "// not a comment either";
+	int h167 = 4;
+	int h168 = 4;
+int c169 = '"'; /* a comment */ int d169 = 1;
+int e170 = 2; // trailing comment with "quote
+	int h171 = 4;
+x172 = a / b * c;
+static const char *s173 = "/* not a comment */";
+#if defined(BAR) && X174
+int dropped174;
+#endif
+	int h175 = 4;
+int g176 = 3; /* opens a comment
+   continues
+   and closes */ int after176;
+x177 = a / b * c;
+int c178 = '"'; /* a comment */ int d178 = 1;
+static const char *s179 = "/* not a comment */";
+static const char *s180 = "/* not a comment */";
+	int h181 = 4;
+int g182 = 3; /* opens a comment
+   continues
+   and closes */ int after182;
+	int h183 = 4;
+#ifdef FOO
+int kept184;
+#else
+int dropped184;
+#endif
+x185 = a / b * c;
+x186 = a / b * c;
+int e187 = 2; // trailing comment with "quote
+int c188 = '"'; /* a comment */ int d188 = 1;
+char f189[] = "// not a comment either";
+int c190 = '"'; /* a comment */ int d190 = 1;
+int c191 = '"'; /* a comment */ int d191 = 1;
+char f192[] = "// not a comment either";
+#ifdef FOO
+int kept193;
+#else
+int dropped193;
+#endif
+x194 = a / b * c;
+#ifdef FOO
+int kept195;
+#else
+int dropped195;
+#endif
+char f196[] = "// not a comment either";
+static const char *s197 = "/* not a comment */";
+char f198[] = "// not a comment either";
+static const char *s199 = "/* not a comment */";
+	int h200 = 4;
+	int h201 = 4;
+x202 = a / b * c;
+x203 = a / b * c;
+int c204 = '"'; /* a comment */ int d204 = 1;
+x205 = a / b * c;
+static const char *s206 = "/* not a comment */";
+x207 = a / b * c;
+	int h208 = 4;
+	int h209 = 4;
+static const char *s210 = "/* not a comment */";
+static const char *s211 = "/* not a comment */";
+char f212[] = "// not a comment either";
+#if defined(BAR) && X213
+int dropped213;
+#endif
+	int h214 = 4;
+int c215 = '"'; /* a comment */ int d215 = 1;
+x216 = a / b * c;
+#ifdef FOO
+int kept217;
+#else
+int dropped217;
+#endif
+int e218 = 2; // trailing comment with "quote
+int e219 = 2; // trailing comment with "quote
+int c220 = '"'; /* a comment */ int d220 = 1;
+x221 = a / b * c;
+int c222 = '"'; /* a comment */ int d222 = 1;
+int c223 = '"'; /* a comment */ int d223 = 1;
+#if defined(BAR) && X224
+int dropped224;
+#endif
+x225 = a / b * c;
+int g226 = 3; /* opens a comment
+   continues
+   and closes */ int after226;
+int g227 = 3; /* opens a comment
+   continues
+   and closes */ int after227;
+static const char *s228 = "/* not a comment */";
+int e229 = 2; // trailing comment with "quote
+int e230 = 2; // trailing comment with "quote
+x231 = a / b * c;
+int e232 = 2; // trailing comment with "quote
+x233 = a / b * c;
+int g234 = 3; /* opens a comment
+   continues
+   and closes */ int after234;
+x235 = a / b * c;
+static const char *s236 = "/* not a comment */";
+int c237 = '"'; /* a comment */ int d237 = 1;
+int c238 = '"'; /* a comment */ int d238 = 1;
+int c239 = '"'; /* a comment */ int d239 = 1;
+int c240 = '"'; /* a comment */ int d240 = 1;
+int g241 = 3; /* opens a comment
+   continues
+   and closes */ int after241;
+int e242 = 2; // trailing comment with "quote
+int g243 = 3; /* opens a comment
+   continues
+   and closes */ int after243;
+char f244[] = "// not a comment either";
+int c245 = '"'; /* a comment */ int d245 = 1;
+static const char *s246 = "/* not a comment */";
+int e247 = 2; // trailing comment with "quote
+static const char *s248 = "/* not a comment */";
+char f249[] = "// not a comment either";
+char f250[] = "// not a comment either";
+x251 = a / b * c;
+char f252[] = "// not a comment either";
+x253 = a / b * c;
+int g254 = 3; /* opens a comment
+   continues
+   and closes */ int after254;
+#ifdef FOO
+int kept255;
+#else
+int dropped255;
+#endif
+#if defined(BAR) && X256
+int dropped256;
+#endif
+x257 = a / b * c;
+int e258 = 2; // trailing comment with "quote
+#if defined(BAR) && X259
+int dropped259;
+#endif
+int g260 = 3; /* opens a comment
+   continues
+   and closes */ int after260;
+int c261 = '"'; /* a comment */ int d261 = 1;
+int c262 = '"'; /* a comment */ int d262 = 1;
+static const char *s263 = "/* not a comment */";
+int e264 = 2; // trailing comment with "quote
+int g265 = 3; /* opens a comment
+   continues
+   and closes */ int after265;
+	int h266 = 4;
+int g267 = 3; /* opens a comment
+   continues
+   and closes */ int after267;
+x268 = a / b * c;
+	int h269 = 4;
+	int h270 = 4;
+#ifdef FOO
+int kept271;
+#else
+int dropped271;
+#endif
+char f272[] = "// not a comment either";
+int e273 = 2; // trailing comment with "quote
+x274 = a / b * c;
+x275 = a / b * c;
+int g276 = 3; /* opens a comment
+   continues
+   and closes */ int after276;
+x277 = a / b * c;
+int c278 = '"'; /* a comment */ int d278 = 1;
+#ifdef FOO
+int kept279;
+#else
+int dropped279;
+#endif
+	int h280 = 4;
+int c281 = '"'; /* a comment */ int d281 = 1;
+x282 = a / b * c;
+int e283 = 2; // trailing comment with "quote
+#ifdef FOO
+int kept284;
+#else
+int dropped284;
+#endif
+#ifdef FOO
+int kept285;
+#else
+int dropped285;
+#endif
+	int h286 = 4;
+int c287 = '"'; /* a comment */ int d287 = 1;
+static const char *s288 = "/* not a comment */";
+	int h289 = 4;
+x290 = a / b * c;
+int e291 = 2; // trailing comment with "quote
+int c292 = '"'; /* a comment */ int d292 = 1;
+int e293 = 2; // trailing comment with "quote
+x294 = a / b * c;
+x295 = a / b * c;
+char f296[] = "// not a comment either";
+x297 = a / b * c;
+	int h298 = 4;
+#ifdef FOO
+int kept299;
+#else
+int dropped299;
+#endif
+int g300 = 3; /* opens a comment
+   continues
+   and closes */ int after300;
+#if defined(BAR) && X301
+int dropped301;
+#endif
+#if defined(BAR) && X302
+int dropped302;
+#endif
+int g303 = 3; /* opens a comment
+   continues
+   and closes */ int after303;
+int g304 = 3; /* opens a comment
+   continues
+   and closes */ int after304;
+#ifdef FOO
+int kept305;
+#else
+int dropped305;
+#endif
+int g306 = 3; /* opens a comment
+   continues
+   and closes */ int after306;
+static const char *s307 = "/* not a comment */";
+int g308 = 3; /* opens a comment
+   continues
+   and closes */ int after308;
+#if defined(BAR) && X309
+int dropped309;
+#endif
+	int h310 = 4;
+#ifdef FOO
+int kept311;
+#else
+int dropped311;
+#endif
+int c312 = '"'; /* a comment */ int d312 = 1;
+x313 = a / b * c;
+int c314 = '"'; /* a comment */ int d314 = 1;
+x315 = a / b * c;
+#ifdef FOO
+int kept316;
+#else
+int dropped316;
+#endif
+	int h317 = 4;
+#if defined(BAR) && X318
+int dropped318;
+#endif
+#if defined(BAR) && X319
+int dropped319;
+#endif
+int c320 = '"'; /* a comment */ int d320 = 1;
+int g321 = 3; /* opens a comment
+   continues
+   and closes */ int after321;
+char f322[] = "// not a comment either";
+int g323 = 3; /* opens a comment
+   continues
+   and closes */ int after323;
+char f324[] = "// not a comment either";
+int g325 = 3; /* opens a comment
+   continues
+   and closes */ int after325;
+int c326 = '"'; /* a comment */ int d326 = 1;
+char f327[] = "// not a comment either";
+	int h328 = 4;
+int g329 = 3; /* opens a comment
+   continues
+   and closes */ int after329;
+#ifdef FOO
+int kept330;
+#else
+int dropped330;
+#endif
+#ifdef FOO
+int kept331;
+#else
+int dropped331;
+#endif
+int g332 = 3; /* opens a comment
+   continues
+   and closes */ int after332;
+int g333 = 3; /* opens a comment
+   continues
+   and closes */ int after333;
+char f334[] = "// not a comment either";
+#ifdef FOO
+int kept335;
+#else
+int dropped335;
+#endif
+int c336 = '"'; /* a comment */ int d336 = 1;
+int g337 = 3; /* opens a comment
+   continues
+   and closes */ int after337;
+char f338[] = "// not a comment either";
+x339 = a / b * c;
+static const char *s340 = "/* not a comment */";
+#ifdef FOO
+int kept341;
+#else
+int dropped341;
+#endif
+int c342 = '"'; /* a comment */ int d342 = 1;
+x343 = a / b * c;
+#ifdef FOO
+int kept344;
+#else
+int dropped344;
+#endif
+#ifdef FOO
+int kept345;
+#else
+int dropped345;
+#endif
+int c346 = '"'; /* a comment */ int d346 = 1;
+static const char *s347 = "/* not a comment */";
+int e348 = 2; // trailing comment with "quote
+int c349 = '"'; /* a comment */ int d349 = 1;
+x350 = a / b * c;
+char f351[] = "// not a comment either";
+char f352[] = "// not a comment either";
+int c353 = '"'; /* a comment */ int d353 = 1;
+int c354 = '"'; /* a comment */ int d354 = 1;
+#ifdef FOO
+int kept355;
+#else
+int dropped355;
+#endif
+int c356 = '"'; /* a comment */ int d356 = 1;
+int c357 = '"'; /* a comment */ int d357 = 1;
+int g358 = 3; /* opens a comment
+   continues
+   and closes */ int after358;
+x359 = a / b * c;
+int c360 = '"'; /* a comment */ int d360 = 1;
+int e361 = 2; // trailing comment with "quote
+	int h362 = 4;
+x363 = a / b * c;
+	int h364 = 4;
+static const char *s365 = "/* not a comment */";
+int c366 = '"'; /* a comment */ int d366 = 1;
+char f367[] = "// not a comment either";
+int e368 = 2; // trailing comment with "quote
+char f369[] = "// not a comment either";
+char f370[] = "// not a comment either";
+	int h371 = 4;
+char f372[] = "// not a comment either";
+x373 = a / b * c;
+int e374 = 2; // trailing comment with "quote
+int e375 = 2; // trailing comment with "quote
+static const char *s376 = "/* not a comment */";
+int c377 = '"'; /* a comment */ int d377 = 1;
+int e378 = 2; // trailing comment with "quote
+int c379 = '"'; /* a comment */ int d379 = 1;
+int e380 = 2; // trailing comment with "quote
+static const char *s381 = "/* not a comment */";
+int e382 = 2; // trailing comment with "quote
+int g383 = 3; /* opens a comment
+   continues
+   and closes */ int after383;
+char f384[] = "// not a comment either";
+x385 = a / b * c;
+static const char *s386 = "/* not a comment */";
+x387 = a / b * c;
+	int h388 = 4;
+static const char *s389 = "/* not a comment */";
+int e390 = 2; // trailing comment with "quote
+static const char *s391 = "/* not a comment */";
+	int h392 = 4;
+int e393 = 2; // trailing comment with "quote
+#if defined(BAR) && X394
+int dropped394;
+#endif
+static const char *s395 = "/* not a comment */";
+x396 = a / b * c;
+int c397 = '"'; /* a comment */ int d397 = 1;
+int g398 = 3; /* opens a comment
+   continues
+   and closes */ int after398;
+x399 = a / b * c;
+static const char *s400 = "/* not a comment */";
+char f401[] = "// not a comment either";
+#ifdef FOO
+int kept402;
+#else
+int dropped402;
+#endif
+int g403 = 3; /* opens a comment
+   continues
+   and closes */ int after403;
+int c404 = '"'; /* a comment */ int d404 = 1;
+int g405 = 3; /* opens a comment
+   continues
+   and closes */ int after405;
+#ifdef FOO
+int kept406;
+#else
+int dropped406;
+#endif
+#ifdef FOO
+int kept407;
+#else
+int dropped407;
+#endif
+int g408 = 3; /* opens a comment
+   continues
+   and closes */ int after408;
+	int h409 = 4;
+#if defined(BAR) && X410
+int dropped410;
+#endif
+x411 = a / b * c;
+static const char *s412 = "/* not a comment */";
+char f413[] = "// not a comment either";
+	int h414 = 4;
+int e415 = 2; // trailing comment with "quote
+	int h416 = 4;
+static const char *s417 = "/* not a comment */";
+	int h418 = 4;
+#if defined(BAR) && X419
+int dropped419;
+#endif
+#if defined(BAR) && X420
+int dropped420;
+#endif
+#if defined(BAR) && X421
+int dropped421;
+#endif
+	int h422 = 4;
+#if defined(BAR) && X423
+int dropped423;
+#endif
+x424 = a / b * c;
+int c425 = '"'; /* a comment */ int d425 = 1;
+char f426[] = "// not a comment either";
+#ifdef FOO
+int kept427;
+#else
+int dropped427;
+#endif
+	int h428 = 4;
+int g429 = 3; /* opens a comment
+   continues
+   and closes */ int after429;
+int c430 = '"'; /* a comment */ int d430 = 1;
+#ifdef FOO
+int kept431;
+#else
+int dropped431;
+#endif
+int c432 = '"'; /* a comment */ int d432 = 1;
+x433 = a / b * c;
+	int h434 = 4;
+int c435 = '"'; /* a comment */ int d435 = 1;
+	int h436 = 4;
+x437 = a / b * c;
+int g438 = 3; /* opens a comment
+   continues
+   and closes */ int after438;
+#ifdef FOO
+int kept439;
+#else
+int dropped439;
+#endif
+int e440 = 2; // trailing comment with "quote
+int e441 = 2; // trailing comment with "quote
+int e442 = 2; // trailing comment with "quote
+x443 = a / b * c;
+char f444[] = "// not a comment either";
+char f445[] = "// not a comment either";
+	int h446 = 4;
+int c447 = '"'; /* a comment */ int d447 = 1;
+static const char *s448 = "/* not a comment */";
+static const char *s449 = "/* not a comment */";
+	int h450 = 4;
+static const char *s451 = "/* not a comment */";
+	int h452 = 4;
+	int h453 = 4;
+char f454[] = "// not a comment either";
+int e455 = 2; // trailing comment with "quote
+char f456[] = "// not a comment either";
+char f457[] = "// not a comment either";
+#ifdef FOO
+int kept458;
+#else
+int dropped458;
+#endif
+int c459 = '"'; /* a comment */ int d459 = 1;
+	int h460 = 4;
+	int h461 = 4;
+char f462[] = "// not a comment either";
+char f463[] = "// not a comment either";
+int c464 = '"'; /* a comment */ int d464 = 1;
+char f465[] = "// not a comment either";
+#ifdef FOO
+int kept466;
+#else
+int dropped466;
+#endif
+x467 = a / b * c;
+#if defined(BAR) && X468
+int dropped468;
+#endif
+int g469 = 3; /* opens a comment
+   continues
+   and closes */ int after469;
+	int h470 = 4;
+static const char *s471 = "/* not a comment */";
+int c472 = '"'; /* a comment */ int d472 = 1;
+static const char *s473 = "/* not a comment */";
+static const char *s474 = "/* not a comment */";
+char f475[] = "// not a comment either";
+x476 = a / b * c;
+int c477 = '"'; /* a comment */ int d477 = 1;
+x478 = a / b * c;
+#ifdef FOO
+int kept479;
+#else
+int dropped479;
+#endif
+int c480 = '"'; /* a comment */ int d480 = 1;
+int c481 = '"'; /* a comment */ int d481 = 1;
+char f482[] = "// not a comment either";
+x483 = a / b * c;
+int e484 = 2; // trailing comment with "quote
+int c485 = '"'; /* a comment */ int d485 = 1;
+#ifdef FOO
+int kept486;
+#else
+int dropped486;
+#endif
+char f487[] = "// not a comment either";
+char f488[] = "// not a comment either";
+int e489 = 2; // trailing comment with "quote
+	int h490 = 4;
+#ifdef FOO
+int kept491;
+#else
+int dropped491;
+#endif
+int c492 = '"'; /* a comment */ int d492 = 1;
+	int h493 = 4;
+x494 = a / b * c;
+char f495[] = "// not a comment either";
+int g496 = 3; /* opens a comment
+   continues
+   and closes */ int after496;
+int g497 = 3; /* opens a comment
+   continues
+   and closes */ int after497;
+x498 = a / b * c;
+#ifdef FOO
+int kept499;
+#else
+int dropped499;
+#endif
+char f500[] = "// not a comment either";
+	int h501 = 4;
+static const char *s502 = "/* not a comment */";
+x503 = a / b * c;
+static const char *s504 = "/* not a comment */";
+int g505 = 3; /* opens a comment
+   continues
+   and closes */ int after505;
+char f506[] = "// not a comment either";
+char f507[] = "// not a comment either";
+int e508 = 2; // trailing comment with "quote
+#ifdef FOO
+int kept509;
+#else
+int dropped509;
+#endif
+	int h510 = 4;
+int e511 = 2; // trailing comment with "quote
+static const char *s512 = "/* not a comment */";
+int e513 = 2; // trailing comment with "quote
+#if defined(BAR) && X514
+int dropped514;
+#endif
+int g515 = 3; /* opens a comment
+   continues
+   and closes */ int after515;
+int c516 = '"'; /* a comment */ int d516 = 1;
+	int h517 = 4;
+int g518 = 3; /* opens a comment
+   continues
+   and closes */ int after518;
+static const char *s519 = "/* not a comment */";
+#ifdef FOO
+int kept520;
+#else
+int dropped520;
+#endif
+int e521 = 2; // trailing comment with "quote
+int g522 = 3; /* opens a comment
+   continues
+   and closes */ int after522;
+char f523[] = "// not a comment either";
+char f524[] = "// not a comment either";
+static const char *s525 = "/* not a comment */";
+	int h526 = 4;
+int c527 = '"'; /* a comment */ int d527 = 1;
+	int h528 = 4;
+int g529 = 3; /* opens a comment
+   continues
+   and closes */ int after529;
+int e530 = 2; // trailing comment with "quote
+int e531 = 2; // trailing comment with "quote
+static const char *s532 = "/* not a comment */";
+x533 = a / b * c;
+int e534 = 2; // trailing comment with "quote
+#if defined(BAR) && X535
+int dropped535;
+#endif
+#if defined(BAR) && X536
+int dropped536;
+#endif
+static const char *s537 = "/* not a comment */";
+	int h538 = 4;
+#ifdef FOO
+int kept539;
+#else
+int dropped539;
+#endif
+char f540[] = "// not a comment either";
+	int h541 = 4;
+	int h542 = 4;
+int c543 = '"'; /* a comment */ int d543 = 1;
+x544 = a / b * c;
+int c545 = '"'; /* a comment */ int d545 = 1;
+x546 = a / b * c;
+static const char *s547 = "/* not a comment */";
+char f548[] = "// not a comment either";
+x549 = a / b * c;
+char f550[] = "// not a comment either";
+x551 = a / b * c;
+int g552 = 3; /* opens a comment
+   continues
+   and closes */ int after552;
+char f553[] = "// not a comment either";
+int g554 = 3; /* opens a comment
+   continues
+   and closes */ int after554;
+char f555[] = "// not a comment either";
+int g556 = 3; /* opens a comment
+   continues
+   and closes */ int after556;
+int c557 = '"'; /* a comment */ int d557 = 1;
+char f558[] = "// not a comment either";
+int c559 = '"'; /* a comment */ int d559 = 1;
+int g560 = 3; /* opens a comment
+   continues
+   and closes */ int after560;
+	int h561 = 4;
+x562 = a / b * c;
+x563 = a / b * c;
+int g564 = 3; /* opens a comment
+   continues
+   and closes */ int after564;
+	int h565 = 4;
+int e566 = 2; // trailing comment with "quote
+	int h567 = 4;
+int e568 = 2; // trailing comment with "quote
+char f569[] = "// not a comment either";
+	int h570 = 4;
+int g571 = 3; /* opens a comment
+   continues
+   and closes */ int after571;
+	int h572 = 4;
+x573 = a / b * c;
+#ifdef FOO
+int kept574;
+#else
+int dropped574;
+#endif
+int c575 = '"'; /* a comment */ int d575 = 1;
+char f576[] = "// not a comment either";
+char f577[] = "// not a comment either";
+int g578 = 3; /* opens a comment
+   continues
+   and closes */ int after578;
+x579 = a / b * c;
+char f580[] = "// not a comment either";
+char f581[] = "// not a comment either";
+#if defined(BAR) && X582
+int dropped582;
+#endif
+int g583 = 3; /* opens a comment
+   continues
+   and closes */ int after583;
+#if defined(BAR) && X584
+int dropped584;
+#endif
+	int h585 = 4;
+int c586 = '"'; /* a comment */ int d586 = 1;
+static const char *s587 = "/* not a comment */";
+int g588 = 3; /* opens a comment
+   continues
+   and closes */ int after588;
+int e589 = 2; // trailing comment with "quote
+x590 = a / b * c;
+char f591[] = "// not a comment either";
+	int h592 = 4;
+#ifdef FOO
+int kept593;
+#else
+int dropped593;
+#endif
+	int h594 = 4;
+	int h595 = 4;
+int g596 = 3; /* opens a comment
+   continues
+   and closes */ int after596;
+static const char *s597 = "/* not a comment */";
+int e598 = 2; // trailing comment with "quote
+#if defined(BAR) && X599
+int dropped599;
+#endif
+#ifdef FOO
+int kept600;
+#else
+int dropped600;
+#endif
+static const char *s601 = "/* not a comment */";
+#ifdef FOO
+int kept602;
+#else
+int dropped602;
+#endif
+int e603 = 2; // trailing comment with "quote
+static const char *s604 = "/* not a comment */";
+int e605 = 2; // trailing comment with "quote
+static const char *s606 = "/* not a comment */";
+char f607[] = "// not a comment either";
+	int h608 = 4;
+char f609[] = "// not a comment either";
+	int h610 = 4;
+x611 = a / b * c;
+static const char *s612 = "/* not a comment */";
+int c613 = '"'; /* a comment */ int d613 = 1;
+#ifdef FOO
+int kept614;
+#else
+int dropped614;
+#endif
+int g615 = 3; /* opens a comment
+   continues
+   and closes */ int after615;
+char f616[] = "// not a comment either";
+int e617 = 2; // trailing comment with "quote
+	int h618 = 4;
+#ifdef FOO
+int kept619;
+#else
+int dropped619;
+#endif
+int e620 = 2; // trailing comment with "quote
+x621 = a / b * c;
+static const char *s622 = "/* not a comment */";
+int g623 = 3; /* opens a comment
+   continues
+   and closes */ int after623;
+#ifdef FOO
+int kept624;
+#else
+int dropped624;
+#endif
+static const char *s625 = "/* not a comment */";
+char f626[] = "// not a comment either";
+#ifdef FOO
+int kept627;
+#else
+int dropped627;
+#endif
+int e628 = 2; // trailing comment with "quote
+#ifdef FOO
+int kept629;
+#else
+int dropped629;
+#endif
+int g630 = 3; /* opens a comment
+   continues
+   and closes */ int after630;
+static const char *s631 = "/* not a comment */";
+int c632 = '"'; /* a comment */ int d632 = 1;
+int c633 = '"'; /* a comment */ int d633 = 1;
+int g634 = 3; /* opens a comment
+   continues
+   and closes */ int after634;
+int g635 = 3; /* opens a comment
+   continues
+   and closes */ int after635;
+static const char *s636 = "/* not a comment */";
+#ifdef FOO
+int kept637;
+#else
+int dropped637;
+#endif
+int g638 = 3; /* opens a comment
+   continues
+   and closes */ int after638;
+#ifdef FOO
+int kept639;
+#else
+int dropped639;
+#endif
+int g640 = 3; /* opens a comment
+   continues
+   and closes */ int after640;
+int e641 = 2; // trailing comment with "quote
+	int h642 = 4;
+x643 = a / b * c;
+static const char *s644 = "/* not a comment */";
+x645 = a / b * c;
+char f646[] = "// not a comment either";
+x647 = a / b * c;
+char f648[] = "// not a comment either";
+int g649 = 3; /* opens a comment
+   continues
+   and closes */ int after649;
+x650 = a / b * c;
+#ifdef FOO
+int kept651;
+#else
+int dropped651;
+#endif
+	int h652 = 4;
+	int h653 = 4;
+x654 = a / b * c;
+static const char *s655 = "/* not a comment */";
+	int h656 = 4;
+x657 = a / b * c;
+	int h658 = 4;
+int e659 = 2; // trailing comment with "quote
+char f660[] = "// not a comment either";
+#if defined(BAR) && X661
+int dropped661;
+#endif
+x662 = a / b * c;
+int e663 = 2; // trailing comment with "quote
+int g664 = 3; /* opens a comment
+   continues
+   and closes */ int after664;
+x665 = a / b * c;
+int g666 = 3; /* opens a comment
+   continues
+   and closes */ int after666;
+char f667[] = "// not a comment either";
+int c668 = '"'; /* a comment */ int d668 = 1;
+int g669 = 3; /* opens a comment
+   continues
+   and closes */ int after669;
+static const char *s670 = "/* not a comment */";
+x671 = a / b * c;
+char f672[] = "// not a comment either";
+char f673[] = "// not a comment either";
+int c674 = '"'; /* a comment */ int d674 = 1;
+int e675 = 2; // trailing comment with "quote
+char f676[] = "// not a comment either";
+static const char *s677 = "/* not a comment */";
+x678 = a / b * c;
+x679 = a / b * c;
+x680 = a / b * c;
+int e681 = 2; // trailing comment with "quote
+static const char *s682 = "/* not a comment */";
+#ifdef FOO
+int kept683;
+#else
+int dropped683;
+#endif
+	int h684 = 4;
+#ifdef FOO
+int kept685;
+#else
+int dropped685;
+#endif
+int e686 = 2; // trailing comment with "quote
+int g687 = 3; /* opens a comment
+   continues
+   and closes */ int after687;
+#ifdef FOO
+int kept688;
+#else
+int dropped688;
+#endif
+#if defined(BAR) && X689
+int dropped689;
+#endif
+#ifdef FOO
+int kept690;
+#else
+int dropped690;
+#endif
+int e691 = 2; // trailing comment with "quote
+static const char *s692 = "/* not a comment */";
+int e693 = 2; // trailing comment with "quote
+static const char *s694 = "/* not a comment */";
+int e695 = 2; // trailing comment with "quote
+static const char *s696 = "/* not a comment */";
+static const char *s697 = "/* not a comment */";
+static const char *s698 = "/* not a comment */";
+#if defined(BAR) && X699
+int dropped699;
+#endif
+int c700 = '"'; /* a comment */ int d700 = 1;
+int e701 = 2; // trailing comment with "quote
+	int h702 = 4;
+x703 = a / b * c;
+char f704[] = "// not a comment either";
+x705 = a / b * c;
+int c706 = '"'; /* a comment */ int d706 = 1;
+	int h707 = 4;
+#if defined(BAR) && X708
+int dropped708;
+#endif
+x709 = a / b * c;
+	int h710 = 4;
+int g711 = 3; /* opens a comment
+   continues
+   and closes */ int after711;
+	int h712 = 4;
+	int h713 = 4;
+char f714[] = "// not a comment either";
+x715 = a / b * c;
+int e716 = 2; // trailing comment with "quote
+char f717[] = "// not a comment either";
+int c718 = '"'; /* a comment */ int d718 = 1;
+x719 = a / b * c;
+char f720[] = "// not a comment either";
+int c721 = '"'; /* a comment */ int d721 = 1;
+char f722[] = "// not a comment either";
+	int h723 = 4;
+int c724 = '"'; /* a comment */ int d724 = 1;
+int c725 = '"'; /* a comment */ int d725 = 1;
+int g726 = 3; /* opens a comment
+   continues
+   and closes */ int after726;
+	int h727 = 4;
+static const char *s728 = "/* not a comment */";
+int g729 = 3; /* opens a comment
+   continues
+   and closes */ int after729;
+char f730[] = "// not a comment either";
+int c731 = '"'; /* a comment */ int d731 = 1;
+x732 = a / b * c;
+int g733 = 3; /* opens a comment
+   continues
+   and closes */ int after733;
+static const char *s734 = "/* not a comment */";
+int c735 = '"'; /* a comment */ int d735 = 1;
+static const char *s736 = "/* not a comment */";
+#ifdef FOO
+int kept737;
+#else
+int dropped737;
+#endif
+	int h738 = 4;
+int c739 = '"'; /* a comment */ int d739 = 1;
+	int h740 = 4;
+int e741 = 2; // trailing comment with "quote
+int g742 = 3; /* opens a comment
+   continues
+   and closes */ int after742;
+static const char *s743 = "/* not a comment */";
+int c744 = '"'; /* a comment */ int d744 = 1;
+#ifdef FOO
+int kept745;
+#else
+int dropped745;
+#endif
+char f746[] = "// not a comment either";
+int e747 = 2; // trailing comment with "quote
+x748 = a / b * c;
+x749 = a / b * c;
+int e750 = 2; // trailing comment with "quote
+	int h751 = 4;
+x752 = a / b * c;
+int e753 = 2; // trailing comment with "quote
+int g754 = 3; /* opens a comment
+   continues
+   and closes */ int after754;
+static const char *s755 = "/* not a comment */";
+int c756 = '"'; /* a comment */ int d756 = 1;
+static const char *s757 = "/* not a comment */";
+int c758 = '"'; /* a comment */ int d758 = 1;
+x759 = a / b * c;
+int c760 = '"'; /* a comment */ int d760 = 1;
+#if defined(BAR) && X761
+int dropped761;
+#endif
+char f762[] = "// not a comment either";
+int c763 = '"'; /* a comment */ int d763 = 1;
+x764 = a / b * c;
+#if defined(BAR) && X765
+int dropped765;
+#endif
+int c766 = '"'; /* a comment */ int d766 = 1;
+int e767 = 2; // trailing comment with "quote
+#if defined(BAR) && X768
+int dropped768;
+#endif
+#if defined(BAR) && X769
+int dropped769;
+#endif
+int c770 = '"'; /* a comment */ int d770 = 1;
+int g771 = 3; /* opens a comment
+   continues
+   and closes */ int after771;
+x772 = a / b * c;
+int e773 = 2; // trailing comment with "quote
+#ifdef FOO
+int kept774;
+#else
+int dropped774;
+#endif
+int c775 = '"'; /* a comment */ int d775 = 1;
+int g776 = 3; /* opens a comment
+   continues
+   and closes */ int after776;
+	int h777 = 4;
+static const char *s778 = "/* not a comment */";
+static const char *s779 = "/* not a comment */";
+char f780[] = "// not a comment either";
+#ifdef FOO
+int kept781;
+#else
+int dropped781;
+#endif
+	int h782 = 4;
+	int h783 = 4;
+char f784[] = "// not a comment either";
+int e785 = 2; // trailing comment with "quote
+#ifdef FOO
+int kept786;
+#else
+int dropped786;
+#endif
+x787 = a / b * c;
+static const char *s788 = "/* not a comment */";
+char f789[] = "// not a comment either";
+x790 = a / b * c;
+#ifdef FOO
+int kept791;
+#else
+int dropped791;
+#endif
+int e792 = 2; // trailing comment with "quote
+char f793[] = "// not a comment either";
+static const char *s794 = "/* not a comment */";
+x795 = a / b * c;
+char f796[] = "// not a comment either";
+#ifdef FOO
+int kept797;
+#else
+int dropped797;
+#endif
+int e798 = 2; // trailing comment with "quote
+int e799 = 2; // trailing comment with "quote
+x800 = a / b * c;
+x801 = a / b * c;
+int c802 = '"'; /* a comment */ int d802 = 1;
+#if defined(BAR) && X803
+int dropped803;
+#endif
+int c804 = '"'; /* a comment */ int d804 = 1;
+x805 = a / b * c;
+	int h806 = 4;
+int c807 = '"'; /* a comment */ int d807 = 1;
+x808 = a / b * c;
+x809 = a / b * c;
+#if defined(BAR) && X810
+int dropped810;
+#endif
+#ifdef FOO
+int kept811;
+#else
+int dropped811;
+#endif
+int g812 = 3; /* opens a comment
+   continues
+   and closes */ int after812;
+static const char *s813 = "/* not a comment */";
+#if defined(BAR) && X814
+int dropped814;
+#endif
+	int h815 = 4;
+#if defined(BAR) && X816
+int dropped816;
+#endif
+int e817 = 2; // trailing comment with "quote
+int e818 = 2; // trailing comment with "quote
+int g819 = 3; /* opens a comment
+   continues
+   and closes */ int after819;
+	int h820 = 4;
+	int h821 = 4;
+char f822[] = "// not a comment either";
+#if defined(BAR) && X823
+int dropped823;
+#endif
+static const char *s824 = "/* not a comment */";
+#if defined(BAR) && X825
+int dropped825;
+#endif
+char f826[] = "// not a comment either";
+static const char *s827 = "/* not a comment */";
+static const char *s828 = "/* not a comment */";
+int e829 = 2; // trailing comment with "quote
+static const char *s830 = "/* not a comment */";
+int c831 = '"'; /* a comment */ int d831 = 1;
+x832 = a / b * c;
+	int h833 = 4;
+char f834[] = "// not a comment either";
+int c835 = '"'; /* a comment */ int d835 = 1;
+int e836 = 2; // trailing comment with "quote
+#if defined(BAR) && X837
+int dropped837;
+#endif
+	int h838 = 4;
+int g839 = 3; /* opens a comment
+   continues
+   and closes */ int after839;
+static const char *s840 = "/* not a comment */";
+	int h841 = 4;
+static const char *s842 = "/* not a comment */";
+static const char *s843 = "/* not a comment */";
+x844 = a / b * c;
+#ifdef FOO
+int kept845;
+#else
+int dropped845;
+#endif
+#ifdef FOO
+int kept846;
+#else
+int dropped846;
+#endif
+int g847 = 3; /* opens a comment
+   continues
+   and closes */ int after847;
+#ifdef FOO
+int kept848;
+#else
+int dropped848;
+#endif
+int e849 = 2; // trailing comment with "quote
+	int h850 = 4;
+	int h851 = 4;
+int e852 = 2; // trailing comment with "quote
+x853 = a / b * c;
+int e854 = 2; // trailing comment with "quote
+int c855 = '"'; /* a comment */ int d855 = 1;
+char f856[] = "// not a comment either";
+x857 = a / b * c;
+char f858[] = "// not a comment either";
+	int h859 = 4;
+x860 = a / b * c;
+static const char *s861 = "/* not a comment */";
+int g862 = 3; /* opens a comment
+   continues
+   and closes */ int after862;
+	int h863 = 4;
+#ifdef FOO
+int kept864;
+#else
+int dropped864;
+#endif
+char f865[] = "// not a comment either";
+static const char *s866 = "/* not a comment */";
+#ifdef FOO
+int kept867;
+#else
+int dropped867;
+#endif
+static const char *s868 = "/* not a comment */";
+	int h869 = 4;
+int g870 = 3; /* opens a comment
+   continues
+   and closes */ int after870;
+int e871 = 2; // trailing comment with "quote
+int c872 = '"'; /* a comment */ int d872 = 1;
+#ifdef FOO
+int kept873;
+#else
+int dropped873;
+#endif
+int e874 = 2; // trailing comment with "quote
+#ifdef FOO
+int kept875;
+#else
+int dropped875;
+#endif
+	int h876 = 4;
+int e877 = 2; // trailing comment with "quote
+int g878 = 3; /* opens a comment
+   continues
+   and closes */ int after878;
+int c879 = '"'; /* a comment */ int d879 = 1;
+	int h880 = 4;
+#if defined(BAR) && X881
+int dropped881;
+#endif
+x882 = a / b * c;
+int c883 = '"'; /* a comment */ int d883 = 1;
+int e884 = 2; // trailing comment with "quote
+int g885 = 3; /* opens a comment
+   continues
+   and closes */ int after885;
+	int h886 = 4;
+	int h887 = 4;
+char f888[] = "// not a comment either";
+static const char *s889 = "/* not a comment */";
+	int h890 = 4;
+	int h891 = 4;
+char f892[] = "// not a comment either";
+	int h893 = 4;
+	int h894 = 4;
+	int h895 = 4;
+static const char *s896 = "/* not a comment */";
+int g897 = 3; /* opens a comment
+   continues
+   and closes */ int after897;
+int g898 = 3; /* opens a comment
+   continues
+   and closes */ int after898;
+int g899 = 3; /* opens a comment
+   continues
+   and closes */ int after899;
+char f900[] = "// not a comment either";
+int c901 = '"'; /* a comment */ int d901 = 1;
+int c902 = '"'; /* a comment */ int d902 = 1;
+x903 = a / b * c;
+static const char *s904 = "/* not a comment */";
+char f905[] = "// not a comment either";
+static const char *s906 = "/* not a comment */";
+int g907 = 3; /* opens a comment
+   continues
+   and closes */ int after907;
+#ifdef FOO
+int kept908;
+#else
+int dropped908;
+#endif
+int c909 = '"'; /* a comment */ int d909 = 1;
+int c910 = '"'; /* a comment */ int d910 = 1;
+int e911 = 2; // trailing comment with "quote
+x912 = a / b * c;
+char f913[] = "// not a comment either";
+x914 = a / b * c;
+x915 = a / b * c;
+int g916 = 3; /* opens a comment
+   continues
+   and closes */ int after916;
+int e917 = 2; // trailing comment with "quote
+#if defined(BAR) && X918
+int dropped918;
+#endif
+#ifdef FOO
+int kept919;
+#else
+int dropped919;
+#endif
+char f920[] = "// not a comment either";
+int c921 = '"'; /* a comment */ int d921 = 1;
+x922 = a / b * c;
+int g923 = 3; /* opens a comment
+   continues
+   and closes */ int after923;
+#if defined(BAR) && X924
+int dropped924;
+#endif
+x925 = a / b * c;
+int c926 = '"'; /* a comment */ int d926 = 1;
+#ifdef FOO
+int kept927;
+#else
+int dropped927;
+#endif
+x928 = a / b * c;
+int g929 = 3; /* opens a comment
+   continues
+   and closes */ int after929;
+int e930 = 2; // trailing comment with "quote
+char f931[] = "// not a comment either";
+x932 = a / b * c;
+int e933 = 2; // trailing comment with "quote
+	int h934 = 4;
+int c935 = '"'; /* a comment */ int d935 = 1;
+x936 = a / b * c;
+x937 = a / b * c;
+#if defined(BAR) && X938
+int dropped938;
+#endif
+#if defined(BAR) && X939
+int dropped939;
+#endif
+	int h940 = 4;
+char f941[] = "// not a comment either";
+x942 = a / b * c;
+	int h943 = 4;
+int e944 = 2; // trailing comment with "quote
+char f945[] = "// not a comment either";
+static const char *s946 = "/* not a comment */";
+int g947 = 3; /* opens a comment
+   continues
+   and closes */ int after947;
+#ifdef FOO
+int kept948;
+#else
+int dropped948;
+#endif
+static const char *s949 = "/* not a comment */";
+int c950 = '"'; /* a comment */ int d950 = 1;
+int e951 = 2; // trailing comment with "quote
+int g952 = 3; /* opens a comment
+   continues
+   and closes */ int after952;
+int c953 = '"'; /* a comment */ int d953 = 1;
+x954 = a / b * c;
+int g955 = 3; /* opens a comment
+   continues
+   and closes */ int after955;
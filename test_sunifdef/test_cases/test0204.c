@@ -0,0 +1,7 @@
+/**ARGS: -DFOO --incremental test0204.state --replace */
+/**SYSCODE: = 4 */
+#ifdef FOO
+int kept;
+#else
+int dropped;
+#endif
@@ -0,0 +1,10 @@
+/**ARGS: --discard comment -DFOO=1 -UBAR */
+/**SYSCODE: = 1 | 32 */
+#if FOO
+KEEP ME
+#elif BAR || (BAZ)
+DELETE ME
+#endif
+#if BAZ && (BAR || FOO)
+KEEP ME
+#endif
@@ -0,0 +1,23 @@
+/**ARGS: --diff -DFOO -UBAR */
+/**SYSCODE: = 1 | 16 | 32 */
+#ifdef FOO
+KEEP ME
+#endif
+line 6
+line 7
+line 8
+line 9
+line 10
+line 11
+line 12
+#if defined(FOO) && defined(BAZ)
+KEEP ME
+#else
+KEEP ME
+#endif
+line 18
+line 19
+#ifdef BAR
+DELETE ME
+#endif
+line 23
@@ -0,0 +1,3 @@
+/**ARGS: -sfl -X 'test0173-[!2].c' */
+/**ALTFILES: ./test_cases/altfiles/test0173-1.c ./test_cases/altfiles/test0173-2.c */
+/**SYSCODE: = 0 */
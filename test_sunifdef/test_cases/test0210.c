@@ -0,0 +1,3 @@
+/**ARGS: --diff -DFOO1 -UFOO2 */
+/**ALTFILES: ./test_cases/altfiles/test0173-1.c ./test_cases/altfiles/test0173-2.c */
+/**SYSCODE: = 1 | 16 */
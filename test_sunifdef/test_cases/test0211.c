@@ -0,0 +1,24 @@
+/**ARGS: -DFOO1=1 -UFOO2 --profile=/dev/stdout */
+/**SYSCODE: = 1 | 16 */
+#ifdef FOO1
+KEEP ME
+#endif
+#if defined(FOO2) && defined(FOO3)
+DELETE ME
+#elif defined FOO3 || defined FOO1
+KEEP ME
+#elif FOO5
+DELETE ME
+#endif
+#ifndef FOO1
+DELETE ME
+#endif
+#if FOO1 || FOO3
+KEEP ME
+#endif
+#if FOO3 && FOO4
+UNKNOWN
+#endif
+#if FOO1 || FOO3
+KEEP ME
+#endif